@@ -0,0 +1,143 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "audio_player.h"
+
+namespace islandapp {
+
+using island::AudioCommand;
+using island::AudioCommandKind;
+using island::SoundId;
+
+AudioPlayer::AudioPlayer(size_t num_voices)
+    : buffer_slots_(num_voices),
+      stream_voices_(num_voices) {}
+
+void AudioPlayer::SetBuffer(SoundId sound,
+                            const cinder::audio::BufferRef& buffer) {
+  RemoveSource(sound);
+  buffers_[sound] = buffer;
+}
+
+void AudioPlayer::SetStream(SoundId sound,
+                            std::unique_ptr<MusicStream> stream) {
+  RemoveSource(sound);
+  streams_[sound] = std::move(stream);
+}
+
+void AudioPlayer::RemoveSource(SoundId sound) {
+  auto stream = streams_.find(sound);
+  for (size_t slot = 0; slot < buffer_slots_.size(); slot++) {
+    if (buffer_slots_[slot].sound_ == sound
+        || (stream != streams_.end() && stream_voices_[slot]
+            == stream->second->GetVoice())) {
+      StopSlot(slot);
+    }
+  }
+
+  buffers_.erase(sound);
+  if (stream != streams_.end()) {
+    num_dropped_underruns_ += stream->second->GetRing().GetNumUnderruns();
+    streams_.erase(stream);
+  }
+}
+
+bool AudioPlayer::HasSource(SoundId sound) const {
+  return buffers_.count(sound) > 0 || streams_.count(sound) > 0;
+}
+
+double AudioPlayer::GetDuration(SoundId sound) const {
+  auto stream = streams_.find(sound);
+  if (stream != streams_.end()) {
+    return stream->second->GetDuration();
+  }
+  auto buffer = buffers_.find(sound);
+  if (buffer == buffers_.end()) {
+    return 0;
+  }
+  return static_cast<double>(buffer->second->getNumFrames())
+         / static_cast<double>(cinder::audio::master()->getSampleRate());
+}
+
+void AudioPlayer::Apply(const std::vector<AudioCommand>& commands) {
+  for (const AudioCommand& command : commands) {
+    num_commands_++;
+    const size_t slot = command.voice_;
+    switch (command.kind_) {
+      case AudioCommandKind::kStart: {
+        // The slot may still hold a sound effect which finished by itself.
+        StopSlot(slot);
+        auto stream = streams_.find(command.sound_);
+        auto buffer = buffers_.find(command.sound_);
+        if (stream != streams_.end()) {
+          stream->second->SetLooping(command.is_looping_);
+          stream_voices_[slot] = stream->second->GetVoice();
+          stream_voices_[slot]->setVolume(command.gain_);
+          stream_voices_[slot]->start();
+        } else if (buffer != buffers_.end()) {
+          StartBuffer(slot, command, buffer->second);
+        }
+        break;
+      }
+      case AudioCommandKind::kSetGain:
+        if (stream_voices_[slot]) {
+          stream_voices_[slot]->setVolume(command.gain_);
+        } else if (buffer_slots_[slot].sound_ != island::kNoSound) {
+          buffer_slots_[slot].gain_->setValue(command.gain_);
+        }
+        break;
+      case AudioCommandKind::kStop:
+        StopSlot(slot);
+        break;
+    }
+  }
+}
+
+size_t AudioPlayer::GetNumUnderruns() const {
+  size_t num_underruns = num_dropped_underruns_;
+  for (const auto& stream : streams_) {
+    num_underruns += stream.second->GetRing().GetNumUnderruns();
+  }
+  return num_underruns;
+}
+
+size_t AudioPlayer::GetNumStreamBytes() const {
+  size_t num_bytes = 0;
+  for (const auto& stream : streams_) {
+    num_bytes += stream.second->GetNumResidentBytes();
+  }
+  return num_bytes;
+}
+
+void AudioPlayer::StartBuffer(size_t slot, const AudioCommand& command,
+                              const cinder::audio::BufferRef& buffer) {
+  BufferSlot& buffer_slot = buffer_slots_[slot];
+  if (!buffer_slot.player_) {
+    cinder::audio::Context* context = cinder::audio::master();
+    buffer_slot.player_ = context->makeNode(
+        new cinder::audio::BufferPlayerNode());
+    buffer_slot.gain_ = context->makeNode(new cinder::audio::GainNode(0));
+    buffer_slot.player_ >> buffer_slot.gain_ >> context->getOutput();
+    context->enable();
+  }
+
+  buffer_slot.player_->setBuffer(buffer);
+  buffer_slot.player_->setLoopEnabled(command.is_looping_);
+  buffer_slot.gain_->setValue(command.gain_);
+  buffer_slot.player_->seek(0);
+  buffer_slot.player_->start();
+  buffer_slot.sound_ = command.sound_;
+}
+
+void AudioPlayer::StopSlot(size_t slot) {
+  if (stream_voices_[slot]) {
+    stream_voices_[slot]->stop();
+    stream_voices_[slot].reset();
+  }
+  BufferSlot& buffer_slot = buffer_slots_[slot];
+  if (buffer_slot.sound_ != island::kNoSound) {
+    buffer_slot.player_->stop();
+    buffer_slot.sound_ = island::kNoSound;
+  }
+}
+
+}  // namespace islandapp
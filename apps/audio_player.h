@@ -0,0 +1,159 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_AUDIOPLAYER_H_
+#define FINALPROJECT_APPS_AUDIOPLAYER_H_
+
+#include <cinder/audio/Voice.h>
+#include <cinder/audio/audio.h>
+
+#include <island/audio_mixer.h>
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "music_stream.h"
+
+namespace islandapp {
+
+/**
+ * Plays the commands of an audio mixer. Sound effects are already decoded
+ * buffers, played by a buffer player of the slot they are started on which
+ * is kept and given the next buffer, so triggering one never decodes or
+ * builds anything. Music is streamed instead, through its stream's voice.
+ */
+class AudioPlayer {
+ public:
+  /**
+   * Creates a player with every slot silent.
+   *
+   * @param num_voices the number of voices in the mixer's pool
+   */
+  explicit AudioPlayer(size_t num_voices);
+
+  /**
+   * Sets the decoded samples a sound is played from, for sound effects.
+   *
+   * @param sound the sound
+   * @param buffer the samples, at the audio context's sample rate
+   */
+  void SetBuffer(island::SoundId sound,
+                 const cinder::audio::BufferRef& buffer);
+
+  /**
+   * Sets the stream a sound is played from, for music too long to decode
+   * all at once.
+   *
+   * @param sound the sound
+   * @param stream the stream
+   */
+  void SetStream(island::SoundId sound, std::unique_ptr<MusicStream> stream);
+
+  /**
+   * Stops a sound and drops its samples or stream.
+   *
+   * @param sound the sound
+   */
+  void RemoveSource(island::SoundId sound);
+
+  /**
+   * Determines whether a sound has samples or a stream to be played from.
+   *
+   * @param sound the sound
+   * @return true if the sound can be played
+   */
+  bool HasSource(island::SoundId sound) const;
+
+  /**
+   * Gets the length of a sound.
+   *
+   * @param sound the sound
+   * @return the length, in seconds, or 0 if the sound cannot be played
+   */
+  double GetDuration(island::SoundId sound) const;
+
+  /**
+   * Starts, stops and changes the gain of the slots as the mixer says.
+   *
+   * @param commands the mixer's commands, in order
+   */
+  void Apply(const std::vector<island::AudioCommand>& commands);
+
+  /**
+   * Accessor function for the number of commands applied.
+   *
+   * @return the number of commands
+   */
+  inline size_t GetNumCommands() const {
+    return num_commands_;
+  }
+
+  /**
+   * Counts the times a stream ran out of decoded music, including streams
+   * which have since been dropped.
+   *
+   * @return the number of underruns
+   */
+  size_t GetNumUnderruns() const;
+
+  /**
+   * Counts the memory holding decoded music.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumStreamBytes() const;
+
+ private:
+  /** The nodes a slot plays sound effects on. */
+  struct BufferSlot {
+    /** Plays the samples of the slot's sound. */
+    cinder::audio::BufferPlayerNodeRef player_;
+
+    /** Sets the gain of the slot's sound. */
+    cinder::audio::GainNodeRef gain_;
+
+    /** The sound playing on the slot, or kNoSound. */
+    island::SoundId sound_ = island::kNoSound;
+  };
+
+  /**
+   * Plays a sound effect on a slot, connecting the slot's nodes the first
+   * time the slot plays one.
+   *
+   * @param slot the slot
+   * @param command the start command
+   * @param buffer the samples of the sound effect
+   */
+  void StartBuffer(size_t slot, const island::AudioCommand& command,
+                   const cinder::audio::BufferRef& buffer);
+
+  /**
+   * Stops whatever a slot is playing.
+   *
+   * @param slot the slot
+   */
+  void StopSlot(size_t slot);
+
+  /** The samples of each sound effect. */
+  std::unordered_map<island::SoundId, cinder::audio::BufferRef> buffers_;
+
+  /** The stream of each sound played from one. */
+  std::unordered_map<island::SoundId, std::unique_ptr<MusicStream>> streams_;
+
+  /** The nodes each slot plays sound effects on. */
+  std::vector<BufferSlot> buffer_slots_;
+
+  /** The stream voice each slot plays, or nullptr. */
+  std::vector<cinder::audio::VoiceRef> stream_voices_;
+
+  /** The number of commands applied. */
+  size_t num_commands_ = 0;
+
+  /** The number of underruns of the streams which have been dropped. */
+  size_t num_dropped_underruns_ = 0;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_AUDIOPLAYER_H_
@@ -0,0 +1,119 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "command_renderer.h"
+
+namespace islandapp {
+
+using cinder::Rectf;
+using island::CommandKind;
+using island::DrawCommand;
+
+namespace {
+
+/** The largest value of a color channel. */
+const float kMaxChannel = 255.0f;
+
+/**
+ * Gets one channel of a 0xRRGGBBAA color.
+ *
+ * @param color the color
+ * @param shift the position of the channel, in bits
+ * @return the channel, from 0 to 1
+ */
+float GetChannel(uint32_t color, uint32_t shift) {
+  return static_cast<float>((color >> shift) & 0xFF) / kMaxChannel;
+}
+
+}  // namespace
+
+void CommandRenderer::Clear() {
+  textures_.clear();
+  texture_ids_.clear();
+  num_batches_ = 0;
+}
+
+uint32_t CommandRenderer::GetTextureId(
+    const cinder::gl::TextureRef& texture) {
+  auto id = texture_ids_.find(texture.get());
+  if (id != texture_ids_.end()) {
+    return id->second;
+  }
+  const uint32_t new_id = static_cast<uint32_t>(textures_.size());
+  textures_.push_back(texture);
+  texture_ids_.emplace(texture.get(), new_id);
+  return new_id;
+}
+
+void CommandRenderer::Submit(const island::CommandBuffer& commands,
+                             uint16_t first_layer, uint16_t end_layer) {
+  if (!batch_) {
+    batch_ = cinder::gl::VertBatch::create(GL_TRIANGLES);
+  }
+
+  // The first command of the batch being built, or nullptr for none.
+  const DrawCommand* batch_start = nullptr;
+  for (const DrawCommand& command : commands.GetCommands()) {
+    if (command.layer_ < first_layer || command.layer_ >= end_layer) {
+      continue;
+    }
+    if (batch_start != nullptr && (command.kind_ != batch_start->kind_
+        || command.texture_ != batch_start->texture_)) {
+      Flush(*batch_start);
+      batch_start = nullptr;
+    }
+    if (batch_start == nullptr) {
+      batch_start = &command;
+    }
+
+    const bool is_textured = command.kind_ != CommandKind::kRect;
+    Rectf coords(0, 0, 1, 1);
+    if (is_textured) {
+      const cinder::gl::TextureRef& texture = textures_[command.texture_];
+      coords = texture->getAreaTexCoords(texture->getBounds());
+    } else {
+      // The blending expects colors premultiplied by their alpha.
+      const float alpha = GetChannel(command.color_, 0);
+      batch_->color(cinder::ColorA(GetChannel(command.color_, 24) * alpha,
+                                   GetChannel(command.color_, 16) * alpha,
+                                   GetChannel(command.color_, 8) * alpha,
+                                   alpha));
+    }
+
+    // Two triangles per quad, in the same order as the tile batches.
+    const island::CommandRect& rect = command.rect_;
+    const float xs[] = {rect.x1_, rect.x2_, rect.x2_,
+                        rect.x1_, rect.x2_, rect.x1_};
+    const float ys[] = {rect.y1_, rect.y1_, rect.y2_,
+                        rect.y1_, rect.y2_, rect.y2_};
+    const float us[] = {coords.x1, coords.x2, coords.x2,
+                        coords.x1, coords.x2, coords.x1};
+    const float vs[] = {coords.y1, coords.y1, coords.y2,
+                        coords.y1, coords.y2, coords.y2};
+    for (size_t vertex = 0; vertex < 6; vertex++) {
+      if (is_textured) {
+        batch_->texCoord(us[vertex], vs[vertex]);
+      }
+      batch_->vertex(xs[vertex], ys[vertex]);
+    }
+  }
+  if (batch_start != nullptr) {
+    Flush(*batch_start);
+  }
+}
+
+void CommandRenderer::Flush(const DrawCommand& command) {
+  if (command.kind_ == CommandKind::kRect) {
+    cinder::gl::ScopedGlslProg shader(
+        cinder::gl::getStockShader(cinder::gl::ShaderDef().color()));
+    batch_->draw();
+  } else {
+    cinder::gl::ScopedGlslProg shader(
+        cinder::gl::getStockShader(cinder::gl::ShaderDef().texture()));
+    cinder::gl::ScopedTextureBind texture(textures_[command.texture_]);
+    batch_->draw();
+  }
+  batch_->clear();
+  num_batches_++;
+}
+
+}  // namespace islandapp
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_COMMANDRENDERER_H_
+#define FINALPROJECT_APPS_COMMANDRENDERER_H_
+
+#include <cinder/gl/gl.h>
+
+#include <island/command_buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace islandapp {
+
+/**
+ * Submits a sorted command buffer to the GPU. Every run of commands sharing
+ * a kind and a texture is drawn as one batch of quads, so the texture and
+ * shader are only bound once per run.
+ */
+class CommandRenderer {
+ public:
+  /** Forgets the textures of the last frame. */
+  void Clear();
+
+  /**
+   * Gets the id commands refer to a texture by, for the current frame.
+   *
+   * @param texture the texture
+   * @return the texture's id
+   */
+  uint32_t GetTextureId(const cinder::gl::TextureRef& texture);
+
+  /**
+   * Draws the commands in a range of layers, in the order of the buffer.
+   * Must be called on the thread that owns the GL context.
+   *
+   * @param commands the sorted commands
+   * @param first_layer the first layer to draw
+   * @param end_layer the layer after the last layer to draw
+   */
+  void Submit(const island::CommandBuffer& commands, uint16_t first_layer,
+              uint16_t end_layer);
+
+  /**
+   * Accessor function for the number of batches drawn since the last Clear.
+   *
+   * @return the number of batches
+   */
+  inline size_t GetNumBatches() const {
+    return num_batches_;
+  }
+
+ private:
+  /**
+   * Draws the batch being built.
+   *
+   * @param command a command of the batch, which has the batch's state
+   */
+  void Flush(const island::DrawCommand& command);
+
+  /** The textures of the current frame, with their ids as the indices. */
+  std::vector<cinder::gl::TextureRef> textures_;
+
+  /** The ids of the textures of the current frame. */
+  std::unordered_map<const cinder::gl::Texture2d*, uint32_t> texture_ids_;
+
+  /** The quads of the batch being built, reused between batches. */
+  cinder::gl::VertBatchRef batch_;
+
+  /** The number of batches drawn since the last Clear. */
+  size_t num_batches_ = 0;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_COMMANDRENDERER_H_
@@ -0,0 +1,178 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "frame_recorder.h"
+
+#include <cinder/ImageIo.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace islandapp {
+
+using island::CapturedFrame;
+using island::CaptureStats;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::string;
+
+FrameRecorder::FrameRecorder(const string& directory, CaptureFormat format)
+    : directory_{directory},
+      format_{format},
+      readbacks_(kNumPixelBuffers),
+      oldest_readback_{0},
+      num_readbacks_{0},
+      num_frames_{0},
+      num_readback_drops_{0},
+      capture_time_{0},
+      max_capture_time_{0},
+      width_{0},
+      height_{0} {
+  if (format_ == CaptureFormat::kRaw) {
+    raw_file_.open(directory_ + "/capture.rgba", std::ios::binary);
+  }
+  encoder_.reset(new island::FrameEncoder(kNumEncoderSlots,
+      [this](const CapturedFrame& frame) { Encode(frame); }));
+}
+
+void FrameRecorder::Capture(const cinder::gl::FboRef& fbo) {
+  const auto start = steady_clock::now();
+  const size_t index = num_frames_++;
+  CollectReadbacks(false);
+
+  // A raw video has one size throughout, so it keeps the first frame's.
+  const cinder::ivec2 size = fbo->getSize();
+  if (width_ == 0) {
+    width_ = size.x;
+    height_ = size.y;
+  }
+  const bool is_resized = format_ == CaptureFormat::kRaw
+      && (size.x != width_ || size.y != height_);
+
+  if (num_readbacks_ == readbacks_.size() || is_resized) {
+    num_readback_drops_++;
+  } else {
+    Readback& readback =
+        readbacks_[(oldest_readback_ + num_readbacks_) % readbacks_.size()];
+    const GLsizeiptr num_bytes = size.x * size.y * 4;
+    if (!readback.pbo_ || readback.pbo_->getSize() != num_bytes) {
+      readback.pbo_ = cinder::gl::Pbo::create(GL_PIXEL_PACK_BUFFER, num_bytes,
+                                              nullptr, GL_STREAM_READ);
+    }
+
+    // With a pack buffer bound, glReadPixels only queues the copy and
+    // returns, and the fence tells when the GPU has done it.
+    cinder::gl::ScopedFramebuffer framebuffer(fbo, GL_READ_FRAMEBUFFER);
+    cinder::gl::ScopedBuffer buffer(readback.pbo_);
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    readback.fence_ = cinder::gl::Sync::create();
+    readback.index_ = index;
+    readback.width_ = size.x;
+    readback.height_ = size.y;
+    num_readbacks_++;
+  }
+
+  const nanoseconds time = duration_cast<nanoseconds>(
+      steady_clock::now() - start);
+  capture_time_ += time;
+  if (time > max_capture_time_) {
+    max_capture_time_ = time;
+  }
+}
+
+void FrameRecorder::Finish() {
+  CollectReadbacks(true);
+  encoder_->Flush();
+  raw_file_.flush();
+}
+
+void FrameRecorder::CollectReadbacks(bool should_wait) {
+  while (num_readbacks_ > 0) {
+    Readback& readback = readbacks_[oldest_readback_];
+    const GLuint64 timeout = should_wait ? GL_TIMEOUT_IGNORED : 0;
+    if (readback.fence_->clientWaitSync(GL_SYNC_FLUSH_COMMANDS_BIT, timeout)
+        == GL_TIMEOUT_EXPIRED) {
+      return;
+    }
+
+    Submit(readback);
+    readback.fence_.reset();
+    oldest_readback_ = (oldest_readback_ + 1) % readbacks_.size();
+    num_readbacks_--;
+  }
+}
+
+void FrameRecorder::Submit(const Readback& readback) {
+  CapturedFrame* frame = encoder_->Acquire();
+  if (frame == nullptr) {
+    return;
+  }
+
+  // Number the frame by when it was drawn, so frames dropped before reaching
+  // the encoder still leave a gap.
+  frame->index_ = readback.index_;
+  frame->width_ = static_cast<size_t>(readback.width_);
+  frame->height_ = static_cast<size_t>(readback.height_);
+  const size_t row_bytes = frame->width_ * island::kBytesPerPixel;
+  frame->pixels_.resize(row_bytes * frame->height_);
+
+  cinder::gl::ScopedBuffer buffer(readback.pbo_);
+  const uint8_t* pixels = static_cast<const uint8_t*>(
+      readback.pbo_->mapBufferRange(0, readback.pbo_->getSize(),
+                                    GL_MAP_READ_BIT));
+  if (pixels != nullptr) {
+    // GL reads the bottom row first.
+    for (size_t row = 0; row < frame->height_; row++) {
+      std::memcpy(&frame->pixels_[row * row_bytes],
+                  pixels + (frame->height_ - 1 - row) * row_bytes, row_bytes);
+    }
+  }
+  readback.pbo_->unmap();
+  encoder_->Submit(frame);
+}
+
+void FrameRecorder::Encode(const CapturedFrame& frame) {
+  if (format_ == CaptureFormat::kRaw) {
+    raw_file_.write(reinterpret_cast<const char*>(frame.pixels_.data()),
+                    static_cast<std::streamsize>(frame.pixels_.size()));
+    return;
+  }
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "/frame_%06zu.png", frame.index_);
+  cinder::Surface8u surface(
+      const_cast<uint8_t*>(frame.pixels_.data()),
+      static_cast<int32_t>(frame.width_), static_cast<int32_t>(frame.height_),
+      static_cast<ptrdiff_t>(frame.width_ * island::kBytesPerPixel),
+      cinder::SurfaceChannelOrder::RGBA);
+  cinder::writeImage(directory_ + name, surface);
+}
+
+string FrameRecorder::GetReport() const {
+  const CaptureStats stats = encoder_->GetStats();
+  const long long num_frames = num_frames_ == 0 ? 1 :
+      static_cast<long long>(num_frames_);
+  const long long num_encoded = stats.num_encoded_ == 0 ? 1 :
+      static_cast<long long>(stats.num_encoded_);
+
+  std::ostringstream report;
+  report << "Recorded " << stats.num_encoded_ << " of " << num_frames_
+         << " frames to " << directory_ << " (" << num_readback_drops_
+         << " dropped waiting for readback, " << stats.num_dropped_
+         << " dropped waiting for the encoder)" << std::endl
+         << "Capture overhead on the drawing thread: "
+         << capture_time_.count() / num_frames << " ns/frame, max "
+         << max_capture_time_.count() << " ns" << std::endl
+         << "Encoding: " << stats.encode_time_.count() / num_encoded
+         << " ns/frame on the encoder thread";
+  if (format_ == CaptureFormat::kRaw) {
+    report << std::endl << "Convert with: ffmpeg -f rawvideo -pixel_format"
+           << " rgba -video_size " << width_ << "x" << height_
+           << " -framerate 60 -i " << directory_ << "/capture.rgba "
+           << directory_ << "/capture.mp4";
+  }
+  return report.str();
+}
+
+}  // namespace islandapp
@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_FRAMERECORDER_H_
+#define FINALPROJECT_APPS_FRAMERECORDER_H_
+
+#include <cinder/gl/gl.h>
+
+#include <island/frame_encoder.h>
+#include <island/tile_atlas.h>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace islandapp {
+
+/** How the recorder writes the captured frames. */
+enum class CaptureFormat {
+  /** One PNG image per frame. */
+  kPng,
+
+  /** Every frame appended to one file of raw RGBA pixels. */
+  kRaw,
+};
+
+/**
+ * Records the frames the game draws without stalling the drawing thread.
+ * Each frame is read back into one of a ring of pixel buffers, which the GPU
+ * fills in the background, and is copied out a few frames later once the GPU
+ * is done with it. The copies are written by a background encoder.
+ *
+ * When every pixel buffer is still being filled, or every encoder slot is
+ * still being written, the frame is dropped instead of waiting.
+ */
+class FrameRecorder {
+ public:
+  /** The number of frames which can be read back at the same time. */
+  const size_t kNumPixelBuffers = 3;
+
+  /** The number of copied frames which can wait to be written. */
+  const size_t kNumEncoderSlots = 8;
+
+  /**
+   * Constructor which starts the encoder.
+   *
+   * @param directory the existing directory to write the frames to
+   * @param format how to write the frames
+   */
+  FrameRecorder(const std::string& directory, CaptureFormat format);
+
+  /**
+   * Starts reading back a frame, and hands any frames the GPU has finished
+   * reading back to the encoder. Must be called on the thread that owns the
+   * GL context.
+   *
+   * @param fbo the framebuffer holding the frame
+   */
+  void Capture(const cinder::gl::FboRef& fbo);
+
+  /**
+   * Waits for the frames still being read back and written. Must be called
+   * on the thread that owns the GL context.
+   */
+  void Finish();
+
+  /**
+   * Gets a summary of what the recording cost, for the log.
+   *
+   * @return the number of frames written and dropped, and the time spent on
+   * the drawing thread and on the encoder thread
+   */
+  std::string GetReport() const;
+
+ private:
+  /** A frame being read back into a pixel buffer. */
+  struct Readback {
+    /** The pixel buffer the frame is read into. */
+    cinder::gl::PboRef pbo_;
+
+    /** Signalled once the GPU has filled the pixel buffer. */
+    cinder::gl::SyncRef fence_;
+
+    /** The number of the frame since the recording started. */
+    size_t index_;
+
+    /** The width of the frame, in pixels. */
+    int width_;
+
+    /** The height of the frame, in pixels. */
+    int height_;
+  };
+
+  /**
+   * Hands the frames the GPU has finished reading back to the encoder,
+   * oldest first.
+   *
+   * @param should_wait true to wait for every frame, false to stop at the
+   * first one which is not ready
+   */
+  void CollectReadbacks(bool should_wait);
+
+  /**
+   * Copies a read back frame into an encoder slot, flipping it so the top
+   * row comes first, and submits it. Drops the frame if no slot is free.
+   *
+   * @param readback the frame to copy
+   */
+  void Submit(const Readback& readback);
+
+  /**
+   * Writes one frame, called on the encoder thread.
+   *
+   * @param frame the frame to write
+   */
+  void Encode(const island::CapturedFrame& frame);
+
+  /** The directory the frames are written to. */
+  std::string directory_;
+
+  /** How the frames are written. */
+  CaptureFormat format_;
+
+  /** The file the raw frames are appended to, only used by Encode. */
+  std::ofstream raw_file_;
+
+  /** The ring of frames being read back. */
+  std::vector<Readback> readbacks_;
+
+  /** The index of the oldest frame being read back. */
+  size_t oldest_readback_;
+
+  /** The number of frames being read back. */
+  size_t num_readbacks_;
+
+  /** The number of frames drawn since the recording started. */
+  size_t num_frames_;
+
+  /** The number of frames dropped because every pixel buffer was busy. */
+  size_t num_readback_drops_;
+
+  /** The total time Capture spent on the drawing thread. */
+  std::chrono::nanoseconds capture_time_;
+
+  /** The longest time a single Capture spent on the drawing thread. */
+  std::chrono::nanoseconds max_capture_time_;
+
+  /** The width of the frames written so far, for the raw video's size. */
+  int width_;
+
+  /** The height of the frames written so far, for the raw video's size. */
+  int height_;
+
+  /** Writes the frames on a background thread. */
+  std::unique_ptr<island::FrameEncoder> encoder_;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_FRAMERECORDER_H_
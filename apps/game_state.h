@@ -0,0 +1,20 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_GAMESTATE_H_
+#define FINALPROJECT_APPS_GAMESTATE_H_
+
+namespace islandapp {
+
+/** Enum used to represents the game's current state. */
+enum class GameState {
+  kPlaying,
+  kInventory,
+  kMarket,
+  kBattle,
+  kBattleText,
+  kDisplayingText
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_GAMESTATE_H_
@@ -2,137 +2,239 @@
 
 #include "island_app.h"
 
+#include <cinder/Buffer.h>
+#include <cinder/DataSource.h>
+#include <cinder/Filesystem.h>
 #include <cinder/ImageIo.h>
 #include <cinder/gl/draw.h>
 #include <gflags/gflags.h>
 #include <gflags/gflags_declare.h>
+#include <island/key_actions.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
-
-#if defined(CINDER_COCOA_TOUCH)
-const char kNormalFont[] = "Arial";
-const char kBoldFont[] = "Arial-BoldMT";
-const char kDifferentFont[] = "AmericanTypewriter";
-#elif defined(CINDER_LINUX)
-const char kNormalFont[] = "Arial Unicode MS";
-const char kBoldFont[] = "Arial Unicode MS";
-const char kDifferentFont[] = "Purisa";
-#else
-const char kNormalFont[] = "Arial";
-const char kBoldFont[] = "Arial Bold";
-#endif
+#include <memory>
+#include <iostream>
+#include <thread>
 
 namespace islandapp {
 
 using cinder::Color;
-using cinder::Rectf;
-using cinder::TextBox;
-using cinder::ColorA;
 using cinder::app::KeyEvent;
 using nlohmann::json;
 using island::Direction;
 using island::Location;
 using island::Tile;
 using island::Npc;
+using island::PlayerAction;
+using island::SessionState;
 using island::Statistics;
 using island::Item;
 using std::chrono::seconds;
 using std::chrono::system_clock;
 using std::string;
 
+// Keys are mapped to actions by their codes, which are Cinder's.
+static_assert(island::kKeyUp == static_cast<uint32_t>(KeyEvent::KEY_UP)
+              && island::kKeyDown == static_cast<uint32_t>(KeyEvent::KEY_DOWN)
+              && island::kKeyLeft == static_cast<uint32_t>(KeyEvent::KEY_LEFT)
+              && island::kKeyRight
+                 == static_cast<uint32_t>(KeyEvent::KEY_RIGHT)
+              && island::kKeySpace
+                 == static_cast<uint32_t>(KeyEvent::KEY_SPACE)
+              && island::kKeyA == static_cast<uint32_t>(KeyEvent::KEY_a)
+              && island::kKeyZ == static_cast<uint32_t>(KeyEvent::KEY_z),
+              "island::KeyCode must match Cinder's key codes");
+
 DECLARE_string(player_name);
 DECLARE_string(load);
 DECLARE_bool(new_game);
+DECLARE_string(save_dir);
+DECLARE_int32(slot);
+DECLARE_string(capture_dir);
+DECLARE_bool(capture_raw);
+DECLARE_uint64(texture_budget_mb);
+DECLARE_bool(show_texture_memory);
+DECLARE_bool(print_stats);
 
 IslandApp::IslandApp()
-    : engine_{island::kMapSize, island::kMapSize,
-              std::vector<island::Item>(),
-              FLAGS_player_name,
-              {7, 0},
-              {10, 10, 10, 10},
-              std::vector<island::Item>(),
-              1200},
-      state_{GameState::kPlaying},
-      npc_battle_move_{BattleMove::kAttack},
-      player_battle_move_{BattleMove::kAttack},
-      hp_multiplier_{1},
-      attack_multiplier_{1},
-      defense_multiplier_{1},
-      speed_multiplier_{1},
+    : state_{GameState::kPlaying},
+      world_{island::LoadIslandWorld(kTilesetPath)},
+      session_{world_, FLAGS_player_name},
+      job_system_{std::max(std::thread::hardware_concurrency(), 1u) - 1},
+      is_simulating_{false},
+      drawn_version_{0},
+      num_frames_{0},
+      num_skipped_frames_{0},
+      window_width_{0},
+      window_height_{0},
+      camera_{island::kMapSize, island::kMapSize, kPlayerTileSize},
+      num_zoom_steps_{0},
       speed_{kSpeed},
       char_counter_{0},
       last_changed_direction_{0},
-      npc_hp_{0},
-      player_hp_{0},
-      battle_turn_counter_{0},
-      is_player_turn_{false},
-      is_changed_direction_{false},
-      should_start_battle_{false},
-      prev_direction_{Direction::kDown},
-      camera_{0,0},
-      battle_npc_{Npc("", {0, 0},
-          {0, 0, 0, 0},
-          false, 0)}{
-  if (!FLAGS_new_game) {
-    engine_.Load(FLAGS_load);
+      is_minimap_shown_{false},
+      save_slots_{FLAGS_save_dir},
+      loaded_playtime_seconds_{0} {
+  if (FLAGS_new_game) {
+    return;
+  }
+  if (FLAGS_slot < 0) {
+    uint64_t generation;
+    if (session_.GetEngine().Load(FLAGS_load, &generation)
+        && FLAGS_load == kSavePath) {
+      autosaver_.Resume(generation);
+    }
+    return;
+  }
+
+  island::SaveState state;
+  island::SaveSlotHeader header;
+  if (save_slots_.Load(static_cast<size_t>(FLAGS_slot), &state, &header)) {
+    session_.GetEngine().Restore(state);
+    loaded_playtime_seconds_ = header.playtime_seconds_;
+  } else {
+    std::cerr << "Slot " << FLAGS_slot << " holds no save" << std::endl;
   }
 }
 
 void IslandApp::setup() {
+  resources_.Open(kResourcePackPath);
+  cinder::fs::create_directories(FLAGS_save_dir);
+  save_slots_.Open();
+  PrintSaveSlots();
   InitializeAudio();
-  InitializeItems();
   InitializeDisplayFilePaths();
   InitializeNpcTextFilePaths();
-  InitializeNpcSpriteFilePaths();
-  InitializeNpcBattleSpriteFilePaths();
-  InitializeActiveNpcSpriteFiles();
 
   cinder::gl::disableDepthRead();
   cinder::gl::disableDepthWrite();
+  scene_renderer_.SetTextureBudget(FLAGS_texture_budget_mb * kBytesPerMegabyte);
+  scene_renderer_.SetMemoryReportShown(FLAGS_show_texture_memory);
+  scene_renderer_.Load(session_.GetEngine(), &resources_, &job_system_);
+  if (!FLAGS_capture_dir.empty()) {
+    recorder_.reset(new FrameRecorder(FLAGS_capture_dir, FLAGS_capture_raw
+        ? CaptureFormat::kRaw : CaptureFormat::kPng));
+  }
+
+  window_width_ = getWindowWidth();
+  window_height_ = getWindowHeight();
+  MovePlayerCamera();
+  PublishSnapshot();
+
+  is_simulating_ = true;
+  simulation_thread_ = std::thread(&IslandApp::RunSimulation, this);
+}
+
+void IslandApp::cleanup() {
+  is_simulating_ = false;
+  if (simulation_thread_.joinable()) {
+    simulation_thread_.join();
+  }
+
+  if (slot_saving_.valid()) {
+    slot_saving_.wait();
+  }
+  autosaver_.Flush();
+  if (FLAGS_print_stats) {
+    PrintStats();
+  }
+  if (recorder_) {
+    recorder_->Finish();
+    std::cout << recorder_->GetReport() << std::endl;
+  }
+}
+
+void IslandApp::PrintStats() const {
+  std::cout << "Skipped " << num_skipped_frames_ << " of " << num_frames_
+            << " frames with nothing new to draw" << std::endl;
+  std::cout << scene_renderer_.GetMemoryReport() << std::endl;
+  std::cout << "Sent " << audio_player_.GetNumCommands()
+            << " audio commands, skipped " << mixer_.GetNumSkippedSfx()
+            << " sound effects, " << audio_player_.GetNumUnderruns()
+            << " music underruns, "
+            << audio_player_.GetNumStreamBytes() / 1024
+            << " KB of decoded music" << std::endl;
+  const island::AutosaveStats save_stats = autosaver_.GetStats();
+  std::cout << "Wrote " << save_stats.num_written_ << " of "
+            << save_stats.num_captured_ << " full saves and "
+            << save_stats.num_records_ << " changes in "
+            << save_stats.num_batches_ << " journal batches ("
+            << save_stats.num_journal_bytes_ << " bytes), "
+            << save_stats.num_replaced_ << " replaced, "
+            << save_stats.num_failed_ << " failed, stalling the game "
+            << save_stats.max_stall_time_.count() / 1000 << " us and taking "
+            << save_stats.max_latency_.count() / 1000000
+            << " ms to reach the disk at most" << std::endl;
 }
 
 void IslandApp::InitializeAudio() {
-  cinder::audio::SourceFileRef background_src = cinder::audio::load
-      (cinder::app::loadAsset("background_music.mp3"));
-  background_audio_ = cinder::audio::Voice::create(background_src);
-  background_audio_->start();
-
-  cinder::audio::SourceFileRef battle_src = cinder::audio::load
-      (cinder::app::loadAsset("battle_music.mp3"));
-  battle_audio_ = cinder::audio::Voice::create(battle_src);
-  battle_audio_->setVolume(kMaxBattleVolume);
-
-  cinder::audio::SourceFileRef text_src = cinder::audio::load
-      (cinder::app::loadAsset("text_sound.wav"));
-  text_audio_ = cinder::audio::Voice::create(text_src);
+  // Opening the music only reads its header, the stream decodes the rest.
+  audio_player_.SetStream(kBackgroundMusic, std::unique_ptr<MusicStream>(
+      new MusicStream(LoadMusic("background_music.mp3"))));
+
+  // Sound effects come decoded from the cache, which is only written again
+  // when a sound effect was missing from it or its file has changed.
+  pcm_cache_.Open(kPcmCachePath);
+  island::PcmCacheWriter sfx_cache;
+  bool is_cached = true;
+  audio_player_.SetBuffer(kTextSound,
+                          LoadSfx("text_sound.wav", &sfx_cache, &is_cached));
+  if (!is_cached) {
+    pcm_cache_.Close();
+    sfx_cache.Write(kPcmCachePath);
+  }
+}
+
+cinder::audio::BufferRef IslandApp::LoadSfx(const string& file_name,
+                                            island::PcmCacheWriter* cache,
+                                            bool* is_cached) const {
+  const cinder::DataSourceRef source = LoadAsset(file_name);
+  const cinder::BufferRef bytes = source->getBuffer();
+  const uint64_t hash = island::HashBytes(
+      static_cast<const uint8_t*>(bytes->getData()), bytes->getSize());
+  const size_t sample_rate = cinder::audio::master()->getSampleRate();
+
+  cinder::audio::BufferRef buffer;
+  island::PcmView sound;
+  if (pcm_cache_.Find(hash, sample_rate, &sound)) {
+    buffer = std::make_shared<cinder::audio::Buffer>(sound.num_frames_,
+                                                     sound.num_channels_);
+    const float* samples = sound.samples_;
+    for (size_t channel = 0; channel < sound.num_channels_; channel++) {
+      std::copy(samples, samples + sound.num_frames_,
+                buffer->getChannel(channel));
+      samples += sound.num_frames_;
+    }
+  } else {
+    buffer = cinder::audio::load(source, sample_rate)->loadBuffer();
+    *is_cached = false;
+  }
+
+  const float* samples = buffer->getData();
+  cache->Add(hash, sample_rate, buffer->getNumChannels(),
+             std::vector<float>(samples, samples + buffer->getNumFrames()
+                                         * buffer->getNumChannels()));
+  return buffer;
 }
 
-void IslandApp::InitializeItems() {
-  island::Item shoe("shoe",
-      "Footwear that helps you outspeed others in battle.",
-      "assets/shoe.png");
-  island::Item sword("sword",
-                     "A legendary sword, it is said that it "
-                     "grants the user amazing attack power.",
-                     "assets/sword.png");
-  island::Item shield("shield",
-                      "Armour that increases your defensive prowess,"
-                      " helping you take hits better in battle.",
-                      "assets/shield.png");
-  island::Item heart("heart",
-                     "An extra heart, it will help strengthen "
-                     "your life force in battle.",
-                     "assets/heart.png");
-  island::Item key("key",
-                      "Looks like a key to someone's house",
-                      "assets/key.png");
-
-  engine_.AddItem(shoe);
-  engine_.AddItem(sword);
-  engine_.AddItem(shield);
-  engine_.AddItem(heart);
-  engine_.AddItem(key);
+cinder::audio::SourceFileRef IslandApp::LoadMusic(
+    const string& file_name) const {
+  return cinder::audio::load(LoadAsset(file_name),
+                             cinder::audio::master()->getSampleRate());
+}
+
+cinder::DataSourceRef IslandApp::LoadAsset(const string& file_name) const {
+  island::ResourceSpan resource;
+  if (resources_.Find("assets/" + file_name, &resource)) {
+    // The buffer only wraps the mapped bytes, which outlive the decoder.
+    return cinder::DataSourceBuffer::create(
+        cinder::Buffer::create(const_cast<uint8_t*>(resource.data_),
+                               resource.size_), file_name);
+  }
+  return cinder::app::loadAsset(file_name);
 }
 
 void IslandApp::InitializeDisplayFilePaths() {
@@ -159,877 +261,540 @@ void IslandApp::InitializeDisplayFilePaths() {
 }
 
 void IslandApp::InitializeNpcTextFilePaths() {
-  for (const auto& npc : engine_.GetNpcs()) {
+  for (const auto& npc : session_.GetEngine().GetNpcs()) {
     npc_text_files_.insert(std::pair<string, string>
        (npc.name_, "assets/npc/dialogue/" + npc.name_ + ".txt"));
   }
-  ChangeMarketDialogue();
+  market_text_files_.insert(std::pair<string, string>
+      ("shoe", "assets/npc/dialogue/Boi_shoes.txt"));
+  market_text_files_.insert(std::pair<string, string>
+      ("sword", "assets/npc/dialogue/Boi_sword.txt"));
+  market_text_files_.insert(std::pair<string, string>
+      ("shield", "assets/npc/dialogue/Boi_shield.txt"));
+  market_text_files_.insert(std::pair<string, string>
+      ("heart", "assets/npc/dialogue/Boi_heart.txt"));
 }
 
-void IslandApp::InitializeNpcSpriteFilePaths() {
-  for (const auto& npc : engine_.GetNpcs()) {
-    AddNpcSprites(npc.name_);
-  }
-}
+void IslandApp::RunSimulation() {
+  const std::chrono::microseconds tick(1000000 / kTicksPerSecond);
+  auto next_tick = system_clock::now();
 
-void IslandApp::InitializeNpcBattleSpriteFilePaths() {
-  for (const auto& npc : engine_.GetNpcs()) {
-    if (npc.is_combatable_) {
-      npc_battle_sprite_files_.insert(std::pair<string, string>
-        (npc.name_, "assets/npc/images/" + npc.name_ + "_battle.png"));
+  while (is_simulating_) {
+    int key_code;
+    while (input_queue_.Pop(&key_code)) {
+      HandleKey(key_code);
     }
-  }
-}
 
-void IslandApp::AddNpcSprites(const std::string& name) {
-  npc_sprite_files_.insert(std::pair<string, string>
-      (name + "_right", "assets/npc/images/" + name + "_right.png"));
-  npc_sprite_files_.insert(std::pair<string, string>
-      (name + "_left", "assets/npc/images/" + name + "_left.png"));
-  npc_sprite_files_.insert(std::pair<string, string>
-      (name + "_up", "assets/npc/images/" + name + "_up.png"));
-  npc_sprite_files_.insert(std::pair<string, string>
-      (name + "_down", "assets/npc/images/" + name + "_down.png"));
-}
+    Simulate();
+    PublishSnapshot();
 
-void IslandApp::InitializeActiveNpcSpriteFiles() {
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Rosalyn", Direction::kUp));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("John", Direction::kDown));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Azura", Direction::kLeft));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Klutz", Direction::kRight));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Rod", Direction::kUp));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Sven", Direction::kUp));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Elf", Direction::kUp));
-  active_npc_sprite_files_.insert(std::pair<string, Direction>
-      ("Boi", Direction::kUp));
+    next_tick += tick;
+    const auto time = system_clock::now();
+    if (next_tick < time) {
+      // The tick ran long, so start counting again instead of catching up.
+      next_tick = time;
+    }
+    std::this_thread::sleep_until(next_tick);
+  }
 }
 
-void IslandApp::update() {
+void IslandApp::Simulate() {
   const auto time = system_clock::now();
   if (time - last_time_ > std::chrono::milliseconds(speed_)) {
-    if (is_changed_direction_) {
-      engine_.ExecuteTimeStep();
-      is_changed_direction_ = false;
-    }
+    session_.Step(&job_system_);
     last_time_ = time;
   }
+  autosaver_.Update(&session_.GetEngine());
+  PrefetchBattle();
 
-  if (should_start_battle_ && char_counter_ == display_text_.size()) {
-    state_ = GameState::kBattle;
-    battle_turn_counter_ = 0;
-    should_start_battle_ = false;
-  }
-
-  if (state_ != GameState::kBattle && state_ != GameState::kBattleText
-      && !background_audio_->isPlaying()) {
-    background_audio_->start();
-    battle_audio_->stop();
+  // A battle starts by itself once the npc has finished talking.
+  if (session_.IsBattleStarting() && char_counter_ == display_text_.size()) {
+    HandleAction(PlayerAction::kInteract);
   }
 
-  if (state_ == GameState::kBattle || state_ == GameState::kBattleText) {
-    battle_audio_->start();
-    background_audio_->stop();
-    UpdateBattle();
+  if (state_ == GameState::kBattle || state_ == GameState::kBattleText
+      || state_ == GameState::kDisplayingText
+      || state_ == GameState::kMarket) {
+    AdvanceText();
   }
 
-  UpdateStatisticMultipliers();
   MovePlayerCamera();
+  UpdateAudio();
 }
 
-void IslandApp::draw() {
-  cinder::gl::enableAlphaBlending();
-  cinder::gl::clear();
-  cinder::gl::color(Color(1,1,1));
+void IslandApp::PrefetchBattle() {
+  const bool is_battle = state_ == GameState::kBattle
+                         || state_ == GameState::kBattleText;
+  const string& npc_name = battle_prefetch_.Update(
+      session_.GetEngine().GetCombatableNpcsNear(kBattlePrefetchTiles),
+      is_battle ? session_.GetBattleNpc().name_ : "");
 
-  if (state_ == GameState::kBattle || state_ == GameState::kBattleText) {
-    DrawBattle();
-    return;
-  }
-
-  Translate(false);
-  DrawMap();
-  DrawPlayer();
-  DrawNpcs();
-  if (state_ == GameState::kDisplayingText || state_ == GameState::kMarket) {
-    DrawTextBox();
-  } else if (state_ == GameState::kInventory) {
-    DrawInventory();
+  if (battle_audio_loading_.valid()
+      && battle_audio_loading_.wait_for(seconds(0))
+         == std::future_status::ready) {
+    WaitForBattleAudio();
   }
-  Translate(true);
-}
-
-void IslandApp::DrawBattle() {
-  auto background = cinder::gl::Texture::create
-      (cinder::loadImage("assets/battle_background.png"));
-  cinder::gl::draw(background, getWindowBounds());
-  DrawBattlePlayer();
-  DrawBattleOpponent();
-  DrawHpBars();
-  DrawBattleText();
-}
-
-void IslandApp::DrawHpBars() {
-  auto hp_box = cinder::gl::Texture::create
-      (cinder::loadImage("assets/hp_bar.png"));
-  cinder::gl::draw(hp_box, Rectf
-  (230, 180, 430, 320));
-  cinder::gl::draw(hp_box, Rectf
-  (300, 380, 500, 520));
-
-  auto blood = cinder::gl::Texture::create
-      (cinder::loadImage("assets/blood.png"));
-  cinder::gl::draw(blood, Rectf(270, 233.5,
-      270 + npc_hp_ / battle_npc_.statistics_.hit_points_ * 140,
-      253.5));
-  cinder::gl::draw(blood, Rectf(340, 433.5,
-      340 + player_hp_ / engine_.GetPlayer().statistics_.hit_points_ * 140,
-      453.5));
-
-}
-
-void IslandApp::DrawBattleText() {
-  display_text_ = GetBattleText();
-
-  if (!battle_turn_counter_) {
-    display_text_ = battle_npc_.name_ + " wants to battle!";
+  if (npc_name.empty()) {
+    // Kept until the music has faded out after the battle.
+    if (!mixer_.IsPlaying(kBattleMusic)) {
+      audio_player_.RemoveSource(kBattleMusic);
+    }
+  } else if (!audio_player_.HasSource(kBattleMusic)
+             && !battle_audio_loading_.valid()) {
+    battle_audio_loading_ = std::async(std::launch::async, [this] {
+      return LoadMusic("battle_music.mp3");
+    });
   }
-
-  Translate(false);
-  DrawTextBox();
-  Translate(true);
-}
-
-void IslandApp::DrawBattlePlayer() {
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-
-  auto background = cinder::gl::Texture::create
-      (cinder::loadImage("assets/battle_player.png"));
-  cinder::gl::draw(background, Rectf(
-  1.0 / 8.0 * width, center.y,3.0 / 8.0 * width,
-  (center.y + height * kTextLocMultiplier) / (kTextLocMultiplier + 1.0)));
-}
-
-void IslandApp::DrawBattleOpponent() {
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-  string opponent_image_path = npc_battle_sprite_files_[battle_npc_.name_];
-
-  auto background = cinder::gl::Texture::create
-      (cinder::loadImage(opponent_image_path));
-  cinder::gl::draw(background, Rectf(
-    4.5 / 8.0 * width,200.0 / 800.0 * height,
-    6.0 / 8.0 * width,425.0 / 800.0 * height));
-}
-
-void IslandApp::DrawMap() const {
-  auto map = cinder::gl::Texture::create
-      (cinder::loadImage("assets/map.png"));
-  cinder::gl::draw(map, Rectf( 0,0,
-                               kMapTileSize * kScreenSize,
-                               kMapTileSize * kScreenSize));
-}
-
-void IslandApp::DrawPlayer() const {
-  Location loc = engine_.GetPlayer().location_;
-  cinder::gl::TextureRef image = GetPlayerImage();
-  cinder::gl::draw(image, Rectf( kPlayerTileSize * loc.GetRow(),
-                                 kPlayerTileSize * loc.GetCol(),
-                                 kPlayerTileSize * (loc.GetRow() + 1),
-                                 kPlayerTileSize * (loc.GetCol() + 1)));
 }
 
-void IslandApp::DrawNpcs() {
-  for (const auto& npc : engine_.GetNpcs()) {
-    Location loc = npc.location_;
-    Direction facing_direction = active_npc_sprite_files_[npc.name_];
-    string image_path = GetActiveNpcImagePath(npc.name_, facing_direction);
-
-    cinder::gl::TextureRef image =
-        cinder::gl::Texture::create(cinder::loadImage(image_path));
-    cinder::gl::draw(image, Rectf( kPlayerTileSize * loc.GetRow(),
-                                   kPlayerTileSize * loc.GetCol(),
-                                   kPlayerTileSize * (loc.GetRow() + 1),
-                                   kPlayerTileSize * (loc.GetCol() + 1)));
+void IslandApp::WaitForBattleAudio() {
+  if (audio_player_.HasSource(kBattleMusic)) {
+    return;
   }
+  const cinder::audio::SourceFileRef source =
+      battle_audio_loading_.valid() ? battle_audio_loading_.get()
+                                    : LoadMusic("battle_music.mp3");
+  audio_player_.SetStream(kBattleMusic, std::unique_ptr<MusicStream>(
+      new MusicStream(source)));
 }
 
-void IslandApp::DrawTextBox() {
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-  const cinder::ivec2 size = {kTextBoxWidth, kTextBoxHeight};
-  const Color color = Color::black();
-  auto text_box = cinder::gl::Texture::create
-      (cinder::loadImage("assets/text_box.png"));
-
+void IslandApp::AdvanceText() {
   if (char_counter_ < display_text_.size()) {
     char_counter_ +=  kCharSpeed;
-    text_audio_->start();
+    // The mixer skips the sound while the last one has barely started.
+    mixer_.PlaySfx(kTextSound, static_cast<float>(kMaxVolume),
+                   audio_player_.GetDuration(kTextSound));
   }
-  string to_display = display_text_.substr(0, char_counter_);
-
-  Translate(true);
-  cinder::gl::draw(text_box, Rectf( 0,
-  (center.y + height * kTextLocMultiplier) / (kTextLocMultiplier + 1.0),
-                                      width, height));
-  PrintText(to_display, color, size, {width, height});
-  Translate(false);
-}
-
-void IslandApp::DrawInventory() const {
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-
-  Translate(true);
-  auto inventory = cinder::gl::Texture::create
-      (cinder::loadImage("assets/inventory.png"));
-  cinder::gl::draw(inventory, Rectf(center.x / kScreenDivider,
-   center.y / kScreenDivider,(center.x + width) / kScreenDivider,
-  (center.y + height) / kScreenDivider));
-
-  DrawItems();
-  DrawMoney();
-  DrawInventoryDescription();
-  Translate(false);
 }
 
-template <typename C>
-void IslandApp::PrintText(const string& text, const C& color,
-    const cinder::ivec2& size, const cinder::vec2& loc) const {
-  cinder::gl::color(color);
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-  auto box = TextBox()
-      .alignment(TextBox::LEFT)
-      .font(cinder::Font(kNormalFont, kFontSize))
-      .size(size)
-      .color(color)
-      .backgroundColor(ColorA(0, 0, 0, 0))
-      .text(text);
-
-  const auto texture = cinder::gl::Texture::create(box.render());
-  cinder::gl::draw(texture,
-      Rectf( kTextOffset,(center.y + height * kTextLocMultiplier) /
-                    (kTextLocMultiplier + 1.0) + kTextOffset, width, height));
-}
+void IslandApp::UpdateAudio() {
+  // Setting the same music every tick is free; the mixer only sends a
+  // command to the audio output when the music actually changes.
+  if (state_ == GameState::kBattle || state_ == GameState::kBattleText) {
+    mixer_.SetMusic(kBattleMusic, kMaxBattleVolume);
+  } else {
+    mixer_.SetMusic(kBackgroundMusic, static_cast<float>(kMaxVolume));
+  }
+  audio_player_.Apply(mixer_.Update(getElapsedSeconds()));
+}
+
+void IslandApp::PublishSnapshot() {
+  RenderSnapshot& snapshot = snapshots_.GetBack();
+  const island::Engine& engine = session_.GetEngine();
+  const island::Player& player = engine.GetPlayer();
+
+  snapshot.state_ = state_;
+  snapshot.player_location_ = player.location_;
+  snapshot.player_direction_ = session_.GetFacing();
+  snapshot.player_step_ = last_changed_direction_;
+  snapshot.camera_ = camera_.GetLocation();
+  snapshot.visible_tiles_ = camera_.GetVisibleTiles();
+  snapshot.num_zoom_steps_ = num_zoom_steps_;
+  snapshot.level_ = camera_.GetLevel();
+  snapshot.is_minimap_shown_ = is_minimap_shown_;
+  if (snapshot.num_tile_changes_ != engine.GetNumTileChanges()) {
+    snapshot.num_tile_changes_ = engine.GetNumTileChanges();
+    snapshot.tile_overrides_ = engine.GetTileOverrides();
+  }
+  snapshot.visible_text_ = display_text_.substr(0, char_counter_);
+  snapshot.money_ = player.money_;
+
+  snapshot.inventory_file_paths_.clear();
+  for (const Item& item : player.inventory_) {
+    snapshot.inventory_file_paths_.push_back(item.file_path_);
+  }
+
+  // Only the npcs the camera can see are drawn.
+  const island::EntityStore& npcs = engine.GetNpcStore();
+  snapshot.npcs_.clear();
+  for (size_t index = 0; index < npcs.GetSize(); index++) {
+    Location loc = npcs.GetLocations()[index];
+    if (!snapshot.visible_tiles_.Contains(loc)) {
+      continue;
+    }
 
-void IslandApp::DrawItems() const {
-  const cinder::vec2 center = getWindowCenter();
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-
-  for (size_t ite = 0; ite < engine_.GetPlayer().inventory_.size(); ite++) {
-    auto item_image = cinder::gl::Texture::create
-        (cinder::loadImage
-        (engine_.GetInventoryItem(ite).file_path_));
-
-    double offset_start = (double) (ite) * 43.0 / 800.0 * width + width / 16.0;
-    cinder::gl::draw(item_image,
-        Rectf(center.x / kScreenDivider + offset_start,
-              center.y / kScreenDivider + height * 90.0 / 800.0,
-              center.x / kScreenDivider + offset_start + width / 20.0,
-              center.y / kScreenDivider + height * 140.0 / 800.0));
+    NpcSprite sprite;
+    sprite.name_ = npcs.GetNames()[index];
+    sprite.location_ = loc;
+    sprite.facing_ = session_.GetNpcFacings()[index];
+    snapshot.npcs_.push_back(sprite);
   }
-}
 
-void IslandApp::DrawMoney() const {
-  cinder::gl::color(Color::black());
-  const cinder::vec2 center = getWindowCenter();
-  const cinder::ivec2 size = {150, 100};
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-
-  auto box = TextBox()
-      .alignment(TextBox::LEFT)
-      .font(cinder::Font(kNormalFont, kFontSize))
-      .size(size)
-      .color(Color::black())
-      .backgroundColor(ColorA(0, 0, 0, 0))
-      .text("$" + std::to_string(engine_.GetPlayer().money_));
-
-  const auto texture = cinder::gl::Texture::create(box.render());
-
-  cinder::gl::draw(texture,
-   Rectf( center.x / kScreenDivider + 50.0 / 800.0 * width,
-          center.y / kScreenDivider + 20.0 / 800.0 * height,
-          center.x / kScreenDivider + 200.0 / 800.0 * width,
-          center.y / kScreenDivider + 90.0 / 800.0 * height));
-}
+  const Npc& battle_npc = session_.GetBattleNpc();
+  snapshot.battle_npc_name_ = battle_npc.name_;
+  snapshot.player_hp_fraction_ = player.statistics_.hit_points_ == 0 ? 0 :
+      session_.GetPlayerHp() / player.statistics_.hit_points_;
+  snapshot.npc_hp_fraction_ = battle_npc.statistics_.hit_points_ == 0 ? 0 :
+      session_.GetNpcHp() / battle_npc.statistics_.hit_points_;
+  snapshot.prefetch_npc_name_ = battle_prefetch_.GetTarget();
 
-void IslandApp::DrawInventoryDescription() const {
-  cinder::gl::color(Color::black());
-  const cinder::vec2 center = getWindowCenter();
-  const cinder::ivec2 size = {350, 130};
-  const double width = getWindowWidth();
-  const double height = getWindowHeight();
-  string text;
-  size_t inventory_size = engine_.GetPlayer().inventory_.size();
-
-  if (inventory_size == 0) {
-    text = "You have no items! You should try and search around, "
-           "or perhaps even buy some.";
-  } else if (inventory_size == kMaxInventorySize) {
-    text = "You have all the items. I believed in you from the very beginning!";
+  if (snapshot.IsSameFrame(last_snapshot_)) {
+    snapshot.version_ = last_snapshot_.version_;
   } else {
-    text = "These items of yours sure are impressive, "
-           "but there's still a few more you can get!";
+    snapshot.version_ = last_snapshot_.version_ + 1;
+    last_snapshot_ = snapshot;
   }
-
-  auto box = TextBox()
-      .alignment(TextBox::LEFT)
-      .font(cinder::Font(kNormalFont, 2 * kFontSize / 3.0))
-      .size(size)
-      .color(Color::black())
-      .backgroundColor(ColorA(0, 0, 0, 0))
-      .text(text);
-
-  const auto texture = cinder::gl::Texture::create(box.render());
-
-  cinder::gl::draw(texture,
-     Rectf( center.x / kScreenDivider + 50.0 / 800.0 * width,
-            center.y / kScreenDivider + 320.0 / 800.0 * height,
-            center.x / kScreenDivider + 400.0 / 800.0 * width,
-            center.y / kScreenDivider + 450.0 / 800.0 * height));
+  snapshots_.Publish();
 }
 
-void IslandApp::Translate(bool is_up) const {
-  float direction;
-  if (is_up) {
-    direction = 1.0;
+void IslandApp::draw() {
+  window_width_ = getWindowWidth();
+  window_height_ = getWindowHeight();
+  snapshots_.Update();
+  const RenderSnapshot& snapshot = snapshots_.GetFront();
+  num_frames_++;
+
+  // Only draw when the snapshot or the window changed since the last drawn
+  // frame, and otherwise present that frame again.
+  const cinder::ivec2 size = getWindowSize();
+  const bool is_resized = !frame_fbo_ || frame_fbo_->getSize() != size;
+  if (is_resized) {
+    frame_fbo_ = cinder::gl::Fbo::create(size.x, size.y);
+  }
+
+  if (is_resized || snapshot.version_ != drawn_version_) {
+    cinder::gl::ScopedFramebuffer framebuffer(frame_fbo_);
+    scene_renderer_.SetViewSize(size.x, size.y);
+    scene_renderer_.Draw(snapshot);
+    drawn_version_ = snapshot.version_;
   } else {
-    direction = -1.0;
+    num_skipped_frames_++;
   }
+  PresentFrame();
 
-  cinder::gl::translate(
-      direction * (camera_.GetRow() * kTranslationMultiplier),
-      direction * (camera_.GetCol() * kTranslationMultiplier));
-}
-
-cinder::gl::TextureRef IslandApp::GetPlayerImage() const {
-  string image_path;
-  switch (prev_direction_) {
-    case Direction::kDown:
-      image_path = GetDownImagePath();
-      break;
-    case Direction::kUp:
-      image_path = GetUpImagePath();
-      break;
-    case Direction::kLeft:
-      image_path = GetLeftImagePath();
-      break;
-    case Direction::kRight:
-      image_path = GetRightImagePath();
-      break;
+  if (recorder_) {
+    recorder_->Capture(frame_fbo_);
   }
-
-  return cinder::gl::Texture::create(cinder::loadImage(image_path));
 }
 
-string IslandApp::GetDownImagePath() const {
-  switch (last_changed_direction_ % kNumSprites) {
-    case 0 :
-      return "assets/player/down_nomove.png";
-    case 1 :
-      return "assets/player/down_left.png";
-    case 2 :
-      return "assets/player/down_nomove.png";
-    case 3 :
-      return "assets/player/down_right.png";
-  }
-  return "";
+void IslandApp::PresentFrame() const {
+  cinder::gl::disableAlphaBlending();
+  cinder::gl::color(Color(1,1,1));
+  cinder::gl::draw(frame_fbo_->getColorTexture(), getWindowBounds());
 }
 
-string IslandApp::GetUpImagePath() const {
-  switch (last_changed_direction_ % kNumSprites) {
-    case 0 :
-      return "assets/player/up_nomove.png";
-    case 1 :
-      return "assets/player/up_left.png";
-    case 2 :
-      return "assets/player/up_nomove.png";
-    case 3 :
-      return "assets/player/up_right.png";
-  }
-  return "";
+
+void IslandApp::MovePlayerCamera() {
+  camera_.SetViewSize(static_cast<size_t>(window_width_.load()),
+                      static_cast<size_t>(window_height_.load()));
+  camera_.Follow(session_.GetEngine().GetPlayer().location_);
 }
 
-string IslandApp::GetLeftImagePath() const {
-  switch (last_changed_direction_ % kNumSprites) {
-    case 0 :
-      return "assets/player/left_nomove.png";
-    case 1 :
-      return "assets/player/left_left.png";
-    case 2 :
-      return "assets/player/left_nomove.png";
-    case 3 :
-      return "assets/player/left_right.png";
-  }
-  return "";
+void IslandApp::keyDown(KeyEvent event) {
+  // A key pressed while the queue is full is dropped, as the simulation is
+  // already a full queue behind.
+  input_queue_.Push(event.getCode());
 }
 
-string IslandApp::GetRightImagePath() const {
-  switch (last_changed_direction_ % kNumSprites) {
-    case 0 :
-      return "assets/player/right_nomove.png";
-    case 1 :
-      return "assets/player/right_left.png";
-    case 2 :
-      return "assets/player/right_nomove.png";
-    case 3 :
-      return "assets/player/right_right.png";
+void IslandApp::HandleKey(int key_code) {
+  // The keys which play the game are mapped the same way as on a server.
+  PlayerAction action;
+  const bool is_action =
+      island::GetKeyAction(static_cast<uint32_t>(key_code), &action);
+  if (state_ == GameState::kBattle || state_ == GameState::kBattleText) {
+    if (key_code == KeyEvent::KEY_m) {
+      ToggleVolume();
+    } else if (is_action) {
+      BattleKey(action);
+    }
+    return;
+  }
+  if (is_action) {
+    ActionKey(action);
+    return;
   }
-  return "";
-}
 
-string IslandApp::GetActiveNpcImagePath
-      (const string& name, const Direction& direction) {
-  string dir_path;
-  switch (direction) {
-    case Direction::kUp :
-      dir_path = "_up";
+  switch (key_code) {
+    case KeyEvent::KEY_m:
+      ToggleVolume();
       break;
-    case Direction::kDown :
-      dir_path = "_down";
+
+    case KeyEvent::KEY_v:
+      autosaver_.RequestSave();
       break;
-    case Direction::kLeft :
-      dir_path = "_left";
+
+    case KeyEvent::KEY_1:
+    case KeyEvent::KEY_2:
+    case KeyEvent::KEY_3:
+    case KeyEvent::KEY_4:
+    case KeyEvent::KEY_5:
+    case KeyEvent::KEY_6:
+    case KeyEvent::KEY_7:
+    case KeyEvent::KEY_8:
+    case KeyEvent::KEY_9:
+      SaveToSlot(static_cast<size_t>(key_code - KeyEvent::KEY_0));
       break;
-    case Direction::kRight :
-      dir_path = "_right";
+
+    case KeyEvent::KEY_EQUALS:
+      ZoomCamera(true);
       break;
-  }
-  return npc_sprite_files_[name + dir_path];
-}
 
-std::string IslandApp::GetBattleText() {
-  if (is_player_turn_) {
-    if (state_ == GameState::kBattleText) {
-      switch (player_battle_move_) {
-        case BattleMove::kAttack:
-          return GetTextFromFile("assets/battle/player_attack.txt");
-        case BattleMove::kHeal:
-          return GetTextFromFile("assets/battle/player_heal.txt");
-        case BattleMove::kRun:
-          return GetTextFromFile("assets/battle/player_run.txt");
-      }
-    }
-    return GetTextFromFile("assets/battle/player_move.txt");
-  } else {
-    if (npc_battle_move_ == BattleMove::kAttack) {
-      return GetTextFromFile("assets/battle/npc_attack.txt");
-    } else {
-      return GetTextFromFile("assets/battle/npc_heal.txt");
-    }
-  }
-}
+    case KeyEvent::KEY_MINUS:
+      ZoomCamera(false);
+      break;
 
-void IslandApp::UpdateBattle() {
-  if (player_battle_move_ == BattleMove::kRun) {
-    state_ = GameState::kPlaying;
-  }
-  if (player_hp_ < 0) {
-    if (engine_.GetPlayer().money_ > battle_npc_.money_) {
-      engine_.RemoveMoney(battle_npc_.money_);
-    }
-    state_ = GameState::kPlaying;
-  }
-  if (npc_hp_ < 0) {
-    engine_.AddMoney(battle_npc_.money_);
-    state_ = GameState::kPlaying;
+    case KeyEvent::KEY_TAB:
+      is_minimap_shown_ = !is_minimap_shown_;
+      break;
   }
 }
 
-void IslandApp::UpdateStatisticMultipliers() {
-  std::vector<Item> inventory = engine_.GetPlayer().inventory_;
-  for (const Item& item : inventory) {
-    if (item.name_ == "shoe")
-      speed_multiplier_ = kStatMultiplier;
-    else if (item.name_ == "sword")
-      attack_multiplier_ = kStatMultiplier;
-    else if (item.name_ == "shield")
-      defense_multiplier_ = kStatMultiplier;
-    else if (item.name_ == "heart")
-      hp_multiplier_ = kStatMultiplier;
+void IslandApp::SaveToSlot(size_t slot) {
+  if (slot_saving_.valid()) {
+    slot_saving_.wait();
   }
+  const island::SaveState state = session_.GetEngine().CaptureSave();
+  const auto playtime = static_cast<uint64_t>(getElapsedSeconds())
+                        + loaded_playtime_seconds_;
+  const auto timestamp = static_cast<uint64_t>(
+      std::chrono::duration_cast<seconds>(
+          system_clock::now().time_since_epoch()).count());
+  slot_saving_ = std::async(std::launch::async,
+                            [this, slot, state, playtime, timestamp] {
+    return save_slots_.Write(slot, state, playtime, timestamp, {});
+  });
 }
 
-void IslandApp::MovePlayerCamera() {
-  size_t screen_width = getWindowWidth();
-  size_t screen_height = getWindowHeight();
-  camera_.SetRow(engine_.GetPlayer().location_.GetRow() -
-                            (screen_width / kScreenSize) / kScreenDivider);
-  camera_.SetCol(engine_.GetPlayer().location_.GetCol() -
-                            (screen_height / kScreenSize) / kScreenDivider);
-
-  if (camera_.GetRow() < 0) {
-    camera_.SetRow(0);
-  }
-
-  if (camera_.GetCol() < 0) {
-    camera_.SetCol(0);
-  }
-
-  size_t max_camera_width = kMapTileSize - screen_width / kScreenSize;
-  size_t max_camera_height = kMapTileSize - screen_height / kScreenSize;
-
-  if (camera_.GetRow() > max_camera_width) {
-    camera_.SetRow(max_camera_width);
-  }
-
-  if (camera_.GetCol() >  max_camera_height) {
-    camera_.SetCol(max_camera_height);
+void IslandApp::PrintSaveSlots() const {
+  for (const island::SaveSlotHeader& header : save_slots_.GetSlots()) {
+    std::cout << "Slot " << header.slot_ << ": " << header.player_name_
+              << ", $" << header.player_money_ << ", "
+              << header.playtime_seconds_ / 60 << " minutes played"
+              << (header.is_key_found_ ? ", has the key" : "") << std::endl;
   }
 }
 
-void IslandApp::keyDown(KeyEvent event) {
-  if (state_ == GameState::kBattle || state_ == GameState::kBattleText) {
-    if (event.getCode() == KeyEvent::KEY_m) {
-      ToggleVolume();
-    }
-    BattleKey(event);
-    return;
-  }
-
-  switch (event.getCode()) {
-    case KeyEvent::KEY_UP:
-    case KeyEvent::KEY_w:
-    case KeyEvent::KEY_DOWN:
-    case KeyEvent::KEY_s:
-    case KeyEvent::KEY_LEFT:
-    case KeyEvent::KEY_a:
-    case KeyEvent::KEY_RIGHT:
-    case KeyEvent::KEY_d:
-      MovementKey(event);
-      break;
-
-    case KeyEvent::KEY_z:
-    case KeyEvent::KEY_x:
-    case KeyEvent::KEY_y:
-    case KeyEvent::KEY_n:
-      InteractionKey(event);
-      break;
-
-    case KeyEvent::KEY_m:
-      ToggleVolume();
-      break;
-
-    case KeyEvent::KEY_v:
-      engine_.Save();
-      break;
+void IslandApp::ZoomCamera(bool is_in) {
+  if (is_in && num_zoom_steps_ > 0) {
+    num_zoom_steps_--;
+  } else if (!is_in && num_zoom_steps_ < kMaxZoomSteps) {
+    num_zoom_steps_++;
   }
+  camera_.SetZoom(GetZoom(num_zoom_steps_));
+  MovePlayerCamera();
 }
 
-void IslandApp::MovementKey(const KeyEvent& event) {
-  switch (event.getCode()) {
-    case KeyEvent::KEY_UP:
-    case KeyEvent::KEY_w:
+void IslandApp::ActionKey(PlayerAction action) {
+  switch (action) {
+    case PlayerAction::kMoveUp:
       HandleMovement(Direction::kUp);
       break;
 
-    case KeyEvent::KEY_DOWN:
-    case KeyEvent::KEY_s:
+    case PlayerAction::kMoveDown:
       HandleMovement(Direction::kDown);
       break;
 
-    case KeyEvent::KEY_LEFT:
-    case KeyEvent::KEY_a:
+    case PlayerAction::kMoveLeft:
       HandleMovement(Direction::kLeft);
       break;
 
-    case KeyEvent::KEY_RIGHT:
-    case KeyEvent::KEY_d:
+    case PlayerAction::kMoveRight:
       HandleMovement(Direction::kRight);
       break;
-  }
-}
 
-void IslandApp::InteractionKey(const KeyEvent& event) {
-  switch (event.getCode()) {
-    case KeyEvent::KEY_z:
+    case PlayerAction::kInteract:
       if ((state_ == GameState::kDisplayingText || state_ == GameState::kMarket)
           && char_counter_ != display_text_.size()) {
         char_counter_ = display_text_.size();
         break;
-      } else {
-        char_counter_ = 0;
       }
-
-      ExecutePlayerInteractions(event);
+      HandleAction(action);
       break;
 
-    case KeyEvent::KEY_x:
-      if (state_ == GameState::kBattle || state_ == GameState::kDisplayingText){
-        break;
-      } else if (state_ == GameState::kInventory) {
-        state_ = GameState::kPlaying;
-      } else {
-        state_ = GameState::kInventory;
-      }
+    case PlayerAction::kToggleInventory:
+    case PlayerAction::kAccept:
+    case PlayerAction::kDecline:
+      HandleAction(action);
       break;
 
-    case KeyEvent::KEY_y:
-      if (state_ == GameState::kMarket) {
-        ExecuteMarketInteraction(event);
-      }
-      break;
-
-    case KeyEvent::KEY_n:
-      if (state_ == GameState::kMarket) {
-        state_ = GameState::kPlaying;
-      }
+    // Battle moves only mean something in battle.
+    case PlayerAction::kAttack:
+    case PlayerAction::kHeal:
+    case PlayerAction::kRun:
       break;
   }
 }
 
-void IslandApp::BattleKey(const KeyEvent& event) {
-  switch (event.getCode()) {
-    case KeyEvent::KEY_z:
-    case KeyEvent::KEY_SPACE:
-    case KeyEvent::KEY_h:
-    case KeyEvent::KEY_r:
-      ExecuteBattleStep(event);
-      break;
-  }
-}
-
-void IslandApp::ExecuteBattleStep(const KeyEvent& event) {
-  if (state_ == GameState::kBattleText && event.getCode() == KeyEvent::KEY_z) {
-    state_ = GameState::kBattle;
-  } else if (state_ == GameState::kBattleText) {
-    return;
-  }
-
-  if (battle_turn_counter_ == 0) {
-    battle_turn_counter_++;
-    return;
-  }
-
-  if (is_player_turn_) {
-    switch (event.getCode()) {
-      case KeyEvent::KEY_SPACE:
-      case KeyEvent::KEY_h:
-      case KeyEvent::KEY_r:
-        ExecutePlayerBattleMove(event);
-        state_ = GameState::kBattleText;
-        break;
-
-      default: return;
+void IslandApp::BattleKey(PlayerAction action) {
+  if (state_ == GameState::kBattleText) {
+    if (action == PlayerAction::kInteract) {
+      ShowNextBattleText();
     }
-  } else {
-    player_hp_ -= battle_npc_.statistics_.attack_ * kAttackConstant
-            / (engine_.GetPlayer().statistics_.defense_ * defense_multiplier_);
+    return;
   }
 
-  battle_turn_counter_++;
-  is_player_turn_ = !is_player_turn_;
-}
-
-void IslandApp::ExecutePlayerBattleMove(const KeyEvent& event) {
-  switch (event.getCode()) {
-    case KeyEvent::KEY_SPACE:
-      player_battle_move_ = BattleMove::kAttack;
-      npc_hp_ -= (engine_.GetPlayer().statistics_.attack_ * attack_multiplier_)
-              * kAttackConstant / battle_npc_.statistics_.defense_;
+  string file_path;
+  switch (action) {
+    case PlayerAction::kAttack:
+      file_path = "assets/battle/player_attack.txt";
       break;
 
-    case KeyEvent::KEY_h:
-      player_battle_move_ = BattleMove::kHeal;
-      player_hp_ += engine_.GetPlayer().statistics_.hit_points_ / kHealConstant;
-      if (player_hp_ > engine_.GetPlayer().statistics_.hit_points_) {
-        player_hp_ = engine_.GetPlayer().statistics_.hit_points_;
-      }
+    case PlayerAction::kHeal:
+      file_path = "assets/battle/player_heal.txt";
       break;
 
-    case KeyEvent::KEY_r:
-      player_battle_move_ = BattleMove::kRun;
+    case PlayerAction::kRun:
+      file_path = "assets/battle/player_run.txt";
       break;
+
+    default:
+      return;
+  }
+
+  const size_t num_npc_turns = session_.GetNumNpcTurns();
+  HandleAction(action);
+  if (session_.GetState() != SessionState::kBattle) {
+    return;
+  }
+  battle_texts_.push_back(GetTextFromFile(file_path));
+  if (session_.GetNumNpcTurns() > num_npc_turns) {
+    battle_texts_.push_back(GetTextFromFile("assets/battle/npc_attack.txt"));
   }
+  ShowNextBattleText();
 }
 
 void IslandApp::ToggleVolume() {
-  if (background_audio_->getVolume() == 0) {
-    background_audio_->setVolume(kMaxVolume);
-    text_audio_->setVolume(kMaxVolume);
-    battle_audio_->setVolume(kMaxBattleVolume);
-  } else {
-    background_audio_->setVolume(0);
-    text_audio_->setVolume(0);
-    battle_audio_->setVolume(0);  }
+  mixer_.SetMuted(!mixer_.IsMuted());
 }
 
 void IslandApp::HandleMovement(const Direction& direction) {
-  if (state_ != GameState::kPlaying) {
+  if (session_.GetState() != SessionState::kPlaying) {
     return;
   }
 
-  if (prev_direction_ == direction) {
+  if (session_.GetFacing() == direction) {
     last_changed_direction_++;
   } else {
     last_changed_direction_ = 0;
   }
-  prev_direction_ = direction;
 
-  if (!engine_.IsValidDirection(direction)) {
-    return;
+  switch (direction) {
+    case Direction::kUp:
+      HandleAction(PlayerAction::kMoveUp);
+      break;
+    case Direction::kDown:
+      HandleAction(PlayerAction::kMoveDown);
+      break;
+    case Direction::kLeft:
+      HandleAction(PlayerAction::kMoveLeft);
+      break;
+    case Direction::kRight:
+      HandleAction(PlayerAction::kMoveRight);
+      break;
   }
-
-  is_changed_direction_ = true;
-  engine_.SetDirection(direction);
 }
 
-void IslandApp::ExecutePlayerInteractions(const KeyEvent& event) {
-  if (state_ == GameState::kDisplayingText) {
-    state_ = GameState::kPlaying;
-  } else if (state_ == GameState::kPlaying || state_ == GameState::kMarket){
-    Location facing_location = engine_.GetFacingLocation(prev_direction_);
-    Tile facing_tile = engine_.GetTileType(facing_location);
-    string file_path;
-
-    if (facing_location.GetRow() == kMarketLocation.GetRow()
-      && facing_location.GetCol() == kMarketLocation.GetCol()) {
-      ExecuteMarketInteraction(event);
-      return;
-    }
+void IslandApp::HandleAction(PlayerAction action) {
+  // What the player faces is looked at first, as the key they pick up is
+  // gone from the map once the session has handled the action.
+  const island::Engine& engine = session_.GetEngine();
+  const SessionState last_state = session_.GetState();
+  const Location location = engine.GetFacingLocation(session_.GetFacing());
+  const Tile tile = engine.GetTileType(location);
+  const size_t num_inventory_items = engine.GetPlayer().inventory_.size();
+  session_.HandleAction(action);
 
-    if (facing_tile == island::kNpc) {
-      ExecuteNpcInteraction(facing_location);
-      return;
-    }
+  switch (session_.GetState()) {
+    case SessionState::kPlaying:
+      state_ = GameState::kPlaying;
+      battle_texts_.clear();
+      break;
 
-    state_ = GameState::kDisplayingText;
-    if (display_text_files_.count(facing_tile)) {
-      if (facing_tile == Tile::kKey) {
-        engine_.SetKey(true);
-        engine_.AddInventoryItem(engine_.GetItem("key"));
-        engine_.RemoveItem("key");
-        engine_.SetTile(facing_location, Tile::kTree);
+    case SessionState::kInventory:
+      state_ = GameState::kInventory;
+      break;
+
+    case SessionState::kTalking:
+      if (last_state != SessionState::kTalking) {
+        ShowText(GetInteractionText(location, tile, num_inventory_items));
       }
+      state_ = GameState::kDisplayingText;
+      break;
 
-      if (facing_tile == island::kPuddle) {
-        engine_.AddMoney(kPuddleMoney);
+    case SessionState::kMarket: {
+      island::Item item("", "", "");
+      if (last_state != SessionState::kMarket) {
+        ShowText(GetMarketText());
+      } else if (action == PlayerAction::kAccept
+                 && session_.GetItemForSale(&item)) {
+        ShowText(GetTextFromFile("assets/npc/dialogue/Boi_no_money.txt"));
       }
-      file_path = display_text_files_[facing_tile];
-      display_text_ = GetTextFromFile(file_path);
-    } else {
-      state_ = GameState::kPlaying;
+      state_ = GameState::kMarket;
+      break;
     }
+
+    case SessionState::kBattle:
+      if (last_state != SessionState::kBattle) {
+        StartBattle();
+      }
+      break;
   }
 }
 
-void IslandApp::ExecuteMarketInteraction(const KeyEvent& event) {
-  if (npc_text_files_["Boi"] == "assets/npc/dialogue/Boi_no_items.txt") {
-    return;
+std::string IslandApp::GetInteractionText(const Location& location,
+                                          Tile tile,
+                                          size_t num_inventory_items) {
+  if (tile != island::kNpc) {
+    return display_text_files_.count(tile)
+           ? GetTextFromFile(display_text_files_[tile]) : "";
   }
-  Npc npc = engine_.GetNpcAtLocation(kMarketLocation);
-  UpdateActiveNpcSprites(npc);
 
-  display_text_ = GetTextFromFile(npc_text_files_["Boi"]);
-  if(event.getCode() == KeyEvent::KEY_y) {
-    BuyItem(0);
-  } else {
-    if (state_ == GameState::kMarket) {
-      state_ = GameState::kPlaying;
-      return;
-    } else {
-      state_ = GameState::kMarket;
-    }
+  const island::Engine& engine = session_.GetEngine();
+  const Npc npc = engine.GetNpcAtLocation(location);
+  if (npc.name_ == "Klutz" && engine.GetKey()) {
+    // Klutz took his key back if the player was still carrying it.
+    return GetTextFromFile(
+        engine.GetPlayer().inventory_.size() < num_inventory_items
+        ? "assets/npc/dialogue/Klutz_during_key.txt"
+        : "assets/npc/dialogue/Klutz_after_key.txt");
   }
+  return GetTextFromFile(npc_text_files_[npc.name_]);
 }
 
-void IslandApp::BuyItem(size_t item_index) {
-  bool has_enough_money = engine_.GetPlayer().money_ >= kItemPrice;
-  if (has_enough_money && engine_.GetNumItems() > item_index) {
-    ChangeMarketDialogue();
-    engine_.AddInventoryItem(engine_.GetItemFromIndex(item_index));
-    engine_.RemoveItem(engine_.GetItemFromIndex(item_index).name_);
-    engine_.RemoveMoney(kItemPrice);
-    state_ = GameState::kPlaying;
-  } else {
-    display_text_ = GetTextFromFile
-        ("assets/npc/dialogue/Boi_no_money.txt");
+std::string IslandApp::GetMarketText() const {
+  island::Item item("", "", "");
+  if (session_.GetItemForSale(&item)) {
+    const auto file_path = market_text_files_.find(item.name_);
+    if (file_path != market_text_files_.end()) {
+      return GetTextFromFile(file_path->second);
+    }
   }
+  return GetTextFromFile("assets/npc/dialogue/Boi_no_items.txt");
 }
 
-void IslandApp::ChangeMarketDialogue() {
-  string dialogue = npc_text_files_["Boi"];
-  if (dialogue == "assets/npc/dialogue/Boi.txt") {
-    dialogue = "assets/npc/dialogue/Boi_shoes.txt";
-  } else if (dialogue == "assets/npc/dialogue/Boi_shoes.txt") {
-    dialogue = "assets/npc/dialogue/Boi_sword.txt";
-  } else if (dialogue == "assets/npc/dialogue/Boi_sword.txt") {
-    dialogue = "assets/npc/dialogue/Boi_shield.txt";
-  } else if (dialogue == "assets/npc/dialogue/Boi_shield.txt") {
-    dialogue = "assets/npc/dialogue/Boi_heart.txt";
-  } else if (dialogue == "assets/npc/dialogue/Boi_heart.txt") {
-    dialogue = "assets/npc/dialogue/Boi_no_items.txt";
+void IslandApp::StartBattle() {
+  WaitForBattleAudio();
+  battle_texts_.clear();
+  battle_texts_.push_back(session_.GetBattleNpc().name_
+                          + " wants to battle!");
+  // A faster npc has already made the first move.
+  if (session_.GetNumNpcTurns() > 0) {
+    battle_texts_.push_back(GetTextFromFile("assets/battle/npc_attack.txt"));
   }
-  npc_text_files_["Boi"] = dialogue;
+  ShowNextBattleText();
 }
 
-void IslandApp::ExecuteNpcInteraction(const island::Location& location) {
-  Npc npc = engine_.GetNpcAtLocation(location);
-
-  if (npc_text_files_["Klutz"] == "assets/npc/dialogue/Klutz_during_key.txt") {
-    npc_text_files_["Klutz"] = "assets/npc/dialogue/Klutz_after_key.txt";
-  }
-
-  UpdateActiveNpcSprites(npc);
-  display_text_ = GetTextFromFile(npc_text_files_[npc.name_]);
-
-  if (state_ == GameState::kDisplayingText) {
-    state_ = GameState::kPlaying;
-  } else {
-    state_ = GameState::kDisplayingText;
-  }
-
-  if (npc.is_combatable_) {
-    should_start_battle_ = true;
-    battle_npc_ = npc;
-    player_hp_ = engine_.GetPlayer().statistics_.hit_points_ * hp_multiplier_;
-    npc_hp_ = npc.statistics_.hit_points_;
-    player_battle_move_ = BattleMove::kAttack;
-
-    is_player_turn_ = engine_.GetPlayer().statistics_.speed_ * speed_multiplier_
-                        >= npc.statistics_.speed_;
+void IslandApp::ShowNextBattleText() {
+  if (battle_texts_.empty()) {
+    ShowText(GetTextFromFile("assets/battle/player_move.txt"));
+    state_ = GameState::kBattle;
+    return;
   }
+  ShowText(battle_texts_.front());
+  battle_texts_.pop_front();
+  state_ = GameState::kBattleText;
 }
 
-void IslandApp::UpdateActiveNpcSprites(const Npc& npc) {
-  Direction facing_direction;
-  switch (prev_direction_) {
-    case Direction::kUp :
-      facing_direction = Direction::kDown;
-      break;
-    case Direction::kDown :
-      facing_direction = Direction::kUp;
-      break;
-    case Direction::kLeft :
-      facing_direction = Direction::kRight;
-      break;
-    case Direction::kRight :
-      facing_direction = Direction::kLeft;
-      break;
-  }
-  active_npc_sprite_files_[npc.name_] = facing_direction;
+void IslandApp::ShowText(const string& text) {
+  display_text_ = text;
+  char_counter_ = 0;
 }
 
-std::string IslandApp::GetTextFromFile(const string& file_path) {
-  if (engine_.GetKey() && file_path == "assets/npc/dialogue/Klutz.txt") {
-    engine_.AddMoney(kKeyMoney);
-    engine_.RemoveInventoryItem("key");
-    npc_text_files_["Klutz"] = "assets/npc/dialogue/Klutz_during_key.txt";
+std::string IslandApp::GetTextFromFile(const string& file_path) const {
+  island::ResourceSpan resource;
+  if (resources_.Find(file_path, &resource)) {
+    return std::string(reinterpret_cast<const char*>(resource.data_),
+                       resource.size_);
   }
 
   std::ifstream file(file_path);
@@ -7,38 +7,53 @@
 #include <cinder/audio/Voice.h>
 #include <cinder/gl/gl.h>
 
+#include <island/audio_mixer.h>
+#include <island/autosaver.h>
+#include <island/battle_prefetch.h>
+#include <island/camera.h>
 #include <island/engine.h>
 #include <island/direction.h>
+#include <island/game_session.h>
 #include <island/location.h>
 #include <island/map.h>
 #include <island/item.h>
-
+#include <island/job_system.h>
+#include <island/pcm_cache.h>
+#include <island/resource_pack.h>
+#include <island/save_slots.h>
+#include <island/spsc_queue.h>
+#include <island/triple_buffer.h>
+#include <island/world.h>
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
 #include <string>
 #include <fstream>
+#include <thread>
+
+#include "audio_player.h"
+#include "frame_recorder.h"
+#include "game_state.h"
+#include "render_snapshot.h"
+#include "scene_renderer.h"
 
 namespace islandapp {
 
-/** Enum used to represents the game's current state. */
-enum class GameState {
-  kPlaying,
-  kInventory,
-  kMarket,
-  kBattle,
-  kBattleText,
-  kDisplayingText
-};
+/** The number of key presses that can wait for the simulation thread. */
+const size_t kInputQueueSize = 64;
 
-enum class BattleMove {
-  kAttack,
-  kHeal,
-  kRun
+/** Every sound the game plays, as the audio mixer knows them. */
+enum Sound : island::SoundId {
+  kBackgroundMusic,
+  kBattleMusic,
+  kTextSound
 };
 
 /** The class that interacts with cinder to run the game. */
 class IslandApp : public cinder::app::App {
 public:
-  /** The number of movement sprites for the player. */
-  const size_t kNumSprites = 4;
 
   /** The screen size in terms of tile size. */
   const size_t kScreenSize = 40;
@@ -52,275 +67,199 @@ public:
   /** The speed of the player character. */
   const size_t kSpeed = 50;
 
-  /** The divider for how much of the total screen the user should view. */
-  const size_t kScreenDivider = 2;
-
-  /** The font size of the text to be displayed to the user. */
-  const size_t kFontSize = 30;
-
-  /** The width of the text box to be displayed. */
-  const size_t kTextBoxWidth = 800;
-
-  /** The height of the text box to be displayed. */
-  const size_t kTextBoxHeight = 150;
-
   /** The max volume for all the audio files in the game. */
   const size_t kMaxVolume = 1;
 
   /** The speed at which characters are displayed in the text box. */
   const size_t kCharSpeed = 1;
 
-  /** The number of pixels the text is offset from the textbox. */
-  const size_t kTextOffset = 10;
-
-  /** The maximum number of items the player can hold. */
-  const size_t kMaxInventorySize = 5;
-
-  /** The price of an item on the market. */
-  const size_t kItemPrice = 5000;
+  /** The max volume for the battle audio file in the game. */
+  const float kMaxBattleVolume = 0.5;
 
-  /** The reward of money one gets for completing the key quest. */
-  const size_t kKeyMoney = 8800;
+  /** The furthest the camera can zoom out, in steps from full size. */
+  const size_t kMaxZoomSteps = 3;
 
-  /** Money awarded to the player every time they interact with the puddle. */
-  const size_t kPuddleMoney = 100;
+  /** The number of times per second the simulation thread runs. */
+  const size_t kTicksPerSecond = 60;
 
   /**
-   * The ratio of attack over defense in calculations in battle.
-   * A higher value would mean all characters deal more damage.
+   * How near the player has to be to an npc they can battle, in tiles, for
+   * the battle's assets to be loaded ahead of time.
    */
-  const double kAttackConstant = 2.0;
+  const size_t kBattlePrefetchTiles = 5;
 
-  /**
-   * The constant used to calculate how much the characters heal in battle.
-   * A lower value would mean all characters heal more health.
-   */
-  const double kHealConstant = 4.0;
+  /** The number of sounds that can play at once. */
+  const size_t kNumVoices = 4;
 
-  /** The statistical bonus the player gets from getting items. */
-  const double kStatMultiplier = 1.5;
+  /** The time the music takes to fade from one track to another. */
+  const double kCrossfadeSeconds = 1.0;
 
-  /** Determines how far down the text box is placed, higher is further down. */
-  const double kTextLocMultiplier = 2.0;
+  /** The least time between two text sounds, however fast text appears. */
+  const double kTextSoundInterval = 0.08;
 
-  /** The multiplier for how many pixels the camera translates the view. */
-  const double kTranslationMultiplier = 40.0;
+  /** The number of bytes in a megabyte. */
+  const size_t kBytesPerMegabyte = 1024 * 1024;
 
-  /** The max volume for the battle audio file in the game. */
-  const float kMaxBattleVolume = 0.5;
+  /** Every asset in one file, written by the pack-resources tool. */
+  const std::string kResourcePackPath = "assets/resources.pack";
+
+  /** The sound effects already decoded, written by the game itself. */
+  const std::string kPcmCachePath = "assets/sfx.pcmcache";
+
+  /** The tiles of the island's map. */
+  const std::string kTilesetPath = "assets/map_tileset.txt";
+
+  /** The file the game is saved to. */
+  const std::string kSavePath = "assets/saved_game.json";
 
-  /** The location on the map where the market is. */
-  const island::Location kMarketLocation = {36, 36};
+  /** The time between appending the game's changes to the save journal. */
+  const size_t kJournalFlushSeconds = 1;
+
+  /** The time between full saves made without the player asking. */
+  const size_t kAutosaveSeconds = 60;
+
+  /** The number of changes in the save journal which forces a full save. */
+  const size_t kMaxJournalRecords = 4096;
 
   /** The constructor for the game. */
   IslandApp();
 
-  /** The setup function, called before the game is launched. */
+  /**
+   * The setup function, called before the game is launched.
+   * Starts the simulation thread.
+   */
   void setup() override;
 
-  /** The update function, called roughly every frame to
-   * update what happens in the game, and what the user sees.
-   */
-  void update() override;
+  /** The cleanup function, called when the game quits. */
+  void cleanup() override;
 
   /**
    * The graphic related function, called whenever a change is to be made
-   * to the graphics that the user sees.
+   * to the graphics that the user sees. Only reads the latest snapshot
+   * published by the simulation thread, and skips drawing when the
+   * snapshot would draw the same frame as last time.
    */
   void draw() override;
 
   /**
    * The key bind function, called to tell the game what to do
-   * when a certain key is pressed on the keyboard.
+   * when a certain key is pressed on the keyboard. The key is handed to the
+   * simulation thread, which handles it at the start of its next tick.
    */
   void keyDown(cinder::app::KeyEvent) override;
 
 private:
   /**
-   * Initializes the audio objects that play through the game.
+   * The loop run by the simulation thread, which handles the queued keys,
+   * updates the game and publishes a snapshot at a fixed rate.
    */
-  void InitializeAudio();
+  void RunSimulation();
 
-  /**
-   * Initializes all the items that exist in the game.
-   */
-  void InitializeItems();
-
-  /**
-   * Initializes the file paths used to relay text on the screen.
-   */
-  void InitializeDisplayFilePaths();
-
-  /**
-   * Initializes the npc file paths used to relay the npcs' dialogue.
-   */
-   void InitializeNpcTextFilePaths();
-
-  /**
-   * Initializes the npc sprite file paths to display the npcs on the screen.
-   */
-  void InitializeNpcSpriteFilePaths();
-
-  /**
-   * Initializes the battle npc sprite file paths to
-   * display the npcs in battle on the screen.
-   */
-  void InitializeNpcBattleSpriteFilePaths();
-
-  /**
-   * Initializes the sprites to be drawn on the screen.
-   */
-  void InitializeActiveNpcSpriteFiles();
-
-  /**
-   * Adds the npc sprites to the map to be used to draw the sprites.
-   *
-   * @param name the name of the npc
-   */
-  void AddNpcSprites(const std::string& name);
-
-  /**
-   * Draws the battle scene whenever a battle is initiated.
-   */
-  void DrawBattle();
-
-  /**
-   * Draws the Hitpoint bars for both the player and the npc.
-   */
-  void DrawHpBars();
-
-  /**
-   * Draws the text relaying information to the user in the battle.
-   */
-  void DrawBattleText();
-
-  /**
-   * Draws the player in battle, facing the opponent away from the user.
-   */
-  void DrawBattlePlayer();
-
-  /**
-   * Draws the opponent in battle, facing the user and the player.
-   */
-  void DrawBattleOpponent();
-
-  /**
-   * Draws the map in the background of the game.
-   */
-  void DrawMap() const;
-
-  /**
-   * Draws the player on the map.
-   */
-  void DrawPlayer() const;
+  /** Updates what happens in the game, called once every tick. */
+  void Simulate();
 
   /**
-   * Draws the npcs throughout the map.
-   * Non const since it accesses engine's list of npcs.
+   * Loads the battle music in the background once the player comes near an
+   * npc they can battle, and drops it once the battle is over or the player
+   * walks away.
    */
-  void DrawNpcs();
+  void PrefetchBattle();
 
   /**
-   * Draws the text box that displays the player's interaction text.
-   * Non const since the typewriter effect used changes char_counter_.
+   * Finishes loading the battle music, waiting for it if it is still
+   * loading, so it is ready to play.
    */
-  void DrawTextBox();
+  void WaitForBattleAudio();
 
   /**
-   * Draws the inventory which displays the player's items.
+   * Reveals the next characters of the text box, playing the text sound.
    */
-  void DrawInventory() const;
+  void AdvanceText();
 
   /**
-   * Draws the items in the inventory.
+   * Sets the music for the game's state and plays whatever the audio mixer
+   * decided on since the last tick.
    */
-  void DrawItems() const;
+  void UpdateAudio();
 
   /**
-   * Draws the money the player currently has in the inventory menu.
+   * Copies what the draw functions need into the back snapshot and
+   * publishes it.
    */
-  void DrawMoney() const;
+  void PublishSnapshot();
 
   /**
-   * Draws the description of the inventory of the player.
+   * Initializes the audio objects that play through the game.
    */
-  void DrawInventoryDescription() const;
+  void InitializeAudio();
 
   /**
-   * Called whenever the user is shown a text box.
+   * Opens an asset, from the resource pack if it is there, without copying
+   * it, and from the assets directory otherwise.
    *
-   * @tparam C The typename for the color of the text
-   * @param text the text to be displayed
-   * @param color the color of the text
-   * @param size the size of the text
-   * @param loc the location on the screen where the text is to be displayed
+   * @param file_name the asset's path relative to the assets directory
+   * @return the asset's data
    */
-  template <typename C>
-  void PrintText(const std::string& text, const C& color,
-                  const cinder::ivec2& size, const cinder::vec2& loc) const;
+  cinder::DataSourceRef LoadAsset(const std::string& file_name) const;
 
   /**
-   * Translates the outputted image and text.
+   * Opens a music asset to be streamed, without decoding any of it.
    *
-   * @param is_up true if the translation is upward, false otherwise
+   * @param file_name the asset's path relative to the assets directory
+   * @return the music file, set to output at the audio context's rate
    */
-  void Translate(bool is_up) const;
+  cinder::audio::SourceFileRef LoadMusic(const std::string& file_name) const;
 
   /**
-   * Determines what the player character should look like
-   * when they move in a particular direction.
+   * Loads a sound effect's samples from the PCM cache, decoding it only if
+   * the cache does not have it.
    *
-   * @return the TextureRef representing the image of the player character
+   * @param file_name the asset's path relative to the assets directory
+   * @param cache the cache to write, which the samples are added to
+   * @param is_cached set to false if the sound effect had to be decoded
+   * @return the samples, at the audio context's sample rate
    */
-  cinder::gl::TextureRef GetPlayerImage() const;
+  cinder::audio::BufferRef LoadSfx(const std::string& file_name,
+                                   island::PcmCacheWriter* cache,
+                                   bool* is_cached) const;
 
   /**
-   * Gets the direction image path to be displayed for the
-   * player character when the user moves down.
-   *
-   * @return the string containing the correct image path to be displayed
+   * Initializes the file paths used to relay text on the screen.
    */
-  std::string GetDownImagePath() const;
+  void InitializeDisplayFilePaths();
 
   /**
-   * Gets the direction image path to be displayed for the
-   * player character when the user moves up.
-   *
-   * @return the string containing the correct image path to be displayed
+   * Initializes the npc file paths used to relay the npcs' dialogue, and
+   * the market's for each item it sells.
    */
-  std::string GetUpImagePath() const;
+   void InitializeNpcTextFilePaths();
 
-  /**
-   * Gets the direction image path to be displayed for the
-   * player character when the user moves left.
-   *
-   * @return the string containing the correct image path to be displayed
-   */
-  std::string GetLeftImagePath() const;
+  /** Draws the last drawn frame to the window. */
+  void PresentFrame() const;
 
   /**
-   * Gets the direction image path to be displayed for the
-   * player character when the user moves right.
+   * Saves the game to a slot. The save is captured at once and written in
+   * the background.
    *
-   * @return the string containing the correct image path to be displayed
+   * @param slot the slot
    */
-  std::string GetRightImagePath() const;
+  void SaveToSlot(size_t slot);
 
-  /**
-   * Returns the text to be displayed during battles.
-   */
-  std::string GetBattleText();
+  /** Lists the saves in the slots, from the slots' index alone. */
+  void PrintSaveSlots() const;
 
   /**
-   * Updates the engine and all the player npc interactions during battle.
+   * Prints how many frames were skipped, the texture memory report and what
+   * the audio and the autosaver cost, when asked with --print_stats.
    */
-  void UpdateBattle();
+  void PrintStats() const;
 
   /**
-   * Updates the player's statistics multipliers based on which items
-   * the playe has in their inventory.
+   * Zooms the camera in or out by one step.
+   *
+   * @param is_in true to zoom in, false to zoom out
    */
-  void UpdateStatisticMultipliers();
+  void ZoomCamera(bool is_in);
 
   /**
    * Handles the movement of the camera with respect to the player.
@@ -329,52 +268,28 @@ private:
   void MovePlayerCamera();
 
   /**
-   * Gets the image path for the NPC according to where the NPC is facing.
-   *
-   * @param name the name of the npc
-   * @param direction the direction the npc is facing
-   * @return the file path containing the image of the npc
-   */
-  std::string GetActiveNpcImagePath
-      (const std::string& name, const island::Direction& direction);
-
-  /**
-   * Handler for the player's movement according to the user's input
-   *
-   * @param event the user's input
-   */
-  void MovementKey(const cinder::app::KeyEvent& event);
-
-  /**
-   * Handler for the player's interaction with the map,
+   * Handler for the player's movement and interaction with the map,
    * or the npcs, or when the player tries to access the
    * inventory etc. according to the user's input.
    *
-   * @param event the user's input
+   * @param action the action the key the user pressed stands for
    */
-  void InteractionKey(const cinder::app::KeyEvent& event);
+  void ActionKey(island::PlayerAction action);
 
   /**
    * Handler for the player's actions during battle, like attacking,
    * healing, running etc. according to the user's input.
    *
-   * @param event the user's input
+   * @param action the action the key the user pressed stands for
    */
-  void BattleKey(const cinder::app::KeyEvent& event);
+  void BattleKey(island::PlayerAction action);
 
   /**
-   * Executes a battle step whenever the player battles the npc.
+   * Handles a key press on the simulation thread.
    *
-   * @param event the user's input
+   * @param key_code the code of the key the user pressed
    */
-  void ExecuteBattleStep(const cinder::app::KeyEvent& event);
-
-  /**
-   * Executes the player's moves in battle according to the user's input.
-   *
-   * @param event the user's input
-   */
-  void ExecutePlayerBattleMove(const cinder::app::KeyEvent& event);
+  void HandleKey(int key_code);
 
   /**
    * Changes the volume of the game, mutes or un-mutes all the audios.
@@ -390,46 +305,47 @@ private:
   void HandleMovement(const island::Direction& direction);
 
   /**
-   * Handles the player's interactions with the map, displays text on the
-   * screen accordingly.
+   * Hands an action to the game session, then shows the text of whatever
+   * the action started: a dialogue, the market or a battle.
    *
-   * @param event The key last pressed on the keyboard
+   * @param action the action
    */
-  void ExecutePlayerInteractions(const cinder::app::KeyEvent& event);
+  void HandleAction(island::PlayerAction action);
 
   /**
-   * Handles the player's interactions with the market, where the player
-   * can but items depending on their money.
+   * Gets the text of what the player interacted with.
    *
-   * @param event The key last pressed on the keyboard
+   * @param location the location the player faced
+   * @param tile the tile at the location before the interaction
+   * @param num_inventory_items the size of the inventory before it
+   * @return the text, or an empty one if there is nothing to say
    */
-  void ExecuteMarketInteraction(const cinder::app::KeyEvent& event);
+  std::string GetInteractionText(const island::Location& location,
+                                 island::Tile tile,
+                                 size_t num_inventory_items);
 
   /**
-   * Buys the item if the player decides
+   * Gets what the market's npc says about the next item on sale.
    *
-   * @param item_index the index of the item in the items list
+   * @return the text
    */
-  void BuyItem(size_t item_index);
+  std::string GetMarketText() const;
 
-  /**
-   * Changes the dialogue for the npc who controls the market
-   */
-  void ChangeMarketDialogue();
+  /** Starts showing a battle which the game session has started. */
+  void StartBattle();
 
   /**
-   * Handles the player's interactions with any npc, be it
-   * talking or initiating a battle.
+   * Shows the next text of the battle, or asks for the player's move once
+   * every text has been shown.
    */
-  void ExecuteNpcInteraction(const island::Location& location);
+  void ShowNextBattleText();
 
   /**
-   * Updates the active npc sprites when the player
-   * interacts with a particular npc.
+   * Shows a text in the text box, one character at a time.
    *
-   * @param npc the npc the player interacted with
+   * @param text the text
    */
-  void UpdateActiveNpcSprites(const island::Npc& npc);
+  void ShowText(const std::string& text);
 
   /**
    * Retrieves the text from a file.
@@ -437,37 +353,92 @@ private:
    * @param file_path the path to the file to be read from
    * @return the text stored in the file
    */
-  std::string GetTextFromFile(const std::string& file_path);
+  std::string GetTextFromFile(const std::string& file_path) const;
 
-  /** Represents the current state of the game. */
+  /** Represents what the screen shows of the game session's state. */
   GameState state_;
 
-  /** The move the npc chooses in battle. */
-  BattleMove npc_battle_move_;
-
-  /** The move the player chooses in battle. */
-  BattleMove player_battle_move_;
-
   /** The time elapsed since the update function has been called. */
   std::chrono::time_point<std::chrono::system_clock> last_time_;
 
-  /** The handler for the background audio. */
-  cinder::audio::VoiceRef background_audio_;
+  /** Decides which sounds play on which voices, and how loud. */
+  island::AudioMixer mixer_{kNumVoices, kCrossfadeSeconds,
+                            kTextSoundInterval};
+
+  /** Plays what the mixer decides. Has the battle music only near a battle. */
+  AudioPlayer audio_player_{kNumVoices};
+
+  /** The battle audio being loaded in the background. */
+  std::future<cinder::audio::SourceFileRef> battle_audio_loading_;
+
+  /** Picks the npc whose battle assets are loaded. */
+  island::BattlePrefetch battle_prefetch_;
+
+  /** The map, npcs and items the game starts out with. */
+  std::shared_ptr<const island::World> world_;
+
+  /** The game and the rules it plays by, which the keys are handed to. */
+  island::GameSession session_;
 
-  /** The handler for the background audio. */
-  cinder::audio::VoiceRef battle_audio_;
+  /** Runs the engine's per tick systems alongside each other. */
+  island::JobSystem job_system_;
 
-  /** The handler for the text displaying audio. */
-  cinder::audio::VoiceRef text_audio_;
+  /** Writes the saves captured on the simulation thread in the background. */
+  island::Autosaver autosaver_{kSavePath,
+                               std::chrono::seconds(kJournalFlushSeconds),
+                               std::chrono::seconds(kAutosaveSeconds),
+                               kMaxJournalRecords};
 
-  /** The game engine responsible for running the game. */
-  island::Engine engine_;
+  /** Runs the game logic at a fixed rate, apart from the drawing. */
+  std::thread simulation_thread_;
 
-  /** The previous direction that the user moved in. */
-  island::Direction prev_direction_;
+  /** Determines whether the simulation thread should keep running. */
+  std::atomic<bool> is_simulating_;
 
-  /** The location object to offset the rendering by, illusion of a camera. */
-  island::Location camera_;
+  /** The key presses waiting to be handled by the simulation thread. */
+  island::SpscQueue<int, kInputQueueSize> input_queue_;
+
+  /** Hands the game state from the simulation thread to draw. */
+  island::TripleBuffer<RenderSnapshot> snapshots_;
+
+  /** The last snapshot published with a new version. */
+  RenderSnapshot last_snapshot_;
+
+  /** The last drawn frame, presented again when nothing changed. */
+  cinder::gl::FboRef frame_fbo_;
+
+  /** The version of the snapshot drawn into frame_fbo_. */
+  size_t drawn_version_;
+
+  /** The number of frames presented. */
+  size_t num_frames_;
+
+  /** The number of frames presented without drawing anything new. */
+  size_t num_skipped_frames_;
+
+  /** Records every presented frame, or nullptr when not recording. */
+  std::unique_ptr<FrameRecorder> recorder_;
+
+  /** The width of the window, kept for the simulation thread. */
+  std::atomic<int> window_width_;
+
+  /** The height of the window, kept for the simulation thread. */
+  std::atomic<int> window_height_;
+
+  /** Tracks the part of the map on screen, offsetting the rendering. */
+  island::Camera camera_;
+
+  /** The number of steps the camera is zoomed out by, from full size. */
+  size_t num_zoom_steps_;
+
+  /** Every asset of the game, mapped into memory if it has been built. */
+  island::ResourcePack resources_;
+
+  /** The decoded sound effects of the last launch, mapped into memory. */
+  island::PcmCache pcm_cache_;
+
+  /** Draws the snapshots, owned by the drawing thread. */
+  SceneRenderer scene_renderer_;
 
   /**
    * Stores the paths to the display files for the texts with the
@@ -482,46 +453,16 @@ private:
   std::unordered_map<std::string, std::string> npc_text_files_;
 
   /**
-   * Stores the npc sprites with the name of the npc as the key and
-   * the file path as the corresponding value, displayed in the overworld.
-   */
-  std::unordered_map<std::string, std::string> npc_sprite_files_;
-
-  /**
-   * Stores the npc battle sprites with the name of the npc as the key and
-   * the file path as the corresponding value, displayed in battle.
+   * Stores the market's dialogue with the name of the item on sale as the
+   * key and the file path as the corresponding value.
    */
-  std::unordered_map<std::string, std::string> npc_battle_sprite_files_;
-
-  /**
-   * The npc sprites which are drawn on the screen, mapped with the npc name
-   * as the key and the direction in which they are facing as the value.
-   */
-  std::unordered_map<std::string, island::Direction> active_npc_sprite_files_;
+  std::unordered_map<std::string, std::string> market_text_files_;
 
   /** The text to be displayed when the player interacts with the map. */
   std::string display_text_;
 
-  /** The name of the npc the player is currently battling. */
-  island::Npc battle_npc_;
-
-  /** The stat bonus to hp for the player. */
-  double hp_multiplier_;
-
-  /** The stat bonus to attack for the player. */
-  double attack_multiplier_;
-
-  /** The stat bonus to defense for the player. */
-  double defense_multiplier_;
-
-  /** The stat bonus to speed for the player. */
-  double speed_multiplier_;
-
-  /** The hitpoints for the player, battle ends when this reaches 0. */
-  double player_hp_;
-
-  /** The hitpoints for the npc, battle ends when this reaches 0. */
-  double npc_hp_;
+  /** The texts of the battle still to be shown, oldest first. */
+  std::deque<std::string> battle_texts_;
 
   /** The speed or delay of the game, i.e. a lesser value is faster. */
   size_t speed_;
@@ -529,32 +470,23 @@ private:
   /** Keeps track of the characters to be displayed in a text message. */
   size_t char_counter_;
 
-  /** Keeps track of the number of turns in the battle. */
-  size_t battle_turn_counter_;
-
   /**
    * The number of directional commands
    * since the direction was last changed changed.
    */
   size_t last_changed_direction_;
 
-  /**
-   * Determines whether the user changed their direction
-   * after the previous directional command.
-   */
-  bool is_changed_direction_;
+  /** Determines whether the minimap is drawn over the overworld. */
+  bool is_minimap_shown_;
 
-  /**
-   * Determines whether the game should start a battle sequence
-   * based on whether the last npc the player encountered was combatable.
-   */
-  bool should_start_battle_;
+  /** The numbered saves the player makes and loads with --slot. */
+  island::SaveSlots save_slots_;
 
-  /**
-   * Determines whether it's the player's or the npc's turn to move in
-   * battle, depending on their respective speed stats.
-   */
-  bool is_player_turn_;
+  /** The save to a slot being written in the background. */
+  std::future<bool> slot_saving_;
+
+  /** The time played before the game was loaded from a slot, in seconds. */
+  uint64_t loaded_playtime_seconds_;
 };
 
 }  // namespace islandapp
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "music_stream.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace islandapp {
+
+namespace {
+
+/** How long the decoding thread sleeps while the ring is full. */
+const std::chrono::milliseconds kDecodeWait(10);
+
+}  // namespace
+
+const size_t MusicStream::kRingFrames;
+const size_t MusicStream::kChunkFrames;
+
+MusicStream::MusicStream(const cinder::audio::SourceFileRef& source)
+    : source_{source},
+      ring_{kRingFrames, source->getNumChannels()},
+      chunk_{kChunkFrames, source->getNumChannels()},
+      interleaved_(kChunkFrames * source->getNumChannels()),
+      is_looping_{true},
+      is_decoding_{true},
+      voice_{cinder::audio::Voice::create(
+          [this](cinder::audio::Buffer* buffer, size_t) { Process(buffer); },
+          cinder::audio::Voice::Options().channels(
+              source->getNumChannels()))},
+      decoder_{&MusicStream::Decode, this} {}
+
+MusicStream::~MusicStream() {
+  // The voice is stopped first so the callback no longer reads the ring.
+  voice_->stop();
+  voice_.reset();
+  is_decoding_ = false;
+  if (decoder_.joinable()) {
+    decoder_.join();
+  }
+}
+
+void MusicStream::SetLooping(bool is_looping) {
+  is_looping_ = is_looping;
+}
+
+double MusicStream::GetDuration() const {
+  return static_cast<double>(source_->getNumFrames())
+         / static_cast<double>(source_->getSampleRate());
+}
+
+size_t MusicStream::GetNumResidentBytes() const {
+  return (ring_.GetCapacity() * ring_.GetNumChannels()
+          + chunk_.getNumFrames() * chunk_.getNumChannels()
+          + interleaved_.size() + output_.size()) * sizeof(float);
+}
+
+void MusicStream::Decode() {
+  const size_t num_channels = ring_.GetNumChannels();
+  while (is_decoding_) {
+    if (ring_.GetNumFramesFree() < kChunkFrames) {
+      std::this_thread::sleep_for(kDecodeWait);
+      continue;
+    }
+
+    const size_t num_frames = source_->read(&chunk_);
+    if (num_frames == 0) {
+      if (is_looping_) {
+        source_->seek(0);
+      } else {
+        std::this_thread::sleep_for(kDecodeWait);
+      }
+      continue;
+    }
+
+    for (size_t channel = 0; channel < num_channels; channel++) {
+      const float* samples = chunk_.getChannel(channel);
+      for (size_t frame = 0; frame < num_frames; frame++) {
+        interleaved_[frame * num_channels + channel] = samples[frame];
+      }
+    }
+    ring_.Write(interleaved_.data(), num_frames);
+  }
+}
+
+void MusicStream::Process(cinder::audio::Buffer* buffer) {
+  const size_t num_channels = ring_.GetNumChannels();
+  const size_t num_frames = buffer->getNumFrames();
+  if (output_.size() < num_frames * num_channels) {
+    // Only grows on the first callback, the block size never changes.
+    output_.resize(num_frames * num_channels);
+  }
+  ring_.Read(output_.data(), num_frames);
+
+  for (size_t channel = 0; channel < buffer->getNumChannels(); channel++) {
+    // A mono file plays the same samples on every channel.
+    const size_t source_channel = std::min(channel, num_channels - 1);
+    float* samples = buffer->getChannel(channel);
+    for (size_t frame = 0; frame < num_frames; frame++) {
+      samples[frame] = output_[frame * num_channels + source_channel];
+    }
+  }
+}
+
+}  // namespace islandapp
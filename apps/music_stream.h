@@ -0,0 +1,126 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_MUSICSTREAM_H_
+#define FINALPROJECT_APPS_MUSICSTREAM_H_
+
+#include <cinder/audio/Voice.h>
+#include <cinder/audio/audio.h>
+
+#include <island/pcm_ring.h>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace islandapp {
+
+/**
+ * Plays a music file while decoding it, instead of decoding all of it up
+ * front. A background thread decodes a chunk at a time into a small ring,
+ * and the voice's audio callback only copies out of the ring, so only a
+ * fraction of a second of the track is ever held decoded.
+ */
+class MusicStream {
+ public:
+  /** The number of frames the ring holds, under a second of music. */
+  static const size_t kRingFrames = 32768;
+
+  /** The number of frames decoded at a time. */
+  static const size_t kChunkFrames = 4096;
+
+  /**
+   * Creates the voice, and starts decoding a music file into the ring.
+   *
+   * @param source the music file, set to output at the audio context's
+   * sample rate
+   */
+  explicit MusicStream(const cinder::audio::SourceFileRef& source);
+
+  /** Stops the voice and the decoding thread. */
+  ~MusicStream();
+
+  MusicStream(const MusicStream&) = delete;
+  MusicStream& operator=(const MusicStream&) = delete;
+
+  /**
+   * Sets whether the music starts over once it reaches its end.
+   *
+   * @param is_looping true to loop the music
+   */
+  void SetLooping(bool is_looping);
+
+  /**
+   * Accessor function for the voice playing the ring.
+   *
+   * @return the voice
+   */
+  inline const cinder::audio::VoiceRef& GetVoice() const {
+    return voice_;
+  }
+
+  /**
+   * Gets the length of the music.
+   *
+   * @return the length, in seconds
+   */
+  double GetDuration() const;
+
+  /**
+   * Counts the memory holding decoded music.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumResidentBytes() const;
+
+  /**
+   * Accessor function for the ring the music is decoded into.
+   *
+   * @return the ring, whose counters report the underruns
+   */
+  inline const island::PcmRing& GetRing() const {
+    return ring_;
+  }
+
+ private:
+  /** The decoding thread's loop, which keeps the ring topped up. */
+  void Decode();
+
+  /**
+   * The voice's audio callback, which copies frames out of the ring.
+   *
+   * @param buffer the buffer to fill, one channel after another
+   */
+  void Process(cinder::audio::Buffer* buffer);
+
+  /** The music file being decoded. */
+  cinder::audio::SourceFileRef source_;
+
+  /** The decoded frames waiting to be played. */
+  island::PcmRing ring_;
+
+  /** The chunk the decoding thread decodes into. */
+  cinder::audio::Buffer chunk_;
+
+  /** The chunk interleaved, as the ring holds frames. */
+  std::vector<float> interleaved_;
+
+  /** The frames the audio callback copies out of the ring. */
+  std::vector<float> output_;
+
+  /** Determines whether the music starts over at its end. */
+  std::atomic<bool> is_looping_;
+
+  /** Determines whether the decoding thread should keep running. */
+  std::atomic<bool> is_decoding_;
+
+  /** The voice playing the ring. */
+  cinder::audio::VoiceRef voice_;
+
+  /** Decodes the music into the ring. */
+  std::thread decoder_;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_MUSICSTREAM_H_
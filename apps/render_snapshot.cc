@@ -0,0 +1,45 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "render_snapshot.h"
+
+#include <cmath>
+
+namespace islandapp {
+
+double GetZoom(size_t num_zoom_steps) {
+  return std::pow(kZoomStep, -static_cast<double>(num_zoom_steps));
+}
+
+bool NpcSprite::operator==(const NpcSprite& rhs) const {
+  return name_ == rhs.name_ && location_ == rhs.location_
+         && facing_ == rhs.facing_;
+}
+
+bool RenderSnapshot::IsSameFrame(const RenderSnapshot& other) const {
+  // The count of tile changes only ever grows, so it tells the tiles apart.
+  // The hit point fractions are always computed the same way from the same
+  // values, so they are compared exactly, without == to keep -Wfloat-equal
+  // quiet.
+  return state_ == other.state_
+         && player_location_ == other.player_location_
+         && player_direction_ == other.player_direction_
+         && player_step_ == other.player_step_
+         && camera_ == other.camera_
+         && visible_tiles_ == other.visible_tiles_
+         && num_zoom_steps_ == other.num_zoom_steps_
+         && level_ == other.level_
+         && is_minimap_shown_ == other.is_minimap_shown_
+         && num_tile_changes_ == other.num_tile_changes_
+         && npcs_ == other.npcs_
+         && visible_text_ == other.visible_text_
+         && inventory_file_paths_ == other.inventory_file_paths_
+         && money_ == other.money_
+         && battle_npc_name_ == other.battle_npc_name_
+         && prefetch_npc_name_ == other.prefetch_npc_name_
+         && !(player_hp_fraction_ < other.player_hp_fraction_)
+         && !(other.player_hp_fraction_ < player_hp_fraction_)
+         && !(npc_hp_fraction_ < other.npc_hp_fraction_)
+         && !(other.npc_hp_fraction_ < npc_hp_fraction_);
+}
+
+}  // namespace islandapp
@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_RENDERSNAPSHOT_H_
+#define FINALPROJECT_APPS_RENDERSNAPSHOT_H_
+
+#include <island/camera.h>
+#include <island/direction.h>
+#include <island/location.h>
+#include <island/map.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "game_state.h"
+
+namespace islandapp {
+
+/** The factor the camera zooms in or out by with each step. */
+const double kZoomStep = 2.0;
+
+/**
+ * Gets how far the camera is zoomed in after a number of steps out.
+ *
+ * @param num_zoom_steps the number of steps zoomed out from full size
+ * @return the number of screen pixels per map pixel
+ */
+double GetZoom(size_t num_zoom_steps);
+
+/** Everything needed to draw one npc in the overworld. */
+struct NpcSprite {
+  /** The name of the npc. */
+  std::string name_;
+
+  /** The location of the npc on the map. */
+  island::Location location_ = {0, 0};
+
+  /** The direction the npc is facing. */
+  island::Direction facing_ = island::Direction::kDown;
+
+  /**
+   * Overload for the == operator, compares two sprites.
+   *
+   * @param rhs the other sprite to compare with
+   * @return true if both sprites draw the same npc in the same way
+   */
+  bool operator==(const NpcSprite& rhs) const;
+};
+
+/**
+ * A copy of everything the draw functions need from the game, published by
+ * the simulation thread every tick. The drawing thread only ever reads a
+ * snapshot, so it never touches the live game state.
+ */
+struct RenderSnapshot {
+  /** The state of the game. */
+  GameState state_ = GameState::kPlaying;
+
+  /** The location of the player on the map. */
+  island::Location player_location_ = {0, 0};
+
+  /** The direction the player last moved in. */
+  island::Direction player_direction_ = island::Direction::kDown;
+
+  /** The number of steps since the player changed direction. */
+  size_t player_step_ = 0;
+
+  /** The location to offset the rendering by. */
+  island::Location camera_ = {0, 0};
+
+  /** The tiles of the map within view of the camera. */
+  island::TileRect visible_tiles_ = {0, 0, 0, 0};
+
+  /**
+   * The number of steps the camera is zoomed out by, from the map at full
+   * size.
+   */
+  size_t num_zoom_steps_ = 0;
+
+  /** The level of detail the map is drawn at, matching the zoom. */
+  size_t level_ = 0;
+
+  /** Determines whether the minimap is drawn. */
+  bool is_minimap_shown_ = false;
+
+  /** The number of changes made to the map's tiles. */
+  size_t num_tile_changes_ = 0;
+
+  /** The tiles which differ from the map the game started with. */
+  std::vector<island::TileChange> tile_overrides_;
+
+  /** The npcs within view of the camera. */
+  std::vector<NpcSprite> npcs_;
+
+  /** The part of the text box's text revealed so far. */
+  std::string visible_text_;
+
+  /** The image paths of the items in the player's inventory. */
+  std::vector<std::string> inventory_file_paths_;
+
+  /** The amount of money the player has. */
+  size_t money_ = 0;
+
+  /** The name of the npc the player is battling. */
+  std::string battle_npc_name_;
+
+  /** The player's remaining hitpoints as a fraction of their maximum. */
+  double player_hp_fraction_ = 0;
+
+  /** The npc's remaining hitpoints as a fraction of their maximum. */
+  double npc_hp_fraction_ = 0;
+
+  /**
+   * The name of the npc whose battle images should be loaded ahead of the
+   * battle, or empty to drop them.
+   */
+  std::string prefetch_npc_name_;
+
+  /**
+   * Counts the snapshots which would draw a different frame. Two snapshots
+   * with the same version draw exactly the same picture.
+   */
+  size_t version_ = 0;
+
+  /**
+   * Determines whether two snapshots would draw the same frame, ignoring
+   * their versions.
+   *
+   * @param other the other snapshot to compare with
+   * @return true if every drawn value is the same, false otherwise
+   */
+  bool IsSameFrame(const RenderSnapshot& other) const;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_RENDERSNAPSHOT_H_
@@ -19,6 +19,20 @@ namespace islandapp {
 DEFINE_string(player_name, "Meow", "The name of the player");
 DEFINE_string(load, "assets/saved_game.json", "The save file");
 DEFINE_bool(new_game, false, "Whether the player plays a new game");
+DEFINE_string(save_dir, "assets/saves", "The directory of the save slots");
+DEFINE_int32(slot, -1, "The save slot to load instead of --load, if any");
+DEFINE_string(capture_dir, "",
+              "The directory to record the session's frames to, if any");
+DEFINE_bool(capture_raw, false,
+            "Whether to record one raw RGBA video instead of PNG images");
+DEFINE_uint64(texture_budget_mb, 128,
+              "The most memory textures may use, in megabytes, before the "
+              "ones used least recently are evicted");
+DEFINE_bool(show_texture_memory, false,
+            "Whether to draw the texture memory report on screen");
+DEFINE_bool(print_stats, false,
+            "Whether to print the frame, texture, audio and save statistics "
+            "on exit");
 
 const int kSamples = 8;
 const int kWidth = 800;
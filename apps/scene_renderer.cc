@@ -0,0 +1,596 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "scene_renderer.h"
+
+#include <cinder/Text.h>
+#include <cinder/gl/draw.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#if defined(CINDER_COCOA_TOUCH)
+const char kNormalFont[] = "Arial";
+const char kBoldFont[] = "Arial-BoldMT";
+const char kDifferentFont[] = "AmericanTypewriter";
+#elif defined(CINDER_LINUX)
+const char kNormalFont[] = "Arial Unicode MS";
+const char kBoldFont[] = "Arial Unicode MS";
+const char kDifferentFont[] = "Purisa";
+#else
+const char kNormalFont[] = "Arial";
+const char kBoldFont[] = "Arial Bold";
+#endif
+
+namespace islandapp {
+
+using cinder::Color;
+using cinder::ColorA;
+using cinder::Rectf;
+using cinder::TextBox;
+using island::Direction;
+using island::Location;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::string;
+
+namespace {
+
+/** The largest value of a color channel. */
+const float kMaxChannel = 255.0f;
+
+/**
+ * Packs a color into the format commands hold colors in.
+ *
+ * @param color the color
+ * @return the color, as 0xRRGGBBAA
+ */
+uint32_t PackColor(const ColorA& color) {
+  const auto channel = [](float value, uint32_t shift) {
+    const float clamped = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<uint32_t>(clamped * kMaxChannel + 0.5f) << shift;
+  };
+  return channel(color.r, 24) | channel(color.g, 16) | channel(color.b, 8)
+         | channel(color.a, 0);
+}
+
+}  // namespace
+
+void SceneRenderer::AddNpcSprites(const std::string& name) {
+  npc_sprite_files_.insert(std::pair<string, string>
+      (name + "_right", "assets/npc/images/" + name + "_right.png"));
+  npc_sprite_files_.insert(std::pair<string, string>
+      (name + "_left", "assets/npc/images/" + name + "_left.png"));
+  npc_sprite_files_.insert(std::pair<string, string>
+      (name + "_up", "assets/npc/images/" + name + "_up.png"));
+  npc_sprite_files_.insert(std::pair<string, string>
+      (name + "_down", "assets/npc/images/" + name + "_down.png"));
+}
+
+void SceneRenderer::Load(const island::Engine& engine,
+                         const island::ResourcePack* resources,
+                         island::JobSystem* job_system) {
+  textures_.SetResources(resources);
+  tile_renderer_.Load(textures_.GetImage("assets/map.png"), kPlayerTileSize,
+                      engine, job_system);
+  textures_.Track("map", island::TextureCategory::kMap,
+                  tile_renderer_.GetNumTextureBytes());
+
+  for (const auto& npc : engine.GetNpcs()) {
+    AddNpcSprites(npc.name_);
+    if (npc.is_combatable_) {
+      npc_battle_sprite_files_.insert(std::pair<string, string>
+        (npc.name_, "assets/npc/images/" + npc.name_ + "_battle.png"));
+    }
+  }
+}
+
+void SceneRenderer::SetViewSize(int width, int height) {
+  width_ = width;
+  height_ = height;
+}
+
+void SceneRenderer::SetProfiling(bool is_profiling) {
+  is_profiling_ = is_profiling;
+}
+
+void SceneRenderer::ResetTimings() {
+  timings_.clear();
+}
+
+void SceneRenderer::SetTextureBudget(size_t budget) {
+  textures_.SetBudget(budget);
+}
+
+void SceneRenderer::SetMemoryReportShown(bool is_shown) {
+  is_memory_report_shown_ = is_shown;
+}
+
+template <typename F>
+void SceneRenderer::Time(const string& name, const F& routine) {
+  if (!is_profiling_) {
+    routine();
+    return;
+  }
+
+  // GL calls only queue work, so wait for the GPU on both sides for the
+  // time to cover the routine's drawing as well as its calls.
+  glFinish();
+  const auto start = steady_clock::now();
+  routine();
+  glFinish();
+  DrawTiming& timing = timings_[name];
+  timing.duration_ += duration_cast<nanoseconds>(steady_clock::now() - start);
+  timing.num_calls_++;
+}
+
+void SceneRenderer::Draw(const RenderSnapshot& snapshot) {
+  textures_.BeginFrame();
+  PrefetchBattleImages(snapshot.prefetch_npc_name_);
+  commands_.Clear();
+  command_renderer_.Clear();
+
+  // Every image and text texture has premultiplied alpha.
+  cinder::gl::enableAlphaBlending(true);
+  cinder::gl::clear();
+  cinder::gl::color(Color(1,1,1));
+
+  if (snapshot.state_ == GameState::kBattle
+      || snapshot.state_ == GameState::kBattleText) {
+    DrawBattle(snapshot);
+  } else {
+    DrawOverworld(snapshot);
+  }
+  if (is_memory_report_shown_) {
+    DrawMemoryReport();
+  }
+}
+
+void SceneRenderer::DrawOverworld(const RenderSnapshot& snapshot) {
+  Time("player", [&] { DrawPlayer(snapshot); });
+  Time("npcs", [&] { DrawNpcs(snapshot); });
+  if (snapshot.is_minimap_shown_) {
+    DrawMinimapPlayer(snapshot);
+  }
+  if (snapshot.state_ == GameState::kDisplayingText
+      || snapshot.state_ == GameState::kMarket) {
+    Time("text_box", [&] { DrawTextBox(snapshot); });
+  } else if (snapshot.state_ == GameState::kInventory) {
+    Time("inventory", [&] { DrawInventory(snapshot); });
+  }
+  commands_.Sort();
+
+  // The overworld is zoomed and scrolled, the menus on top of it are not.
+  const float zoom = static_cast<float>(GetZoom(snapshot.num_zoom_steps_));
+  cinder::gl::pushModelMatrix();
+  cinder::gl::scale(zoom, zoom);
+  Translate(snapshot.camera_, false);
+  Time("map", [&] { DrawMap(snapshot); });
+  Time("submit_world", [&] {
+    command_renderer_.Submit(commands_, kWorldLayer, kWorldLayer + 1);
+  });
+  cinder::gl::popModelMatrix();
+
+  if (snapshot.is_minimap_shown_) {
+    Time("minimap", [&] { DrawMinimap(); });
+  }
+  Time("submit", [&] {
+    command_renderer_.Submit(commands_, kMarkerLayer, kNumLayers);
+  });
+}
+
+void SceneRenderer::PrefetchBattleImages(const string& npc_name) {
+  if (npc_name != prefetched_npc_name_) {
+    const std::vector<string> paths = GetBattleImagePaths(npc_name);
+    for (const string& path : GetBattleImagePaths(prefetched_npc_name_)) {
+      if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+        textures_.Evict(path);
+      }
+    }
+    for (const string& path : paths) {
+      textures_.Prefetch(path);
+    }
+    prefetched_npc_name_ = npc_name;
+  }
+  textures_.UploadPrefetched();
+}
+
+std::vector<string> SceneRenderer::GetBattleImagePaths(
+    const string& npc_name) const {
+  auto opponent = npc_battle_sprite_files_.find(npc_name);
+  if (opponent == npc_battle_sprite_files_.end()) {
+    return {};
+  }
+  return {"assets/battle_background.png", "assets/battle_player.png",
+          "assets/hp_bar.png", "assets/blood.png", opponent->second};
+}
+
+void SceneRenderer::DrawBattle(const RenderSnapshot& snapshot) {
+  Time("battle_background", [&] {
+    auto background = textures_.GetTexture("assets/battle_background.png");
+    AddSprite(kBackgroundLayer, background,
+              Rectf(0, 0, static_cast<float>(width_),
+                    static_cast<float>(height_)));
+  });
+  Time("battle_player", [&] { DrawBattlePlayer(); });
+  Time("battle_opponent", [&] { DrawBattleOpponent(snapshot); });
+  Time("hp_bars", [&] { DrawHpBars(snapshot); });
+  Time("battle_text", [&] { DrawBattleText(snapshot); });
+  commands_.Sort();
+
+  Time("submit", [&] {
+    command_renderer_.Submit(commands_, kMarkerLayer, kNumLayers);
+  });
+}
+
+void SceneRenderer::DrawHpBars(const RenderSnapshot& snapshot) const {
+  auto hp_box = textures_.GetTexture("assets/hp_bar.png");
+  AddSprite(kFrameLayer, hp_box, Rectf
+  (230, 180, 430, 320));
+  AddSprite(kFrameLayer, hp_box, Rectf
+  (300, 380, 500, 520));
+
+  auto blood = textures_.GetTexture("assets/blood.png");
+  AddSprite(kFillLayer, blood, Rectf(270, 233.5,
+      270 + snapshot.npc_hp_fraction_ * 140,
+      253.5));
+  AddSprite(kFillLayer, blood, Rectf(340, 433.5,
+      340 + snapshot.player_hp_fraction_ * 140,
+      453.5));
+
+}
+
+void SceneRenderer::DrawBattleText(const RenderSnapshot& snapshot) const {
+  DrawTextBox(snapshot);
+}
+
+void SceneRenderer::DrawBattlePlayer() const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+
+  auto background = textures_.GetTexture("assets/battle_player.png");
+  AddSprite(kSpriteLayer, background, Rectf(
+  1.0 / 8.0 * width, center.y,3.0 / 8.0 * width,
+  (center.y + height * kTextLocMultiplier) / (kTextLocMultiplier + 1.0)));
+}
+
+void SceneRenderer::DrawBattleOpponent(const RenderSnapshot& snapshot) const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+  string opponent_image_path =
+      npc_battle_sprite_files_.at(snapshot.battle_npc_name_);
+
+  auto background = textures_.GetTexture(opponent_image_path);
+  AddSprite(kSpriteLayer, background, Rectf(
+    4.5 / 8.0 * width,200.0 / 800.0 * height,
+    6.0 / 8.0 * width,425.0 / 800.0 * height));
+}
+
+void SceneRenderer::DrawMap(const RenderSnapshot& snapshot) {
+  tile_renderer_.ApplyTileChanges(snapshot.tile_overrides_,
+                                  snapshot.num_tile_changes_);
+  tile_renderer_.Draw(snapshot.visible_tiles_, snapshot.level_);
+}
+
+void SceneRenderer::DrawMinimap() const {
+  tile_renderer_.DrawMinimap(GetMinimapBounds());
+}
+
+void SceneRenderer::DrawMinimapPlayer(const RenderSnapshot& snapshot) const {
+  // Mark the player with a tile sized dot, scaled down like the map.
+  const Rectf bounds = GetMinimapBounds();
+  const float scale = static_cast<float>(kMinimapSize)
+                      / static_cast<float>(island::kMapSize);
+  const Location loc = snapshot.player_location_;
+  AddRect(kMarkerLayer, ColorA(1, 0, 0, 1), Rectf(
+      bounds.x1 + scale * static_cast<float>(loc.GetRow()),
+      bounds.y1 + scale * static_cast<float>(loc.GetCol()),
+      bounds.x1 + scale * static_cast<float>(loc.GetRow() + 1),
+      bounds.y1 + scale * static_cast<float>(loc.GetCol() + 1)));
+}
+
+Rectf SceneRenderer::GetMinimapBounds() const {
+  const float width = static_cast<float>(width_);
+  const float size = static_cast<float>(kMinimapSize);
+  const float margin = static_cast<float>(kTextOffset);
+  return Rectf(width - size - margin, margin, width - margin, margin + size);
+}
+
+void SceneRenderer::DrawPlayer(const RenderSnapshot& snapshot) const {
+  Location loc = snapshot.player_location_;
+  cinder::gl::TextureRef image = GetPlayerImage(snapshot);
+  AddSprite(kWorldLayer, image, Rectf( kPlayerTileSize * loc.GetRow(),
+                                 kPlayerTileSize * loc.GetCol(),
+                                 kPlayerTileSize * (loc.GetRow() + 1),
+                                 kPlayerTileSize * (loc.GetCol() + 1)));
+}
+
+void SceneRenderer::DrawNpcs(const RenderSnapshot& snapshot) const {
+  for (const NpcSprite& npc : snapshot.npcs_) {
+    Location loc = npc.location_;
+    string image_path = GetActiveNpcImagePath(npc.name_, npc.facing_);
+
+    cinder::gl::TextureRef image = textures_.GetTexture(image_path);
+    AddSprite(kWorldLayer, image, Rectf( kPlayerTileSize * loc.GetRow(),
+                                   kPlayerTileSize * loc.GetCol(),
+                                   kPlayerTileSize * (loc.GetRow() + 1),
+                                   kPlayerTileSize * (loc.GetCol() + 1)));
+  }
+}
+
+void SceneRenderer::DrawTextBox(const RenderSnapshot& snapshot) const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+  const cinder::ivec2 size = {kTextBoxWidth, kTextBoxHeight};
+  const Color color = Color::black();
+  auto text_box = textures_.GetTexture("assets/text_box.png");
+
+  AddSprite(kFrameLayer, text_box, Rectf( 0,
+  (center.y + height * kTextLocMultiplier) / (kTextLocMultiplier + 1.0),
+                                      width, height));
+  PrintText(snapshot.visible_text_, color, size, {width, height});
+}
+
+void SceneRenderer::DrawInventory(const RenderSnapshot& snapshot) const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+
+  auto inventory = textures_.GetTexture("assets/inventory.png");
+  AddSprite(kFrameLayer, inventory, Rectf(center.x / kScreenDivider,
+   center.y / kScreenDivider,(center.x + width) / kScreenDivider,
+  (center.y + height) / kScreenDivider));
+
+  DrawItems(snapshot);
+  DrawMoney(snapshot);
+  DrawInventoryDescription(snapshot);
+}
+
+template <typename C>
+void SceneRenderer::PrintText(const string& text, const C& color,
+    const cinder::ivec2& size, const cinder::vec2& loc) const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+  const auto texture = RenderText(text, color,
+                                  static_cast<float>(kFontSize), size);
+  AddText(kTextLayer, texture,
+      Rectf( kTextOffset,(center.y + height * kTextLocMultiplier) /
+                    (kTextLocMultiplier + 1.0) + kTextOffset, width, height));
+}
+
+void SceneRenderer::DrawItems(const RenderSnapshot& snapshot) const {
+  const cinder::vec2 center = GetCenter();
+  const double width = width_;
+  const double height = height_;
+
+  for (size_t ite = 0; ite < snapshot.inventory_file_paths_.size(); ite++) {
+    auto item_image =
+        textures_.GetTexture(snapshot.inventory_file_paths_[ite]);
+
+    double offset_start = (double) (ite) * 43.0 / 800.0 * width + width / 16.0;
+    AddSprite(kFillLayer, item_image,
+        Rectf(center.x / kScreenDivider + offset_start,
+              center.y / kScreenDivider + height * 90.0 / 800.0,
+              center.x / kScreenDivider + offset_start + width / 20.0,
+              center.y / kScreenDivider + height * 140.0 / 800.0));
+  }
+}
+
+void SceneRenderer::DrawMoney(const RenderSnapshot& snapshot) const {
+  const cinder::vec2 center = GetCenter();
+  const cinder::ivec2 size = {150, 100};
+  const double width = width_;
+  const double height = height_;
+
+  const auto texture = RenderText("$" + std::to_string(snapshot.money_),
+                                  Color::black(),
+                                  static_cast<float>(kFontSize), size);
+
+  AddText(kTextLayer, texture,
+   Rectf( center.x / kScreenDivider + 50.0 / 800.0 * width,
+          center.y / kScreenDivider + 20.0 / 800.0 * height,
+          center.x / kScreenDivider + 200.0 / 800.0 * width,
+          center.y / kScreenDivider + 90.0 / 800.0 * height));
+}
+
+void SceneRenderer::DrawInventoryDescription(const RenderSnapshot& snapshot)
+    const {
+  const cinder::vec2 center = GetCenter();
+  const cinder::ivec2 size = {350, 130};
+  const double width = width_;
+  const double height = height_;
+  string text;
+  size_t inventory_size = snapshot.inventory_file_paths_.size();
+
+  if (inventory_size == 0) {
+    text = "You have no items! You should try and search around, "
+           "or perhaps even buy some.";
+  } else if (inventory_size == kMaxInventorySize) {
+    text = "You have all the items. I believed in you from the very beginning!";
+  } else {
+    text = "These items of yours sure are impressive, "
+           "but there's still a few more you can get!";
+  }
+
+  const auto texture = RenderText(text, Color::black(),
+                                  static_cast<float>(2 * kFontSize / 3.0),
+                                  size);
+
+  AddText(kTextLayer, texture,
+     Rectf( center.x / kScreenDivider + 50.0 / 800.0 * width,
+            center.y / kScreenDivider + 320.0 / 800.0 * height,
+            center.x / kScreenDivider + 400.0 / 800.0 * width,
+            center.y / kScreenDivider + 450.0 / 800.0 * height));
+}
+
+cinder::gl::TextureRef SceneRenderer::RenderText(
+    const string& text, const Color& color, float font_size,
+    const cinder::ivec2& size) const {
+  std::ostringstream key;
+  key << font_size << ' ' << size.x << 'x' << size.y << ' ' << color.r << ','
+      << color.g << ',' << color.b << ' ' << text;
+  return textures_.GetText(key.str(), [&] {
+    return TextBox()
+        .alignment(TextBox::LEFT)
+        .font(cinder::Font(kNormalFont, font_size))
+        .size(size)
+        .color(color)
+        .backgroundColor(ColorA(0, 0, 0, 0))
+        .premultiplied()
+        .text(text)
+        .render();
+  });
+}
+
+void SceneRenderer::DrawMemoryReport() const {
+  // Rendered every time, since the report changes with what it reports.
+  const cinder::ivec2 size = {kTextBoxWidth / 2, kTextBoxHeight};
+  auto box = TextBox()
+      .alignment(TextBox::LEFT)
+      .font(cinder::Font(kNormalFont, static_cast<float>(kFontSize) / 2))
+      .size(size)
+      .color(Color::white())
+      .backgroundColor(ColorA(0, 0, 0, 0.5f))
+      .premultiplied()
+      .text(GetMemoryReport());
+  cinder::gl::color(Color::white());
+  cinder::gl::draw(cinder::gl::Texture::create(box.render()),
+                   cinder::vec2(kTextOffset, kTextOffset));
+}
+
+void SceneRenderer::AddSprite(Layer layer,
+                              const cinder::gl::TextureRef& texture,
+                              const Rectf& rect) const {
+  commands_.AddSprite(layer, command_renderer_.GetTextureId(texture),
+                      {rect.x1, rect.y1, rect.x2, rect.y2});
+}
+
+void SceneRenderer::AddText(Layer layer,
+                            const cinder::gl::TextureRef& texture,
+                            const Rectf& rect) const {
+  commands_.AddText(layer, command_renderer_.GetTextureId(texture),
+                    {rect.x1, rect.y1, rect.x2, rect.y2});
+}
+
+void SceneRenderer::AddRect(Layer layer, const ColorA& color,
+                            const Rectf& rect) const {
+  commands_.AddRect(layer, PackColor(color),
+                    {rect.x1, rect.y1, rect.x2, rect.y2});
+}
+
+void SceneRenderer::Translate(const Location& camera, bool is_up) const {
+  float direction;
+  if (is_up) {
+    direction = 1.0;
+  } else {
+    direction = -1.0;
+  }
+
+  cinder::gl::translate(
+      direction * (camera.GetRow() * kTranslationMultiplier),
+      direction * (camera.GetCol() * kTranslationMultiplier));
+}
+
+cinder::gl::TextureRef SceneRenderer::GetPlayerImage
+    (const RenderSnapshot& snapshot) const {
+  string image_path;
+  switch (snapshot.player_direction_) {
+    case Direction::kDown:
+      image_path = GetDownImagePath(snapshot.player_step_);
+      break;
+    case Direction::kUp:
+      image_path = GetUpImagePath(snapshot.player_step_);
+      break;
+    case Direction::kLeft:
+      image_path = GetLeftImagePath(snapshot.player_step_);
+      break;
+    case Direction::kRight:
+      image_path = GetRightImagePath(snapshot.player_step_);
+      break;
+  }
+
+  return textures_.GetTexture(image_path);
+}
+
+string SceneRenderer::GetDownImagePath(size_t step) const {
+  switch (step % kNumSprites) {
+    case 0 :
+      return "assets/player/down_nomove.png";
+    case 1 :
+      return "assets/player/down_left.png";
+    case 2 :
+      return "assets/player/down_nomove.png";
+    case 3 :
+      return "assets/player/down_right.png";
+  }
+  return "";
+}
+
+string SceneRenderer::GetUpImagePath(size_t step) const {
+  switch (step % kNumSprites) {
+    case 0 :
+      return "assets/player/up_nomove.png";
+    case 1 :
+      return "assets/player/up_left.png";
+    case 2 :
+      return "assets/player/up_nomove.png";
+    case 3 :
+      return "assets/player/up_right.png";
+  }
+  return "";
+}
+
+string SceneRenderer::GetLeftImagePath(size_t step) const {
+  switch (step % kNumSprites) {
+    case 0 :
+      return "assets/player/left_nomove.png";
+    case 1 :
+      return "assets/player/left_left.png";
+    case 2 :
+      return "assets/player/left_nomove.png";
+    case 3 :
+      return "assets/player/left_right.png";
+  }
+  return "";
+}
+
+string SceneRenderer::GetRightImagePath(size_t step) const {
+  switch (step % kNumSprites) {
+    case 0 :
+      return "assets/player/right_nomove.png";
+    case 1 :
+      return "assets/player/right_left.png";
+    case 2 :
+      return "assets/player/right_nomove.png";
+    case 3 :
+      return "assets/player/right_right.png";
+  }
+  return "";
+}
+
+string SceneRenderer::GetActiveNpcImagePath
+      (const string& name, const Direction& direction) const {
+  string dir_path;
+  switch (direction) {
+    case Direction::kUp :
+      dir_path = "_up";
+      break;
+    case Direction::kDown :
+      dir_path = "_down";
+      break;
+    case Direction::kLeft :
+      dir_path = "_left";
+      break;
+    case Direction::kRight :
+      dir_path = "_right";
+      break;
+  }
+  return npc_sprite_files_.at(name + dir_path);
+}
+
+}  // namespace islandapp
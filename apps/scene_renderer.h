@@ -0,0 +1,501 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_SCENERENDERER_H_
+#define FINALPROJECT_APPS_SCENERENDERER_H_
+
+#include <cinder/gl/gl.h>
+
+#include <island/command_buffer.h>
+#include <island/direction.h>
+#include <island/engine.h>
+#include <island/job_system.h>
+#include <island/location.h>
+#include <island/resource_pack.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "command_renderer.h"
+#include "render_snapshot.h"
+#include "texture_cache.h"
+#include "tile_renderer.h"
+
+namespace islandapp {
+
+/** The time spent in one of the scene's draw routines. */
+struct DrawTiming {
+  /** The total time spent in the routine. */
+  std::chrono::nanoseconds duration_ = std::chrono::nanoseconds(0);
+
+  /** The number of times the routine ran. */
+  size_t num_calls_ = 0;
+};
+
+/**
+ * Draws a render snapshot into the bound framebuffer. Only reads the
+ * snapshot, so the same scene can be drawn by the game or by a benchmark
+ * without a running simulation.
+ *
+ * The sprites, text and menus are recorded into a command buffer first and
+ * submitted once the whole frame is recorded, sorted so that everything
+ * sharing a texture within a layer is drawn in one batch. Only the map and
+ * the minimap, which have their own batched meshes, are drawn immediately.
+ */
+class SceneRenderer {
+ public:
+  /** The tile size for the player terms of pixels. */
+  const size_t kPlayerTileSize = 40;
+
+  /** The number of movement sprites for the player. */
+  const size_t kNumSprites = 4;
+
+  /** The divider for how much of the total screen the user should view. */
+  const size_t kScreenDivider = 2;
+
+  /** The font size of the text to be displayed to the user. */
+  const size_t kFontSize = 30;
+
+  /** The width of the text box to be displayed. */
+  const size_t kTextBoxWidth = 800;
+
+  /** The height of the text box to be displayed. */
+  const size_t kTextBoxHeight = 150;
+
+  /** The number of pixels the text is offset from the textbox. */
+  const size_t kTextOffset = 10;
+
+  /** The maximum number of items the player can hold. */
+  const size_t kMaxInventorySize = 5;
+
+  /** Determines how far down the text box is placed, higher is further down. */
+  const double kTextLocMultiplier = 2.0;
+
+  /** The multiplier for how many pixels the camera translates the view. */
+  const double kTranslationMultiplier = 40.0;
+
+  /** The width and height of the minimap, in pixels. */
+  const size_t kMinimapSize = 200;
+
+  /**
+   * Loads the map and the npc sprite paths, from the resource pack if it has
+   * been built. Must be called on the thread that owns the GL context.
+   *
+   * @param engine the engine whose map and npcs are drawn
+   * @param resources the resource pack to take images from, which must
+   * outlive the renderer, or nullptr to decode every image
+   * @param job_system the job system to build the map's pyramid on
+   */
+  void Load(const island::Engine& engine,
+            const island::ResourcePack* resources,
+            island::JobSystem* job_system);
+
+  /**
+   * Sets the size of the framebuffer the scene is drawn into.
+   *
+   * @param width the width, in pixels
+   * @param height the height, in pixels
+   */
+  void SetViewSize(int width, int height);
+
+  /**
+   * Draws everything in a snapshot into the bound framebuffer.
+   * Non const since the map's renderer caches what it last drew.
+   */
+  void Draw(const RenderSnapshot& snapshot);
+
+  /**
+   * Turns timing each draw routine on or off. Timing waits for the GPU
+   * before and after every routine, so it slows drawing down and is only
+   * meant for profiling.
+   *
+   * @param is_profiling true to time the draw routines
+   */
+  void SetProfiling(bool is_profiling);
+
+  /** Clears the timings of every draw routine. */
+  void ResetTimings();
+
+  /**
+   * Accessor function for the time spent in each draw routine.
+   *
+   * @return the timings, with the name of the routine as the key
+   */
+  inline const std::map<std::string, DrawTiming>& GetTimings() const {
+    return timings_;
+  }
+
+  /**
+   * Changes the memory the textures may use, evicting the textures used
+   * least recently to stay within it.
+   *
+   * @param budget the most memory the textures should use, in bytes
+   */
+  void SetTextureBudget(size_t budget);
+
+  /**
+   * Turns drawing the texture memory report on top of the scene on or off.
+   *
+   * @param is_shown true to draw the report
+   */
+  void SetMemoryReportShown(bool is_shown);
+
+  /**
+   * Formats the memory used by the textures, per category.
+   *
+   * @return the report
+   */
+  inline std::string GetMemoryReport() const {
+    return textures_.GetBudget().GetReport();
+  }
+
+  /**
+   * Accessor function for the number of commands recorded for the last
+   * frame drawn.
+   *
+   * @return the number of commands
+   */
+  inline size_t GetNumCommands() const {
+    return commands_.GetCommands().size();
+  }
+
+  /**
+   * Accessor function for the number of batches the last frame drawn was
+   * submitted in.
+   *
+   * @return the number of batches
+   */
+  inline size_t GetNumBatches() const {
+    return command_renderer_.GetNumBatches();
+  }
+
+ private:
+  /**
+   * The layers commands are recorded in, drawn in this order. The world
+   * layer is drawn with the camera's transform, every other layer on top
+   * of the minimap without it.
+   */
+  enum Layer : uint16_t {
+    kWorldLayer,
+    kMarkerLayer,
+    kBackgroundLayer,
+    kSpriteLayer,
+    kFrameLayer,
+    kFillLayer,
+    kTextLayer,
+    kNumLayers
+  };
+
+  /**
+   * Runs a draw routine, timing it if profiling is on.
+   *
+   * @tparam F The type of the routine
+   * @param name the name to record the routine's time under
+   * @param routine the routine to run
+   */
+  template <typename F>
+  void Time(const std::string& name, const F& routine);
+
+  /**
+   * Adds the npc sprites to the map to be used to draw the sprites.
+   *
+   * @param name the name of the npc
+   */
+  void AddNpcSprites(const std::string& name);
+
+  /**
+   * Loads the battle images of the npc the player is near, in the
+   * background, and drops those of the npc they were near before.
+   *
+   * @param npc_name the name of the npc, or empty to drop every battle image
+   */
+  void PrefetchBattleImages(const std::string& npc_name);
+
+  /**
+   * Gets the images drawn in a battle with an npc.
+   *
+   * @param npc_name the name of the npc
+   * @return the paths to the images, empty if there is no such battle
+   */
+  std::vector<std::string> GetBattleImagePaths(const std::string& npc_name)
+      const;
+
+  /**
+   * Draws the map with everything on it, and the menus on top.
+   */
+  void DrawOverworld(const RenderSnapshot& snapshot);
+
+  /**
+   * Draws the battle scene whenever a battle is initiated.
+   */
+  void DrawBattle(const RenderSnapshot& snapshot);
+
+  /**
+   * Records the Hitpoint bars for both the player and the npc.
+   */
+  void DrawHpBars(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the text relaying information to the user in the battle.
+   */
+  void DrawBattleText(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the player in battle, facing the opponent away from the user.
+   */
+  void DrawBattlePlayer() const;
+
+  /**
+   * Records the opponent in battle, facing the user and the player.
+   */
+  void DrawBattleOpponent(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Draws the tiles of the map within view of the camera.
+   * Non const since the tile renderer caches the visible tiles.
+   */
+  void DrawMap(const RenderSnapshot& snapshot);
+
+  /**
+   * Draws the whole map in the corner of the screen.
+   */
+  void DrawMinimap() const;
+
+  /**
+   * Records the player's dot on the minimap.
+   */
+  void DrawMinimapPlayer(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Gets where the minimap is drawn.
+   *
+   * @return the minimap's bounds, in pixels
+   */
+  cinder::Rectf GetMinimapBounds() const;
+
+  /**
+   * Records the player on the map.
+   */
+  void DrawPlayer(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the npcs within view of the camera.
+   */
+  void DrawNpcs(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the text box that displays the player's interaction text.
+   */
+  void DrawTextBox(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the inventory which displays the player's items.
+   */
+  void DrawInventory(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the items in the inventory.
+   */
+  void DrawItems(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the money the player currently has in the inventory menu.
+   */
+  void DrawMoney(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Records the description of the inventory of the player.
+   */
+  void DrawInventoryDescription(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Gets a texture of rendered text, rendering it only the first time the
+   * same text is drawn.
+   *
+   * @param text the text
+   * @param color the color of the text
+   * @param font_size the size of the font
+   * @param size the size of the texture, in pixels
+   * @return the texture
+   */
+  cinder::gl::TextureRef RenderText(const std::string& text,
+                                    const cinder::Color& color,
+                                    float font_size,
+                                    const cinder::ivec2& size) const;
+
+  /** Draws the texture memory report in the top left corner. */
+  void DrawMemoryReport() const;
+
+  /**
+   * Records drawing a whole texture.
+   *
+   * @param layer the layer to draw in
+   * @param texture the texture
+   * @param rect where to draw the texture
+   */
+  void AddSprite(Layer layer, const cinder::gl::TextureRef& texture,
+                 const cinder::Rectf& rect) const;
+
+  /**
+   * Records drawing a texture of rendered text.
+   *
+   * @param layer the layer to draw in
+   * @param texture the text's texture
+   * @param rect where to draw the text
+   */
+  void AddText(Layer layer, const cinder::gl::TextureRef& texture,
+               const cinder::Rectf& rect) const;
+
+  /**
+   * Records drawing a rectangle of a solid color.
+   *
+   * @param layer the layer to draw in
+   * @param color the color
+   * @param rect where to draw the rectangle
+   */
+  void AddRect(Layer layer, const cinder::ColorA& color,
+               const cinder::Rectf& rect) const;
+
+  /**
+   * Records the text of a text box.
+   *
+   * @tparam C The typename for the color of the text
+   * @param text the text to be displayed
+   * @param color the color of the text
+   * @param size the size of the text
+   * @param loc the location on the screen where the text is to be displayed
+   */
+  template <typename C>
+  void PrintText(const std::string& text, const C& color,
+                  const cinder::ivec2& size, const cinder::vec2& loc) const;
+
+  /**
+   * Translates the outputted image and text.
+   *
+   * @param camera the location the camera is at
+   * @param is_up true if the translation is upward, false otherwise
+   */
+  void Translate(const island::Location& camera, bool is_up) const;
+
+  /**
+   * Determines what the player character should look like
+   * when they move in a particular direction.
+   *
+   * @param snapshot the snapshot holding the player's direction and step
+   * @return the TextureRef representing the image of the player character
+   */
+  cinder::gl::TextureRef GetPlayerImage(const RenderSnapshot& snapshot) const;
+
+  /**
+   * Gets the direction image path to be displayed for the
+   * player character when the user moves down.
+   *
+   * @param step the number of steps since the player changed direction
+   * @return the string containing the correct image path to be displayed
+   */
+  std::string GetDownImagePath(size_t step) const;
+
+  /**
+   * Gets the direction image path to be displayed for the
+   * player character when the user moves up.
+   *
+   * @param step the number of steps since the player changed direction
+   * @return the string containing the correct image path to be displayed
+   */
+  std::string GetUpImagePath(size_t step) const;
+
+  /**
+   * Gets the direction image path to be displayed for the
+   * player character when the user moves left.
+   *
+   * @param step the number of steps since the player changed direction
+   * @return the string containing the correct image path to be displayed
+   */
+  std::string GetLeftImagePath(size_t step) const;
+
+  /**
+   * Gets the direction image path to be displayed for the
+   * player character when the user moves right.
+   *
+   * @param step the number of steps since the player changed direction
+   * @return the string containing the correct image path to be displayed
+   */
+  std::string GetRightImagePath(size_t step) const;
+
+  /**
+   * Gets the image path for the NPC according to where the NPC is facing.
+   *
+   * @param name the name of the npc
+   * @param direction the direction the npc is facing
+   * @return the file path containing the image of the npc
+   */
+  std::string GetActiveNpcImagePath
+      (const std::string& name, const island::Direction& direction) const;
+
+  /**
+   * Accessor function for the center of the framebuffer.
+   *
+   * @return the center, in pixels
+   */
+  inline cinder::vec2 GetCenter() const {
+    return {static_cast<float>(width_) / 2.0f,
+            static_cast<float>(height_) / 2.0f};
+  }
+
+  /** Draws the map from its tiles. */
+  TileRenderer tile_renderer_;
+
+  /**
+   * Every image drawn, loaded on first use.
+   * Mutable since the draw functions load the images they draw.
+   */
+  mutable TextureCache textures_;
+
+  /**
+   * Stores the npc sprites with the name of the npc as the key and
+   * the file path as the corresponding value, displayed in the overworld.
+   */
+  std::unordered_map<std::string, std::string> npc_sprite_files_;
+
+  /**
+   * Stores the npc battle sprites with the name of the npc as the key and
+   * the file path as the corresponding value, displayed in battle.
+   */
+  std::unordered_map<std::string, std::string> npc_battle_sprite_files_;
+
+  /**
+   * The commands of the frame being drawn.
+   * Mutable since the draw functions record what they draw.
+   */
+  mutable island::CommandBuffer commands_;
+
+  /**
+   * Submits the commands, and gives their textures ids.
+   * Mutable since the draw functions give the textures they draw ids.
+   */
+  mutable CommandRenderer command_renderer_;
+
+  /** The npc whose battle images are loaded, or empty for none. */
+  std::string prefetched_npc_name_;
+
+  /** The time spent in each draw routine, with its name as the key. */
+  std::map<std::string, DrawTiming> timings_;
+
+  /** Determines whether the draw routines are timed. */
+  bool is_profiling_ = false;
+
+  /** Determines whether the texture memory report is drawn. */
+  bool is_memory_report_shown_ = false;
+
+  /** The width of the framebuffer, in pixels. */
+  int width_ = 0;
+
+  /** The height of the framebuffer, in pixels. */
+  int height_ = 0;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_SCENERENDERER_H_
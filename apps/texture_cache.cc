@@ -0,0 +1,249 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "texture_cache.h"
+
+#include <cinder/ImageIo.h>
+
+#include <island/tile_atlas.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace islandapp {
+
+using island::TextureView;
+using std::string;
+
+void TextureCache::SetResources(const island::ResourcePack* resources) {
+  for (const auto& texture : textures_) {
+    budget_.Remove(texture.first);
+  }
+  textures_.clear();
+  resources_ = resources;
+}
+
+TextureView TextureCache::GetImage(const string& image_path) {
+  TextureView image;
+  if (resources_ != nullptr && resources_->FindTexture(image_path, &image)) {
+    return image;
+  }
+
+  auto prefetched = prefetched_.find(image_path);
+  if (prefetched != prefetched_.end()) {
+    FinishPrefetch(prefetched);
+  }
+
+  auto decoded = decoded_.find(image_path);
+  if (decoded == decoded_.end()) {
+    DecodedImage image;
+    image.pixels_ = DecodeRgba(image_path, &image.width_, &image.height_);
+    island::PremultiplyAlpha(&image.pixels_);
+    decoded = decoded_.emplace(image_path, std::move(image)).first;
+  }
+  return {decoded->second.width_, decoded->second.height_,
+          decoded->second.pixels_.data()};
+}
+
+cinder::gl::TextureRef TextureCache::GetTexture(const string& image_path) {
+  auto texture = textures_.find(image_path);
+  if (texture != textures_.end()) {
+    budget_.Touch(image_path);
+    return texture->second;
+  }
+
+  // The surface only wraps the pixels, so a cooked image is uploaded
+  // straight from the mapped pack.
+  const TextureView image = GetImage(image_path);
+  cinder::Surface8u surface(
+      const_cast<uint8_t*>(image.pixels_),
+      static_cast<int32_t>(image.width_), static_cast<int32_t>(image.height_),
+      static_cast<ptrdiff_t>(image.width_ * island::kBytesPerPixel),
+      cinder::SurfaceChannelOrder::RGBA);
+  cinder::gl::TextureRef uploaded = cinder::gl::Texture::create(surface);
+  textures_.emplace(image_path, uploaded);
+
+  // Images not in the pack keep their decoded pixels as well.
+  size_t num_bytes = image.width_ * image.height_ * island::kBytesPerPixel;
+  auto decoded = decoded_.find(image_path);
+  if (decoded != decoded_.end()) {
+    num_bytes += decoded->second.pixels_.size();
+  }
+  Account(image_path, GetCategory(image_path), num_bytes);
+  return uploaded;
+}
+
+cinder::gl::TextureRef TextureCache::GetText(
+    const string& key, const std::function<cinder::Surface8u()>& render) {
+  // Named apart from the images, whose names are their paths.
+  const string name = "text:" + key;
+  auto texture = textures_.find(name);
+  if (texture != textures_.end()) {
+    budget_.Touch(name);
+    return texture->second;
+  }
+
+  cinder::gl::TextureRef rendered = cinder::gl::Texture::create(render());
+  textures_.emplace(name, rendered);
+  Account(name, island::TextureCategory::kText,
+          static_cast<size_t>(rendered->getWidth())
+          * static_cast<size_t>(rendered->getHeight())
+          * island::kBytesPerPixel);
+  return rendered;
+}
+
+void TextureCache::Track(const string& name,
+                         island::TextureCategory category, size_t num_bytes) {
+  for (const string& evicted : budget_.Add(name, category, num_bytes, true)) {
+    Drop(evicted);
+  }
+}
+
+void TextureCache::BeginFrame() {
+  budget_.BeginFrame();
+}
+
+void TextureCache::SetBudget(size_t budget) {
+  for (const string& evicted : budget_.SetBudget(budget)) {
+    Drop(evicted);
+  }
+}
+
+island::TextureCategory TextureCache::GetCategory(const string& image_path) {
+  if (image_path == "assets/map.png") {
+    return island::TextureCategory::kMap;
+  }
+  if (image_path.find("battle") != string::npos
+      || image_path == "assets/hp_bar.png"
+      || image_path == "assets/blood.png") {
+    return island::TextureCategory::kBattle;
+  }
+  if (image_path.compare(0, 18, "assets/npc/images/") == 0
+      || image_path.compare(0, 14, "assets/player/") == 0) {
+    return island::TextureCategory::kSprites;
+  }
+  return island::TextureCategory::kUi;
+}
+
+void TextureCache::Prefetch(const string& image_path) {
+  if (textures_.count(image_path) != 0 || decoded_.count(image_path) != 0
+      || prefetched_.count(image_path) != 0) {
+    return;
+  }
+  prefetched_.emplace(image_path, std::async(std::launch::async,
+                                             &TextureCache::Load, resources_,
+                                             image_path));
+}
+
+void TextureCache::UploadPrefetched() {
+  const auto is_ready = [](const std::future<DecodedImage>& image) {
+    return image.wait_for(std::chrono::seconds(0))
+           == std::future_status::ready;
+  };
+  abandoned_.erase(std::remove_if(abandoned_.begin(), abandoned_.end(),
+                                  is_ready), abandoned_.end());
+
+  std::vector<string> loaded;
+  for (const auto& prefetched : prefetched_) {
+    if (is_ready(prefetched.second)) {
+      loaded.push_back(prefetched.first);
+    }
+  }
+  for (const string& image_path : loaded) {
+    FinishPrefetch(prefetched_.find(image_path));
+  }
+
+  // Each upload copies a whole image, so only one is done per frame.
+  if (!uploads_.empty()) {
+    GetTexture(uploads_.front());
+    uploads_.erase(uploads_.begin());
+  }
+}
+
+void TextureCache::Evict(const string& image_path) {
+  budget_.Remove(image_path);
+  Drop(image_path);
+
+  // Destroying the future would wait for the load, so it is kept until the
+  // load finishes instead.
+  auto prefetched = prefetched_.find(image_path);
+  if (prefetched != prefetched_.end()) {
+    abandoned_.push_back(std::move(prefetched->second));
+    prefetched_.erase(prefetched);
+  }
+}
+
+TextureCache::DecodedImage TextureCache::Load(
+    const island::ResourcePack* resources, const string& image_path) {
+  DecodedImage image;
+  TextureView packed;
+  if (resources != nullptr && resources->FindTexture(image_path, &packed)) {
+    // Read a byte of every page, so the upload does not wait on the disk.
+    const volatile uint8_t* pixels = packed.pixels_;
+    const size_t size = packed.width_ * packed.height_
+                        * island::kBytesPerPixel;
+    for (size_t offset = 0; offset < size; offset += kPageSize) {
+      static_cast<void>(pixels[offset]);
+    }
+    image.width_ = packed.width_;
+    image.height_ = packed.height_;
+    return image;
+  }
+
+  image.pixels_ = DecodeRgba(image_path, &image.width_, &image.height_);
+  island::PremultiplyAlpha(&image.pixels_);
+  return image;
+}
+
+void TextureCache::Account(const string& name,
+                           island::TextureCategory category,
+                           size_t num_bytes) {
+  for (const string& evicted : budget_.Add(name, category, num_bytes)) {
+    Drop(evicted);
+  }
+}
+
+void TextureCache::Drop(const string& name) {
+  textures_.erase(name);
+  decoded_.erase(name);
+  uploads_.erase(std::remove(uploads_.begin(), uploads_.end(), name),
+                 uploads_.end());
+}
+
+void TextureCache::FinishPrefetch(
+    std::unordered_map<string, std::future<DecodedImage>>::iterator
+        prefetched) {
+  DecodedImage image = prefetched->second.get();
+  if (!image.pixels_.empty()) {
+    decoded_.emplace(prefetched->first, std::move(image));
+  }
+  uploads_.push_back(prefetched->first);
+  prefetched_.erase(prefetched);
+}
+
+std::vector<uint8_t> TextureCache::DecodeRgba(const string& image_path,
+                                              size_t* width, size_t* height) {
+  cinder::Surface8u surface(cinder::loadImage(image_path));
+  *width = static_cast<size_t>(surface.getWidth());
+  *height = static_cast<size_t>(surface.getHeight());
+  const int8_t pixel_inc = surface.getPixelInc();
+  const bool has_alpha = surface.hasAlpha();
+
+  // Repack the surface as tightly packed RGBA.
+  std::vector<uint8_t> pixels(*width * *height * island::kBytesPerPixel);
+  for (size_t y = 0; y < *height; y++) {
+    const uint8_t* line = surface.getData() +
+        static_cast<ptrdiff_t>(y) * surface.getRowBytes();
+    for (size_t x = 0; x < *width; x++) {
+      const uint8_t* pixel = line + static_cast<ptrdiff_t>(x) * pixel_inc;
+      uint8_t* out = &pixels[(y * *width + x) * island::kBytesPerPixel];
+      out[0] = pixel[surface.getRedOffset()];
+      out[1] = pixel[surface.getGreenOffset()];
+      out[2] = pixel[surface.getBlueOffset()];
+      out[3] = has_alpha ? pixel[surface.getAlphaOffset()] : UINT8_MAX;
+    }
+  }
+  return pixels;
+}
+
+}  // namespace islandapp
@@ -0,0 +1,235 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_TEXTURECACHE_H_
+#define FINALPROJECT_APPS_TEXTURECACHE_H_
+
+#include <cinder/gl/gl.h>
+
+#include <island/resource_pack.h>
+#include <island/texture_budget.h>
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace islandapp {
+
+/**
+ * Loads every image the game draws, each at most once. Images are taken
+ * from the resource pack when it has them cooked, which skips decoding the
+ * PNG entirely, and are otherwise decoded from their PNG. Either way the
+ * images have premultiplied alpha, so they must be drawn with premultiplied
+ * blending.
+ *
+ * Every texture is accounted in a memory budget under its category, and
+ * the textures used least recently are dropped to stay within it, to be
+ * loaded again on their next use.
+ */
+class TextureCache {
+ public:
+  /** The memory the textures may use unless set otherwise, in bytes. */
+  static const size_t kDefaultBudget = 128 * 1024 * 1024;
+
+  /**
+   * Sets the resource pack images are taken from. Without a pack, every
+   * image is decoded from its PNG instead.
+   *
+   * @param resources the resource pack, which must outlive the cache, or
+   * nullptr for none
+   */
+  void SetResources(const island::ResourcePack* resources);
+
+  /**
+   * Gets the pixels of an image, decoding it if it is not in the pack.
+   *
+   * @param image_path the path to the image's PNG
+   * @return the image, tightly packed premultiplied RGBA, valid for as long
+   * as the cache
+   */
+  island::TextureView GetImage(const std::string& image_path);
+
+  /**
+   * Gets an image as a texture, uploading it on first use. Must be called on
+   * the thread that owns the GL context.
+   *
+   * @param image_path the path to the image's PNG
+   * @return the texture
+   */
+  cinder::gl::TextureRef GetTexture(const std::string& image_path);
+
+  /**
+   * Gets a texture of rendered text, rendering it on first use. Must be
+   * called on the thread that owns the GL context.
+   *
+   * @param key identifies the text and everything it is rendered with
+   * @param render renders the text
+   * @return the texture
+   */
+  cinder::gl::TextureRef GetText(
+      const std::string& key, const std::function<cinder::Surface8u()>& render);
+
+  /**
+   * Accounts a texture owned elsewhere, which is never evicted.
+   *
+   * @param name the name the texture is reported under
+   * @param category what the texture is drawn for
+   * @param num_bytes the memory the texture uses, in bytes
+   */
+  void Track(const std::string& name, island::TextureCategory category,
+             size_t num_bytes);
+
+  /**
+   * Starts a new frame, so textures not used since may be evicted.
+   */
+  void BeginFrame();
+
+  /**
+   * Changes the memory budget, evicting textures to stay within it.
+   *
+   * @param budget the most memory the textures should use, in bytes
+   */
+  void SetBudget(size_t budget);
+
+  /**
+   * Accessor function for the memory budget and its accounting.
+   *
+   * @return the budget
+   */
+  inline const island::TextureBudget& GetBudget() const {
+    return budget_;
+  }
+
+  /**
+   * Gets the category an image's memory is accounted under.
+   *
+   * @param image_path the path to the image's PNG
+   * @return the category
+   */
+  static island::TextureCategory GetCategory(const std::string& image_path);
+
+  /**
+   * Starts loading an image in the background, so it is ready to draw
+   * before it is first needed. Images not in the pack are decoded, and
+   * images in the pack have their pages read in.
+   *
+   * @param image_path the path to the image's PNG
+   */
+  void Prefetch(const std::string& image_path);
+
+  /**
+   * Uploads a prefetched image whose loading has finished, so the upload
+   * does not land on the frame which first draws it. Must be called on the
+   * thread that owns the GL context.
+   */
+  void UploadPrefetched();
+
+  /**
+   * Drops an image's texture and decoded pixels, to be loaded again on next
+   * use.
+   *
+   * @param image_path the path to the image's PNG
+   */
+  void Evict(const std::string& image_path);
+
+  /**
+   * Decodes an image from its PNG, without premultiplying it.
+   *
+   * @param image_path the path to the image's PNG
+   * @param width set to the width of the image, in pixels
+   * @param height set to the height of the image, in pixels
+   * @return the image, tightly packed RGBA with the top row first
+   */
+  static std::vector<uint8_t> DecodeRgba(const std::string& image_path,
+                                         size_t* width, size_t* height);
+
+  /**
+   * Accessor function for the number of images decoded from PNG, which the
+   * pack would have avoided.
+   *
+   * @return the number of decoded images
+   */
+  inline size_t GetNumDecoded() const {
+    return decoded_.size();
+  }
+
+ private:
+  /** An image which was not in the pack. */
+  struct DecodedImage {
+    /** The width of the image, in pixels. */
+    size_t width_;
+
+    /** The height of the image, in pixels. */
+    size_t height_;
+
+    /** The pixels of the image, tightly packed premultiplied RGBA. */
+    std::vector<uint8_t> pixels_;
+  };
+
+  /** The size of a page of memory, the granularity the pack is read in. */
+  static const size_t kPageSize = 4096;
+
+  /** The resource pack with the cooked images, or nullptr for none. */
+  const island::ResourcePack* resources_ = nullptr;
+
+  /**
+   * Loads an image, on a background thread.
+   *
+   * @param resources the resource pack, or nullptr for none
+   * @param image_path the path to the image's PNG
+   * @return the image, without pixels if it is in the pack
+   */
+  static DecodedImage Load(const island::ResourcePack* resources,
+                           const std::string& image_path);
+
+  /**
+   * Accounts a texture which was just loaded, dropping the textures evicted
+   * to make room for it.
+   *
+   * @param name the name of the texture
+   * @param category what the texture is drawn for
+   * @param num_bytes the memory the texture uses, in bytes
+   */
+  void Account(const std::string& name, island::TextureCategory category,
+               size_t num_bytes);
+
+  /**
+   * Drops a texture and its decoded pixels, once it is no longer accounted.
+   *
+   * @param name the name of the texture
+   */
+  void Drop(const std::string& name);
+
+  /**
+   * Finishes loading a prefetched image, waiting for it if it is not done.
+   *
+   * @param prefetched the image being loaded
+   */
+  void FinishPrefetch(
+      std::unordered_map<std::string,
+                         std::future<DecodedImage>>::iterator prefetched);
+
+  /** The images which were not in the pack, decoded from PNG. */
+  std::unordered_map<std::string, DecodedImage> decoded_;
+
+  /** The images being loaded in the background. */
+  std::unordered_map<std::string, std::future<DecodedImage>> prefetched_;
+
+  /** The prefetched images which were loaded, waiting to be uploaded. */
+  std::vector<std::string> uploads_;
+
+  /** The images evicted while they were loading, dropped once loaded. */
+  std::vector<std::future<DecodedImage>> abandoned_;
+
+  /** The memory used by every texture, along with its budget. */
+  island::TextureBudget budget_{kDefaultBudget};
+
+  /** The textures uploaded so far, including rendered text. */
+  std::unordered_map<std::string, cinder::gl::TextureRef> textures_;
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_TEXTURECACHE_H_
@@ -0,0 +1,250 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include "tile_renderer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace islandapp {
+
+using cinder::Rectf;
+using island::Location;
+using island::TileAtlas;
+using island::TilePyramid;
+using island::TileRect;
+
+namespace {
+
+/**
+ * Wraps a pyramid level's pixels in a surface, without copying them.
+ *
+ * @param level the level
+ * @return the surface
+ */
+cinder::Surface8u GetLevelSurface(const TilePyramid::Level& level) {
+  return cinder::Surface8u(
+      const_cast<uint8_t*>(level.pixels_.data()),
+      static_cast<int32_t>(level.width_),
+      static_cast<int32_t>(level.height_),
+      static_cast<ptrdiff_t>(level.width_ * island::kBytesPerPixel),
+      cinder::SurfaceChannelOrder::RGBA);
+}
+
+}  // namespace
+
+void TileRenderer::Load(const island::TextureView& image, size_t tile_size,
+                        const island::Engine& engine,
+                        island::JobSystem* job_system) {
+  std::vector<uint8_t> pixels(image.pixels_, image.pixels_
+      + image.width_ * image.height_ * island::kBytesPerPixel);
+  atlas_.reset(new TileAtlas(pixels, image.width_, image.height_,
+                             tile_size));
+
+  // The image shows the map the game started with, so it is where every
+  // tile type is drawn from, and tiles changed since are redrawn like any
+  // other change.
+  base_tiles_.clear();
+  palette_.clear();
+  for (size_t row = 0; row < atlas_->GetNumRows(); row++) {
+    for (size_t col = 0; col < atlas_->GetNumCols(); col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      base_tiles_.push_back(engine.GetBaseTileType(location));
+      palette_.insert({base_tiles_.back(), atlas_->GetCell(location)});
+    }
+  }
+  overrides_.clear();
+  num_applied_changes_ = 0;
+
+  pyramid_.reset(new TilePyramid(*atlas_));
+  pyramid_->Build(job_system);
+  UploadLevels();
+
+  cinder::Surface8u atlas_surface(
+      const_cast<uint8_t*>(atlas_->GetPixels().data()),
+      static_cast<int32_t>(atlas_->GetWidth()),
+      static_cast<int32_t>(atlas_->GetHeight()),
+      static_cast<ptrdiff_t>(atlas_->GetWidth() * island::kBytesPerPixel),
+      cinder::SurfaceChannelOrder::RGBA);
+  // Nearest filtering keeps neighbouring cells from bleeding into each other.
+  texture_ = cinder::gl::Texture::create(atlas_surface,
+      cinder::gl::Texture::Format().minFilter(GL_NEAREST)
+                                   .magFilter(GL_NEAREST));
+  batch_.reset();
+}
+
+void TileRenderer::ApplyTileChanges(
+    const std::vector<island::TileChange>& overrides, size_t num_changes) {
+  if (!atlas_ || num_applied_changes_ == num_changes) {
+    return;
+  }
+
+  // Tiles which were overridden and no longer are went back to the map's.
+  std::vector<island::TileChange> changes = overrides;
+  std::vector<bool> is_overridden(base_tiles_.size());
+  for (const island::TileChange& change : overrides) {
+    is_overridden[GetTileIndex(change.location_)] = true;
+  }
+  for (const island::TileChange& change : overrides_) {
+    const size_t index = GetTileIndex(change.location_);
+    if (!is_overridden[index]) {
+      changes.push_back({change.location_, base_tiles_[index]});
+    }
+  }
+
+  // Only the band of lines holding the changed tiles is uploaded again.
+  const size_t tile_size = atlas_->GetTileSize();
+  size_t first_line = pyramid_->GetLevel(0).height_;
+  size_t last_line = 0;
+  for (const island::TileChange& tile_change : changes) {
+    auto cell = palette_.find(tile_change.tile_);
+    if (cell == palette_.end()
+        || atlas_->GetCell(tile_change.location_) == cell->second) {
+      continue;
+    }
+    atlas_->SetCell(tile_change.location_, cell->second);
+    pyramid_->UpdateTile(*atlas_, tile_change.location_);
+    const size_t line =
+        static_cast<size_t>(tile_change.location_.GetCol()) * tile_size;
+    first_line = std::min(first_line, line);
+    last_line = std::max(last_line, line + tile_size);
+  }
+  overrides_ = overrides;
+  num_applied_changes_ = num_changes;
+
+  if (first_line < last_line) {
+    batch_.reset();
+    UpdateLevels(first_line, last_line);
+  }
+}
+
+size_t TileRenderer::GetTileIndex(const Location& location) const {
+  return static_cast<size_t>(location.GetRow()) * atlas_->GetNumCols()
+         + static_cast<size_t>(location.GetCol());
+}
+
+void TileRenderer::Draw(const TileRect& visible, size_t level) {
+  if (!texture_) {
+    return;
+  }
+  level = std::min(level, level_textures_.size() - 1);
+  if (level > 0) {
+    DrawLevel(visible, level);
+    return;
+  }
+  if (!batch_ || visible != batch_tiles_) {
+    BuildBatch(visible);
+  }
+
+  cinder::gl::ScopedGlslProg shader(
+      cinder::gl::getStockShader(cinder::gl::ShaderDef().texture()));
+  cinder::gl::ScopedTextureBind texture(texture_);
+  batch_->draw();
+}
+
+void TileRenderer::BuildBatch(const TileRect& visible) {
+  batch_ = cinder::gl::VertBatch::create(GL_TRIANGLES);
+  const float tile_size = static_cast<float>(atlas_->GetTileSize());
+  const int cell_size = static_cast<int>(atlas_->GetTileSize());
+
+  for (size_t row = visible.first_row_;
+       row < visible.first_row_ + visible.num_rows_; row++) {
+    for (size_t col = visible.first_col_;
+         col < visible.first_col_ + visible.num_cols_; col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      Location origin = atlas_->GetCellOrigin(atlas_->GetCell(location));
+      Rectf coords = texture_->getAreaTexCoords(cinder::Area(
+          origin.GetRow(), origin.GetCol(),
+          origin.GetRow() + cell_size, origin.GetCol() + cell_size));
+      Rectf quad(static_cast<float>(row) * tile_size,
+                 static_cast<float>(col) * tile_size,
+                 static_cast<float>(row + 1) * tile_size,
+                 static_cast<float>(col + 1) * tile_size);
+
+      batch_->texCoord(coords.x1, coords.y1);
+      batch_->vertex(quad.x1, quad.y1);
+      batch_->texCoord(coords.x2, coords.y1);
+      batch_->vertex(quad.x2, quad.y1);
+      batch_->texCoord(coords.x2, coords.y2);
+      batch_->vertex(quad.x2, quad.y2);
+
+      batch_->texCoord(coords.x1, coords.y1);
+      batch_->vertex(quad.x1, quad.y1);
+      batch_->texCoord(coords.x2, coords.y2);
+      batch_->vertex(quad.x2, quad.y2);
+      batch_->texCoord(coords.x1, coords.y2);
+      batch_->vertex(quad.x1, quad.y2);
+    }
+  }
+  batch_tiles_ = visible;
+}
+
+void TileRenderer::DrawLevel(const TileRect& visible, size_t level) const {
+  // A level's pixels cover 2^level pixels of the full size map.
+  const size_t tile_size = atlas_->GetTileSize();
+  const size_t scale = size_t(1) << level;
+  const TilePyramid::Level& pixels = pyramid_->GetLevel(level);
+  size_t first_x = visible.first_row_ * tile_size / scale;
+  size_t first_y = visible.first_col_ * tile_size / scale;
+  size_t last_x = std::min(((visible.first_row_ + visible.num_rows_)
+                            * tile_size + scale - 1) / scale, pixels.width_);
+  size_t last_y = std::min(((visible.first_col_ + visible.num_cols_)
+                            * tile_size + scale - 1) / scale, pixels.height_);
+
+  cinder::gl::draw(level_textures_[level],
+      cinder::Area(static_cast<int>(first_x), static_cast<int>(first_y),
+                   static_cast<int>(last_x), static_cast<int>(last_y)),
+      Rectf(static_cast<float>(first_x * scale),
+            static_cast<float>(first_y * scale),
+            static_cast<float>(last_x * scale),
+            static_cast<float>(last_y * scale)));
+}
+
+void TileRenderer::DrawMinimap(const Rectf& bounds) const {
+  if (level_textures_.size() < 2) {
+    return;
+  }
+
+  size_t level = 1;
+  while (level + 1 < level_textures_.size()
+         && static_cast<float>(pyramid_->GetLevel(level + 1).width_)
+            >= bounds.getWidth()) {
+    level++;
+  }
+  cinder::gl::draw(level_textures_[level], bounds);
+}
+
+size_t TileRenderer::GetNumTextureBytes() const {
+  if (!atlas_) {
+    return 0;
+  }
+
+  // The atlas and every level after level 0 are kept on both sides.
+  size_t num_bytes = 2 * atlas_->GetPixels().size();
+  for (size_t level = 1; level < pyramid_->GetNumLevels(); level++) {
+    num_bytes += 2 * pyramid_->GetLevel(level).pixels_.size();
+  }
+  return num_bytes;
+}
+
+void TileRenderer::UploadLevels() {
+  level_textures_.assign(pyramid_->GetNumLevels(), nullptr);
+  for (size_t level = 1; level < pyramid_->GetNumLevels(); level++) {
+    level_textures_[level] = cinder::gl::Texture::create(
+        GetLevelSurface(pyramid_->GetLevel(level)));
+  }
+}
+
+void TileRenderer::UpdateLevels(size_t first_line, size_t last_line) {
+  // Whole lines are updated, so the lines sent are contiguous in the level.
+  for (size_t level = 1; level < level_textures_.size(); level++) {
+    first_line /= 2;
+    last_line = (last_line + 1) / 2;
+    const TilePyramid::Level& pixels = pyramid_->GetLevel(level);
+    level_textures_[level]->update(GetLevelSurface(pixels),
+        cinder::Area(0, static_cast<int32_t>(first_line),
+                     static_cast<int32_t>(pixels.width_),
+                     static_cast<int32_t>(last_line)));
+  }
+}
+
+}  // namespace islandapp
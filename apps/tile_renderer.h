@@ -0,0 +1,157 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_APPS_TILERENDERER_H_
+#define FINALPROJECT_APPS_TILERENDERER_H_
+
+#include <cinder/gl/gl.h>
+
+#include <island/camera.h>
+#include <island/engine.h>
+#include <island/job_system.h>
+#include <island/map.h>
+#include <island/resource_pack.h>
+#include <island/tile_atlas.h>
+#include <island/tile_pyramid.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace islandapp {
+
+/**
+ * Draws the map from a tile atlas. Close up, only the tiles within the
+ * camera's view are emitted, batched into one mesh which is only rebuilt
+ * when a different set of tiles comes into view. Zoomed out, and in the
+ * minimap, the matching level of a tile pyramid is drawn instead.
+ */
+class TileRenderer {
+ public:
+  /**
+   * Cuts the map image into an atlas, builds the pyramid and uploads both
+   * to the GPU. Must be called on the thread that owns the GL context.
+   *
+   * @param image the image of the whole map
+   * @param tile_size the size of a tile in the image, in pixels
+   * @param engine the engine whose map the image shows
+   * @param job_system the job system to build the pyramid on
+   */
+  void Load(const island::TextureView& image, size_t tile_size,
+            const island::Engine& engine, island::JobSystem* job_system);
+
+  /**
+   * Redraws the tiles changed since the last call, using the image of
+   * another tile of the same type. Tiles which are no longer overridden are
+   * redrawn as the map's own tile.
+   *
+   * @param overrides the tiles which differ from the map, row after row
+   * @param num_changes the number of changes made to the map so far, see
+   * Engine::GetNumTileChanges
+   */
+  void ApplyTileChanges(const std::vector<island::TileChange>& overrides,
+                        size_t num_changes);
+
+  /**
+   * Draws the visible tiles at their place on the map, in map pixels.
+   *
+   * @param visible the tiles within the camera's view
+   * @param level the level of detail matching the camera's zoom
+   */
+  void Draw(const island::TileRect& visible, size_t level);
+
+  /**
+   * Draws the whole map into a rectangle on the screen, from the smallest
+   * pyramid level that still fills it.
+   *
+   * @param bounds the rectangle to draw in, in screen pixels
+   */
+  void DrawMinimap(const cinder::Rectf& bounds) const;
+
+  /**
+   * Accessor function for the atlas the map is drawn from.
+   *
+   * @return the atlas, or nullptr before Load is called
+   */
+  inline const island::TileAtlas* GetAtlas() const {
+    return atlas_.get();
+  }
+
+  /**
+   * Gets the memory used by the map's textures, both on the GPU and the
+   * copies kept to redraw changed tiles.
+   *
+   * @return the memory, in bytes
+   */
+  size_t GetNumTextureBytes() const;
+
+ private:
+  /**
+   * Gets the index of a tile among the tiles of the map, row after row.
+   *
+   * @param location the location of the tile
+   * @return the index
+   */
+  size_t GetTileIndex(const island::Location& location) const;
+
+  /**
+   * Rebuilds the mesh of quads for the visible tiles.
+   *
+   * @param visible the tiles within the camera's view
+   */
+  void BuildBatch(const island::TileRect& visible);
+
+  /**
+   * Draws the part of a pyramid level covering the visible tiles.
+   *
+   * @param visible the tiles within the camera's view
+   * @param level the level to draw, at least 1
+   */
+  void DrawLevel(const island::TileRect& visible, size_t level) const;
+
+  /** Uploads every pyramid level after level 0 to the GPU. */
+  void UploadLevels();
+
+  /**
+   * Updates the lines of the level textures which cover a band of lines of
+   * level 0, leaving the rest of each texture as it is.
+   *
+   * @param first_line the first line of level 0 which changed
+   * @param last_line one past the last line of level 0 which changed
+   */
+  void UpdateLevels(size_t first_line, size_t last_line);
+
+  /** The distinct tiles of the map and where each tile is drawn from. */
+  std::unique_ptr<island::TileAtlas> atlas_;
+
+  /** The map at decreasing levels of detail. */
+  std::unique_ptr<island::TilePyramid> pyramid_;
+
+  /** The atlas cell of the first tile of each type, to redraw changes. */
+  std::unordered_map<island::Tile, uint32_t> palette_;
+
+  /** The tile types of the map the game started with, row after row. */
+  std::vector<island::Tile> base_tiles_;
+
+  /** The overridden tiles as last redrawn. */
+  std::vector<island::TileChange> overrides_;
+
+  /** The number of tile changes which have been redrawn. */
+  size_t num_applied_changes_ = 0;
+
+  /** The atlas image, on the GPU. */
+  cinder::gl::TextureRef texture_;
+
+  /** The pyramid levels on the GPU, with no texture for level 0. */
+  std::vector<cinder::gl::TextureRef> level_textures_;
+
+  /** The quads of the visible tiles. */
+  cinder::gl::VertBatchRef batch_;
+
+  /** The tiles the batch was last built for. */
+  island::TileRect batch_tiles_ = {0, 0, 0, 0};
+};
+
+}  // namespace islandapp
+
+#endif  // FINALPROJECT_APPS_TILERENDERER_H_
@@ -0,0 +1,169 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/flow_field.h>
+#include <island/location.h>
+#include <island/map.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using island::FlowField;
+using island::Location;
+using island::Map;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+/** The number of npcs chasing the target. */
+const size_t kNumAgents = 10000;
+
+/** The number of ticks to simulate. */
+const size_t kNumTicks = 1000;
+
+/** The number of tiles the flow field may visit each tick. */
+const size_t kBuildBudget = 512;
+
+/** The number of agents the per agent search baseline is timed with. */
+const size_t kNumBaselineAgents = 100;
+
+/**
+ * Gets every accessible tile on the map.
+ *
+ * @param map the map to search
+ * @return the accessible locations
+ */
+std::vector<Location> GetAccessibleTiles(const Map& map) {
+  std::vector<Location> tiles;
+  for (size_t row = 0; row < map.GetNumRows(); row++) {
+    for (size_t col = 0; col < map.GetNumCols(); col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      if (map.IsAccessibleTile(location)) {
+        tiles.push_back(location);
+      }
+    }
+  }
+  return tiles;
+}
+
+/**
+ * Runs a breadth first search from one agent to the target, the way each
+ * npc would have to without a shared flow field.
+ *
+ * @param map the map to search
+ * @param from the location of the agent
+ * @param target the location of the target
+ * @return the number of steps to the target
+ */
+size_t SearchPath(const Map& map, const Location& from,
+                  const Location& target) {
+  const size_t num_cols = map.GetNumCols();
+  std::vector<uint16_t> distances(map.GetNumRows() * num_cols, UINT16_MAX);
+  std::vector<Location> frontier = {from};
+  const Location deltas[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+  distances[from.GetRow() * num_cols + from.GetCol()] = 0;
+
+  for (size_t next = 0; next < frontier.size(); next++) {
+    Location current = frontier[next];
+    size_t distance =
+        distances[current.GetRow() * num_cols + current.GetCol()];
+    if (current == target) {
+      return distance;
+    }
+    for (const auto& delta : deltas) {
+      Location neighbor = current + delta;
+      if (neighbor.GetRow() < 0 || neighbor.GetCol() < 0
+          || neighbor.GetRow() >= static_cast<int>(map.GetNumRows())
+          || neighbor.GetCol() >= static_cast<int>(num_cols)
+          || !map.IsAccessibleTile(neighbor)) {
+        continue;
+      }
+      size_t index = neighbor.GetRow() * num_cols + neighbor.GetCol();
+      if (distances[index] == UINT16_MAX) {
+        distances[index] = static_cast<uint16_t>(distance + 1);
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+  return SIZE_MAX;
+}
+
+int main() {
+  Map map;
+  std::vector<Location> tiles = GetAccessibleTiles(map);
+  std::mt19937 random(126);
+  std::uniform_int_distribution<size_t> pick_tile(0, tiles.size() - 1);
+
+  std::vector<Location> agents;
+  for (size_t agent = 0; agent < kNumAgents; agent++) {
+    agents.push_back(tiles[pick_tile(random)]);
+  }
+
+  // The target wanders the map like a player would, one tile at a time.
+  std::vector<Location> targets = {tiles[pick_tile(random)]};
+  const Location deltas[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+  std::uniform_int_distribution<size_t> pick_delta(0, 3);
+  while (targets.size() < kNumTicks) {
+    Location next = targets.back() + deltas[pick_delta(random)];
+    if (next.GetRow() >= 0 && next.GetCol() >= 0
+        && next.GetRow() < static_cast<int>(map.GetNumRows())
+        && next.GetCol() < static_cast<int>(map.GetNumCols())
+        && map.IsAccessibleTile(next)) {
+      targets.push_back(next);
+    } else {
+      targets.push_back(targets.back());
+    }
+  }
+
+  // Time the baseline before the agents converge on the target.
+  auto baseline_start = steady_clock::now();
+  size_t total_steps = 0;
+  for (size_t agent = 0; agent < kNumBaselineAgents; agent++) {
+    total_steps += SearchPath(map, agents[agent], targets.front());
+  }
+  nanoseconds baseline_time = duration_cast<nanoseconds>(
+      steady_clock::now() - baseline_start);
+
+  FlowField field(map);
+  field.SetTarget(targets.front());
+  field.Rebuild(map);
+
+  nanoseconds build_time(0);
+  nanoseconds step_time(0);
+  size_t num_completed_builds = 0;
+  for (const auto& target : targets) {
+    auto start = steady_clock::now();
+    field.SetTarget(target);
+    if (field.Advance(map, kBuildBudget)) {
+      num_completed_builds++;
+    }
+    auto built = steady_clock::now();
+    field.StepAll(&agents);
+    auto stepped = steady_clock::now();
+
+    build_time += duration_cast<nanoseconds>(built - start);
+    step_time += duration_cast<nanoseconds>(stepped - built);
+  }
+
+  std::cout << "agents: " << kNumAgents << ", ticks: " << kNumTicks
+            << ", map: " << map.GetNumRows() << "x" << map.GetNumCols()
+            << std::endl;
+  std::cout << "flow field build: " << build_time.count() / kNumTicks
+            << " ns/tick (" << num_completed_builds << " ticks ended with a"
+            << " complete field)" << std::endl;
+  std::cout << "flow field step: " << step_time.count() / kNumTicks
+            << " ns/tick, "
+            << step_time.count() / static_cast<long long>(kNumTicks
+                                                          * kNumAgents)
+            << " ns/agent" << std::endl;
+  std::cout << "per agent search: "
+            << baseline_time.count() / static_cast<long long>(
+                kNumBaselineAgents)
+            << " ns/agent, projected "
+            << baseline_time.count() / static_cast<long long>(
+                kNumBaselineAgents) * static_cast<long long>(kNumAgents)
+            << " ns/tick (checksum " << total_steps << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,333 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <cinder/ImageIo.h>
+#include <cinder/app/App.h>
+#include <cinder/app/RendererGl.h>
+#include <cinder/gl/gl.h>
+#include <gflags/gflags.h>
+
+#include <island/camera.h>
+#include <island/engine.h>
+#include <island/location.h>
+#include <island/map.h>
+#include <island/resource_pack.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "render_snapshot.h"
+#include "scene_renderer.h"
+
+using cinder::app::App;
+using cinder::app::RendererGl;
+using island::Location;
+using islandapp::DrawTiming;
+using islandapp::GameState;
+using islandapp::GetZoom;
+using islandapp::NpcSprite;
+using islandapp::RenderSnapshot;
+using islandapp::SceneRenderer;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::string;
+using std::vector;
+
+DEFINE_uint64(frames, 200, "The number of frames to draw of each scene");
+DEFINE_bool(software_gl, true,
+            "Whether to draw with Mesa's software rasterizer, so results "
+            "match between machines");
+DEFINE_string(golden_dir, "",
+              "The directory of golden images to compare each scene with, "
+              "or empty to skip the comparison");
+DEFINE_bool(write_golden, false,
+            "Whether to write each scene to the golden directory instead of "
+            "comparing with it");
+DEFINE_string(resources, "assets/resources.pack",
+              "The resource pack to take images from, decoding every image "
+              "if it cannot be opened");
+
+/** The size of the offscreen framebuffer, matching the game's window. */
+const int kWidth = 800;
+const int kHeight = 800;
+
+/** The size of a tile on screen, in pixels. */
+const size_t kTileSize = 40;
+
+/** One scripted scene of the benchmark. */
+struct Scene {
+  /** The name the scene is reported and saved under. */
+  string name_;
+
+  /** The snapshot drawn for every frame of the scene. */
+  RenderSnapshot snapshot_;
+};
+
+/**
+ * Draws a set of scripted scenes into an offscreen framebuffer with the
+ * game's renderer, reporting the frame rate of each scene and the time spent
+ * in each of its draw routines. Runs without any input and quits when done.
+ *
+ * For repeatable numbers run it under a virtual display with the software
+ * rasterizer, for example: xvfb-run -s "-screen 0 800x800x24" render-benchmark
+ */
+class RenderBenchmarkApp : public App {
+ public:
+  RenderBenchmarkApp();
+
+  void setup() override;
+
+ private:
+  /**
+   * Builds a snapshot of the overworld with the camera following a location.
+   *
+   * @param player the location of the player
+   * @param num_zoom_steps the number of steps zoomed out from full size
+   * @return the snapshot
+   */
+  RenderSnapshot MakeOverworld(const Location& player,
+                               size_t num_zoom_steps) const;
+
+  /** Builds every scene the benchmark draws. */
+  vector<Scene> MakeScenes() const;
+
+  /**
+   * Draws a scene for the set number of frames, once for the frame rate and
+   * once more with every draw routine timed, then checks its golden image.
+   *
+   * @param scene the scene to draw
+   * @return true if the scene matched its golden image or none was checked
+   */
+  bool RunScene(const Scene& scene);
+
+  /**
+   * Compares the framebuffer with the scene's golden image, or writes it.
+   *
+   * @param scene the scene in the framebuffer
+   * @return true if the images match or the image was written
+   */
+  bool CheckGolden(const Scene& scene) const;
+
+  /** The engine the scenes are taken from, as the game starts it. */
+  island::Engine engine_;
+
+  /** The assets the scenes are drawn with. */
+  island::ResourcePack resources_;
+
+  /** The renderer under test. */
+  SceneRenderer scene_renderer_;
+
+  /** The framebuffer every scene is drawn into. */
+  cinder::gl::FboRef fbo_;
+};
+
+RenderBenchmarkApp::RenderBenchmarkApp()
+    : engine_{island::kMapSize, island::kMapSize,
+              std::vector<island::Item>(),
+              "Meow",
+              {7, 0},
+              {10, 10, 10, 10},
+              std::vector<island::Item>(),
+              1200} {}
+
+void RenderBenchmarkApp::setup() {
+  cinder::gl::disableDepthRead();
+  cinder::gl::disableDepthWrite();
+  resources_.Open(FLAGS_resources);
+  scene_renderer_.Load(engine_, &resources_, nullptr);
+  scene_renderer_.SetViewSize(kWidth, kHeight);
+  fbo_ = cinder::gl::Fbo::create(kWidth, kHeight);
+
+  std::cout << "renderer: " << glGetString(GL_RENDERER) << ", frames: "
+            << FLAGS_frames << ", size: " << kWidth << "x" << kHeight
+            << std::endl;
+  size_t num_mismatches = 0;
+  for (const Scene& scene : MakeScenes()) {
+    if (!RunScene(scene)) {
+      num_mismatches++;
+    }
+  }
+  std::cout << scene_renderer_.GetMemoryReport() << std::endl;
+  if (num_mismatches > 0) {
+    std::cout << num_mismatches << " scenes did not match their golden image"
+              << std::endl;
+  }
+  quit();
+}
+
+RenderSnapshot RenderBenchmarkApp::MakeOverworld(const Location& player,
+                                                 size_t num_zoom_steps) const {
+  island::Camera camera(island::kMapSize, island::kMapSize, kTileSize);
+  camera.SetViewSize(kWidth, kHeight);
+  camera.SetZoom(GetZoom(num_zoom_steps));
+  camera.Follow(player);
+
+  RenderSnapshot snapshot;
+  snapshot.player_location_ = player;
+  snapshot.camera_ = camera.GetLocation();
+  snapshot.visible_tiles_ = camera.GetVisibleTiles();
+  snapshot.num_zoom_steps_ = num_zoom_steps;
+  snapshot.level_ = camera.GetLevel();
+  snapshot.money_ = engine_.GetPlayer().money_;
+  for (const island::Npc& npc : engine_.GetNpcs()) {
+    if (snapshot.visible_tiles_.Contains(npc.location_)) {
+      NpcSprite sprite;
+      sprite.name_ = npc.name_;
+      sprite.location_ = npc.location_;
+      snapshot.npcs_.push_back(sprite);
+    }
+  }
+  return snapshot;
+}
+
+vector<Scene> RenderBenchmarkApp::MakeScenes() const {
+  vector<Scene> scenes;
+  scenes.push_back({"overworld_start", MakeOverworld({7, 0}, 0)});
+  scenes.push_back({"overworld_village", MakeOverworld({25, 22}, 0)});
+  scenes.push_back({"overworld_market", MakeOverworld({36, 35}, 0)});
+  scenes.push_back({"overworld_corner", MakeOverworld({49, 49}, 0)});
+
+  Scene zoomed_out = {"overworld_zoomed_out",
+                      MakeOverworld({25, 25}, 2)};
+  zoomed_out.snapshot_.is_minimap_shown_ = true;
+  scenes.push_back(zoomed_out);
+
+  Scene text_box = {"text_box", MakeOverworld({7, 0}, 0)};
+  text_box.snapshot_.state_ = GameState::kDisplayingText;
+  text_box.snapshot_.visible_text_ =
+      "A notice board. Most of the notices have been washed away by the "
+      "rain, but one of them is still readable.";
+  scenes.push_back(text_box);
+
+  Scene inventory = {"inventory", MakeOverworld({7, 0}, 0)};
+  inventory.snapshot_.state_ = GameState::kInventory;
+  inventory.snapshot_.inventory_file_paths_ = {
+      "assets/shoe.png", "assets/sword.png", "assets/shield.png",
+      "assets/heart.png", "assets/key.png"};
+  scenes.push_back(inventory);
+
+  Scene battle = {"battle", MakeOverworld({25, 21}, 0)};
+  battle.snapshot_.state_ = GameState::kBattle;
+  battle.snapshot_.battle_npc_name_ = "Sven";
+  battle.snapshot_.player_hp_fraction_ = 0.75;
+  battle.snapshot_.npc_hp_fraction_ = 0.5;
+  battle.snapshot_.visible_text_ = "Sven wants to battle!";
+  scenes.push_back(battle);
+  return scenes;
+}
+
+bool RenderBenchmarkApp::RunScene(const Scene& scene) {
+  cinder::gl::ScopedFramebuffer framebuffer(fbo_);
+  cinder::gl::ScopedViewport viewport(cinder::ivec2(0, 0), fbo_->getSize());
+
+  // The first frame builds the map's mesh for the scene, so it is left out.
+  scene_renderer_.SetProfiling(false);
+  scene_renderer_.Draw(scene.snapshot_);
+  glFinish();
+
+  const auto start = steady_clock::now();
+  for (size_t frame = 0; frame < FLAGS_frames; frame++) {
+    scene_renderer_.Draw(scene.snapshot_);
+  }
+  glFinish();
+  const nanoseconds time = duration_cast<nanoseconds>(
+      steady_clock::now() - start);
+
+  scene_renderer_.ResetTimings();
+  scene_renderer_.SetProfiling(true);
+  for (size_t frame = 0; frame < FLAGS_frames; frame++) {
+    scene_renderer_.Draw(scene.snapshot_);
+  }
+  scene_renderer_.SetProfiling(false);
+
+  const double seconds = static_cast<double>(time.count()) / 1e9;
+  std::cout << scene.name_ << ": "
+            << static_cast<double>(FLAGS_frames) / seconds << " fps, "
+            << time.count() / static_cast<long long>(FLAGS_frames)
+            << " ns/frame, " << scene_renderer_.GetNumCommands()
+            << " commands in " << scene_renderer_.GetNumBatches()
+            << " batches" << std::endl;
+  for (const auto& timing : scene_renderer_.GetTimings()) {
+    const DrawTiming& routine = timing.second;
+    std::cout << "  " << timing.first << ": "
+              << routine.duration_.count()
+                 / static_cast<long long>(routine.num_calls_)
+              << " ns/call" << std::endl;
+  }
+  return CheckGolden(scene);
+}
+
+bool RenderBenchmarkApp::CheckGolden(const Scene& scene) const {
+  if (FLAGS_golden_dir.empty()) {
+    return true;
+  }
+
+  const string path = FLAGS_golden_dir + "/" + scene.name_ + ".png";
+  cinder::Surface8u frame = fbo_->readPixels8u(fbo_->getBounds());
+  if (FLAGS_write_golden) {
+    cinder::writeImage(path, frame);
+    std::cout << "  wrote " << path << std::endl;
+    return true;
+  }
+
+  cinder::Surface8u golden(cinder::loadImage(path));
+  if (golden.getSize() != frame.getSize()) {
+    std::cout << "  golden image " << path << " is a different size"
+              << std::endl;
+    return false;
+  }
+
+  // Software rasterizers still differ slightly between versions, so only
+  // pixels that are clearly different count.
+  const int kTolerance = 2;
+  size_t num_different = 0;
+  for (int y = 0; y < frame.getHeight(); y++) {
+    for (int x = 0; x < frame.getWidth(); x++) {
+      const cinder::ColorA8u lhs = frame.getPixel(cinder::ivec2(x, y));
+      const cinder::ColorA8u rhs = golden.getPixel(cinder::ivec2(x, y));
+      if (std::abs(lhs.r - rhs.r) > kTolerance
+          || std::abs(lhs.g - rhs.g) > kTolerance
+          || std::abs(lhs.b - rhs.b) > kTolerance) {
+        num_different++;
+      }
+    }
+  }
+  if (num_different > 0) {
+    std::cout << "  " << num_different << " pixels differ from " << path
+              << std::endl;
+  }
+  return num_different == 0;
+}
+
+/**
+ * Parses the flags and sets up the offscreen window before the GL context is
+ * created.
+ *
+ * @param settings the settings from cinder::app
+ */
+void SetUp(App::Settings* settings) {
+  vector<string> args = settings->getCommandLineArgs();
+  int argc = static_cast<int>(args.size());
+  vector<char*> argvs;
+  for (string& arg : args) {
+    argvs.push_back(&arg[0]);
+  }
+  char** argv = argvs.data();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // Mesa reads this when the context is created, which is after this call.
+  if (FLAGS_software_gl) {
+#ifdef _WIN32
+    _putenv_s("LIBGL_ALWAYS_SOFTWARE", "1");
+#else
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+  }
+  settings->setWindowSize(kWidth, kHeight);
+  settings->setTitle("Render Benchmark");
+}
+
+CINDER_APP(RenderBenchmarkApp, RendererGl, SetUp)
@@ -0,0 +1,190 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/game_session.h>
+#include <island/replication.h>
+#include <island/world.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using island::GameSession;
+using island::PlayerAction;
+using island::ReplicatedState;
+using island::ReplicationDecoder;
+using island::ReplicationEncoder;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+/** The number of sessions replicated every tick. */
+const size_t kNumSessions = 4096;
+
+/** The number of ticks to simulate. */
+const size_t kNumTicks = 200;
+
+/** The number of ticks an acknowledgement takes to get back. */
+const size_t kAcknowledgementDelay = 6;
+
+/** One frame in this many never arrives. */
+const uint32_t kLossRate = 50;
+
+/** A player moves on one tick in this many, and does anything else on one. */
+const uint32_t kActionRate = 3;
+
+/**
+ * Gets the size of a state sent whole, with a byte for each row, column and
+ * enum and the money in full, to compare the frames with.
+ *
+ * @param state the state
+ * @return the number of bytes
+ */
+size_t GetRawSize(const ReplicatedState& state) {
+  return 2 + 1 + 1 + sizeof(state.money_) + 1 + state.inventory_.size()
+         + 2 * state.npc_locations_.size() + state.npc_facings_.size()
+         + 3 * state.tile_overrides_.size();
+}
+
+/** One session with both ends of its replication. */
+struct Client {
+  /**
+   * Constructor for a new game on a shared world.
+   *
+   * @param world the world to play in
+   */
+  explicit Client(const std::shared_ptr<const island::World>& world)
+      : session_{world, "Bot"},
+        encoder_{world},
+        full_encoder_{world},
+        decoder_{world} {}
+
+  /** The session. */
+  GameSession session_;
+
+  /** The encoder sending deltas against acknowledged frames. */
+  ReplicationEncoder encoder_;
+
+  /** An encoder which never hears back, for comparison. */
+  ReplicationEncoder full_encoder_;
+
+  /** The client's decoder. */
+  ReplicationDecoder decoder_;
+
+  /** The sequence numbers acknowledged, by the tick they arrive on. */
+  std::vector<uint16_t> acknowledgements_ =
+      std::vector<uint16_t>(kAcknowledgementDelay);
+
+  /** Determines whether an acknowledgement is on its way in each slot. */
+  std::vector<bool> is_acknowledging_ =
+      std::vector<bool>(kAcknowledgementDelay);
+};
+
+int main() {
+  std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  std::vector<std::unique_ptr<Client>> clients;
+  for (size_t client = 0; client < kNumSessions; client++) {
+    clients.emplace_back(new Client(world));
+  }
+
+  std::mt19937 random(126);
+  std::uniform_int_distribution<uint32_t> pick_move(0, 4 * kActionRate - 1);
+  std::uniform_int_distribution<uint32_t> pick_action(
+      static_cast<uint32_t>(PlayerAction::kInteract),
+      static_cast<uint32_t>(PlayerAction::kRun));
+  std::uniform_int_distribution<uint32_t> pick_loss(0, kLossRate - 1);
+
+  std::vector<uint8_t> frame;
+  ReplicatedState decoded;
+  nanoseconds capture_time(0);
+  nanoseconds encode_time(0);
+  nanoseconds decode_time(0);
+  size_t num_bytes = 0;
+  size_t num_full_bytes = 0;
+  size_t num_raw_bytes = 0;
+  size_t num_lost = 0;
+  size_t num_mismatches = 0;
+  for (size_t tick = 0; tick < kNumTicks; tick++) {
+    const size_t slot = tick % kAcknowledgementDelay;
+    for (const auto& client : clients) {
+      if (client->is_acknowledging_[slot]) {
+        client->encoder_.Acknowledge(client->acknowledgements_[slot]);
+        client->is_acknowledging_[slot] = false;
+      }
+      // Players mostly walk, which is what most ticks have to send.
+      const uint32_t move = pick_move(random);
+      if (move < 4) {
+        client->session_.HandleAction(static_cast<PlayerAction>(move));
+      } else if (move < 4 + kActionRate) {
+        client->session_.HandleAction(
+            static_cast<PlayerAction>(pick_action(random)));
+      }
+      client->session_.Step();
+
+      auto start = steady_clock::now();
+      const ReplicatedState state =
+          island::CaptureReplicatedState(*world, client->session_);
+      auto captured = steady_clock::now();
+      client->encoder_.Encode(state, &frame);
+      auto encoded = steady_clock::now();
+      capture_time += duration_cast<nanoseconds>(captured - start);
+      encode_time += duration_cast<nanoseconds>(encoded - captured);
+      num_bytes += frame.size();
+      num_raw_bytes += GetRawSize(state);
+
+      if (pick_loss(random) == 0) {
+        num_lost++;
+      } else {
+        auto received = steady_clock::now();
+        const bool is_decoded =
+            client->decoder_.Decode(frame.data(), frame.size(), &decoded);
+        decode_time += duration_cast<nanoseconds>(steady_clock::now()
+                                                  - received);
+        if (!is_decoded || !(decoded == state)) {
+          num_mismatches++;
+        } else {
+          client->acknowledgements_[slot] = client->decoder_.GetSequence();
+          client->is_acknowledging_[slot] = true;
+        }
+      }
+
+      client->full_encoder_.Encode(state, &frame);
+      num_full_bytes += frame.size();
+    }
+  }
+
+  const long long num_frames =
+      static_cast<long long>(kNumSessions * kNumTicks);
+  std::cout << "sessions: " << kNumSessions << ", ticks: " << kNumTicks
+            << ", acknowledgement delay: " << kAcknowledgementDelay
+            << " ticks, lost frames: " << num_lost << std::endl;
+  std::cout << "delta frames: " << num_bytes / kNumTicks << " bytes/tick, "
+            << static_cast<double>(num_bytes) / static_cast<double>(num_frames)
+            << " bytes/session" << std::endl;
+  std::cout << "unacknowledged frames: " << num_full_bytes / kNumTicks
+            << " bytes/tick, "
+            << static_cast<double>(num_full_bytes)
+               / static_cast<double>(num_frames)
+            << " bytes/session" << std::endl;
+  std::cout << "whole states: " << num_raw_bytes / kNumTicks
+            << " bytes/tick" << std::endl;
+  std::cout << "capture: " << capture_time.count() / num_frames
+            << " ns/session, encode: " << encode_time.count() / num_frames
+            << " ns/session, " << encode_time.count()
+               / static_cast<long long>(kNumTicks)
+            << " ns/tick" << std::endl;
+  std::cout << "decode: "
+            << decode_time.count()
+               / (num_frames - static_cast<long long>(num_lost))
+            << " ns/session, " << decode_time.count()
+               / static_cast<long long>(kNumTicks)
+            << " ns/tick" << std::endl;
+  if (num_mismatches > 0) {
+    std::cout << num_mismatches << " frames were not decoded to the state "
+              << "they were encoded from" << std::endl;
+  }
+  return num_mismatches > 0 ? 1 : 0;
+}
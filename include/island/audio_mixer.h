@@ -0,0 +1,259 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_AUDIO_MIXER_H_
+#define ISLAND_AUDIO_MIXER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace island {
+
+/** Identifies a sound the game plays. */
+using SoundId = uint32_t;
+
+/** The sound of a voice playing nothing, or of silence as the music. */
+const SoundId kNoSound = UINT32_MAX;
+
+/** What the audio output is told to do with one of its voices. */
+enum class AudioCommandKind : uint8_t {
+  /** Plays a sound from its start on the voice. */
+  kStart,
+
+  /** Changes the gain of the sound playing on the voice. */
+  kSetGain,
+
+  /** Stops the sound playing on the voice. */
+  kStop
+};
+
+/** One change to the audio output. */
+struct AudioCommand {
+  /** What to do with the voice. */
+  AudioCommandKind kind_;
+
+  /** The voice, from 0 to the number of voices. */
+  size_t voice_;
+
+  /** The sound to start, or kNoSound for the other commands. */
+  SoundId sound_;
+
+  /** The gain to start the sound at or to change it to. */
+  float gain_;
+
+  /** Whether the started sound repeats until it is stopped. */
+  bool is_looping_;
+};
+
+/**
+ * Decides what a fixed pool of voices plays. The game says which music
+ * should be playing and which sound effects were triggered as often as it
+ * likes, and the mixer turns that into the few commands that change what
+ * is heard: music changes crossfade over two voices, a sound effect is not
+ * restarted more often than its interval, and nothing is sent for a sound
+ * which is already playing at the right gain.
+ */
+class AudioMixer {
+ public:
+  /**
+   * Creates a mixer with every voice free.
+   *
+   * @param num_voices the number of voices in the pool, at least two so
+   * music can crossfade
+   * @param crossfade_time the time a music change fades over, in seconds
+   * @param sfx_interval the least time between two starts of the same
+   * sound effect, in seconds
+   */
+  AudioMixer(size_t num_voices, double crossfade_time, double sfx_interval);
+
+  /**
+   * Sets the music which should be playing, fading over from the music
+   * playing now on the next update. Does nothing if it is already playing.
+   *
+   * @param music the music, or kNoSound for silence
+   * @param volume the gain of the music once faded in
+   */
+  void SetMusic(SoundId music, float volume);
+
+  /**
+   * Triggers a sound effect, played on the next update unless the same
+   * sound effect was started within its interval.
+   *
+   * @param sfx the sound effect
+   * @param volume the gain of the sound effect
+   * @param duration the length of the sound effect, in seconds
+   */
+  void PlaySfx(SoundId sfx, float volume, double duration);
+
+  /**
+   * Mutes or un-mutes every voice from the next update on.
+   *
+   * @param is_muted true to mute
+   */
+  void SetMuted(bool is_muted);
+
+  /**
+   * Applies everything set since the last update, and advances the fades.
+   *
+   * @param time the current time, in seconds, never less than the time of
+   * the last update
+   * @return the commands to send to the audio output, in order
+   */
+  std::vector<AudioCommand> Update(double time);
+
+  /**
+   * Counts the voices playing a sound.
+   *
+   * @return the number of voices in use
+   */
+  size_t GetNumVoicesInUse() const;
+
+  /**
+   * Determines whether a sound is playing on any voice, including music
+   * which is still fading out.
+   *
+   * @param sound the sound
+   * @return true if the sound is playing
+   */
+  bool IsPlaying(SoundId sound) const;
+
+  /**
+   * Accessor function for whether the voices are muted.
+   *
+   * @return true if muted
+   */
+  inline bool IsMuted() const {
+    return is_muted_;
+  }
+
+  /**
+   * Accessor function for the number of sound effects skipped since the
+   * same sound effect had started within its interval.
+   *
+   * @return the number of skipped sound effects
+   */
+  inline size_t GetNumSkippedSfx() const {
+    return num_skipped_sfx_;
+  }
+
+  /**
+   * Accessor function for the number of sound effects cut off to free a
+   * voice for another sound.
+   *
+   * @return the number of stolen voices
+   */
+  inline size_t GetNumStolenVoices() const {
+    return num_stolen_voices_;
+  }
+
+ private:
+  /** What one voice of the pool is playing. */
+  struct Voice {
+    /** The sound, or kNoSound if the voice is free. */
+    SoundId sound_ = kNoSound;
+
+    /** Whether the sound is music, which is faded instead of stopped. */
+    bool is_music_ = false;
+
+    /** The gain of the sound at full level. */
+    float volume_ = 0;
+
+    /** The gain last sent for the voice. */
+    float gain_ = 0;
+
+    /** The level the current fade started at, from 0 to 1. */
+    float fade_from_ = 0;
+
+    /** The level the current fade ends at, from 0 to 1. */
+    float fade_to_ = 0;
+
+    /** The time the current fade started, in seconds. */
+    double fade_start_ = 0;
+
+    /** The time a sound effect finishes, in seconds. */
+    double end_time_ = 0;
+  };
+
+  /** A sound effect waiting for the next update. */
+  struct SfxRequest {
+    /** The sound effect. */
+    SoundId sfx_;
+
+    /** The gain of the sound effect. */
+    float volume_;
+
+    /** The length of the sound effect, in seconds. */
+    double duration_;
+  };
+
+  /**
+   * Gets the level of a voice within its fade.
+   *
+   * @param voice the voice
+   * @param time the current time, in seconds
+   * @return the level, from 0 to 1
+   */
+  float GetLevel(const Voice& voice, double time) const;
+
+  /**
+   * Starts a fade of a music voice from its current level.
+   *
+   * @param voice the voice
+   * @param level the level to fade to, from 0 to 1
+   * @param time the current time, in seconds
+   */
+  void Fade(Voice* voice, float level, double time) const;
+
+  /**
+   * Finds a voice to play a new sound on, stopping the sound effect which
+   * finishes first if every voice is in use.
+   *
+   * @param commands the commands to add the stop to, if any
+   * @return the index of the voice, or the number of voices if every voice
+   * is playing music
+   */
+  size_t AcquireVoice(std::vector<AudioCommand>* commands);
+
+  /**
+   * Starts the music that should be playing, and fades out any other.
+   *
+   * @param time the current time, in seconds
+   * @param commands the commands to add to
+   */
+  void UpdateMusic(double time, std::vector<AudioCommand>* commands);
+
+  /** The voices of the pool. */
+  std::vector<Voice> voices_;
+
+  /** The time a music change fades over, in seconds. */
+  double crossfade_time_;
+
+  /** The least time between two starts of a sound effect, in seconds. */
+  double sfx_interval_;
+
+  /** The music which should be playing, or kNoSound for silence. */
+  SoundId music_;
+
+  /** The gain of the music which should be playing. */
+  float music_volume_;
+
+  /** The sound effects triggered since the last update. */
+  std::vector<SfxRequest> sfx_requests_;
+
+  /** The time each sound effect last started, in seconds. */
+  std::unordered_map<SoundId, double> sfx_start_times_;
+
+  /** Whether every voice is muted. */
+  bool is_muted_;
+
+  /** The number of sound effects skipped within their interval. */
+  size_t num_skipped_sfx_;
+
+  /** The number of sound effects cut off to free their voice. */
+  size_t num_stolen_voices_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_AUDIO_MIXER_H_
@@ -0,0 +1,240 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_AUTOSAVER_H_
+#define ISLAND_AUTOSAVER_H_
+
+#include "engine.h"
+#include "save_journal.h"
+#include "save_state.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace island {
+
+/** How much saving has cost so far. */
+struct AutosaveStats {
+  /** The number of full saves captured from the engine. */
+  size_t num_captured_;
+
+  /**
+   * The number of full saves and journal batches replaced by a newer full
+   * save before being written.
+   */
+  size_t num_replaced_;
+
+  /** The number of full saves written. */
+  size_t num_written_;
+
+  /** The number of full saves and journal batches which were not written. */
+  size_t num_failed_;
+
+  /** The number of journal batches written. */
+  size_t num_batches_;
+
+  /** The number of changes written to the journal. */
+  size_t num_records_;
+
+  /** The number of bytes written to the journal. */
+  size_t num_journal_bytes_;
+
+  /** The total time the engine's thread spent handing off saves. */
+  std::chrono::nanoseconds stall_time_;
+
+  /** The longest time the engine's thread spent handing off one save. */
+  std::chrono::nanoseconds max_stall_time_;
+
+  /** The total time from capturing each written save to it being on disk. */
+  std::chrono::nanoseconds latency_;
+
+  /** The longest time from capturing a save to it being on disk. */
+  std::chrono::nanoseconds max_latency_;
+};
+
+/**
+ * Saves the game without making the game wait on the file. Between full
+ * saves, the changes the engine records are appended to the save's journal
+ * in batches, so most saves cost as much as what changed. The journal is
+ * compacted into a new full save every so often, when it grows long, and
+ * whenever asked, and loading the save replays the journal written since.
+ *
+ * The engine's thread only captures a save state, which shares the engine's
+ * unchanged item lists, or takes the recorded changes; both are written on
+ * a background thread, in order. A full save replaces everything still
+ * waiting to be written, since it already holds those changes.
+ */
+class Autosaver {
+ public:
+  /**
+   * Constructor which starts the saving thread.
+   *
+   * @param path the path of the save file, with its journal next to it
+   * @param flush_interval the time between journal batches
+   * @param compact_interval the time between full saves, or zero to only
+   * make one when asked or when the journal grows long
+   * @param max_journal_records the number of changes which makes the next
+   * save a full one
+   */
+  Autosaver(std::string path, std::chrono::milliseconds flush_interval,
+            std::chrono::milliseconds compact_interval,
+            size_t max_journal_records);
+
+  /** Destructor which writes everything waiting and stops the thread. */
+  ~Autosaver();
+
+  Autosaver(const Autosaver&) = delete;
+  Autosaver& operator=(const Autosaver&) = delete;
+
+  /** Requests a full save during the next update. */
+  inline void RequestSave() {
+    is_save_requested_ = true;
+  }
+
+  /**
+   * Carries on from the save on disk instead of replacing it, appending
+   * changes to its journal until the next full save. Called after the engine
+   * loaded the save at this saver's path, before the first update.
+   *
+   * @param generation the generation of the loaded save's journal, or 0 if
+   * it has none, in which case the first change makes a full save
+   */
+  void Resume(uint64_t generation);
+
+  /**
+   * Makes a full save if one is due, otherwise hands the engine's recorded
+   * changes to the journal if a batch is due. The first update starts the
+   * engine recording changes; nothing is written until the game changes or
+   * a save is requested, and the first change makes a full save unless the
+   * saver resumed a save. Called from the thread which changes the engine.
+   *
+   * @param engine the engine to save
+   * @return true if anything was handed off to be written
+   */
+  bool Update(Engine* engine);
+
+  /**
+   * Captures a full save and hands it to the saving thread, starting a new
+   * journal after it.
+   *
+   * @param engine the engine to save
+   */
+  void Save(Engine* engine);
+
+  /** Waits until everything handed off has been written or replaced. */
+  void Flush();
+
+  /**
+   * Gets how much saving has cost so far.
+   *
+   * @return the counts and times
+   */
+  AutosaveStats GetStats() const;
+
+ private:
+  /** A full save or a journal batch waiting to be written. */
+  struct Work {
+    /** Determines whether this is a full save rather than a batch. */
+    bool is_full_save_;
+
+    /** The full save. */
+    SaveState state_;
+
+    /** The changes of the batch, oldest first. */
+    std::vector<JournalRecord> records_;
+
+    /** When the save or batch was handed off. */
+    std::chrono::steady_clock::time_point capture_time_;
+  };
+
+  /**
+   * Queues a save or batch and counts the time the engine's thread spent.
+   *
+   * @param work the save or batch
+   * @param start when the engine's thread started handing it off
+   */
+  void Push(Work work, std::chrono::steady_clock::time_point start);
+
+  /** The loop run by the saving thread. */
+  void SaveLoop();
+
+  /**
+   * Writes one save or batch, on the saving thread.
+   *
+   * @param work the save or batch
+   * @return true if it was written
+   */
+  bool Write(const Work& work);
+
+  /** The path of the save file. */
+  const std::string path_;
+
+  /** The time between journal batches. */
+  const std::chrono::milliseconds flush_interval_;
+
+  /** The time between full saves, or zero. */
+  const std::chrono::milliseconds compact_interval_;
+
+  /** The number of changes which makes the next save a full one. */
+  const size_t max_journal_records_;
+
+  /** When the last full save was captured. */
+  std::chrono::steady_clock::time_point last_save_time_;
+
+  /** When the last batch was handed off. */
+  std::chrono::steady_clock::time_point last_flush_time_;
+
+  /** The generation of the last full save, or 0 if there is none yet. */
+  uint64_t generation_;
+
+  /** The number of changes handed off since the last full save. */
+  size_t num_journal_records_;
+
+  /** Determines whether a full save should be made during the next update. */
+  bool is_save_requested_;
+
+  /**
+   * Determines whether the journal on disk no longer follows the save on
+   * disk, because one of them failed to be written, so the next update
+   * has to make a full save. Set by the saving thread.
+   */
+  std::atomic<bool> is_journal_broken_;
+
+  /** The journal of the save, written by the saving thread. */
+  SaveJournal journal_;
+
+  /** The saves and batches waiting to be written, oldest first. */
+  std::deque<Work> pending_;
+
+  /** Determines whether the saving thread is writing a save or batch. */
+  bool is_writing_;
+
+  /** The counts and times so far. */
+  AutosaveStats stats_;
+
+  /** Determines whether the saving thread should keep running. */
+  bool is_running_;
+
+  /** Guards the waiting work, the stats and the flags. */
+  mutable std::mutex mutex_;
+
+  /** Signalled when work is handed off or the saver stops. */
+  std::condition_variable captured_;
+
+  /** Signalled when work has been written. */
+  std::condition_variable written_;
+
+  /** The thread writing the saves and batches. */
+  std::thread thread_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_AUTOSAVER_H_
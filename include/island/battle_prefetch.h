@@ -0,0 +1,51 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_BATTLE_PREFETCH_H_
+#define ISLAND_BATTLE_PREFETCH_H_
+
+#include <string>
+#include <vector>
+
+namespace island {
+
+/**
+ * Decides whose battle assets should be loaded. An npc's assets are loaded
+ * ahead of time once the player comes near them and kept for the battle.
+ * The npc fought last stays loaded while the player is still near them, even
+ * when another npc is as near, so a rematch on the spot is loaded too. It
+ * is dropped once the player walks away.
+ */
+class BattlePrefetch {
+ public:
+  /**
+   * Picks the npc whose assets should be loaded now.
+   *
+   * @param nearby_npcs the names of the npcs the player can battle near
+   * them, nearest first, see Engine::GetCombatableNpcsNear
+   * @param battle_npc_name the name of the npc in battle with the player, or
+   * empty when there is no battle
+   * @return the name of the npc, or empty if no assets should be loaded
+   */
+  const std::string& Update(const std::vector<std::string>& nearby_npcs,
+                            const std::string& battle_npc_name);
+
+  /**
+   * Accessor function for the npc whose assets should be loaded.
+   *
+   * @return the name of the npc, or empty if no assets should be loaded
+   */
+  inline const std::string& GetTarget() const {
+    return target_;
+  }
+
+ private:
+  /** The npc whose assets should be loaded, or empty for none. */
+  std::string target_;
+
+  /** The npc fought last, while the player is still near them. */
+  std::string fought_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_BATTLE_PREFETCH_H_
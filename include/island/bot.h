@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_BOT_H_
+#define ISLAND_BOT_H_
+
+#include "flow_field.h"
+#include "game_session.h"
+#include "location.h"
+#include "replication.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace island {
+
+/** What a bot sets out to do next. */
+enum class BotGoal : uint8_t {
+  kWander,
+  kTalk,
+  kMarket,
+  kBattle
+};
+
+/** Counts of what bots got done. */
+struct BotStats {
+  /**
+   * Adds another bot's counts to these.
+   *
+   * @param rhs the other bot's counts
+   * @return these counts
+   */
+  BotStats& operator+=(const BotStats& rhs);
+
+  /** The number of actions taken. */
+  size_t num_actions_ = 0;
+
+  /** The number of dialogues started, with npcs or about tiles. */
+  size_t num_talks_ = 0;
+
+  /** The number of times the market was opened. */
+  size_t num_market_visits_ = 0;
+
+  /** The number of battles started. */
+  size_t num_battles_ = 0;
+
+  /** The number of goals given up on before they were reached. */
+  size_t num_given_up_ = 0;
+};
+
+/**
+ * The ways to every place bots walk to, the npcs and the market, worked out
+ * once for a world and shared by every bot playing on it.
+ */
+class BotRoutes {
+ public:
+  /**
+   * Constructor which builds a flow field to every place.
+   *
+   * @param world the world the bots play in
+   */
+  explicit BotRoutes(const World& world);
+
+  /**
+   * Accessor function for the places bots walk to for a goal.
+   *
+   * @param goal the goal, other than wandering
+   * @return the indices of the places
+   */
+  inline const std::vector<size_t>& GetTargets(BotGoal goal) const {
+    return targets_[static_cast<size_t>(goal)];
+  }
+
+  /**
+   * Accessor function for the flow field leading to a place.
+   *
+   * @param target the index of the place
+   * @return the flow field
+   */
+  inline const FlowField& GetField(size_t target) const {
+    return fields_[target];
+  }
+
+ private:
+  /** The flow fields leading to every place. */
+  std::vector<FlowField> fields_;
+
+  /** The indices of the places for each goal. */
+  std::vector<std::vector<size_t>> targets_;
+};
+
+/**
+ * A scripted player, which does what a person would in the game's window.
+ * It wanders, talks to npcs, visits the market and battles Sven and Elf,
+ * walking to each along the shared routes and giving up on a goal when it
+ * takes too long. A bot only sees what a client would, the replicated
+ * state, so it can play a headless session as well as a game on a server,
+ * where its actions are sent as the keys which stand for them.
+ */
+class Bot {
+ public:
+  /**
+   * Constructor for a bot on the routes of a world.
+   *
+   * @param routes the routes, which must outlive the bot
+   * @param seed the seed of the bot's choices
+   */
+  Bot(const BotRoutes* routes, uint32_t seed);
+
+  /**
+   * Decides what to do next.
+   *
+   * @param state what the bot sees of its game
+   * @param action where to store the action
+   * @return true if the bot does something, false if it waits
+   */
+  bool GetAction(const ReplicatedState& state, PlayerAction* action);
+
+  /**
+   * Accessor function for what the bot got done.
+   *
+   * @return the counts
+   */
+  inline const BotStats& GetStats() const {
+    return stats_;
+  }
+
+ private:
+  /**
+   * Picks the next goal and the place to walk to for it.
+   *
+   * @param location where the bot is
+   */
+  void PickGoal(const Location& location);
+
+  /**
+   * Decides what to do while walking around.
+   *
+   * @param state what the bot sees of its game
+   * @param action where to store the action
+   * @return true if the bot does something, false if it waits
+   */
+  bool GetPlayingAction(const ReplicatedState& state, PlayerAction* action);
+
+  /** The routes to the places bots walk to. */
+  const BotRoutes* routes_;
+
+  /** The source of the bot's choices. */
+  std::mt19937 random_;
+
+  /** What the bot is doing. */
+  BotGoal goal_;
+
+  /** The index of the place the bot is walking to. */
+  size_t target_;
+
+  /** The number of actions left before the bot gives up on its goal. */
+  size_t num_actions_left_;
+
+  /** What the bot's game was doing when the bot last looked. */
+  SessionState last_state_;
+
+  /** Determines whether the bot has tried to buy since the market opened. */
+  bool has_tried_buying_;
+
+  /** What the bot got done. */
+  BotStats stats_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_BOT_H_
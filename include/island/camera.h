@@ -0,0 +1,159 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_CAMERA_H_
+#define ISLAND_CAMERA_H_
+
+#include <island/location.h>
+
+#include <cstddef>
+
+namespace island {
+
+/** A rectangle of whole tiles on the map. */
+struct TileRect {
+  /** The row of the first tile in the rectangle. */
+  size_t first_row_;
+
+  /** The column of the first tile in the rectangle. */
+  size_t first_col_;
+
+  /** The number of rows the rectangle spans. */
+  size_t num_rows_;
+
+  /** The number of columns the rectangle spans. */
+  size_t num_cols_;
+
+  /**
+   * Determines whether a location lies within the rectangle.
+   *
+   * @param location the location to check
+   * @return true if the location is inside, false otherwise
+   */
+  bool Contains(const Location& location) const;
+
+  /**
+   * Overload for the == operator, compares two rectangles.
+   *
+   * @param rhs the other rectangle to compare with
+   * @return true if both rectangles cover the same tiles
+   */
+  bool operator==(const TileRect& rhs) const;
+
+  /**
+   * Overload for the != operator, compares two rectangles.
+   *
+   * @param rhs the other rectangle to compare with
+   * @return true if the rectangles cover different tiles
+   */
+  bool operator!=(const TileRect& rhs) const;
+};
+
+/**
+ * Tracks which part of the map is on screen. The camera's location is the
+ * tile shown at the top left corner of the view.
+ */
+class Camera {
+ public:
+  /**
+   * Constructor for the camera, starting at the top left of the map with an
+   * empty view and no zoom.
+   *
+   * @param num_rows the number of rows in the map
+   * @param num_cols the number of columns in the map
+   * @param tile_size the size of a tile on screen, in pixels
+   */
+  Camera(size_t num_rows, size_t num_cols, size_t tile_size);
+
+  /**
+   * Sets the size of the view the camera fills.
+   *
+   * @param width the width of the view, in pixels
+   * @param height the height of the view, in pixels
+   */
+  void SetViewSize(size_t width, size_t height);
+
+  /**
+   * Moves the camera so a location is at the center of the view, without
+   * showing anything beyond the edges of the map.
+   *
+   * @param target the location to center on
+   */
+  void Follow(const Location& target);
+
+  /**
+   * Sets how far the camera is zoomed in.
+   *
+   * @param zoom the number of screen pixels per map pixel, where 1 shows
+   * the map at full size and smaller values zoom out
+   */
+  void SetZoom(double zoom);
+
+  /**
+   * Gets the level of detail matching the zoom, where level 0 is the map at
+   * full size and every level after it halves the width and height.
+   *
+   * @return the most zoomed out level with at least one pixel per screen
+   * pixel
+   */
+  size_t GetLevel() const;
+
+  /**
+   * Gets the tiles which are at least partly within the view.
+   *
+   * @return the visible tiles, clamped to the map
+   */
+  TileRect GetVisibleTiles() const;
+
+  /**
+   * Accessor function for the tile at the top left of the view.
+   *
+   * @return the location of the camera
+   */
+  inline Location GetLocation() const {
+    return location_;
+  }
+
+  /**
+   * Accessor function for the size of a tile on screen.
+   *
+   * @return the tile size, in pixels
+   */
+  inline size_t GetTileSize() const {
+    return tile_size_;
+  }
+
+  /**
+   * Accessor function for how far the camera is zoomed in.
+   *
+   * @return the number of screen pixels per map pixel
+   */
+  inline double GetZoom() const {
+    return zoom_;
+  }
+
+ private:
+  /** The number of rows in the map. */
+  size_t num_rows_;
+
+  /** The number of columns in the map. */
+  size_t num_cols_;
+
+  /** The size of a tile on screen, in pixels. */
+  size_t tile_size_;
+
+  /** The width of the view, in pixels. */
+  size_t view_width_;
+
+  /** The height of the view, in pixels. */
+  size_t view_height_;
+
+  /** The number of screen pixels per map pixel. */
+  double zoom_;
+
+  /** The tile at the top left of the view. */
+  Location location_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_CAMERA_H_
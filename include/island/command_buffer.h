@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_COMMAND_BUFFER_H_
+#define ISLAND_COMMAND_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace island {
+
+/** The texture of a command which draws no texture. */
+const uint32_t kNoTexture = UINT32_MAX;
+
+/** What a draw command draws. */
+enum class CommandKind : uint8_t {
+  /** A whole texture stretched over a rectangle. */
+  kSprite,
+
+  /** A texture of rendered text stretched over a rectangle. */
+  kText,
+
+  /** A rectangle of a solid color. */
+  kRect
+};
+
+/** A rectangle on the screen, or on the map, in pixels. */
+struct CommandRect {
+  /** The left edge. */
+  float x1_;
+
+  /** The top edge. */
+  float y1_;
+
+  /** The right edge. */
+  float x2_;
+
+  /** The bottom edge. */
+  float y2_;
+};
+
+/** One recorded draw, without any of the state needed to submit it. */
+struct DrawCommand {
+  /** Commands are drawn in order of layer, lowest first. */
+  uint16_t layer_;
+
+  /** What the command draws. */
+  CommandKind kind_;
+
+  /** The renderer's id for the texture, or kNoTexture. */
+  uint32_t texture_;
+
+  /** The color of a rectangle, as 0xRRGGBBAA. */
+  uint32_t color_;
+
+  /** The order the command was recorded in. */
+  uint32_t sequence_;
+
+  /** Where the command draws. */
+  CommandRect rect_;
+};
+
+/**
+ * A frame's worth of draw commands. Game side code records what it wants
+ * drawn without touching the GPU, and the render stage sorts the commands
+ * so every command sharing a texture within a layer is submitted together.
+ *
+ * Commands in different layers are drawn in the order of their layers, and
+ * commands in the same layer are assumed not to overlap, so only their
+ * textures decide their order. A buffer is recorded by one thread, so each
+ * thread records its own buffer and they are appended together.
+ */
+class CommandBuffer {
+ public:
+  /** Removes every command, keeping the memory for the next frame. */
+  void Clear();
+
+  /**
+   * Records drawing a whole texture.
+   *
+   * @param layer the layer to draw in
+   * @param texture the renderer's id for the texture
+   * @param rect where to draw the texture
+   */
+  void AddSprite(uint16_t layer, uint32_t texture, const CommandRect& rect);
+
+  /**
+   * Records drawing a texture of rendered text.
+   *
+   * @param layer the layer to draw in
+   * @param texture the renderer's id for the text's texture
+   * @param rect where to draw the text
+   */
+  void AddText(uint16_t layer, uint32_t texture, const CommandRect& rect);
+
+  /**
+   * Records drawing a rectangle of a solid color.
+   *
+   * @param layer the layer to draw in
+   * @param color the color, as 0xRRGGBBAA
+   * @param rect where to draw the rectangle
+   */
+  void AddRect(uint16_t layer, uint32_t color, const CommandRect& rect);
+
+  /**
+   * Appends the commands another buffer recorded, as if recorded after
+   * this buffer's commands.
+   *
+   * @param other the buffer to append
+   */
+  void Append(const CommandBuffer& other);
+
+  /**
+   * Sorts the commands by layer, then by kind and texture, keeping the
+   * order they were recorded in otherwise.
+   */
+  void Sort();
+
+  /**
+   * Counts the batches the commands are submitted in, in their current
+   * order: every run of commands of the same kind and texture is one.
+   *
+   * @return the number of batches
+   */
+  size_t CountBatches() const;
+
+  /**
+   * Accessor function for the commands.
+   *
+   * @return the commands, in the order they are to be submitted once sorted
+   */
+  inline const std::vector<DrawCommand>& GetCommands() const {
+    return commands_;
+  }
+
+ private:
+  /**
+   * Records a command.
+   *
+   * @param command the command, whose sequence is filled in
+   */
+  void Add(DrawCommand command);
+
+  /** The commands recorded so far. */
+  std::vector<DrawCommand> commands_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_COMMAND_BUFFER_H_
@@ -4,11 +4,19 @@
 #define ISLAND_ENGINE_H_
 
 #include "direction.h"
+#include "entity_store.h"
+#include "flow_field.h"
+#include "job_system.h"
 #include "player.h"
 #include "map.h"
 #include "npc.h"
+#include "regions.h"
+#include "save_journal.h"
+#include "save_state.h"
+#include "world.h"
 
 #include <cstddef>
+#include <memory>
 #include <string>
 
 namespace island {
@@ -19,7 +27,10 @@ namespace island {
 class Engine {
  public:
   /** The location of the key on the map. */
-  const Location kKeyLocation = {31, 45};
+  const Location kKeyLocation = kIslandKeyLocation;
+
+  /** The number of tiles the npcs' flow field may visit every tick. */
+  const size_t kFlowFieldBudget = 256;
 
   /**
    * Creates a new game for the island.
@@ -40,20 +51,134 @@ class Engine {
          const Statistics& player_stats,
          std::vector<Item> player_inventory, size_t player_money);
 
+  /**
+   * Creates a new game on a world shared with other games, which only keeps
+   * what it changes of the world's map and items.
+   *
+   * @param world the world to play in
+   * @param player_name the name of the player
+   * @param player_loc the location of the player
+   * @param player_stats the statistics of the player
+   * @param player_money the amount of money the player has
+   */
+  Engine(std::shared_ptr<const World> world, const std::string& player_name,
+         const Location& player_loc, const Statistics& player_stats,
+         size_t player_money);
+
   /** Initializes the Npcs throughout the map. */
   void InitializeNpcs();
 
+  /** Finds the locations of all the doors on the map. */
+  void InitializeDoorLocations();
+
   /** Executes a time step, moves the player character. */
   void ExecuteTimeStep();
 
+  /**
+   * Runs the per tick systems of the game: pathfinding towards the player,
+   * the roaming npcs' movement and the distance fields to points of
+   * interest. Systems which don't share any state run at the same time.
+   *
+   * @param job_system the job system to run the systems on
+   */
+  void Tick(JobSystem* job_system);
+
+  /**
+   * Runs the per tick systems of the game one after the other on the
+   * calling thread, for games which are themselves run as jobs.
+   */
+  void Tick();
+
+  /**
+   * Adds an npc to the game.
+   *
+   * @param npc the npc to add
+   * @param is_roaming whether the npc chases the player around the map
+   * @return the handle to the npc
+   */
+  EntityHandle AddNpc(const Npc& npc, bool is_roaming);
+
   /** Gets the location delta value from a direction. */
   Location GetLocationDelta(const Direction& direction) const;
 
-  /** Saves the game. */
-  void Save();
+  /**
+   * Captures everything a save file holds. The item lists are only copied
+   * when they have changed since the last capture, otherwise the save
+   * shares the lists of the last one.
+   *
+   * @return the save
+   */
+  SaveState CaptureSave() const;
+
+  /**
+   * Restores the game to a save, leaving the npcs as they are. Only the
+   * tiles which differ between the map and the save are set, and tiles
+   * off the map are ignored.
+   *
+   * @param state the save
+   */
+  void Restore(const SaveState& state);
+
+  /**
+   * Makes the change a journal record describes, as if it were made through
+   * the engine's own functions. Tiles and moves off the map are ignored, as
+   * are tiles and directions which do not exist.
+   *
+   * @param record the change
+   */
+  void Apply(const JournalRecord& record);
+
+  /**
+   * Starts or stops recording every change to the saved state of the game,
+   * dropping what has been recorded so far.
+   *
+   * @param is_journaling true to record changes, false to stop
+   */
+  void SetJournaling(bool is_journaling);
+
+  /**
+   * Determines whether changes are being recorded.
+   *
+   * @return true if changes are recorded, false otherwise
+   */
+  inline bool IsJournaling() const {
+    return is_journaling_;
+  }
+
+  /**
+   * Takes the changes recorded since the last time they were taken.
+   *
+   * @return the changes, oldest first
+   */
+  std::vector<JournalRecord> TakeJournal();
+
+  /**
+   * Accessor function for the number of changes recorded and not yet taken.
+   *
+   * @return the number of changes
+   */
+  inline size_t GetNumJournalRecords() const {
+    return journal_.size();
+  }
 
-  /** Loads the saved game. */
-  void Load(const std::string& file_path);
+  /**
+   * Saves the game, waiting for the file to be written.
+   *
+   * @param file_path the path of the save file
+   * @return true if the save was written, false otherwise
+   */
+  bool Save(const std::string& file_path) const;
+
+  /**
+   * Loads the saved game, then replays its journal if the journal belongs
+   * to it.
+   *
+   * @param file_path the path of the save file
+   * @param generation where to store the generation of the save's journal,
+   * 0 if it has none, or nullptr
+   * @return true if the save was loaded, false if it is missing or invalid
+   */
+  bool Load(const std::string& file_path, uint64_t* generation = nullptr);
 
   /** Determines whether the direction the player wants to move in is valid. */
   bool IsValidDirection(const Direction& direction) const;
@@ -62,6 +187,7 @@ class Engine {
    * Gets the npc that is at the location specified on the map.
    *
    * @param location the location at which the npc is
+   * @return the npc, or an unnamed npc if there is none at the location
    */
   Npc GetNpcAtLocation(const Location& location) const;
 
@@ -81,11 +207,52 @@ class Engine {
    */
   Tile GetTileType(const Location& location) const;
 
-  /** Changes the direction of the player character with each step. */
-  inline void SetDirection(const Direction& direction) {
-    direction_ = direction;
+  /**
+   * Determines whether the player can walk onto, or right next to, a location
+   * from where they are currently standing. Runs in constant time.
+   *
+   * @param location the location to reach, such as a door or an npc
+   * @return true if the location can be reached, false otherwise
+   */
+  bool CanPlayerReach(const Location& location) const;
+
+  /**
+   * Gets the number of steps the player needs to take to reach a point of
+   * interest, such as the key or a door.
+   *
+   * @param location the location of the point of interest
+   * @return the number of steps, or kUnreachable
+   */
+  uint16_t GetPlayerDistance(const Location& location);
+
+  /**
+   * Gets all the npcs the player can walk up to and interact with.
+   *
+   * @return the reachable npcs
+   */
+  std::vector<Npc> GetReachableNpcs() const;
+
+  /**
+   * Gets the npcs the player can battle within a number of tiles of them,
+   * in either direction.
+   *
+   * @param num_tiles the furthest an npc may be, in tiles
+   * @return the names of the npcs, nearest first
+   */
+  std::vector<std::string> GetCombatableNpcsNear(size_t num_tiles) const;
+
+  /**
+   * Accessor function for the reachability regions of the map.
+   *
+   * @return the regions of the map
+   */
+  inline const Regions& GetRegions() const {
+    return *regions_;
   }
 
+  /** Changes the direction of the player character with each step. */
+  void SetDirection(const Direction& direction);
+
   /**
    * Adds the specified item to the player's inventory.
    *
@@ -107,6 +274,15 @@ class Engine {
    */
   void AddItem(const Item& item);
 
+  /**
+   * Puts items on sale in a new game, after the ones it already has. A game
+   * restored from a save is left as it is, since the save holds the items
+   * still on sale.
+   *
+   * @param items the items to put on sale
+   */
+  void StockItems(const std::vector<Item>& items);
+
   /**
    * Removes the specified item from the list of items in the game.
    *
@@ -123,6 +299,36 @@ class Engine {
    */
   void SetTile(const Location& location, const Tile& tile);
 
+  /**
+   * Accessor function for the number of changes made through SetTile, so a
+   * reader only has to look at the tiles again once it has grown.
+   *
+   * @return the number of changes made to the map
+   */
+  inline size_t GetNumTileChanges() const {
+    return num_tile_changes_;
+  }
+
+  /**
+   * Gets every tile which differs from the map the game started with.
+   *
+   * @return the overridden tiles, row after row
+   */
+  inline std::vector<TileChange> GetTileOverrides() const {
+    return map_.GetOverrides();
+  }
+
+  /**
+   * Gets the tile at a location as it was when the game started, whatever
+   * it has been set to since.
+   *
+   * @param location the location of the tile
+   * @return the tile type as a Tile enum object
+   */
+  inline Tile GetBaseTileType(const Location& location) const {
+    return map_.GetBaseTile(location);
+  }
+
   /**
    * Accessor function for any item in the game.
    *
@@ -145,7 +351,7 @@ class Engine {
    * @return the number of items
    */
   inline size_t GetNumItems() const {
-    return items_.size();
+    return items_->size();
   }
 
   /**
@@ -153,18 +359,14 @@ class Engine {
    *
    * @param money_to_add the amount of money to be added
    */
-  inline void AddMoney(size_t money_to_add) {
-    player_.money_ += money_to_add;
-  }
+  void AddMoney(size_t money_to_add);
 
   /**
    * Remove a certain amount of money from the player's pocket
    *
    * @param money_to_remove the amount money to be removed
    */
-  void RemoveMoney(size_t money_to_remove) {
-    player_.money_ -= money_to_remove;
-  }
+  void RemoveMoney(size_t money_to_remove);
 
   /**
    * Accessor function for an item in the player's inventory.
@@ -181,7 +383,7 @@ class Engine {
    *
    * @return the player in the game engine
    */
-  inline Player GetPlayer() const {
+  inline const Player& GetPlayer() const {
     return player_;
   }
 
@@ -190,7 +392,17 @@ class Engine {
    *
    * @return the npcs in the game
    */
-  inline std::vector<Npc> GetNpcs() {
+  inline std::vector<Npc> GetNpcs() const {
+    return npcs_.GetNpcs();
+  }
+
+  /**
+   * Accessor function for the column store of the npcs in the game, for
+   * systems which only need a few of the npcs' properties.
+   *
+   * @return the npc store
+   */
+  inline const EntityStore& GetNpcStore() const {
     return npcs_;
   }
 
@@ -208,11 +420,54 @@ class Engine {
    *
    * @param is_key_found true if the key is found, false otherwise
    */
-  inline void SetKey(bool is_key_found) {
-    is_key_found_ = is_key_found;
-  }
+  void SetKey(bool is_key_found);
+
+  /**
+   * Counts roughly how much memory this game uses, leaving out whatever it
+   * shares with other games, such as the map's tiles and unchanged items.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumBytes() const;
 
  private:
+  /** Moves the flow field's build towards the player. */
+  void UpdatePathfinding();
+
+  /** Moves the roaming npcs one step along the flow field. */
+  void MoveNpcs();
+
+  /** Computes the distance fields to the key and the doors, if missing. */
+  void UpdateDistanceFields();
+
+  /**
+   * Makes sure the distance field from a point of interest is cached. The
+   * regions are copied the first time a field has to be computed.
+   *
+   * @param source the location of the point of interest
+   * @param regions the copy of the regions, or nullptr if none was made yet
+   */
+  void CacheDistanceField(const Location& source,
+                          std::shared_ptr<Regions>* regions) const;
+
+  /**
+   * Determines whether a location is on the map, as a corrupt save or
+   * journal may hold any location.
+   *
+   * @param location the location
+   * @return true if the location is within the map's rows and columns
+   */
+  bool IsOnMap(const Location& location) const;
+
+  /**
+   * Records a change, if changes are being recorded. A move or a turn
+   * replaces the last record when it was a move or a turn too, since only
+   * where the player ended up matters.
+   *
+   * @param record the change
+   */
+  void Record(JournalRecord record);
+
   /** The width of the island map. */
   size_t width_;
 
@@ -231,11 +486,44 @@ class Engine {
   /** Map of the game. */
   Map map_;
 
-  /** The list of all items in the game. */
-  std::vector<Item> items_;
+  /**
+   * The reachability regions of the map, kept up to date with the map. They
+   * are copied whenever they change, so games can share the world's.
+   */
+  std::shared_ptr<const Regions> regions_;
+
+  /**
+   * The directions roaming npcs follow to chase the player, or nullptr until
+   * the game has a roaming npc.
+   */
+  std::unique_ptr<FlowField> flow_field_;
+
+  /** The locations of the doors on the map, found when the game starts. */
+  std::vector<Location> door_locations_;
+
+  /** The number of changes made to the map through SetTile. */
+  size_t num_tile_changes_;
+
+  /**
+   * The list of all items in the game, copied whenever it changes, so saves
+   * and the world it came from can share it.
+   */
+  std::shared_ptr<const std::vector<Item>> items_;
+
+  /** All the non player characters in the game, stored by column. */
+  EntityStore npcs_;
+
+  /** The inventory as of the last save, or nullptr if it has changed since. */
+  mutable std::shared_ptr<const std::vector<Item>> saved_inventory_;
+
+  /** Determines whether changes are being recorded. */
+  bool is_journaling_;
+
+  /** Determines whether the game was restored from a save. */
+  bool is_restored_;
 
-  /** The list of all the non player characters in the game. */
-  std::vector<Npc> npcs_;
+  /** The changes recorded and not yet taken, oldest first. */
+  std::vector<JournalRecord> journal_;
 };
 
 }  // namespace island
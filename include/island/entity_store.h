@@ -0,0 +1,194 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_ENTITY_STORE_H_
+#define ISLAND_ENTITY_STORE_H_
+
+#include "location.h"
+#include "npc.h"
+#include "statistics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/**
+ * Refers to one entity in an EntityStore. A handle stops being valid once
+ * its entity is destroyed, even if the slot is later reused by another one.
+ */
+struct EntityHandle {
+  /** The slot of the entity in the store. */
+  uint32_t index_;
+
+  /** The generation of the slot when the entity was created. */
+  uint32_t generation_;
+};
+
+/**
+ * Stores the non player characters of the game one column per property,
+ * rather than one struct per character. Systems that run every tick, such as
+ * movement or drawing, can then walk through only the columns they use.
+ *
+ * All columns are dense and share the same order, so the value at a given
+ * dense index of every column belongs to the same entity. Destroying an
+ * entity moves the last entity into its place to keep the columns packed.
+ */
+class EntityStore {
+ public:
+  /**
+   * Adds an npc to the store.
+   *
+   * @param npc the npc to add
+   * @param is_roaming whether the npc walks around the map on its own
+   * @return the handle to the new entity
+   */
+  EntityHandle Create(const Npc& npc, bool is_roaming = false);
+
+  /**
+   * Removes an entity from the store.
+   *
+   * @param handle the handle to the entity
+   * @return true if the entity existed, false otherwise
+   */
+  bool Destroy(const EntityHandle& handle);
+
+  /**
+   * Determines whether a handle still refers to an entity in the store.
+   *
+   * @param handle the handle to check
+   * @return true if the entity exists, false otherwise
+   */
+  bool IsAlive(const EntityHandle& handle) const;
+
+  /**
+   * Gets the position of an entity in the columns.
+   *
+   * @param handle the handle to the entity, which must be alive
+   * @return the dense index of the entity
+   */
+  size_t GetDenseIndex(const EntityHandle& handle) const;
+
+  /**
+   * Gets the handle of the entity at a position in the columns.
+   *
+   * @param dense_index the dense index of the entity
+   * @return the handle to the entity
+   */
+  EntityHandle GetHandle(size_t dense_index) const;
+
+  /**
+   * Gathers the columns of one entity back into an Npc.
+   *
+   * @param dense_index the dense index of the entity
+   * @return the npc
+   */
+  Npc GetNpc(size_t dense_index) const;
+
+  /**
+   * Gathers the columns of every entity back into a list of npcs.
+   *
+   * @return the npcs, in dense order
+   */
+  std::vector<Npc> GetNpcs() const;
+
+  /**
+   * Finds the entity standing at a location.
+   *
+   * @param location the location to search
+   * @return the dense index of the entity, or the size of the store if there
+   * is no entity at the location
+   */
+  size_t FindAtLocation(const Location& location) const;
+
+  /**
+   * Accessor function for the number of entities in the store.
+   *
+   * @return the number of entities
+   */
+  inline size_t GetSize() const {
+    return locations_.size();
+  }
+
+  /** Accessor function for the name column. */
+  inline const std::vector<std::string>& GetNames() const {
+    return names_;
+  }
+
+  /** Accessor function for the location column. */
+  inline const std::vector<Location>& GetLocations() const {
+    return locations_;
+  }
+
+  /** Mutable accessor function for the location column. */
+  inline std::vector<Location>& GetLocations() {
+    return locations_;
+  }
+
+  /** Accessor function for the statistics column. */
+  inline const std::vector<Statistics>& GetStatistics() const {
+    return statistics_;
+  }
+
+  /** Mutable accessor function for the statistics column. */
+  inline std::vector<Statistics>& GetStatistics() {
+    return statistics_;
+  }
+
+  /** Accessor function for the column of whether each npc can battle. */
+  inline const std::vector<uint8_t>& GetIsCombatable() const {
+    return is_combatable_;
+  }
+
+  /** Accessor function for the column of whether each npc roams the map. */
+  inline const std::vector<uint8_t>& GetIsRoaming() const {
+    return is_roaming_;
+  }
+
+  /** Accessor function for the money column. */
+  inline const std::vector<size_t>& GetMoney() const {
+    return money_;
+  }
+
+ private:
+  /** Where an entity's slot points into the columns. */
+  struct Slot {
+    /** The dense index of the entity using the slot. */
+    uint32_t dense_index_;
+
+    /** Incremented every time the slot's entity is destroyed. */
+    uint32_t generation_;
+  };
+
+  /** The slots handles refer to, indexed by handle index. */
+  std::vector<Slot> slots_;
+
+  /** The indices of slots which have no entity. */
+  std::vector<uint32_t> free_slots_;
+
+  /** The slot of every entity, indexed by dense index. */
+  std::vector<uint32_t> dense_to_slot_;
+
+  /** The name of every entity. */
+  std::vector<std::string> names_;
+
+  /** The location of every entity. */
+  std::vector<Location> locations_;
+
+  /** The battle statistics of every entity. */
+  std::vector<Statistics> statistics_;
+
+  /** Whether the player can battle every entity, stored as 0 or 1. */
+  std::vector<uint8_t> is_combatable_;
+
+  /** The money the player gains when defeating every entity in battle. */
+  std::vector<size_t> money_;
+
+  /** Whether every entity walks around the map, stored as 0 or 1. */
+  std::vector<uint8_t> is_roaming_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_ENTITY_STORE_H_
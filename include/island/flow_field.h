@@ -0,0 +1,211 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_FLOW_FIELD_H_
+#define ISLAND_FLOW_FIELD_H_
+
+#include <island/direction.h>
+#include <island/location.h>
+#include <island/map.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace island {
+
+/**
+ * Stores, for every accessible tile on the map, the direction to step in to
+ * get closer to a single target. Any number of characters chasing the same
+ * target can then move with one lookup each, instead of each running their
+ * own path search.
+ *
+ * When the target moves, the new field is built a few tiles at a time over
+ * later ticks, within each call to Advance, while lookups keep using the
+ * last complete field until the new one is ready.
+ */
+class FlowField {
+ public:
+  /**
+   * Constructor for the flow field, starts with no target.
+   *
+   * @param map the map the field is built over
+   */
+  explicit FlowField(const Map& map);
+
+  /**
+   * Sets a new target for the field and starts building the field towards
+   * it. If a build is already in progress, it is finished first and the
+   * newest target is built next, so a target that moves every tick still
+   * gets complete fields.
+   *
+   * @param target the location to flow towards
+   */
+  void SetTarget(const Location& target);
+
+  /**
+   * Restarts the build towards the latest target, to be called whenever a
+   * tile on the map changes.
+   */
+  void Invalidate();
+
+  /**
+   * Continues building the field towards the current target.
+   *
+   * @param map the map the field is built over
+   * @param budget the maximum number of tiles to visit in this call
+   * @return true if the field is complete, false otherwise
+   */
+  bool Advance(const Map& map, size_t budget);
+
+  /**
+   * Builds the whole field towards the current target at once.
+   *
+   * @param map the map the field is built over
+   */
+  void Rebuild(const Map& map);
+
+  /**
+   * Determines whether a location has a direction leading to the target.
+   *
+   * @param location the location to check
+   * @return true if the target can be reached by following the field
+   */
+  bool HasDirection(const Location& location) const;
+
+  /**
+   * Gets the direction to step in from a location to get closer to the
+   * target. Only valid when HasDirection is true.
+   *
+   * @param location the location to step from
+   * @return the direction to step in
+   */
+  Direction GetDirection(const Location& location) const;
+
+  /**
+   * Gets the location one step closer to the target. Characters that are
+   * already next to the target, or can't reach it, stay where they are, so
+   * chasers never walk onto the target itself.
+   *
+   * @param location the location to step from
+   * @return the next location
+   */
+  Location Step(const Location& location) const;
+
+  /**
+   * Moves every location in a list one step closer to the target.
+   *
+   * @param locations the locations to step, updated in place
+   */
+  void StepAll(std::vector<Location>* locations) const;
+
+  /**
+   * Gets the number of steps from a location to the target.
+   *
+   * @param location the location to measure from
+   * @return the number of steps, or UINT16_MAX if it can't be reached
+   */
+  uint16_t GetDistance(const Location& location) const;
+
+  /**
+   * Determines whether the field has caught up with the latest target.
+   *
+   * @return true if no build is in progress, false otherwise
+   */
+  inline bool IsComplete() const {
+    return !is_building_;
+  }
+
+  /**
+   * Accessor function for the target the lookups currently lead to.
+   *
+   * @return the target of the last complete field
+   */
+  inline Location GetTarget() const {
+    return target_;
+  }
+
+  /**
+   * Counts the memory the field and the one being built use.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumBytes() const;
+
+ private:
+  /** The direction value stored for tiles with no way to the target. */
+  static const uint8_t kNoDirection = 4;
+
+  /**
+   * Converts a location on the map to an index into the field.
+   *
+   * @param location the location to convert
+   * @return the index
+   */
+  inline size_t ToIndex(const Location& location) const {
+    return static_cast<size_t>(location.GetRow()) * num_cols_ +
+           static_cast<size_t>(location.GetCol());
+  }
+
+  /**
+   * Determines whether a location lies within the map.
+   *
+   * @param location the location to check
+   * @return true if the location is on the map, false otherwise
+   */
+  bool IsOnMap(const Location& location) const;
+
+  /**
+   * Gets the location delta for a direction, matching the engine's
+   * movement so that characters can step with the engine's rules.
+   *
+   * @param direction the direction to step in
+   * @return the change in location
+   */
+  static Location GetDelta(Direction direction);
+
+  /** Clears the back buffers and seeds the search from the pending target. */
+  void StartBuild();
+
+  /** The number of rows in the map. */
+  size_t num_rows_;
+
+  /** The number of columns in the map. */
+  size_t num_cols_;
+
+  /** The target the complete field leads to. */
+  Location target_;
+
+  /** The target the field is currently being built towards. */
+  Location pending_target_;
+
+  /** The most recent target set, built once the current build finishes. */
+  Location latest_target_;
+
+  /** Determines whether the field has a target at all. */
+  bool has_target_;
+
+  /** Determines whether a build towards the pending target is in progress. */
+  bool is_building_;
+
+  /** The complete field's direction for every tile. */
+  std::vector<uint8_t> directions_;
+
+  /** The complete field's distance for every tile. */
+  std::vector<uint16_t> distances_;
+
+  /** The directions of the field being built. */
+  std::vector<uint8_t> back_directions_;
+
+  /** The distances of the field being built. */
+  std::vector<uint16_t> back_distances_;
+
+  /** The tiles the build still has to visit, in breadth first order. */
+  std::vector<Location> frontier_;
+
+  /** The index of the next tile in the frontier to visit. */
+  size_t frontier_head_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_FLOW_FIELD_H_
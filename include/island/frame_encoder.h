@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_FRAME_ENCODER_H_
+#define ISLAND_FRAME_ENCODER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace island {
+
+/** One captured frame, tightly packed RGBA with the top row first. */
+struct CapturedFrame {
+  /** The number of the frame since the capture started. */
+  size_t index_;
+
+  /** The width of the frame, in pixels. */
+  size_t width_;
+
+  /** The height of the frame, in pixels. */
+  size_t height_;
+
+  /** The pixels of the frame. */
+  std::vector<uint8_t> pixels_;
+};
+
+/** How much a capture has cost so far. */
+struct CaptureStats {
+  /** The number of frames handed to the encoder. */
+  size_t num_submitted_;
+
+  /** The number of frames dropped because every slot was busy. */
+  size_t num_dropped_;
+
+  /** The number of frames the encoder has finished writing. */
+  size_t num_encoded_;
+
+  /** The total time the encoder thread spent writing frames. */
+  std::chrono::nanoseconds encode_time_;
+};
+
+/**
+ * Writes captured frames on a background thread. Frames are copied into one
+ * of a fixed number of slots, so memory use is bounded. When every slot is
+ * still waiting to be written, the next frame is dropped rather than making
+ * the capturing thread wait.
+ *
+ * Frames are acquired and submitted from one thread, and written in the
+ * order they were submitted.
+ */
+class FrameEncoder {
+ public:
+  /**
+   * Constructor which starts the encoder thread.
+   *
+   * @param num_slots the number of frames which can wait to be written
+   * @param encode writes one frame, called on the encoder thread
+   */
+  FrameEncoder(size_t num_slots,
+               std::function<void(const CapturedFrame&)> encode);
+
+  /** Destructor which writes the waiting frames and stops the thread. */
+  ~FrameEncoder();
+
+  FrameEncoder(const FrameEncoder&) = delete;
+  FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+  /**
+   * Takes a free slot to copy the next frame into. Counts the frame as
+   * dropped if there is none.
+   *
+   * @return the slot, or nullptr if every slot is busy
+   */
+  CapturedFrame* Acquire();
+
+  /**
+   * Hands a filled slot to the encoder thread.
+   *
+   * @param frame the slot returned by Acquire
+   */
+  void Submit(CapturedFrame* frame);
+
+  /** Waits until every submitted frame has been written. */
+  void Flush();
+
+  /**
+   * Gets how much the capture has cost so far.
+   *
+   * @return the counts and the time spent writing
+   */
+  CaptureStats GetStats() const;
+
+ private:
+  /** The loop run by the encoder thread. */
+  void EncodeLoop();
+
+  /** Writes one frame. */
+  std::function<void(const CapturedFrame&)> encode_;
+
+  /** The storage for every frame. */
+  std::vector<CapturedFrame> slots_;
+
+  /** The slots which can be acquired. */
+  std::vector<CapturedFrame*> free_slots_;
+
+  /** The slots waiting to be written, oldest first. */
+  std::deque<CapturedFrame*> pending_;
+
+  /** The number of frames acquired so far, numbering the next frame. */
+  size_t num_acquired_;
+
+  /** The number of frames submitted so far. */
+  size_t num_submitted_;
+
+  /** The number of frames dropped so far. */
+  size_t num_dropped_;
+
+  /** The number of frames written so far. */
+  size_t num_encoded_;
+
+  /** The total time spent writing frames. */
+  std::chrono::nanoseconds encode_time_;
+
+  /** Determines whether the encoder thread should keep running. */
+  bool is_running_;
+
+  /** Guards the slots, the counts and is_running_. */
+  mutable std::mutex mutex_;
+
+  /** Signalled when a frame is submitted or the encoder stops. */
+  std::condition_variable submitted_;
+
+  /** Signalled when a frame has been written. */
+  std::condition_variable encoded_;
+
+  /** The thread writing the frames. */
+  std::thread thread_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_FRAME_ENCODER_H_
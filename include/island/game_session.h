@@ -0,0 +1,309 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_GAME_SESSION_H_
+#define ISLAND_GAME_SESSION_H_
+
+#include "direction.h"
+#include "engine.h"
+#include "item.h"
+#include "job_system.h"
+#include "location.h"
+#include "npc.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/** The location on the map where the market is. */
+const Location kMarketLocation = {36, 36};
+
+/** Where a new player starts out. */
+const Location kStartLocation = {7, 0};
+
+/** The money a new player starts out with. */
+const size_t kStartMoney = 1200;
+
+/** The price of an item on the market. */
+const size_t kItemPrice = 5000;
+
+/** The reward of money one gets for completing the key quest. */
+const size_t kKeyMoney = 8800;
+
+/** Money awarded to the player every time they interact with the puddle. */
+const size_t kPuddleMoney = 100;
+
+/**
+ * The ratio of attack over defense in calculations in battle.
+ * A higher value would mean all characters deal more damage.
+ */
+const double kAttackConstant = 2.0;
+
+/**
+ * The constant used to calculate how much the characters heal in battle.
+ * A lower value would mean all characters heal more health.
+ */
+const double kHealConstant = 4.0;
+
+/** The statistical bonus the player gets from getting items. */
+const double kStatMultiplier = 1.5;
+
+/** Everything a player can do, whatever key they pressed to do it. */
+enum class PlayerAction : uint8_t {
+  kMoveUp,
+  kMoveDown,
+  kMoveLeft,
+  kMoveRight,
+  kInteract,
+  kToggleInventory,
+  kAccept,
+  kDecline,
+  kAttack,
+  kHeal,
+  kRun
+};
+
+/** What a session's player is doing. */
+enum class SessionState : uint8_t {
+  kPlaying,
+  kInventory,
+  kMarket,
+  kTalking,
+  kBattle
+};
+
+/**
+ * One player's game without a window: the engine along with the rules the
+ * game plays by, which the game's window and the server both play through.
+ * Text is never shown, so a dialogue is a state the next interaction
+ * leaves, and a battle turn ends as soon as the npc has answered the
+ * player's move; the window shows the text of each on top.
+ */
+class GameSession {
+ public:
+  /**
+   * Constructor for a new game on a shared world.
+   *
+   * @param world the world to play in
+   * @param player_name the name of the player
+   */
+  GameSession(std::shared_ptr<const World> world,
+              const std::string& player_name);
+
+  /**
+   * Does what the player asked for, if it can be done in the current state.
+   *
+   * @param action the action
+   */
+  void HandleAction(PlayerAction action);
+
+  /** Runs one tick of the game, moving the player if they asked to. */
+  void Step();
+
+  /**
+   * Runs one tick of the game, moving the player if they asked to, with the
+   * engine's per tick systems run alongside each other.
+   *
+   * @param job_system the job system to run the systems on
+   */
+  void Step(JobSystem* job_system);
+
+  /**
+   * Accessor function for the engine of the game.
+   *
+   * @return the engine
+   */
+  inline const Engine& GetEngine() const {
+    return engine_;
+  }
+
+  /**
+   * Accessor function for the engine of the game, to change it directly.
+   *
+   * @return the engine
+   */
+  inline Engine& GetEngine() {
+    return engine_;
+  }
+
+  /**
+   * Accessor function for what the player is doing.
+   *
+   * @return the state
+   */
+  inline SessionState GetState() const {
+    return state_;
+  }
+
+  /**
+   * Accessor function for the direction the player last tried to move in.
+   *
+   * @return the direction the player is facing
+   */
+  inline Direction GetFacing() const {
+    return facing_;
+  }
+
+  /**
+   * Determines whether the dialogue being shown leads into a battle, which
+   * starts on the interaction that ends the dialogue.
+   *
+   * @return true if a battle follows the dialogue, false otherwise
+   */
+  inline bool IsBattleStarting() const {
+    return state_ == SessionState::kTalking && should_start_battle_;
+  }
+
+  /**
+   * Accessor function for the npc the player is battling or about to.
+   *
+   * @return the npc, unnamed if there is none
+   */
+  inline const Npc& GetBattleNpc() const {
+    return battle_npc_;
+  }
+
+  /**
+   * Accessor function for the hit points the player has left in the battle.
+   *
+   * @return the hit points
+   */
+  inline double GetPlayerHp() const {
+    return player_hp_;
+  }
+
+  /**
+   * Accessor function for the hit points the npc has left in the battle.
+   *
+   * @return the hit points
+   */
+  inline double GetNpcHp() const {
+    return npc_hp_;
+  }
+
+  /**
+   * Accessor function for the number of turns the npc has taken in the
+   * battle, which includes a first turn when the npc is faster.
+   *
+   * @return the number of turns
+   */
+  inline size_t GetNumNpcTurns() const {
+    return num_npc_turns_;
+  }
+
+  /**
+   * Gets the item the market sells next. The market sells everything in the
+   * game except the key, in order.
+   *
+   * @param item where to store the item
+   * @return true if the market has an item for sale, false otherwise
+   */
+  bool GetItemForSale(Item* item) const;
+
+  /**
+   * Accessor function for the directions the npcs face, which turn towards
+   * the player when talked to.
+   *
+   * @return the directions, in the order of the engine's npc store
+   */
+  inline const std::vector<Direction>& GetNpcFacings() const {
+    return npc_facings_;
+  }
+
+  /**
+   * Counts roughly how much memory this game uses on top of its world.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumBytes() const;
+
+ private:
+  /**
+   * Turns the player and starts a step if the way is clear.
+   *
+   * @param direction the direction to move in
+   */
+  void Move(Direction direction);
+
+  /** Interacts with whatever the player is facing. */
+  void Interact();
+
+  /**
+   * Turns the npc at a location to face the player.
+   *
+   * @param location the location of the npc
+   */
+  void TurnNpc(const Location& location);
+
+  /**
+   * Talks to an npc, and gets ready to battle them if they battle.
+   *
+   * @param location the location of the npc
+   */
+  void TalkToNpc(const Location& location);
+
+  /** Buys the next item on the market, if the player can afford it. */
+  void BuyItem();
+
+  /**
+   * Plays the player's move in a battle and the npc's answer.
+   *
+   * @param action the move
+   */
+  void BattleTurn(PlayerAction action);
+
+  /** Runs the npc's turn in a battle. */
+  void NpcTurn();
+
+  /** Ends the battle if either side lost or the player ran. */
+  void UpdateBattle();
+
+  /**
+   * Gets the bonus an item in the inventory gives to a statistic.
+   *
+   * @param item_name the name of the item
+   * @return kStatMultiplier if the player has the item, 1 otherwise
+   */
+  double GetMultiplier(const std::string& item_name) const;
+
+  /** The engine of the game. */
+  Engine engine_;
+
+  /** What the player is doing. */
+  SessionState state_;
+
+  /** The direction the player last tried to move in. */
+  Direction facing_;
+
+  /** Determines whether the player moves during the next tick. */
+  bool is_moving_;
+
+  /** Determines whether leaving the dialogue starts a battle. */
+  bool should_start_battle_;
+
+  /** The npc the player is battling or about to. */
+  Npc battle_npc_;
+
+  /** The directions the npcs face, in the order of the npc store. */
+  std::vector<Direction> npc_facings_;
+
+  /** The hit points the player has left in the battle. */
+  double player_hp_;
+
+  /** The hit points the npc has left in the battle. */
+  double npc_hp_;
+
+  /** The number of turns the npc has taken in the battle. */
+  size_t num_npc_turns_;
+
+  /** Determines whether the player ran from the battle. */
+  bool has_run_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_GAME_SESSION_H_
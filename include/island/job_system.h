@@ -0,0 +1,211 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_JOB_SYSTEM_H_
+#define ISLAND_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace island {
+
+/** Identifies a job submitted to the job system. */
+using JobId = size_t;
+
+/** How long a single job took to run, and where it ran. */
+struct JobTiming {
+  /** The name the job was submitted with. */
+  std::string name_;
+
+  /** The time the job spent running. */
+  std::chrono::nanoseconds duration_;
+
+  /** The worker that ran the job, with the waiting thread as the last one. */
+  size_t worker_;
+};
+
+/**
+ * Runs jobs on a fixed pool of worker threads. Jobs may depend on other
+ * jobs, and only start once all their dependencies have finished.
+ *
+ * Every worker has its own queue of ready jobs. A worker takes the newest job
+ * from its own queue, and when that is empty, steals the oldest job from
+ * another worker's queue. The thread calling Wait helps run jobs as well.
+ *
+ * With zero workers the system is deterministic: every job runs on the
+ * thread calling Wait, in the order the jobs were submitted, as soon as its
+ * dependencies allow.
+ *
+ * Jobs are submitted from one thread, and are not allowed to submit jobs.
+ */
+class JobSystem {
+ public:
+  /**
+   * Constructor which starts the worker threads.
+   *
+   * @param num_workers the number of worker threads, zero to run every job
+   * deterministically on the thread calling Wait
+   */
+  explicit JobSystem(size_t num_workers);
+
+  /** Destructor which waits for all jobs and stops the worker threads. */
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  /**
+   * Adds a job to be run once all its dependencies have finished.
+   *
+   * @param name the name of the job, used in the timings
+   * @param task the work to be done
+   * @param dependencies the jobs which have to finish first
+   * @return the id of the job, to be used as another job's dependency
+   */
+  JobId Submit(const std::string& name, std::function<void()> task,
+               const std::vector<JobId>& dependencies = {});
+
+  /**
+   * Runs jobs on the calling thread until every submitted job has finished,
+   * then records their timings and forgets them.
+   */
+  void Wait();
+
+  /**
+   * Accessor function for the timings of the jobs run by the last Wait.
+   *
+   * @return the timings, in the order the jobs were submitted
+   */
+  inline const std::vector<JobTiming>& GetTimings() const {
+    return timings_;
+  }
+
+  /**
+   * Accessor function for the number of worker threads.
+   *
+   * @return the number of workers
+   */
+  inline size_t GetNumWorkers() const {
+    return workers_.size();
+  }
+
+  /**
+   * Determines whether the jobs all run on the thread calling Wait.
+   *
+   * @return true if there are no worker threads, false otherwise
+   */
+  inline bool IsDeterministic() const {
+    return workers_.empty();
+  }
+
+ private:
+  /** A submitted job along with its progress. */
+  struct Job {
+    /** The name the job was submitted with. */
+    std::string name_;
+
+    /** The work to be done. */
+    std::function<void()> task_;
+
+    /** The number of dependencies which have not finished yet. */
+    size_t num_pending_;
+
+    /** The jobs which depend on this one. */
+    std::vector<Job*> dependents_;
+
+    /** Determines whether the job has finished running. */
+    bool is_finished_;
+
+    /** The timing of the job, filled in once it has run. */
+    JobTiming timing_;
+  };
+
+  /** The queue of ready jobs owned by a single worker. */
+  struct WorkQueue {
+    /** Guards the jobs in the queue. */
+    std::mutex mutex_;
+
+    /** The ready jobs, oldest at the front. */
+    std::deque<Job*> jobs_;
+  };
+
+  /**
+   * The loop run by every worker thread.
+   *
+   * @param worker the index of the worker
+   */
+  void WorkerLoop(size_t worker);
+
+  /**
+   * Takes a ready job, first from the worker's own queue, then from the
+   * other queues.
+   *
+   * @param worker the index of the worker looking for a job
+   * @return the job, or nullptr if no job is ready
+   */
+  Job* TakeJob(size_t worker);
+
+  /**
+   * Adds a job whose dependencies have all finished to a queue.
+   * Requires graph_mutex_ to be held.
+   *
+   * @param job the job to add
+   */
+  void PushReady(Job* job);
+
+  /** Wakes every thread sleeping on wake_. */
+  void WakeAll();
+
+  /**
+   * Runs a job, then releases the jobs depending on it.
+   *
+   * @param job the job to run
+   * @param worker the index of the worker running the job
+   */
+  void Run(Job* job, size_t worker);
+
+  /** The worker threads. */
+  std::vector<std::thread> workers_;
+
+  /** The queues of ready jobs, one per worker plus one for Wait's thread. */
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+  /** Every job submitted since the last Wait, in submission order. */
+  std::vector<std::unique_ptr<Job>> jobs_;
+
+  /** Guards the dependency graph, that is jobs_ and every job's progress. */
+  std::mutex graph_mutex_;
+
+  /** Signalled whenever a job becomes ready or all jobs have finished. */
+  std::condition_variable wake_;
+
+  /** Guards the sleeping of idle threads on wake_. */
+  std::mutex wake_mutex_;
+
+  /** The number of submitted jobs which have not finished. */
+  std::atomic<size_t> num_unfinished_;
+
+  /** The number of jobs waiting in the queues. */
+  std::atomic<size_t> num_ready_;
+
+  /** The queue the next ready job is pushed to. */
+  size_t next_queue_;
+
+  /** Determines whether the workers should stop. */
+  std::atomic<bool> is_stopping_;
+
+  /** The timings of the jobs run by the last Wait. */
+  std::vector<JobTiming> timings_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_JOB_SYSTEM_H_
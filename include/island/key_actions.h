@@ -0,0 +1,59 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_KEY_ACTIONS_H_
+#define ISLAND_KEY_ACTIONS_H_
+
+#include "game_session.h"
+
+#include <cstdint>
+
+namespace island {
+
+/**
+ * The codes of the keys the game is played with. They have the values of
+ * Cinder's key codes, which the window gets and players send to a server,
+ * so the server and its players can map keys without Cinder.
+ */
+enum KeyCode : uint32_t {
+  kKeyUnknown = 0,
+  kKeySpace = 32,
+  kKeyA = 97,
+  kKeyD = 100,
+  kKeyH = 104,
+  kKeyN = 110,
+  kKeyR = 114,
+  kKeyS = 115,
+  kKeyW = 119,
+  kKeyX = 120,
+  kKeyY = 121,
+  kKeyZ = 122,
+  kKeyUp = 273,
+  kKeyDown = 274,
+  kKeyRight = 275,
+  kKeyLeft = 276
+};
+
+/**
+ * Gets the action a key press stands for: the arrows or WASD move, z
+ * interacts, x opens the inventory, y and n answer the market, and space, h
+ * and r attack, heal and run in battle. Keys which only change what the
+ * player sees or hears, such as zooming and muting, stand for no action.
+ *
+ * @param key_code the code of the key
+ * @param action where to store the action
+ * @return true if the key stands for an action
+ */
+bool GetKeyAction(uint32_t key_code, PlayerAction* action);
+
+/**
+ * Gets a key which stands for an action, for players which decide on
+ * actions and send them to a server as key presses.
+ *
+ * @param action the action
+ * @return the code of the key
+ */
+KeyCode GetActionKey(PlayerAction action);
+
+}  // namespace island
+
+#endif  // ISLAND_KEY_ACTIONS_H_
@@ -32,6 +32,22 @@ class Location {
    */
   Location operator%(const Location& rhs) const;
 
+  /**
+   * Overload for the == operator, compares two locations.
+   *
+   * @param rhs the other location to compare with
+   * @return true if both the row and column indices are equal
+   */
+  bool operator==(const Location& rhs) const;
+
+  /**
+   * Overload for the != operator, compares two locations.
+   *
+   * @param rhs the other location to compare with
+   * @return true if either the row or column indices differ
+   */
+  bool operator!=(const Location& rhs) const;
+
 
   /**
    * Accessor function for the row index in the location.
@@ -5,6 +5,10 @@
 
 #include <island/location.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -34,14 +38,68 @@ enum Tile {
   kNpc
 };
 
-/** Class which represents the map for the entire game. */
+/** A change made to a tile of the map while the game is running. */
+struct TileChange {
+  /** The location of the tile. */
+  Location location_;
+
+  /** The new value of the tile. */
+  Tile tile_;
+};
+
+/**
+ * The tiles of a map as it was loaded, which never change, so every map
+ * made from them shares one copy.
+ */
+struct MapTiles {
+  /** The number of rows. */
+  size_t num_rows_;
+
+  /** The number of columns. */
+  size_t num_cols_;
+
+  /** The tiles, row after row. */
+  std::vector<Tile> tiles_;
+};
+
+/**
+ * Class which represents the map for the entire game. The tiles it was made
+ * from are shared with every other map made from them, and the tiles set
+ * since are kept apart in a small layer of overrides, which GetTile checks
+ * first. A map with no overrides costs next to nothing beyond the shared
+ * tiles, and resetting it to them only drops the overrides.
+ */
 class Map {
 public:
-  /** Constructor which initializes the map with tile values. */
+  /**
+   * Constructor which uses the island's tiles, read from the tileset file
+   * the first time any map is made and shared from then on.
+   */
   Map();
 
-  /** Initializes the map for the tiles, mapping a char to a tile object. */
-  void InitializeMapTiles();
+  /**
+   * Constructor which initializes the map with the given tile values,
+   * instead of reading them from the tileset file.
+   *
+   * @param raw_map the tile values, indexed by row and then by column
+   */
+  explicit Map(const std::vector<std::vector<Tile>>& raw_map);
+
+  /**
+   * Constructor which shares tiles already loaded.
+   *
+   * @param base the tiles
+   */
+  explicit Map(std::shared_ptr<const MapTiles> base);
+
+  /**
+   * Reads the island's tiles from a tileset file, one letter per tile.
+   *
+   * @param file_path the path of the tileset file
+   * @return the tiles, with any letter which is not a tile read as kInvalid
+   */
+  static std::shared_ptr<const MapTiles> LoadTiles(
+      const std::string& file_path);
 
   /**
    * Determines whether the player can move onto a particular tile on the map.
@@ -58,26 +116,95 @@ public:
    * @param location the location at which the tile type is required
    * @return the tile type as a Tile enum object
    */
-  Tile GetTile(const Location& location) const;
+  inline Tile GetTile(const Location& location) const {
+    const size_t index = static_cast<size_t>(location.GetRow()) * num_cols_
+                         + static_cast<size_t>(location.GetCol());
+    if (!override_bits_.empty()
+        && (override_bits_[index / 64] >> (index % 64) & 1)) {
+      return overrides_.at(index);
+    }
+    return base_->tiles_[index];
+  }
+
+  /**
+   * Gets the tile a location had when the map was made.
+   *
+   * @param location the location
+   * @return the tile, whatever it has been set to since
+   */
+  inline Tile GetBaseTile(const Location& location) const {
+    return base_->tiles_[static_cast<size_t>(location.GetRow()) * num_cols_
+                         + static_cast<size_t>(location.GetCol())];
+  }
 
   /**
-   * Sets the tile at a particular location to a new Tile value
+   * Sets the tile at a particular location to a new Tile value. Setting a
+   * tile back to what it was when the map was made drops its override.
    *
    * @param location the location where the value of the tile is to be changed
    * @param tile the new value of the tile
    */
   void SetTile(const Location& location, const Tile& tile);
 
+  /** Sets every tile back to what it was when the map was made. */
+  void ResetTiles();
+
+  /**
+   * Gets every tile which differs from when the map was made.
+   *
+   * @return the overridden tiles, row after row
+   */
+  std::vector<TileChange> GetOverrides() const;
+
+  /**
+   * Counts the memory this map uses on top of the shared tiles.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumOverrideBytes() const;
+
+  /**
+   * Accessor function for the tiles the map was made from.
+   *
+   * @return the shared tiles
+   */
+  inline const std::shared_ptr<const MapTiles>& GetBase() const {
+    return base_;
+  }
+
+  /**
+   * Accessor function for the number of rows in the map.
+   *
+   * @return the number of rows
+   */
+  inline size_t GetNumRows() const {
+    return base_->num_rows_;
+  }
+
+  /**
+   * Accessor function for the number of columns in the map.
+   *
+   * @return the number of columns
+   */
+  inline size_t GetNumCols() const {
+    return num_cols_;
+  }
+
  private:
+  /** The tiles the map was made from, shared with other maps. */
+  std::shared_ptr<const MapTiles> base_;
+
+  /** The number of columns, kept here so GetTile reads one less pointer. */
+  size_t num_cols_;
+
   /**
-   * Stores the tile values to be read from the file, with the character
-   * representing a tile in the file as the key, and the tile itself as the
-   * value.
+   * One bit per tile, row after row, set for the tiles with an override.
+   * Empty while the map has none.
    */
-  std::unordered_map<char, Tile> letter_tiles_;
+  std::vector<uint64_t> override_bits_;
 
-  /** Stores all the tile values for the map. */
-  std::vector<std::vector<Tile>> raw_map_;
+  /** The overridden tiles, by their index row after row. */
+  std::unordered_map<size_t, Tile> overrides_;
 };
 
 }  // namespace island
@@ -0,0 +1,73 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_MAPPED_FILE_H_
+#define ISLAND_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/**
+ * A read only file mapped into memory, so its pages are only read from disk
+ * when they are first touched and are shared with every other process
+ * mapping the same file. On platforms without mmap the file is read into
+ * memory instead.
+ */
+class MappedFile {
+ public:
+  /** Constructor for no file. */
+  MappedFile();
+
+  /** Destructor which unmaps the file. */
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Maps a file into memory, replacing any file already mapped.
+   *
+   * @param path the path of the file
+   * @return true if the file was mapped, false if it could not be opened or
+   * is empty
+   */
+  bool Open(const std::string& path);
+
+  /** Unmaps the file. */
+  void Close();
+
+  /**
+   * Accessor function for the contents of the file.
+   *
+   * @return the first byte of the file, or nullptr if no file is mapped
+   */
+  inline const uint8_t* GetData() const {
+    return data_;
+  }
+
+  /**
+   * Accessor function for the size of the file.
+   *
+   * @return the size, in bytes
+   */
+  inline size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  /** The start of the mapped file, or nullptr if no file is mapped. */
+  const uint8_t* data_;
+
+  /** The size of the mapped file, in bytes. */
+  size_t size_;
+
+  /** The file's contents, on platforms where it is read rather than mapped. */
+  std::vector<uint8_t> contents_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_MAPPED_FILE_H_
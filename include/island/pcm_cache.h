@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_PCM_CACHE_H_
+#define ISLAND_PCM_CACHE_H_
+
+#include <island/mapped_file.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/** The first four bytes of every PCM cache. */
+const uint32_t kPcmCacheMagic = 0x43505349;  // "ISPC"
+
+/** The version of the PCM cache layout written by PcmCacheWriter. */
+const uint32_t kPcmCacheVersion = 1;
+
+/** One decoded sound, pointing straight into the mapped cache. */
+struct PcmView {
+  /** The number of frames of the sound. */
+  size_t num_frames_;
+
+  /** The number of channels of the sound. */
+  size_t num_channels_;
+
+  /** The number of frames per second the sound was decoded at. */
+  size_t sample_rate_;
+
+  /** The samples of the sound, channel after channel. */
+  const float* samples_;
+};
+
+/**
+ * Builds a PCM cache: sound effects already decoded, so later launches map
+ * the samples instead of decoding the sound files again. Each sound is
+ * looked up by the hash of its encoded file, see HashBytes, so editing a
+ * sound file misses the cache instead of playing the old sound.
+ *
+ * The file starts with a header of four 32 bit words: the magic number, the
+ * version, the number of sounds and a reserved word. A directory follows
+ * with one 32 byte entry per sound, sorted by hash: the 64 bit hash and
+ * offset of the sound, then its 32 bit number of frames, sample rate and
+ * number of channels, and a reserved word. Every sound's samples follow as
+ * 32 bit floats, channel after channel, aligned to 64 bytes. Everything is
+ * little endian.
+ */
+class PcmCacheWriter {
+ public:
+  /**
+   * Adds a decoded sound, replacing any sound with the same hash.
+   *
+   * @param source_hash the hash of the encoded sound file
+   * @param sample_rate the number of frames per second it was decoded at
+   * @param num_channels the number of channels
+   * @param samples the samples, channel after channel
+   */
+  void Add(uint64_t source_hash, size_t sample_rate, size_t num_channels,
+           std::vector<float> samples);
+
+  /**
+   * Writes the cache to a temporary file, then renames it over the path,
+   * so a cache being read is never seen half written.
+   *
+   * @param path the path of the file to write
+   * @return true if the whole cache was written, false otherwise
+   */
+  bool Write(const std::string& path) const;
+
+  /**
+   * Accessor function for the number of sounds in the cache.
+   *
+   * @return the number of sounds
+   */
+  inline size_t GetNumSounds() const {
+    return sounds_.size();
+  }
+
+ private:
+  /** A sound waiting to be written. */
+  struct Sound {
+    /** The hash of the encoded sound file. */
+    uint64_t source_hash_;
+
+    /** The number of frames per second. */
+    size_t sample_rate_;
+
+    /** The number of channels. */
+    size_t num_channels_;
+
+    /** The samples, channel after channel. */
+    std::vector<float> samples_;
+  };
+
+  /** The sounds to write. */
+  std::vector<Sound> sounds_;
+};
+
+/**
+ * Reads a PCM cache written by PcmCacheWriter, mapped into memory so the
+ * samples are used where they lie.
+ */
+class PcmCache {
+ public:
+  /** Constructor for no cache. */
+  PcmCache();
+
+  /**
+   * Maps a cache, replacing any cache already open.
+   *
+   * @param path the path of the cache
+   * @return true if the cache was opened, false if it is missing or is not
+   * a valid cache
+   */
+  bool Open(const std::string& path);
+
+  /** Unmaps the cache. */
+  void Close();
+
+  /**
+   * Finds a decoded sound.
+   *
+   * @param source_hash the hash of the encoded sound file
+   * @param sample_rate the number of frames per second the sound is played
+   * at, since a sound decoded at another rate would play at the wrong pitch
+   * @param sound where to store the sound, if found
+   * @return true if the cache has the sound at that rate
+   */
+  bool Find(uint64_t source_hash, size_t sample_rate, PcmView* sound) const;
+
+  /**
+   * Accessor function for the number of sounds in the cache.
+   *
+   * @return the number of sounds
+   */
+  inline size_t GetNumSounds() const {
+    return num_sounds_;
+  }
+
+ private:
+  /** The mapped cache. */
+  MappedFile file_;
+
+  /** The number of sounds in the cache. */
+  size_t num_sounds_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_PCM_CACHE_H_
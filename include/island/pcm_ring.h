@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_PCM_RING_H_
+#define ISLAND_PCM_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace island {
+
+/**
+ * A fixed size ring of interleaved audio samples, written by exactly one
+ * decoding thread and read by exactly one audio thread without locks. A
+ * read never waits: whatever the decoder has not caught up with is played
+ * as silence and counted as an underrun.
+ */
+class PcmRing {
+ public:
+  /**
+   * Creates an empty ring.
+   *
+   * @param num_frames the number of frames the ring holds
+   * @param num_channels the number of samples in each frame
+   */
+  PcmRing(size_t num_frames, size_t num_channels);
+
+  PcmRing(const PcmRing&) = delete;
+  PcmRing& operator=(const PcmRing&) = delete;
+
+  /**
+   * Copies frames into the ring, as many as there is room for, called by
+   * the writer.
+   *
+   * @param samples the interleaved samples of the frames
+   * @param num_frames the number of frames
+   * @return the number of frames copied
+   */
+  size_t Write(const float* samples, size_t num_frames);
+
+  /**
+   * Copies frames out of the ring, called by the reader. Frames the ring
+   * does not have yet are filled with silence.
+   *
+   * @param samples where to copy the interleaved samples of the frames
+   * @param num_frames the number of frames wanted
+   * @return the number of frames copied from the ring
+   */
+  size_t Read(float* samples, size_t num_frames);
+
+  /**
+   * Counts the frames waiting to be read.
+   *
+   * @return the number of frames
+   */
+  size_t GetNumFramesQueued() const;
+
+  /**
+   * Counts the frames there is room to write.
+   *
+   * @return the number of frames
+   */
+  size_t GetNumFramesFree() const;
+
+  /**
+   * Accessor function for the number of frames the ring holds.
+   *
+   * @return the number of frames
+   */
+  inline size_t GetCapacity() const {
+    return num_frames_;
+  }
+
+  /**
+   * Accessor function for the number of samples in each frame.
+   *
+   * @return the number of channels
+   */
+  inline size_t GetNumChannels() const {
+    return num_channels_;
+  }
+
+  /**
+   * Accessor function for the number of reads which ran out of frames.
+   *
+   * @return the number of underruns
+   */
+  inline size_t GetNumUnderruns() const {
+    return num_underruns_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Accessor function for the number of frames played as silence since
+   * the ring had run out.
+   *
+   * @return the number of frames
+   */
+  inline size_t GetNumMissedFrames() const {
+    return num_missed_frames_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /** The samples, in frames of num_channels_ samples. */
+  std::vector<float> samples_;
+
+  /** The number of frames the ring holds. */
+  size_t num_frames_;
+
+  /** The number of samples in each frame. */
+  size_t num_channels_;
+
+  /** The number of frames ever read, only written by the reader. */
+  std::atomic<size_t> read_count_;
+
+  /** The number of frames ever written, only written by the writer. */
+  std::atomic<size_t> write_count_;
+
+  /** The number of reads which ran out of frames. */
+  std::atomic<size_t> num_underruns_;
+
+  /** The number of frames played as silence. */
+  std::atomic<size_t> num_missed_frames_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_PCM_RING_H_
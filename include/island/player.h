@@ -13,7 +13,8 @@ namespace island {
 struct Player : Character {
   /** Constructor for the player, calls super class constructor. */
   Player(const std::string& name, const Location& location,
-      const Statistics& statistics, std::vector<Item>& inventory, size_t money)
+      const Statistics& statistics, const std::vector<Item>& inventory,
+      size_t money)
         : Character(name, location, statistics),
           inventory_(inventory),
           money_(money) {}
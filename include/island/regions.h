@@ -0,0 +1,251 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_REGIONS_H_
+#define ISLAND_REGIONS_H_
+
+#include <island/location.h>
+#include <island/map.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace island {
+
+/** The region label given to tiles the player cannot stand on. */
+const uint16_t kNoRegion = 0;
+
+/** The distance given to tiles a distance field's source cannot reach. */
+const uint16_t kUnreachable = UINT16_MAX;
+
+/**
+ * Labels every connected group of accessible tiles on the map with a region
+ * id, so that two tiles can be checked for reachability in constant time.
+ * Also caches breadth first search distance fields from points of interest,
+ * which are computed the first time they are asked for.
+ */
+class Regions {
+ public:
+  /**
+   * Constructor which labels all the regions of the map.
+   *
+   * @param map the map to label
+   */
+  explicit Regions(const Map& map);
+
+  /**
+   * Relabels all the regions of the map and drops every distance field.
+   *
+   * @param map the map to label
+   */
+  void Label(const Map& map);
+
+  /**
+   * Updates the regions after a single tile on the map has been changed.
+   * Only the regions around the tile are relabeled, and only the distance
+   * fields which cover those regions are dropped.
+   *
+   * @param map the map, with the tile already changed
+   * @param location the location of the tile that was changed
+   */
+  void Update(const Map& map, const Location& location);
+
+  /**
+   * Gets the region the tile at a location belongs to.
+   *
+   * @param location the location of the tile
+   * @return the region id, or kNoRegion if the tile is not accessible
+   */
+  uint16_t GetRegion(const Location& location) const;
+
+  /**
+   * Determines whether a character can walk between two accessible tiles.
+   *
+   * @param first the location of the first tile
+   * @param second the location of the second tile
+   * @return true if both tiles are accessible and connected, false otherwise
+   */
+  bool IsSameRegion(const Location& first, const Location& second) const;
+
+  /**
+   * Determines whether a character standing at a location can walk onto,
+   * or right next to, a target tile. Useful for targets such as doors and
+   * npcs, which can not be stood on but can be interacted with.
+   *
+   * @param from the location of the character
+   * @param target the location of the target tile
+   * @return true if the target can be reached, false otherwise
+   */
+  bool CanReach(const Location& from, const Location& target) const;
+
+  /**
+   * Gets the distance field from a point of interest, computing it if it is
+   * not cached. If the point of interest cannot be stood on, the distance is
+   * measured to the closest tile next to it.
+   *
+   * @param source the location of the point of interest
+   * @return the number of steps from every tile, indexed by row and column
+   */
+  const std::vector<uint16_t>& GetDistanceField(const Location& source);
+
+  /**
+   * Gets the number of steps from a location to a point of interest.
+   *
+   * @param source the location of the point of interest
+   * @param location the location to measure from
+   * @return the number of steps, or kUnreachable
+   */
+  uint16_t GetDistance(const Location& source, const Location& location);
+
+  /**
+   * Determines whether the distance field from a point of interest is cached.
+   *
+   * @param source the location of the point of interest
+   * @return true if the field is cached, false otherwise
+   */
+  bool HasDistanceField(const Location& source) const;
+
+  /**
+   * Gets the number of steps from a location to a point of interest, without
+   * computing the distance field.
+   *
+   * @param source the location of the point of interest
+   * @param location the location to measure from
+   * @return the number of steps, or kUnreachable if the field isn't cached
+   */
+  uint16_t GetCachedDistance(const Location& source,
+                             const Location& location) const;
+
+  /**
+   * Finds the accessible tile closest to a location.
+   *
+   * @param location the location to search from
+   * @return the closest accessible tile, or the location itself if the map
+   * has no accessible tiles
+   */
+  Location FindNearestAccessible(const Location& location) const;
+
+  /**
+   * Accessor function for the number of regions on the map.
+   *
+   * @return the number of regions
+   */
+  size_t GetNumRegions() const;
+
+  /**
+   * Accessor function for the number of cached distance fields.
+   *
+   * @return the number of distance fields
+   */
+  inline size_t GetNumDistanceFields() const {
+    return distance_fields_.size();
+  }
+
+  /**
+   * Counts the memory the labels and the cached distance fields use.
+   *
+   * @return the number of bytes
+   */
+  size_t GetNumBytes() const;
+
+ private:
+  /** A cached distance field, along with the regions it spans. */
+  struct DistanceField {
+    /** The distance from the source for every tile on the map. */
+    std::vector<uint16_t> distances_;
+
+    /** The regions the source of the field is connected to. */
+    std::vector<uint16_t> regions_;
+  };
+
+  /**
+   * Converts a location on the map to an index into the label list.
+   *
+   * @param location the location to convert
+   * @return the index
+   */
+  inline size_t ToIndex(const Location& location) const {
+    return static_cast<size_t>(location.GetRow()) * num_cols_ +
+           static_cast<size_t>(location.GetCol());
+  }
+
+  /**
+   * Determines whether a location lies within the map.
+   *
+   * @param location the location to check
+   * @return true if the location is on the map, false otherwise
+   */
+  bool IsOnMap(const Location& location) const;
+
+  /**
+   * Gets the locations of the up to four tiles bordering a location.
+   *
+   * @param location the location at the center
+   * @return the bordering locations that lie within the map
+   */
+  std::vector<Location> GetNeighbors(const Location& location) const;
+
+  /**
+   * Gets an unused region id, reusing released ids when possible.
+   *
+   * @return the region id
+   */
+  uint16_t AllocateRegion();
+
+  /**
+   * Marks a region id as unused.
+   *
+   * @param region the region id to release
+   */
+  void ReleaseRegion(uint16_t region);
+
+  /**
+   * Labels every accessible tile connected to a starting tile.
+   *
+   * @param map the map to label
+   * @param start the location to start from
+   * @param region the region id to label the tiles with
+   */
+  void FloodFill(const Map& map, const Location& start, uint16_t region);
+
+  /**
+   * Moves a single tile into a region, keeping the region sizes up to date.
+   *
+   * @param index the index of the tile
+   * @param region the region id to label the tile with
+   */
+  void Relabel(size_t index, uint16_t region);
+
+  /**
+   * Drops the distance fields which span any of the given regions, or whose
+   * source lies on or next to the given location.
+   *
+   * @param regions the regions that were changed
+   * @param location the location of the tile that was changed
+   */
+  void InvalidateFields(const std::vector<uint16_t>& regions,
+                        const Location& location);
+
+  /** The number of rows in the labeled map. */
+  size_t num_rows_;
+
+  /** The number of columns in the labeled map. */
+  size_t num_cols_;
+
+  /** The region id of every tile, indexed by row and then by column. */
+  std::vector<uint16_t> labels_;
+
+  /** The number of tiles in each region, indexed by region id. */
+  std::vector<size_t> region_sizes_;
+
+  /** Region ids which have been released and can be reused. */
+  std::vector<uint16_t> free_regions_;
+
+  /** The cached distance fields, with the index of the source as the key. */
+  std::unordered_map<size_t, DistanceField> distance_fields_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_REGIONS_H_
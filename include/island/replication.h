@@ -0,0 +1,228 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_REPLICATION_H_
+#define ISLAND_REPLICATION_H_
+
+#include "direction.h"
+#include "game_session.h"
+#include "location.h"
+#include "map.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace island {
+
+/** The number of snapshots kept for frames to be encoded against. */
+const size_t kNumReplicationSnapshots = 32;
+
+/** Everything a client needs to draw a session's game. */
+struct ReplicatedState {
+  /**
+   * Determines whether two states are the same.
+   *
+   * @param rhs the other state
+   * @return true if every field is equal
+   */
+  bool operator==(const ReplicatedState& rhs) const;
+
+  /** The location of the player. */
+  Location player_location_ = {0, 0};
+
+  /** The direction the player is facing. */
+  Direction facing_ = Direction::kDown;
+
+  /** What the player is doing. */
+  SessionState state_ = SessionState::kPlaying;
+
+  /** The amount of money the player has. */
+  uint64_t money_ = 0;
+
+  /** Determines whether the key to the house has been found. */
+  bool is_key_found_ = false;
+
+  /** The player's inventory, as indices into the world's items. */
+  std::vector<uint8_t> inventory_;
+
+  /** The locations of the npcs, in the order of the npc store. */
+  std::vector<Location> npc_locations_;
+
+  /** The directions the npcs face, in the same order. */
+  std::vector<Direction> npc_facings_;
+
+  /** The tiles which differ from the world's map, row after row. */
+  std::vector<TileChange> tile_overrides_;
+};
+
+/**
+ * Gets the state every new game on a world starts out in, which frames with
+ * nothing to be encoded against are encoded against instead.
+ *
+ * @param world the world
+ * @return the state
+ */
+ReplicatedState GetInitialState(const World& world);
+
+/**
+ * Captures what a client needs to draw a session's game.
+ *
+ * @param world the world the session plays in
+ * @param session the session
+ * @return the state
+ */
+ReplicatedState CaptureReplicatedState(const World& world,
+                                       const GameSession& session);
+
+/**
+ * Encodes a session's state every tick as the difference from the last
+ * state the client acknowledged, so a tick in which little happened costs
+ * a few bytes. Until the client acknowledges a frame, or once the frame it
+ * acknowledged is too old to be kept, frames are encoded against the state
+ * a new game starts in instead. A frame which never arrives costs nothing
+ * but the bytes, since no frame is encoded against a frame the client has
+ * not acknowledged.
+ *
+ * A frame is packed bit by bit, starting from the lowest bit of each byte:
+ * a 16 bit sequence number, and 8 bits for how many frames earlier the frame
+ * it is encoded against was, zero for the state a new game starts in. One
+ * bit for each group of fields follows, set if the group changed, then the
+ * groups which changed. Locations take as many bits as the map's rows and
+ * columns need, and a player or npc who took one step since only takes
+ * three bits. Directions take 2 bits, states 3 bits and tiles 5 bits, while
+ * money and counts are variable length integers of 7 bit groups.
+ */
+class ReplicationEncoder {
+ public:
+  /**
+   * Constructor for the frames of one session.
+   *
+   * @param world the world the session plays in
+   */
+  explicit ReplicationEncoder(std::shared_ptr<const World> world);
+
+  /**
+   * Encodes the next frame.
+   *
+   * @param state the session's state this tick
+   * @param frame where to store the frame
+   */
+  void Encode(const ReplicatedState& state, std::vector<uint8_t>* frame);
+
+  /**
+   * Marks a frame as received, so later frames can be encoded against it.
+   * Acknowledging a frame older than the last one acknowledged does nothing.
+   *
+   * @param sequence the sequence number of the frame
+   */
+  void Acknowledge(uint16_t sequence);
+
+  /**
+   * Accessor function for the sequence number of the last frame encoded.
+   *
+   * @return the sequence number
+   */
+  inline uint16_t GetSequence() const {
+    return static_cast<uint16_t>(next_sequence_ - 1);
+  }
+
+ private:
+  /** A state sent to the client, kept until it is too old. */
+  struct Snapshot {
+    /** The sequence number of the frame the state was sent in. */
+    uint16_t sequence_ = 0;
+
+    /** Determines whether a frame has been sent in this slot. */
+    bool is_sent_ = false;
+
+    /** The state. */
+    ReplicatedState state_;
+  };
+
+  /** The world the session plays in. */
+  const std::shared_ptr<const World> world_;
+
+  /** The state a new game starts in. */
+  const ReplicatedState initial_state_;
+
+  /** The states sent, by sequence number modulo their number. */
+  std::vector<Snapshot> snapshots_;
+
+  /** The sequence number of the next frame. */
+  uint16_t next_sequence_;
+
+  /** The sequence number of the last frame acknowledged. */
+  uint16_t acknowledged_sequence_;
+
+  /** Determines whether any frame has been acknowledged. */
+  bool is_acknowledged_;
+};
+
+/**
+ * Decodes the frames of a ReplicationEncoder, keeping the states decoded so
+ * later frames can be decoded against them.
+ */
+class ReplicationDecoder {
+ public:
+  /**
+   * Constructor for the frames of one session.
+   *
+   * @param world the world the session plays in
+   */
+  explicit ReplicationDecoder(std::shared_ptr<const World> world);
+
+  /**
+   * Decodes a frame. Frames older than the last one decoded are ignored.
+   *
+   * @param data the first byte of the frame
+   * @param size the size of the frame, in bytes
+   * @param state where to store the session's state
+   * @return true if the frame was decoded, false if it is damaged, old or
+   * encoded against a frame which was not decoded
+   */
+  bool Decode(const uint8_t* data, size_t size, ReplicatedState* state);
+
+  /**
+   * Accessor function for the sequence number of the last frame decoded,
+   * which is the one to acknowledge.
+   *
+   * @return the sequence number
+   */
+  inline uint16_t GetSequence() const {
+    return sequence_;
+  }
+
+ private:
+  /** A state decoded from a frame. */
+  struct Snapshot {
+    /** The sequence number of the frame. */
+    uint16_t sequence_ = 0;
+
+    /** Determines whether a frame has been decoded into this slot. */
+    bool is_decoded_ = false;
+
+    /** The state. */
+    ReplicatedState state_;
+  };
+
+  /** The world the session plays in. */
+  const std::shared_ptr<const World> world_;
+
+  /** The state a new game starts in. */
+  const ReplicatedState initial_state_;
+
+  /** The states decoded, by sequence number modulo their number. */
+  std::vector<Snapshot> snapshots_;
+
+  /** The sequence number of the last frame decoded. */
+  uint16_t sequence_;
+
+  /** Determines whether any frame has been decoded. */
+  bool is_decoded_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_REPLICATION_H_
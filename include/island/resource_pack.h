@@ -0,0 +1,260 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_RESOURCE_PACK_H_
+#define ISLAND_RESOURCE_PACK_H_
+
+#include <island/mapped_file.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/** The first four bytes of every resource pack. */
+const uint32_t kResourcePackMagic = 0x50525349;  // "ISRP"
+
+/** The version of the resource pack layout written by ResourcePackWriter. */
+const uint32_t kResourcePackVersion = 1;
+
+/** The alignment of every resource in a resource pack, in bytes. */
+const size_t kResourcePackAlignment = 64;
+
+/** The size of the header in front of a cooked texture's pixels, in bytes. */
+const size_t kTextureHeaderSize = 16;
+
+/** Identifies a resource by the hash of its name, see GetAssetId. */
+typedef uint64_t AssetId;
+
+/** How a resource's bytes are to be read. */
+enum class ResourceType : uint16_t {
+  /** The file's bytes, unchanged. */
+  kRaw,
+
+  /** A decoded image with premultiplied alpha, see TextureView. */
+  kTexture
+};
+
+/** The bytes of one resource, pointing straight into the mapped pack. */
+struct ResourceSpan {
+  /** The first byte of the resource. */
+  const uint8_t* data_;
+
+  /** The size of the resource, in bytes. */
+  size_t size_;
+
+  /** How the resource's bytes are to be read. */
+  ResourceType type_;
+};
+
+/** One decoded image, tightly packed RGBA with the top row first. */
+struct TextureView {
+  /** The width of the image, in pixels. */
+  size_t width_;
+
+  /** The height of the image, in pixels. */
+  size_t height_;
+
+  /** The pixels of the image, width * height * 4 bytes. */
+  const uint8_t* pixels_;
+};
+
+/**
+ * Hashes a resource's name into its id, with 64 bit FNV-1a, so a resource
+ * can be looked up without comparing strings.
+ *
+ * @param name the name of the resource, usually its asset path
+ * @return the id of the resource
+ */
+AssetId GetAssetId(const std::string& name);
+
+/**
+ * Hashes bytes with 64 bit FNV-1a, the same hash names are given ids with.
+ *
+ * @param data the first byte
+ * @param size the number of bytes
+ * @return the hash
+ */
+uint64_t HashBytes(const uint8_t* data, size_t size);
+
+/**
+ * Multiplies the color channels of RGBA pixels by their alpha, so that
+ * blending and filtering the image no longer darkens transparent edges.
+ *
+ * @param pixels the pixels to premultiply, tightly packed RGBA
+ */
+void PremultiplyAlpha(std::vector<uint8_t>* pixels);
+
+/**
+ * Builds a resource pack: every asset of the game in a single file, which
+ * is mapped into memory and looked up by id without opening or decoding
+ * anything.
+ *
+ * The file starts with a header of four 32 bit words: the magic number, the
+ * version, the number of resources and a reserved word. A directory follows
+ * with one 32 byte entry per resource, sorted by id: the 64 bit id, offset
+ * and size of the resource, the 32 bit offset of its name in the name table,
+ * the 16 bit length of its name and its 16 bit type. The name table comes
+ * next, and then every resource, aligned to kResourcePackAlignment bytes.
+ * A texture's resource is its 32 bit width and height, padded to
+ * kTextureHeaderSize bytes, followed by its premultiplied pixels.
+ * Everything is little endian.
+ */
+class ResourcePackWriter {
+ public:
+  /**
+   * Adds a file's bytes to the pack, replacing any resource with the same
+   * name.
+   *
+   * @param name the name the resource is looked up by, usually its path
+   * @param bytes the contents of the file
+   */
+  void Add(const std::string& name, std::vector<uint8_t> bytes);
+
+  /**
+   * Adds a decoded image to the pack, premultiplying its alpha, replacing
+   * any resource with the same name.
+   *
+   * @param name the name the image is looked up by, usually its PNG's path
+   * @param width the width of the image, in pixels
+   * @param height the height of the image, in pixels
+   * @param pixels the image, tightly packed RGBA with the top row first
+   */
+  void AddTexture(const std::string& name, size_t width, size_t height,
+                  std::vector<uint8_t> pixels);
+
+  /**
+   * Writes the pack to a file. Fails without writing anything if two names
+   * hash to the same id, so that one can be renamed.
+   *
+   * @param path the path of the file to write
+   * @return true if the whole pack was written, false otherwise
+   */
+  bool Write(const std::string& path) const;
+
+  /**
+   * Accessor function for the number of resources in the pack.
+   *
+   * @return the number of resources
+   */
+  inline size_t GetNumResources() const {
+    return resources_.size();
+  }
+
+ private:
+  /** A resource waiting to be written. */
+  struct Resource {
+    /** The name the resource is looked up by. */
+    std::string name_;
+
+    /** The id of the resource, the hash of its name. */
+    AssetId id_;
+
+    /** How the resource's bytes are to be read. */
+    ResourceType type_;
+
+    /** The bytes of the resource, as they are written. */
+    std::vector<uint8_t> bytes_;
+  };
+
+  /**
+   * Adds a resource, replacing any resource with the same name.
+   *
+   * @param resource the resource to add
+   */
+  void Add(Resource resource);
+
+  /** The resources added so far. */
+  std::vector<Resource> resources_;
+};
+
+/**
+ * A resource pack mapped into memory. Looking a resource up returns a span
+ * straight into the mapping, so nothing is read until it is used and
+ * nothing is ever copied.
+ */
+class ResourcePack {
+ public:
+  /** Constructor for a pack with no resources. */
+  ResourcePack();
+
+  ResourcePack(const ResourcePack&) = delete;
+  ResourcePack& operator=(const ResourcePack&) = delete;
+
+  /**
+   * Maps a resource pack into memory, replacing any pack already open.
+   *
+   * @param path the path of the pack
+   * @return true if the pack was opened and is valid, false otherwise
+   */
+  bool Open(const std::string& path);
+
+  /**
+   * Looks a resource up by id.
+   *
+   * @param id the id of the resource
+   * @param resource set to the resource if it is in the pack
+   * @return true if the resource is in the pack, false otherwise
+   */
+  bool Find(AssetId id, ResourceSpan* resource) const;
+
+  /**
+   * Looks a resource up by name, checking that the name matches and not
+   * only its hash.
+   *
+   * @param name the name the resource was added with
+   * @param resource set to the resource if it is in the pack
+   * @return true if the resource is in the pack, false otherwise
+   */
+  bool Find(const std::string& name, ResourceSpan* resource) const;
+
+  /**
+   * Looks a cooked image up by name.
+   *
+   * @param name the name the image was added with
+   * @param image set to the image if it is in the pack
+   * @return true if the image is in the pack as a texture, false otherwise
+   */
+  bool FindTexture(const std::string& name, TextureView* image) const;
+
+  /**
+   * Accessor function for the number of resources in the pack.
+   *
+   * @return the number of resources, zero if no pack is open
+   */
+  inline size_t GetNumResources() const {
+    return num_resources_;
+  }
+
+ private:
+  /**
+   * Finds the directory entry of a resource.
+   *
+   * @param id the id of the resource
+   * @return the offset of the entry, or zero if the resource is not in the
+   * pack
+   */
+  size_t FindEntry(AssetId id) const;
+
+  /**
+   * Gets the resource a directory entry describes.
+   *
+   * @param entry the offset of the entry
+   * @return the resource
+   */
+  ResourceSpan GetResource(size_t entry) const;
+
+  /** Unmaps the pack, leaving no resources. */
+  void Close();
+
+  /** The mapped pack. */
+  MappedFile file_;
+
+  /** The number of resources in the pack. */
+  size_t num_resources_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_RESOURCE_PACK_H_
@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_SAVE_JOURNAL_H_
+#define ISLAND_SAVE_JOURNAL_H_
+
+#include "location.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/** The first four bytes of every save journal. */
+const uint32_t kSaveJournalMagic = 0x4c4a5349;  // "ISJL"
+
+/** The version of the save journal layout written by SaveJournal. */
+const uint32_t kSaveJournalVersion = 1;
+
+/** The changes to the game a journal records. */
+enum class JournalOp : uint8_t {
+  kAddInventoryItem,
+  kRemoveInventoryItem,
+  kAddItem,
+  kRemoveItem,
+  kSetTile,
+  kAddMoney,
+  kRemoveMoney,
+  kSetKey,
+  kMovePlayer,
+  kSetDirection
+};
+
+/**
+ * One change to the game. Only the fields the change needs are set: the
+ * location for kSetTile and kMovePlayer, the value for the tile, amount of
+ * money, key flag or direction, and the item's name, description and file
+ * path for the item changes.
+ */
+struct JournalRecord {
+  /**
+   * Constructor for a change with none of its fields set yet.
+   *
+   * @param op the kind of change
+   */
+  explicit JournalRecord(JournalOp op = JournalOp::kSetKey)
+      : op_{op} {}
+
+  /** The kind of change. */
+  JournalOp op_;
+
+  /** The location the change is at. */
+  Location location_ = {0, 0};
+
+  /** The number the change sets or adds. */
+  uint64_t value_ = 0;
+
+  /** The name of the item. */
+  std::string name_;
+
+  /** The description of the item. */
+  std::string description_;
+
+  /** The file path of the item's image. */
+  std::string file_path_;
+};
+
+/**
+ * Gets the path of the journal kept next to a save file.
+ *
+ * @param save_path the path of the save file
+ * @return the path of its journal
+ */
+std::string GetJournalPath(const std::string& save_path);
+
+/**
+ * Appends changes to a save journal, so saving costs as much as what has
+ * changed instead of the whole game. The journal belongs to the save file
+ * with the same generation; every time the save is written again, a new
+ * journal is started for the new generation.
+ *
+ * The file starts with a header of the 32 bit magic number and version and
+ * the 64 bit generation. Batches of records follow, each starting with its
+ * 32 bit size in bytes and number of records and the 64 bit HashBytes of
+ * its records, so a batch cut short by a crash is found and ignored. Each
+ * record is its JournalOp as one byte followed by its fields as variable
+ * length integers and length prefixed strings. Everything is little endian.
+ */
+class SaveJournal {
+ public:
+  /**
+   * Constructor for a journal which has not been started.
+   *
+   * @param path the path of the journal file
+   */
+  explicit SaveJournal(std::string path);
+
+  /**
+   * Replaces the journal with an empty one.
+   *
+   * @param generation the generation of the save file the journal follows
+   * @return true if the journal was started, false otherwise
+   */
+  bool Start(uint64_t generation);
+
+  /**
+   * Carries on appending to the journal already on disk, dropping a batch
+   * cut short at its end, or starts an empty one if the journal on disk
+   * belongs to another generation.
+   *
+   * @param generation the generation of the save file the journal follows
+   * @return true if the journal can be appended to, false otherwise
+   */
+  bool Resume(uint64_t generation);
+
+  /**
+   * Appends a batch of changes to the journal and flushes it.
+   *
+   * @param records the changes, oldest first
+   * @return true if the batch was written, false if the journal has not
+   * been started or could not be written
+   */
+  bool Append(const std::vector<JournalRecord>& records);
+
+  /**
+   * Accessor function for the size of the journal.
+   *
+   * @return the number of bytes written since the journal was started
+   */
+  inline size_t GetNumBytes() const {
+    return num_bytes_;
+  }
+
+ private:
+  /** The path of the journal file. */
+  const std::string path_;
+
+  /** The journal file, open for appending once started. */
+  std::ofstream file_;
+
+  /** The number of bytes written since the journal was started. */
+  size_t num_bytes_;
+};
+
+/**
+ * Reads every whole batch of a save journal, stopping at the first batch
+ * which was cut short or is damaged.
+ *
+ * @param path the path of the journal file
+ * @param generation where to store the generation of the journal
+ * @param records where to store the changes, oldest first
+ * @return true if the journal has a valid header, false otherwise
+ */
+bool ReadSaveJournal(const std::string& path, uint64_t* generation,
+                     std::vector<JournalRecord>* records);
+
+}  // namespace island
+
+#endif  // ISLAND_SAVE_JOURNAL_H_
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_SAVE_SLOTS_H_
+#define ISLAND_SAVE_SLOTS_H_
+
+#include "save_state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/** The first four bytes of every save slot file. */
+const uint32_t kSaveSlotMagic = 0x53535349;  // "ISSS"
+
+/** The first four bytes of the save slot index. */
+const uint32_t kSaveSlotIndexMagic = 0x49535349;  // "ISSI"
+
+/** The version of the save slot layout written by SaveSlots. */
+const uint32_t kSaveSlotVersion = 1;
+
+/** The number of slots the game can save to. */
+const size_t kNumSaveSlots = 256;
+
+/** The longest player name a slot's header holds, in bytes. */
+const size_t kMaxSlotNameLength = 31;
+
+/** What a load menu shows about a save, read without reading the save. */
+struct SaveSlotHeader {
+  /** The slot the save is in. */
+  size_t slot_ = 0;
+
+  /** The name of the player, cut to kMaxSlotNameLength bytes. */
+  std::string player_name_;
+
+  /** The amount of money the player has. */
+  size_t player_money_ = 0;
+
+  /** The time the game has been played for, in seconds. */
+  uint64_t playtime_seconds_ = 0;
+
+  /** Determines whether the key to the house has been found. */
+  bool is_key_found_ = false;
+
+  /** When the save was made, in seconds since the epoch. */
+  uint64_t timestamp_ = 0;
+
+  /** Where the thumbnail starts in the slot's file, or 0 if there is none. */
+  uint64_t thumbnail_offset_ = 0;
+
+  /** The size of the thumbnail, in bytes. */
+  uint64_t thumbnail_size_ = 0;
+
+  /** Where the save itself starts in the slot's file. */
+  uint64_t body_offset_ = 0;
+
+  /** The size of the save itself, in bytes. */
+  uint64_t body_size_ = 0;
+
+  /** The HashBytes of the save itself, to find a damaged save. */
+  uint64_t body_hash_ = 0;
+};
+
+/**
+ * Keeps saves in numbered slots, each one a file starting with a header of
+ * a fixed 128 bytes: the 32 bit magic number, version, slot and flags, with
+ * the key flag in the lowest bit; the player's name in 32 bytes, padded
+ * with zeros; then the 64 bit money, playtime, timestamp, thumbnail offset
+ * and size, and save offset, size and hash; and reserved bytes. The save
+ * follows as the text of a save file, then the thumbnail, if any.
+ *
+ * An index file, slots.index, holds a copy of every slot's header after a
+ * header of four 32 bit words: the magic number, the version, the number of
+ * slots and a reserved word. Listing the saves only reads the index, and
+ * loading one only reads its header and then its save, skipping the
+ * thumbnail.
+ * Everything is little endian.
+ */
+class SaveSlots {
+ public:
+  /**
+   * Constructor for the slots in a directory, which are not read yet.
+   *
+   * @param directory the directory holding the slots and their index
+   */
+  explicit SaveSlots(std::string directory);
+
+  /**
+   * Reads the index, or rebuilds it from the header of every slot's file if
+   * it is missing or damaged.
+   *
+   * @return true if the index was read, false if it had to be rebuilt
+   */
+  bool Open();
+
+  /**
+   * Accessor function for the headers of the saves, by slot.
+   *
+   * @return the headers of the filled slots
+   */
+  inline const std::vector<SaveSlotHeader>& GetSlots() const {
+    return slots_;
+  }
+
+  /**
+   * Saves a game to a slot, replacing the save in it, then updates the
+   * index. Both files are written to a temporary file first.
+   *
+   * @param slot the slot, less than kNumSaveSlots
+   * @param state the save
+   * @param playtime_seconds the time the game has been played for
+   * @param timestamp when the save is made, in seconds since the epoch
+   * @param thumbnail the image shown for the save, or nothing
+   * @return true if the save and the index were written
+   */
+  bool Write(size_t slot, const SaveState& state, uint64_t playtime_seconds,
+             uint64_t timestamp, const std::vector<uint8_t>& thumbnail);
+
+  /**
+   * Loads the save in a slot, reading only its header and the save itself.
+   *
+   * @param slot the slot
+   * @param state where to store the save
+   * @param header where to store the header of the save, or nullptr
+   * @return true if the slot holds a valid save
+   */
+  bool Load(size_t slot, SaveState* state, SaveSlotHeader* header) const;
+
+  /**
+   * Loads the thumbnail of the save in a slot.
+   *
+   * @param slot the slot
+   * @param thumbnail where to store the thumbnail
+   * @return true if the slot holds a save, even one without a thumbnail
+   */
+  bool LoadThumbnail(size_t slot, std::vector<uint8_t>* thumbnail) const;
+
+  /**
+   * Gets the path of a slot's file.
+   *
+   * @param slot the slot
+   * @return the path
+   */
+  std::string GetSlotPath(size_t slot) const;
+
+ private:
+  /**
+   * Reads the header at the start of a slot's file.
+   *
+   * @param slot the slot
+   * @param header where to store the header
+   * @return true if the file exists and starts with a valid header
+   */
+  bool ReadHeader(size_t slot, SaveSlotHeader* header) const;
+
+  /**
+   * Writes the index from the headers in memory.
+   *
+   * @return true if the index was written
+   */
+  bool WriteIndex() const;
+
+  /** The directory holding the slots and their index. */
+  const std::string directory_;
+
+  /** The headers of the filled slots, by slot. */
+  std::vector<SaveSlotHeader> slots_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_SAVE_SLOTS_H_
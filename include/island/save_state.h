@@ -0,0 +1,98 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_SAVE_STATE_H_
+#define ISLAND_SAVE_STATE_H_
+
+#include "direction.h"
+#include "item.h"
+#include "location.h"
+#include "map.h"
+#include "statistics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/**
+ * Everything a save file holds, captured from the engine at one moment. The
+ * item lists are shared with the engine and never changed, so capturing a
+ * save while the lists are unchanged since the last one copies nothing but
+ * the few fields of the player.
+ */
+struct SaveState {
+  /** The width of the island map. */
+  size_t width_ = 0;
+
+  /** The height of the island map. */
+  size_t height_ = 0;
+
+  /** Determines whether the key to the house has been found. */
+  bool is_key_found_ = false;
+
+  /** The direction the player character moves in. */
+  Direction direction_ = Direction::kRight;
+
+  /** The name of the player. */
+  std::string player_name_;
+
+  /** The location of the player. */
+  Location player_location_ = {0, 0};
+
+  /** The statistics of the player. */
+  Statistics player_statistics_ = {0, 0, 0, 0};
+
+  /** The amount of money the player has. */
+  size_t player_money_ = 0;
+
+  /** The items in the game the player does not have. */
+  std::shared_ptr<const std::vector<Item>> items_;
+
+  /** The items in the player's inventory. */
+  std::shared_ptr<const std::vector<Item>> inventory_;
+
+  /** The tiles which differ from the island's own, row after row. */
+  std::vector<TileChange> tile_overrides_;
+
+  /**
+   * The generation of the journal holding the changes made since, or 0 if
+   * the save has no journal.
+   */
+  uint64_t journal_generation_ = 0;
+};
+
+/**
+ * Converts a save to the JSON text of a save file.
+ *
+ * @param state the save
+ * @return the text of the save file
+ */
+std::string SerializeSave(const SaveState& state);
+
+/**
+ * Reads the JSON text of a save file.
+ *
+ * @param text the text of the save file
+ * @param state where to store the save
+ * @return true if the text is a valid save, false otherwise
+ */
+bool ParseSave(const std::string& text, SaveState* state);
+
+/**
+ * Writes a file to a temporary file next to it, then renames it over the
+ * path, so a crash while writing leaves the old file in place instead of
+ * half of the new one.
+ *
+ * @param path the path of the file to write
+ * @param contents the contents of the file
+ * @return true if the whole file was written, false otherwise
+ */
+bool WriteFileAtomically(const std::string& path,
+                         const std::string& contents);
+
+}  // namespace island
+
+#endif  // ISLAND_SAVE_STATE_H_
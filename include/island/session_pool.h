@@ -0,0 +1,181 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_SESSION_POOL_H_
+#define ISLAND_SESSION_POOL_H_
+
+#include "game_session.h"
+#include "job_system.h"
+#include "world.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace island {
+
+/** Identifies a session in a session pool. */
+using SessionId = uint32_t;
+
+/** What the sessions of a pool cost. */
+struct SessionStats {
+  /** The number of sessions. */
+  size_t num_sessions_;
+
+  /** The memory all the sessions use on top of their world, in bytes. */
+  size_t num_bytes_;
+
+  /** The memory the largest session uses on top of its world, in bytes. */
+  size_t max_session_bytes_;
+
+  /** The number of ticks run so far. */
+  size_t num_ticks_;
+
+  /** The time the last tick took, for every session together. */
+  std::chrono::nanoseconds tick_time_;
+
+  /** The median time one session's last tick took. */
+  std::chrono::nanoseconds median_latency_;
+
+  /** The time 99 in every 100 sessions' last tick took at most. */
+  std::chrono::nanoseconds p99_latency_;
+
+  /** The longest time one session's last tick took. */
+  std::chrono::nanoseconds max_latency_;
+};
+
+/**
+ * Runs many independent games on one shared world, such as one for every
+ * player connected to a server. Every tick, each session first does what
+ * its player asked for since the last tick, then runs one tick of its game.
+ * The sessions are split into groups which run as jobs on a pool of
+ * workers, since sessions never share anything they change.
+ *
+ * Sessions are created, removed and given actions from one thread, the
+ * same one which runs the ticks.
+ */
+class SessionPool {
+ public:
+  /**
+   * Constructor which starts the workers.
+   *
+   * @param world the world every session plays in
+   * @param num_workers the number of worker threads, zero to run every
+   * session on the thread calling Tick
+   * @param sessions_per_job the number of sessions each job runs
+   */
+  SessionPool(std::shared_ptr<const World> world, size_t num_workers,
+              size_t sessions_per_job);
+
+  /**
+   * Starts a new game.
+   *
+   * @param player_name the name of the player
+   * @return the id of the session
+   */
+  SessionId Create(const std::string& player_name);
+
+  /**
+   * Ends a game.
+   *
+   * @param id the id of the session
+   * @return true if the session existed
+   */
+  bool Remove(SessionId id);
+
+  /**
+   * Queues an action for a session's next tick.
+   *
+   * @param id the id of the session
+   * @param action the action
+   * @return true if the session exists
+   */
+  bool PushAction(SessionId id, PlayerAction action);
+
+  /** Runs one tick of every session, waiting for all of them. */
+  void Tick();
+
+  /**
+   * Finds a session.
+   *
+   * @param id the id of the session
+   * @return the session, or nullptr if there is none with the id
+   */
+  const GameSession* Find(SessionId id) const;
+
+  /**
+   * Accessor function for the number of sessions.
+   *
+   * @return the number of sessions
+   */
+  inline size_t GetNumSessions() const {
+    return entries_.size();
+  }
+
+  /**
+   * Measures what the sessions cost, counting the memory of every session.
+   *
+   * @return the memory and the times of the last tick
+   */
+  SessionStats GetStats() const;
+
+ private:
+  /** A session along with what it is waiting to do and its last tick. */
+  struct Entry {
+    /**
+     * Constructor for a new session.
+     *
+     * @param id the id of the session
+     * @param world the world the session plays in
+     * @param player_name the name of the player
+     */
+    Entry(SessionId id, std::shared_ptr<const World> world,
+          const std::string& player_name)
+        : id_{id},
+          session_{std::move(world), player_name},
+          latency_{0} {}
+
+    /** The id of the session. */
+    SessionId id_;
+
+    /** The game. */
+    GameSession session_;
+
+    /** The actions waiting for the next tick, oldest first. */
+    std::vector<PlayerAction> actions_;
+
+    /** The time the session's last tick took. */
+    std::chrono::nanoseconds latency_;
+  };
+
+  /** The world every session plays in. */
+  const std::shared_ptr<const World> world_;
+
+  /** The number of sessions each job runs. */
+  const size_t sessions_per_job_;
+
+  /** The workers running the sessions. */
+  JobSystem job_system_;
+
+  /** The sessions, packed so they can be split into groups. */
+  std::vector<std::unique_ptr<Entry>> entries_;
+
+  /** The index of every session in the entries, by id. */
+  std::unordered_map<SessionId, size_t> indices_;
+
+  /** The id the next session gets. */
+  SessionId next_id_;
+
+  /** The number of ticks run so far. */
+  size_t num_ticks_;
+
+  /** The time the last tick took. */
+  std::chrono::nanoseconds tick_time_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_SESSION_POOL_H_
@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_SPSC_QUEUE_H_
+#define ISLAND_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace island {
+
+/**
+ * A fixed size queue for handing values from exactly one producer thread to
+ * exactly one consumer thread without locks.
+ *
+ * @tparam T the type of value being queued
+ * @tparam kCapacity the maximum number of values in the queue
+ */
+template <typename T, size_t kCapacity>
+class SpscQueue {
+ public:
+  /** Constructor which starts with an empty queue. */
+  SpscQueue() : head_{0}, tail_{0} {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /**
+   * Adds a value to the back of the queue, called by the producer.
+   *
+   * @param value the value to add
+   * @return true if the value was added, false if the queue was full
+   */
+  bool Push(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t next = (tail + 1) % kNumSlots;
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots_[tail] = value;
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the value at the front of the queue, called by the consumer.
+   *
+   * @param value where to store the removed value
+   * @return true if a value was removed, false if the queue was empty
+   */
+  bool Pop(T* value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *value = slots_[head];
+    head_.store((head + 1) % kNumSlots, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  /** One slot is always left empty to tell a full queue from an empty one. */
+  static const size_t kNumSlots = kCapacity + 1;
+
+  /** The storage for the queued values. */
+  std::array<T, kNumSlots> slots_;
+
+  /** The index of the next value to pop, only written by the consumer. */
+  std::atomic<size_t> head_;
+
+  /** The index of the next slot to push to, only written by the producer. */
+  std::atomic<size_t> tail_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_SPSC_QUEUE_H_
@@ -0,0 +1,216 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_TEXTURE_BUDGET_H_
+#define ISLAND_TEXTURE_BUDGET_H_
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace island {
+
+/** What a texture is drawn for, which its memory is accounted under. */
+enum class TextureCategory {
+  kMap,
+  kSprites,
+  kBattle,
+  kUi,
+  kText
+};
+
+/** The number of texture categories. */
+const size_t kNumTextureCategories = 5;
+
+/**
+ * Gets the name of a texture category, for reports.
+ *
+ * @param category the category
+ * @return the name of the category
+ */
+std::string GetCategoryName(TextureCategory category);
+
+/**
+ * Keeps the memory used by textures within a budget. Every resident texture
+ * is recorded with its size and category, and once the total goes over the
+ * budget the textures used least recently are evicted. Textures used in the
+ * current frame and pinned textures are never evicted, so the budget can be
+ * exceeded when they alone do not fit.
+ */
+class TextureBudget {
+ public:
+  /**
+   * Constructor for a budget with no textures.
+   *
+   * @param budget the most memory the textures should use, in bytes
+   */
+  explicit TextureBudget(size_t budget);
+
+  /** Starts a new frame, so textures used before it may be evicted. */
+  void BeginFrame();
+
+  /**
+   * Records a texture which was loaded, as used in the current frame,
+   * replacing any texture with the same name.
+   *
+   * @param name the name of the texture
+   * @param category what the texture is drawn for
+   * @param num_bytes the memory the texture uses, in bytes
+   * @param is_pinned true if the texture must never be evicted
+   * @return the names of the textures to evict to stay within the budget,
+   * which are no longer recorded
+   */
+  std::vector<std::string> Add(const std::string& name,
+                               TextureCategory category, size_t num_bytes,
+                               bool is_pinned = false);
+
+  /**
+   * Records that a texture was used in the current frame.
+   *
+   * @param name the name of the texture
+   */
+  void Touch(const std::string& name);
+
+  /**
+   * Records that a texture was unloaded.
+   *
+   * @param name the name of the texture
+   */
+  void Remove(const std::string& name);
+
+  /**
+   * Changes the budget.
+   *
+   * @param budget the most memory the textures should use, in bytes
+   * @return the names of the textures to evict to stay within the budget,
+   * which are no longer recorded
+   */
+  std::vector<std::string> SetBudget(size_t budget);
+
+  /**
+   * Formats the memory used by each category, the budget and the number of
+   * evictions, one per line.
+   *
+   * @return the report
+   */
+  std::string GetReport() const;
+
+  /**
+   * Accessor function for the memory used by every texture.
+   *
+   * @return the memory, in bytes
+   */
+  inline size_t GetNumBytes() const {
+    return num_bytes_;
+  }
+
+  /**
+   * Accessor function for the memory used by a category of texture.
+   *
+   * @param category the category
+   * @return the memory, in bytes
+   */
+  inline size_t GetNumBytes(TextureCategory category) const {
+    return category_bytes_[static_cast<size_t>(category)];
+  }
+
+  /**
+   * Accessor function for the most memory the textures have used at once.
+   *
+   * @return the memory, in bytes
+   */
+  inline size_t GetPeakBytes() const {
+    return peak_bytes_;
+  }
+
+  /**
+   * Accessor function for the budget.
+   *
+   * @return the most memory the textures should use, in bytes
+   */
+  inline size_t GetBudget() const {
+    return budget_;
+  }
+
+  /**
+   * Accessor function for the number of textures evicted so far.
+   *
+   * @return the number of evictions
+   */
+  inline size_t GetNumEvictions() const {
+    return num_evictions_;
+  }
+
+  /**
+   * Accessor function for the number of textures recorded.
+   *
+   * @return the number of textures
+   */
+  inline size_t GetNumTextures() const {
+    return index_.size();
+  }
+
+ private:
+  /** A resident texture. */
+  struct Entry {
+    /** The name of the texture. */
+    std::string name_;
+
+    /** What the texture is drawn for. */
+    TextureCategory category_;
+
+    /** The memory the texture uses, in bytes. */
+    size_t num_bytes_;
+
+    /** Determines whether the texture must never be evicted. */
+    bool is_pinned_;
+
+    /** The frame the texture was last used in. */
+    size_t last_frame_;
+  };
+
+  /**
+   * Evicts the textures used least recently until the total fits the
+   * budget, or only textures which cannot be evicted are left.
+   *
+   * @return the names of the evicted textures
+   */
+  std::vector<std::string> Evict();
+
+  /**
+   * Forgets a texture.
+   *
+   * @param entry the texture
+   */
+  void Erase(std::list<Entry>::iterator entry);
+
+  /** The most memory the textures should use, in bytes. */
+  size_t budget_;
+
+  /** The memory used by every texture, in bytes. */
+  size_t num_bytes_;
+
+  /** The most memory the textures have used at once, in bytes. */
+  size_t peak_bytes_;
+
+  /** The number of textures evicted so far. */
+  size_t num_evictions_;
+
+  /** The current frame. */
+  size_t frame_;
+
+  /** The memory used by each category of texture, in bytes. */
+  std::array<size_t, kNumTextureCategories> category_bytes_;
+
+  /** The textures, the one used most recently first. */
+  std::list<Entry> entries_;
+
+  /** The textures, with their names as the keys. */
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_TEXTURE_BUDGET_H_
@@ -0,0 +1,190 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_TILE_ATLAS_H_
+#define ISLAND_TILE_ATLAS_H_
+
+#include <island/location.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace island {
+
+/** The number of bytes in one RGBA pixel. */
+const size_t kBytesPerPixel = 4;
+
+/**
+ * Cuts an image of the whole map into tile sized cells and packs every
+ * distinct cell once into a smaller atlas image. The map is then described
+ * by the atlas index of every tile, so drawing any part of it only needs the
+ * atlas rather than the full map image.
+ *
+ * Images are tightly packed RGBA, one byte per channel, top row first. The
+ * x axis of the image runs along the map's rows, matching how the game
+ * draws tiles.
+ */
+class TileAtlas {
+ public:
+  /**
+   * Constructor which builds the atlas from an image of the map.
+   *
+   * @param pixels the map image, whose size is a multiple of the tile size
+   * @param width the width of the map image, in pixels
+   * @param height the height of the map image, in pixels
+   * @param tile_size the size of a tile in the map image, in pixels
+   */
+  TileAtlas(const std::vector<uint8_t>& pixels, size_t width, size_t height,
+            size_t tile_size);
+
+  /**
+   * Gets the atlas cell holding the image of a tile on the map.
+   *
+   * @param location the location of the tile
+   * @return the index of the atlas cell
+   */
+  uint32_t GetCell(const Location& location) const;
+
+  /**
+   * Changes the atlas cell a tile on the map is drawn from.
+   *
+   * @param location the location of the tile
+   * @param cell the index of the atlas cell
+   */
+  void SetCell(const Location& location, uint32_t cell);
+
+  /**
+   * Gets the pixel position of an atlas cell's top left corner.
+   *
+   * @param cell the index of the atlas cell
+   * @return the x position as the row and the y position as the column
+   */
+  Location GetCellOrigin(uint32_t cell) const;
+
+  /**
+   * Accessor function for the number of distinct cells in the atlas.
+   *
+   * @return the number of cells
+   */
+  inline size_t GetNumCells() const {
+    return num_cells_;
+  }
+
+  /**
+   * Accessor function for the number of rows in the map.
+   *
+   * @return the number of rows
+   */
+  inline size_t GetNumRows() const {
+    return num_rows_;
+  }
+
+  /**
+   * Accessor function for the number of columns in the map.
+   *
+   * @return the number of columns
+   */
+  inline size_t GetNumCols() const {
+    return num_cols_;
+  }
+
+  /**
+   * Accessor function for the size of a tile.
+   *
+   * @return the tile size, in pixels
+   */
+  inline size_t GetTileSize() const {
+    return tile_size_;
+  }
+
+  /**
+   * Accessor function for the width of the atlas image.
+   *
+   * @return the width, in pixels
+   */
+  inline size_t GetWidth() const {
+    return cells_per_line_ * tile_size_;
+  }
+
+  /**
+   * Accessor function for the height of the atlas image.
+   *
+   * @return the height, in pixels
+   */
+  inline size_t GetHeight() const {
+    return pixels_.size() / (GetWidth() * kBytesPerPixel);
+  }
+
+  /**
+   * Accessor function for the atlas image.
+   *
+   * @return the tightly packed RGBA pixels of the atlas
+   */
+  inline const std::vector<uint8_t>& GetPixels() const {
+    return pixels_;
+  }
+
+ private:
+  /**
+   * Hashes the pixels of one tile of the map image.
+   *
+   * @param pixels the map image
+   * @param width the width of the map image, in pixels
+   * @param x the x position of the tile's top left corner
+   * @param y the y position of the tile's top left corner
+   * @return the hash of the tile's pixels
+   */
+  uint64_t HashTile(const std::vector<uint8_t>& pixels, size_t width,
+                    size_t x, size_t y) const;
+
+  /**
+   * Determines whether a tile of the map image matches an atlas cell.
+   *
+   * @param pixels the map image
+   * @param width the width of the map image, in pixels
+   * @param x the x position of the tile's top left corner
+   * @param y the y position of the tile's top left corner
+   * @param cell the index of the atlas cell
+   * @return true if every pixel is the same, false otherwise
+   */
+  bool IsSameTile(const std::vector<uint8_t>& pixels, size_t width,
+                  size_t x, size_t y, uint32_t cell) const;
+
+  /**
+   * Copies a tile of the map image into an atlas cell, growing the atlas
+   * image when needed.
+   *
+   * @param pixels the map image
+   * @param width the width of the map image, in pixels
+   * @param x the x position of the tile's top left corner
+   * @param y the y position of the tile's top left corner
+   * @param cell the index of the atlas cell
+   */
+  void CopyTile(const std::vector<uint8_t>& pixels, size_t width,
+                size_t x, size_t y, uint32_t cell);
+
+  /** The number of rows in the map. */
+  size_t num_rows_;
+
+  /** The number of columns in the map. */
+  size_t num_cols_;
+
+  /** The size of a tile, in pixels. */
+  size_t tile_size_;
+
+  /** The number of cells side by side in one line of the atlas image. */
+  size_t cells_per_line_;
+
+  /** The number of distinct cells in the atlas. */
+  size_t num_cells_;
+
+  /** The atlas cell of every tile, indexed by row and then by column. */
+  std::vector<uint32_t> cells_;
+
+  /** The atlas image. */
+  std::vector<uint8_t> pixels_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_TILE_ATLAS_H_
@@ -0,0 +1,122 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_TILE_PYRAMID_H_
+#define ISLAND_TILE_PYRAMID_H_
+
+#include <island/job_system.h>
+#include <island/location.h>
+#include <island/tile_atlas.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace island {
+
+/**
+ * Precomputed images of the whole tile layer at decreasing levels of
+ * detail. Level 0 is the map at full size, and every level after it is half
+ * the width and height of the one before, down to a single pixel. Zoomed out
+ * views and the minimap draw the level matching their size, which costs the
+ * same no matter how large the map is.
+ */
+class TilePyramid {
+ public:
+  /** The number of lines of a level built by a single job. */
+  static const size_t kBandHeight = 64;
+
+  /** One level of the pyramid. */
+  struct Level {
+    /** The width of the level, in pixels. */
+    size_t width_;
+
+    /** The height of the level, in pixels. */
+    size_t height_;
+
+    /** The tightly packed RGBA pixels of the level, top row first. */
+    std::vector<uint8_t> pixels_;
+  };
+
+  /**
+   * Constructor which lays out the tiles of an atlas as level 0. The levels
+   * after it stay empty until Build is called.
+   *
+   * @param atlas the atlas holding the tiles of the map
+   */
+  explicit TilePyramid(const TileAtlas& atlas);
+
+  /**
+   * Builds every level after level 0, splitting each level into bands of
+   * lines which are built alongside each other.
+   *
+   * @param job_system the job system to build on, or nullptr to build on the
+   * calling thread
+   */
+  void Build(JobSystem* job_system);
+
+  /**
+   * Redraws a single tile from the atlas into level 0, then rebuilds only
+   * the part of every other level covering the tile.
+   *
+   * @param atlas the atlas holding the tiles of the map
+   * @param location the location of the tile which changed
+   */
+  void UpdateTile(const TileAtlas& atlas, const Location& location);
+
+  /**
+   * Gets the level whose detail matches a zoom, i.e. the most zoomed out
+   * level which still has at least one pixel per screen pixel.
+   *
+   * @param zoom the number of screen pixels per pixel of level 0
+   * @return the index of the level
+   */
+  size_t GetLevelForZoom(double zoom) const;
+
+  /**
+   * Accessor function for one level of the pyramid.
+   *
+   * @param level the index of the level
+   * @return the level
+   */
+  inline const Level& GetLevel(size_t level) const {
+    return levels_[level];
+  }
+
+  /**
+   * Accessor function for the number of levels in the pyramid.
+   *
+   * @return the number of levels
+   */
+  inline size_t GetNumLevels() const {
+    return levels_.size();
+  }
+
+ private:
+  /**
+   * Copies a tile from the atlas into its place in level 0.
+   *
+   * @param atlas the atlas holding the tiles of the map
+   * @param location the location of the tile
+   */
+  void CopyTile(const TileAtlas& atlas, const Location& location);
+
+  /**
+   * Averages every 2x2 block of pixels of a level into the next level, for
+   * a rectangle of the next level.
+   *
+   * @param level the index of the level to write, at least 1
+   * @param first_x the first column of pixels to write
+   * @param first_y the first line of pixels to write
+   * @param last_x one past the last column of pixels to write
+   * @param last_y one past the last line of pixels to write
+   */
+  void Downsample(size_t level, size_t first_x, size_t first_y,
+                  size_t last_x, size_t last_y);
+
+  /** The levels of the pyramid, from the most to the least detailed. */
+  std::vector<Level> levels_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_TILE_PYRAMID_H_
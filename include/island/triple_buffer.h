@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_TRIPLE_BUFFER_H_
+#define ISLAND_TRIPLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace island {
+
+/**
+ * Hands values from one writer thread to one reader thread without locks.
+ * The writer fills the back buffer and publishes it, the reader picks up the
+ * most recently published buffer whenever it is ready. Neither side ever
+ * waits on the other, and the reader's buffer is never written to while it
+ * is being read.
+ *
+ * @tparam T the type of value being handed over
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  /** Constructor which starts with nothing published. */
+  TripleBuffer() : back_{0}, middle_{1}, front_{2} {}
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  /**
+   * Accessor function for the buffer the writer fills. Its contents are
+   * whatever was published two or more publishes ago.
+   *
+   * @return the back buffer
+   */
+  inline T& GetBack() {
+    return buffers_[back_];
+  }
+
+  /** Publishes the back buffer to the reader, called by the writer. */
+  void Publish() {
+    uint8_t previous = middle_.exchange(
+        static_cast<uint8_t>(back_ | kFreshBit), std::memory_order_acq_rel);
+    back_ = static_cast<uint8_t>(previous & kIndexMask);
+  }
+
+  /**
+   * Picks up the most recently published buffer, called by the reader.
+   *
+   * @return true if a new buffer was picked up, false if nothing has been
+   * published since the last call
+   */
+  bool Update() {
+    if ((middle_.load(std::memory_order_acquire) & kFreshBit) == 0) {
+      return false;
+    }
+    uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = static_cast<uint8_t>(previous & kIndexMask);
+    return true;
+  }
+
+  /**
+   * Accessor function for the buffer the reader reads from.
+   *
+   * @return the front buffer
+   */
+  inline const T& GetFront() const {
+    return buffers_[front_];
+  }
+
+ private:
+  /** Set on the middle index when it holds a buffer the reader hasn't seen. */
+  static const uint8_t kFreshBit = 4;
+
+  /** Masks the buffer index out of the middle index. */
+  static const uint8_t kIndexMask = 3;
+
+  /** The three buffers. */
+  T buffers_[3];
+
+  /** The index of the buffer the writer fills, only used by the writer. */
+  uint8_t back_;
+
+  /** The index of the buffer being handed over, along with the fresh bit. */
+  std::atomic<uint8_t> middle_;
+
+  /** The index of the buffer the reader reads, only used by the reader. */
+  uint8_t front_;
+};
+
+}  // namespace island
+
+#endif  // ISLAND_TRIPLE_BUFFER_H_
@@ -0,0 +1,93 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef ISLAND_WORLD_H_
+#define ISLAND_WORLD_H_
+
+#include "direction.h"
+#include "item.h"
+#include "location.h"
+#include "map.h"
+#include "npc.h"
+#include "regions.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace island {
+
+/**
+ * Everything about the island which is the same for every game played on
+ * it and never changes: the map as loaded, the npcs as they start out, the
+ * items on sale and what is worked out from the map once. Engines made
+ * from a world share it, so each game only pays for what it has changed.
+ */
+struct World {
+  /**
+   * Constructor which works out everything the tiles imply.
+   *
+   * @param tiles the tiles of the map
+   * @param npcs the npcs as they start out
+   * @param npc_facings the directions the npcs start out facing
+   * @param items the items in the game
+   */
+  World(std::shared_ptr<const MapTiles> tiles, std::vector<Npc> npcs,
+        std::vector<Direction> npc_facings, std::vector<Item> items);
+
+  /** The tiles of the map, which games only override. */
+  std::shared_ptr<const MapTiles> tiles_;
+
+  /** The npcs as they start out. */
+  std::vector<Npc> npcs_;
+
+  /** The directions the npcs start out facing, in the same order. */
+  std::vector<Direction> npc_facings_;
+
+  /** The items in the game, which games copy once they change them. */
+  std::shared_ptr<const std::vector<Item>> items_;
+
+  /** The locations of the doors on the map. */
+  std::vector<Location> door_locations_;
+
+  /**
+   * The reachability regions of the map, with the distance fields from the
+   * key and the doors, which games copy once they change the map.
+   */
+  std::shared_ptr<const Regions> regions_;
+};
+
+/** The location of the key hidden on the island's map. */
+const Location kIslandKeyLocation = {31, 45};
+
+/**
+ * Gets the npcs living on the island, where they start out.
+ *
+ * @return the npcs
+ */
+std::vector<Npc> GetIslandNpcs();
+
+/**
+ * Gets the directions the npcs living on the island start out facing.
+ *
+ * @return the directions, in the order of GetIslandNpcs
+ */
+std::vector<Direction> GetIslandNpcFacings();
+
+/**
+ * Gets the items in the island's game.
+ *
+ * @return the items, the ones on sale at the market first
+ */
+std::vector<Item> GetIslandItems();
+
+/**
+ * Loads the island from its tileset file, with its npcs and items.
+ *
+ * @param tileset_path the path of the tileset file
+ * @return the island
+ */
+std::shared_ptr<const World> LoadIslandWorld(const std::string& tileset_path);
+
+}  // namespace island
+
+#endif  // ISLAND_WORLD_H_
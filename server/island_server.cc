@@ -0,0 +1,403 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <gflags/gflags.h>
+
+#include <island/key_actions.h>
+#include <island/replication.h>
+#include <island/session_pool.h>
+#include <island/world.h>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol.h"
+
+using island::ReplicationEncoder;
+using island::SessionId;
+using island::SessionPool;
+using island::SessionStats;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+DEFINE_string(socket, "/tmp/island.sock",
+              "The path of the Unix socket players connect to");
+DEFINE_string(tileset, "assets/map_tileset.txt",
+              "The tileset file the island's map is read from");
+DEFINE_uint64(workers, std::max(std::thread::hardware_concurrency(), 1u) - 1,
+              "The number of worker threads ticking sessions, besides the "
+              "main thread");
+DEFINE_uint64(sessions_per_job, 64,
+              "The number of sessions each job on the workers ticks");
+DEFINE_uint64(idle_sessions, 0,
+              "The number of sessions to run without a player connected, "
+              "to load the server");
+DEFINE_uint64(ticks_per_second, 60, "The number of ticks every second");
+DEFINE_uint64(stats_seconds, 5,
+              "The time between printing what the sessions cost");
+
+/** The most events handled for every wait on the sockets. */
+const int kMaxEvents = 256;
+
+/** The size of the buffer the players' sockets are read into. */
+const size_t kReadSize = 4096;
+
+/** Set by the signal handler when the server should stop. */
+volatile std::sig_atomic_t is_stopping = 0;
+
+/** A player connected to the server. */
+struct Client {
+  /** The session the player plays in. */
+  SessionId session_;
+
+  /** The bytes of a message which has only partly arrived. */
+  std::vector<uint8_t> pending_;
+
+  /** The frames of the player's game. */
+  std::unique_ptr<ReplicationEncoder> encoder_;
+
+  /** The bytes of the last frame the socket has not taken yet. */
+  std::vector<uint8_t> outgoing_;
+
+  /** Determines whether the socket is watched for room to write. */
+  bool is_watching_output_ = false;
+};
+
+/**
+ * Asks the server to stop after the current tick.
+ *
+ * @param signal the signal received
+ */
+void Stop(int signal) {
+  static_cast<void>(signal);
+  is_stopping = 1;
+}
+
+/**
+ * Opens the socket players connect to, replacing any left by an earlier run.
+ *
+ * @param path the path of the socket
+ * @return the socket, or -1 if it could not be opened
+ */
+int Listen(const std::string& path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK
+                                       | SOCK_CLOEXEC, 0);
+  unlink(path.c_str());
+  if (listener < 0
+      || bind(listener, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) != 0
+      || listen(listener, SOMAXCONN) != 0) {
+    if (listener >= 0) {
+      close(listener);
+    }
+    return -1;
+  }
+  return listener;
+}
+
+/**
+ * Accepts every player waiting to connect and starts a game for each.
+ *
+ * @param listener the socket players connect to
+ * @param epoll the epoll instance watching the sockets
+ * @param world the world the games are played in
+ * @param pool the sessions
+ * @param clients the connected players, by socket
+ */
+void AcceptClients(int listener, int epoll,
+                   const std::shared_ptr<const island::World>& world,
+                   SessionPool* pool,
+                   std::unordered_map<int, Client>* clients) {
+  while (true) {
+    const int fd = accept4(listener, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      continue;
+    }
+    Client client;
+    client.session_ = pool->Create("Player " + std::to_string(fd));
+    client.encoder_.reset(new ReplicationEncoder(world));
+    (*clients)[fd] = std::move(client);
+  }
+}
+
+/**
+ * Ends a player's game and closes their socket.
+ *
+ * @param fd the player's socket
+ * @param pool the sessions
+ * @param clients the connected players, by socket
+ */
+void Disconnect(int fd, SessionPool* pool,
+                std::unordered_map<int, Client>* clients) {
+  auto client = clients->find(fd);
+  if (client != clients->end()) {
+    pool->Remove(client->second.session_);
+    clients->erase(client);
+  }
+  // Closing the socket also takes it out of the epoll instance.
+  close(fd);
+}
+
+/**
+ * Reads every message a player has sent, queueing the actions the keys
+ * stand for and acknowledging the frames received.
+ *
+ * @param fd the player's socket
+ * @param client the player
+ * @param pool the sessions
+ * @return false if the player disconnected
+ */
+bool ReadKeys(int fd, Client* client, SessionPool* pool) {
+  uint8_t buffer[kReadSize];
+  while (true) {
+    const ssize_t num_read = read(fd, buffer, sizeof(buffer));
+    if (num_read == 0) {
+      return false;
+    }
+    if (num_read < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    client->pending_.insert(client->pending_.end(), buffer,
+                            buffer + num_read);
+    size_t offset = 0;
+    for (; offset + islandserver::kMessageSize <= client->pending_.size();
+         offset += islandserver::kMessageSize) {
+      const uint32_t message =
+          islandserver::ReadWord(client->pending_.data() + offset);
+      island::PlayerAction action;
+      if (message & islandserver::kAcknowledgeFlag) {
+        client->encoder_->Acknowledge(static_cast<uint16_t>(message));
+      } else if (island::GetKeyAction(message, &action)) {
+        pool->PushAction(client->session_, action);
+      }
+    }
+    client->pending_.erase(client->pending_.begin(),
+                           client->pending_.begin()
+                               + static_cast<std::ptrdiff_t>(offset));
+  }
+}
+
+/**
+ * Writes as much of a player's last frame as their socket takes, watching
+ * the socket for room to write the rest.
+ *
+ * @param fd the player's socket
+ * @param epoll the epoll instance watching the sockets
+ * @param client the player
+ * @return false if the player disconnected
+ */
+bool Flush(int fd, int epoll, Client* client) {
+  const ssize_t num_written =
+      send(fd, client->outgoing_.data(), client->outgoing_.size(),
+           MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (num_written < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      return false;
+    }
+  } else {
+    client->outgoing_.erase(client->outgoing_.begin(),
+                            client->outgoing_.begin() + num_written);
+  }
+
+  const bool should_watch_output = !client->outgoing_.empty();
+  if (should_watch_output == client->is_watching_output_) {
+    return true;
+  }
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLRDHUP;
+  if (should_watch_output) {
+    event.events |= EPOLLOUT;
+  }
+  event.data.fd = fd;
+  client->is_watching_output_ = should_watch_output;
+  return epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+/**
+ * Sends every player the frame of their game for this tick. A player whose
+ * socket has not taken their last frame yet skips this one, which costs
+ * them nothing but waiting, since frames are only encoded against frames
+ * which were acknowledged.
+ *
+ * @param world the world the games are played in
+ * @param epoll the epoll instance watching the sockets
+ * @param pool the sessions
+ * @param clients the connected players, by socket
+ * @return the sockets of the players who disconnected
+ */
+std::vector<int> SendFrames(const island::World& world, int epoll,
+                            const SessionPool& pool,
+                            std::unordered_map<int, Client>* clients) {
+  std::vector<int> disconnected;
+  std::vector<uint8_t> frame;
+  for (auto& entry : *clients) {
+    Client& client = entry.second;
+    const island::GameSession* session = pool.Find(client.session_);
+    if (!client.outgoing_.empty() || session == nullptr) {
+      continue;
+    }
+    client.encoder_->Encode(island::CaptureReplicatedState(world, *session),
+                            &frame);
+    islandserver::AppendWord(static_cast<uint32_t>(frame.size()),
+                             &client.outgoing_);
+    client.outgoing_.insert(client.outgoing_.end(), frame.begin(),
+                            frame.end());
+    if (!Flush(entry.first, epoll, &client)) {
+      disconnected.push_back(entry.first);
+    }
+  }
+  return disconnected;
+}
+
+/**
+ * Prints what the sessions cost.
+ *
+ * @param stats the stats of the sessions
+ */
+void PrintStats(const SessionStats& stats) {
+  const size_t bytes_per_session = stats.num_sessions_ == 0 ? 0
+      : stats.num_bytes_ / stats.num_sessions_;
+  std::cout << stats.num_sessions_ << " sessions, "
+            << stats.num_bytes_ / 1024 << " KiB ("
+            << bytes_per_session << " bytes each, "
+            << stats.max_session_bytes_ << " at most), tick "
+            << duration_cast<microseconds>(stats.tick_time_).count()
+            << " us, session tick p50 "
+            << stats.median_latency_.count() << " ns, p99 "
+            << stats.p99_latency_.count() << " ns, max "
+            << stats.max_latency_.count() << " ns" << std::endl;
+}
+
+/**
+ * Runs many players' games in one process. The island is loaded once and
+ * shared by every game. Players connect to a Unix socket, each connection
+ * getting a game of its own, and send the codes of the keys they press;
+ * after every tick each player is sent a frame of their game's state, as
+ * encoded by ReplicationEncoder, which they acknowledge. The sockets are
+ * watched with epoll between ticks.
+ */
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Host many players' games in one process.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::signal(SIGINT, Stop);
+  std::signal(SIGTERM, Stop);
+  std::signal(SIGPIPE, SIG_IGN);
+
+  const std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld(FLAGS_tileset);
+  SessionPool pool(world, FLAGS_workers, FLAGS_sessions_per_job);
+  for (size_t index = 0; index < FLAGS_idle_sessions; index++) {
+    pool.Create("Idle " + std::to_string(index));
+  }
+
+  const int listener = Listen(FLAGS_socket);
+  const int epoll = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event listen_event;
+  listen_event.events = EPOLLIN;
+  listen_event.data.fd = listener;
+  if (listener < 0 || epoll < 0
+      || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listen_event) != 0) {
+    std::cerr << "Could not listen on " << FLAGS_socket << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  std::cout << "Listening on " << FLAGS_socket << std::endl;
+
+  const steady_clock::duration tick_interval =
+      duration_cast<steady_clock::duration>(std::chrono::seconds(1))
+      / static_cast<steady_clock::rep>(
+          std::max<uint64_t>(FLAGS_ticks_per_second, 1));
+  const auto stats_interval = std::chrono::seconds(FLAGS_stats_seconds);
+  auto next_tick = steady_clock::now();
+  auto next_stats = next_tick + stats_interval;
+  std::unordered_map<int, Client> clients;
+  epoll_event events[kMaxEvents];
+
+  while (!is_stopping) {
+    // The wait is rounded up, since a wait of less than a millisecond
+    // would otherwise spin until the tick.
+    const auto wait = std::max(next_tick - steady_clock::now(),
+                               steady_clock::duration(0));
+    const int num_events = epoll_wait(
+        epoll, events, kMaxEvents,
+        static_cast<int>(duration_cast<milliseconds>(
+            wait + milliseconds(1) - steady_clock::duration(1)).count()));
+    for (int index = 0; index < num_events; index++) {
+      const int fd = events[index].data.fd;
+      if (fd == listener) {
+        AcceptClients(listener, epoll, world, &pool, &clients);
+        continue;
+      }
+      auto client = clients.find(fd);
+      if (client == clients.end()) {
+        continue;
+      }
+      const bool is_connected =
+          ReadKeys(fd, &client->second, &pool)
+          && (!(events[index].events & EPOLLOUT)
+              || Flush(fd, epoll, &client->second));
+      if (!is_connected
+          || (events[index].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        Disconnect(fd, &pool, &clients);
+      }
+    }
+
+    const auto time = steady_clock::now();
+    if (time < next_tick) {
+      continue;
+    }
+    pool.Tick();
+    for (int fd : SendFrames(*world, epoll, pool, &clients)) {
+      Disconnect(fd, &pool, &clients);
+    }
+    // A server which fell behind skips the ticks it missed.
+    next_tick = std::max(next_tick + tick_interval, time);
+    if (FLAGS_stats_seconds > 0 && time >= next_stats) {
+      PrintStats(pool.GetStats());
+      next_stats = time + stats_interval;
+    }
+  }
+
+  for (const auto& client : clients) {
+    close(client.first);
+  }
+  close(epoll);
+  close(listener);
+  unlink(FLAGS_socket.c_str());
+  PrintStats(pool.GetStats());
+  return 0;
+}
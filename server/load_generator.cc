@@ -0,0 +1,442 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <gflags/gflags.h>
+
+#include <island/bot.h>
+#include <island/key_actions.h>
+#include <island/replication.h>
+#include <island/session_pool.h>
+#include <island/world.h>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "protocol.h"
+
+using island::Bot;
+using island::BotRoutes;
+using island::BotStats;
+using island::ReplicatedState;
+using island::ReplicationDecoder;
+using island::SessionId;
+using island::SessionPool;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+DEFINE_uint64(bots, 2000, "The number of bot players");
+DEFINE_string(socket, "",
+              "The socket of the server to connect the bots to, or empty to "
+              "run their games in a headless session pool instead");
+DEFINE_string(tileset, "assets/map_tileset.txt",
+              "The tileset file the island's map is read from");
+DEFINE_uint64(seconds, 10, "The time to run the bots for");
+DEFINE_uint64(think_ticks, 4,
+              "The number of ticks, or frames from the server, between each "
+              "key a bot presses");
+DEFINE_uint64(workers, std::max(std::thread::hardware_concurrency(), 1u) - 1,
+              "The number of worker threads ticking headless sessions, "
+              "besides the main thread");
+DEFINE_uint64(sessions_per_job, 64,
+              "The number of headless sessions each job on the workers ticks");
+DEFINE_uint64(ticks_per_second, 0,
+              "The number of headless ticks every second, or 0 to tick as "
+              "fast as possible");
+
+/** The most events handled for every wait on the sockets. */
+const int kMaxEvents = 256;
+
+/** The size of the buffer the sockets are read into. */
+const size_t kReadSize = 65536;
+
+/** The time after which a key the server never answered stops being timed. */
+const milliseconds kResponseTimeout(1000);
+
+/** A bot playing a game on the server. */
+struct Connection {
+  /**
+   * Constructor for a bot connected to the server.
+   *
+   * @param fd the bot's socket
+   * @param world the world the game is played in
+   * @param bot the bot
+   */
+  Connection(int fd, const std::shared_ptr<const island::World>& world,
+             const Bot& bot)
+      : fd_{fd},
+        decoder_{world},
+        bot_{bot} {}
+
+  /** The bot's socket. */
+  int fd_;
+
+  /** The bytes of a frame which has only partly arrived. */
+  std::vector<uint8_t> pending_;
+
+  /** The decoder of the game's frames. */
+  ReplicationDecoder decoder_;
+
+  /** The bot. */
+  Bot bot_;
+
+  /** The number of frames decoded. */
+  size_t num_frames_ = 0;
+
+  /** Determines whether a key is waiting for the server's answer. */
+  bool is_waiting_ = false;
+
+  /** When the key waiting for an answer was sent. */
+  steady_clock::time_point sent_time_;
+
+  /** The state the key waiting for an answer was pressed in. */
+  ReplicatedState sent_state_;
+};
+
+/** What a run of the bots measured. */
+struct LoadReport {
+  /** The time the bots ran for. */
+  nanoseconds run_time_ = nanoseconds(0);
+
+  /** The number of ticks run, or frames received. */
+  size_t num_ticks_ = 0;
+
+  /** The number of frames which could not be decoded. */
+  size_t num_bad_frames_ = 0;
+
+  /** The number of keys the server never answered. */
+  size_t num_timeouts_ = 0;
+
+  /** The number of bots which could not connect or were disconnected. */
+  size_t num_disconnected_ = 0;
+
+  /** The times measured: ticks when headless, answers to keys otherwise. */
+  std::vector<nanoseconds> latencies_;
+
+  /** What the bots got done. */
+  BotStats bot_stats_;
+};
+
+/**
+ * Prints the middle, tail and worst of a set of times.
+ *
+ * @param name what the times are of
+ * @param latencies the times
+ */
+void PrintLatencies(const std::string& name,
+                    std::vector<nanoseconds> latencies) {
+  if (latencies.empty()) {
+    std::cout << name << ": none measured" << std::endl;
+    return;
+  }
+  auto median = latencies.begin() + latencies.size() / 2;
+  std::nth_element(latencies.begin(), median, latencies.end());
+  const nanoseconds median_latency = *median;
+  auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+  std::nth_element(latencies.begin(), p99, latencies.end());
+  const nanoseconds p99_latency = *p99;
+  auto p999 = latencies.begin() + latencies.size() * 999 / 1000;
+  std::nth_element(latencies.begin(), p999, latencies.end());
+  std::cout << name << ": p50 "
+            << duration_cast<microseconds>(median_latency).count()
+            << " us, p99 " << duration_cast<microseconds>(p99_latency).count()
+            << " us, p99.9 " << duration_cast<microseconds>(*p999).count()
+            << " us, max "
+            << duration_cast<microseconds>(
+                *std::max_element(latencies.begin(), latencies.end())).count()
+            << " us (" << latencies.size() << " measured)" << std::endl;
+}
+
+/**
+ * Plays every bot's game in a session pool in this process, the way the
+ * server would tick them, timing every tick.
+ *
+ * @param world the world the games are played in
+ * @param routes the routes the bots walk along
+ * @param report where to store what was measured
+ */
+void RunHeadless(const std::shared_ptr<const island::World>& world,
+                 const BotRoutes& routes, LoadReport* report) {
+  SessionPool pool(world, FLAGS_workers, FLAGS_sessions_per_job);
+  std::vector<SessionId> sessions;
+  std::vector<Bot> bots;
+  for (size_t index = 0; index < FLAGS_bots; index++) {
+    sessions.push_back(pool.Create("Bot " + std::to_string(index)));
+    bots.emplace_back(&routes, static_cast<uint32_t>(index));
+  }
+
+  const steady_clock::duration tick_interval = FLAGS_ticks_per_second == 0
+      ? steady_clock::duration(0)
+      : duration_cast<steady_clock::duration>(std::chrono::seconds(1))
+        / static_cast<steady_clock::rep>(FLAGS_ticks_per_second);
+  const auto start = steady_clock::now();
+  const auto end = start + std::chrono::seconds(FLAGS_seconds);
+  auto next_tick = start;
+  const size_t think_ticks = std::max<uint64_t>(FLAGS_think_ticks, 1);
+  for (size_t tick = 0; steady_clock::now() < end; tick++) {
+    std::this_thread::sleep_until(next_tick);
+    next_tick += tick_interval;
+
+    const auto tick_start = steady_clock::now();
+    // Bots take turns to think, so their keys spread over the ticks.
+    for (size_t index = tick % think_ticks; index < bots.size();
+         index += think_ticks) {
+      const island::GameSession* session = pool.Find(sessions[index]);
+      island::PlayerAction action;
+      if (bots[index].GetAction(
+              island::CaptureReplicatedState(*world, *session), &action)) {
+        pool.PushAction(sessions[index], action);
+      }
+    }
+    pool.Tick();
+    report->latencies_.push_back(duration_cast<nanoseconds>(
+        steady_clock::now() - tick_start));
+    report->num_ticks_++;
+  }
+  report->run_time_ = duration_cast<nanoseconds>(steady_clock::now()
+                                                 - start);
+  for (const Bot& bot : bots) {
+    report->bot_stats_ += bot.GetStats();
+  }
+}
+
+/**
+ * Connects a bot to the server.
+ *
+ * @param path the path of the server's socket
+ * @return the socket, or -1 if the bot could not connect
+ */
+int Connect(const std::string& path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0
+      || connect(fd, reinterpret_cast<sockaddr*>(&address),
+                 sizeof(address)) != 0
+      || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * Handles a frame of a bot's game: acknowledges it, times the answer to the
+ * bot's last key, and sends the bot's next key when it is time to think.
+ *
+ * @param frame the first byte of the frame
+ * @param size the size of the frame, in bytes
+ * @param connection the bot
+ * @param report where to store what was measured
+ * @return false if the socket failed
+ */
+bool HandleFrame(const uint8_t* frame, size_t size, Connection* connection,
+                 LoadReport* report) {
+  ReplicatedState state;
+  if (!connection->decoder_.Decode(frame, size, &state)) {
+    report->num_bad_frames_++;
+    return true;
+  }
+  report->num_ticks_++;
+  std::vector<uint8_t> message;
+  islandserver::AppendWord(islandserver::kAcknowledgeFlag
+                           | connection->decoder_.GetSequence(), &message);
+
+  const auto time = steady_clock::now();
+  if (connection->is_waiting_ && !(state == connection->sent_state_)) {
+    report->latencies_.push_back(duration_cast<nanoseconds>(
+        time - connection->sent_time_));
+    connection->is_waiting_ = false;
+  } else if (connection->is_waiting_
+             && time - connection->sent_time_ > kResponseTimeout) {
+    report->num_timeouts_++;
+    connection->is_waiting_ = false;
+  }
+
+  if (connection->num_frames_++ % std::max<uint64_t>(FLAGS_think_ticks, 1)
+      == 0) {
+    island::PlayerAction action;
+    if (connection->bot_.GetAction(state, &action)) {
+      islandserver::AppendWord(island::GetActionKey(action), &message);
+      if (!connection->is_waiting_) {
+        connection->is_waiting_ = true;
+        connection->sent_time_ = time;
+        connection->sent_state_ = state;
+      }
+    }
+  }
+
+  // A message the socket cannot take right now is dropped, like a key a
+  // player pressed while their connection stalled.
+  const ssize_t num_written = send(connection->fd_, message.data(),
+                                   message.size(),
+                                   MSG_DONTWAIT | MSG_NOSIGNAL);
+  return num_written >= 0 || errno == EAGAIN || errno == EWOULDBLOCK
+         || errno == EINTR;
+}
+
+/**
+ * Reads every frame the server has sent a bot.
+ *
+ * @param connection the bot
+ * @param report where to store what was measured
+ * @return false if the server disconnected the bot
+ */
+bool ReadFrames(Connection* connection, LoadReport* report) {
+  uint8_t buffer[kReadSize];
+  while (true) {
+    const ssize_t num_read = read(connection->fd_, buffer, sizeof(buffer));
+    if (num_read == 0) {
+      return false;
+    }
+    if (num_read < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    std::vector<uint8_t>& pending = connection->pending_;
+    pending.insert(pending.end(), buffer, buffer + num_read);
+    size_t offset = 0;
+    while (offset + islandserver::kFrameHeaderSize <= pending.size()) {
+      const size_t size = islandserver::ReadWord(pending.data() + offset);
+      const size_t frame = offset + islandserver::kFrameHeaderSize;
+      if (frame + size > pending.size()) {
+        break;
+      }
+      if (!HandleFrame(pending.data() + frame, size, connection, report)) {
+        return false;
+      }
+      offset = frame + size;
+    }
+    pending.erase(pending.begin(),
+                  pending.begin() + static_cast<std::ptrdiff_t>(offset));
+  }
+}
+
+/**
+ * Connects every bot to the server and plays through its frames, timing
+ * how long the server takes to answer the bots' keys.
+ *
+ * @param world the world the games are played in
+ * @param routes the routes the bots walk along
+ * @param report where to store what was measured
+ */
+void RunClients(const std::shared_ptr<const island::World>& world,
+                const BotRoutes& routes, LoadReport* report) {
+  const int epoll = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<std::unique_ptr<Connection>> connections;
+  for (size_t index = 0; index < FLAGS_bots; index++) {
+    const int fd = Connect(FLAGS_socket);
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = connections.size();
+    if (fd < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      report->num_disconnected_++;
+      continue;
+    }
+    connections.emplace_back(new Connection(
+        fd, world, Bot(&routes, static_cast<uint32_t>(index))));
+  }
+
+  const auto start = steady_clock::now();
+  const auto end = start + std::chrono::seconds(FLAGS_seconds);
+  epoll_event events[kMaxEvents];
+  while (steady_clock::now() < end) {
+    const int num_events = epoll_wait(epoll, events, kMaxEvents, 100);
+    for (int index = 0; index < num_events; index++) {
+      Connection& connection = *connections[events[index].data.u64];
+      if (connection.fd_ < 0) {
+        continue;
+      }
+      if (!ReadFrames(&connection, report)
+          || (events[index].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        close(connection.fd_);
+        connection.fd_ = -1;
+        report->num_disconnected_++;
+      }
+    }
+  }
+  report->run_time_ = duration_cast<nanoseconds>(steady_clock::now()
+                                                 - start);
+
+  for (const auto& connection : connections) {
+    report->bot_stats_ += connection->bot_.GetStats();
+    if (connection->fd_ >= 0) {
+      close(connection->fd_);
+    }
+  }
+  close(epoll);
+}
+
+/**
+ * Generates load with scripted bot players, which press the same keys a
+ * person would in the game's window. The bots play either in a headless
+ * session pool in this process, which measures how long ticks take, or as
+ * clients of a running island-server, which measures how long the server
+ * takes to answer a key with a frame that shows it.
+ */
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Load the game with scripted bot players.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld(FLAGS_tileset);
+  const BotRoutes routes(*world);
+  const bool is_headless = FLAGS_socket.empty();
+  LoadReport report;
+  if (is_headless) {
+    RunHeadless(world, routes, &report);
+  } else {
+    RunClients(world, routes, &report);
+  }
+
+  const double seconds =
+      std::chrono::duration<double>(report.run_time_).count();
+  const BotStats& stats = report.bot_stats_;
+  std::cout << FLAGS_bots << " bots, "
+            << (is_headless ? "headless" : FLAGS_socket) << ", "
+            << seconds << " s" << std::endl;
+  std::cout << (is_headless ? "ticks: " : "frames: ") << report.num_ticks_
+            << " (" << static_cast<double>(report.num_ticks_) / seconds
+            << "/s), actions: " << stats.num_actions_ << " ("
+            << static_cast<double>(stats.num_actions_) / seconds << "/s)"
+            << std::endl;
+  std::cout << "talks: " << stats.num_talks_ << ", market visits: "
+            << stats.num_market_visits_ << ", battles: "
+            << stats.num_battles_ << ", goals given up: "
+            << stats.num_given_up_ << std::endl;
+  PrintLatencies(is_headless ? "tick" : "key to frame", report.latencies_);
+  if (report.num_bad_frames_ + report.num_timeouts_
+      + report.num_disconnected_ > 0) {
+    std::cout << "bad frames: " << report.num_bad_frames_
+              << ", unanswered keys: " << report.num_timeouts_
+              << ", disconnected bots: " << report.num_disconnected_
+              << std::endl;
+  }
+  return 0;
+}
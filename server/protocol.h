@@ -0,0 +1,53 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#ifndef FINALPROJECT_SERVER_PROTOCOL_H_
+#define FINALPROJECT_SERVER_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace islandserver {
+
+/**
+ * The size of a message sent by a player, in bytes: a little endian 32 bit
+ * key code, see island::KeyCode, or the sequence number of a frame received
+ * with kAcknowledgeFlag set.
+ */
+const size_t kMessageSize = 4;
+
+/** Marks a player's message as acknowledging a frame, not a key press. */
+const uint32_t kAcknowledgeFlag = 0x80000000;
+
+/**
+ * The size of the little endian 32 bit length sent before each frame of the
+ * player's game, in bytes.
+ */
+const size_t kFrameHeaderSize = 4;
+
+/**
+ * Appends a little endian 32 bit number to a buffer.
+ *
+ * @param value the number
+ * @param bytes the buffer
+ */
+inline void AppendWord(uint32_t value, std::vector<uint8_t>* bytes) {
+  for (size_t shift = 0; shift < 32; shift += 8) {
+    bytes->push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+/**
+ * Reads a little endian 32 bit number.
+ *
+ * @param bytes the first of its four bytes
+ * @return the number
+ */
+inline uint32_t ReadWord(const uint8_t* bytes) {
+  return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8
+         | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+}  // namespace islandserver
+
+#endif  // FINALPROJECT_SERVER_PROTOCOL_H_
@@ -0,0 +1,196 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/audio_mixer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace island {
+
+namespace {
+
+/**
+ * The least change of gain worth sending while a fade is running, so a
+ * fade is a handful of commands rather than one per update.
+ */
+const float kMinGainChange = 0.02f;
+
+}  // namespace
+
+AudioMixer::AudioMixer(size_t num_voices, double crossfade_time,
+                       double sfx_interval)
+    : voices_(num_voices),
+      crossfade_time_{crossfade_time},
+      sfx_interval_{sfx_interval},
+      music_{kNoSound},
+      music_volume_{0},
+      is_muted_{false},
+      num_skipped_sfx_{0},
+      num_stolen_voices_{0} {}
+
+void AudioMixer::SetMusic(SoundId music, float volume) {
+  music_ = music;
+  music_volume_ = volume;
+}
+
+void AudioMixer::PlaySfx(SoundId sfx, float volume, double duration) {
+  sfx_requests_.push_back({sfx, volume, duration});
+}
+
+void AudioMixer::SetMuted(bool is_muted) {
+  is_muted_ = is_muted;
+}
+
+std::vector<AudioCommand> AudioMixer::Update(double time) {
+  std::vector<AudioCommand> commands;
+
+  // Finished sound effects have already stopped on their own.
+  for (Voice& voice : voices_) {
+    if (voice.sound_ != kNoSound && !voice.is_music_
+        && time >= voice.end_time_) {
+      voice = Voice();
+    }
+  }
+
+  UpdateMusic(time, &commands);
+
+  for (const SfxRequest& request : sfx_requests_) {
+    auto last_start = sfx_start_times_.find(request.sfx_);
+    if (last_start != sfx_start_times_.end()
+        && time - last_start->second < sfx_interval_) {
+      num_skipped_sfx_++;
+      continue;
+    }
+    const size_t index = AcquireVoice(&commands);
+    if (index == voices_.size()) {
+      num_skipped_sfx_++;
+      continue;
+    }
+
+    Voice& voice = voices_[index];
+    voice.sound_ = request.sfx_;
+    voice.volume_ = request.volume_;
+    voice.gain_ = is_muted_ ? 0 : request.volume_;
+    voice.fade_from_ = 1;
+    voice.fade_to_ = 1;
+    voice.fade_start_ = time;
+    voice.end_time_ = time + request.duration_;
+    commands.push_back({AudioCommandKind::kStart, index, request.sfx_,
+                        voice.gain_, false});
+    sfx_start_times_[request.sfx_] = time;
+  }
+  sfx_requests_.clear();
+
+  for (size_t index = 0; index < voices_.size(); index++) {
+    Voice& voice = voices_[index];
+    if (voice.sound_ == kNoSound) {
+      continue;
+    }
+
+    const bool is_fade_done = time - voice.fade_start_ >= crossfade_time_;
+    if (voice.is_music_ && is_fade_done && voice.fade_to_ <= 0) {
+      commands.push_back({AudioCommandKind::kStop, index, kNoSound, 0,
+                          false});
+      voice = Voice();
+      continue;
+    }
+
+    const float gain = is_muted_ ? 0 : GetLevel(voice, time) * voice.volume_;
+    const float change = std::abs(gain - voice.gain_);
+    if (change >= kMinGainChange || (is_fade_done && change > 0)) {
+      commands.push_back({AudioCommandKind::kSetGain, index, kNoSound, gain,
+                          false});
+      voice.gain_ = gain;
+    }
+  }
+  return commands;
+}
+
+size_t AudioMixer::GetNumVoicesInUse() const {
+  return static_cast<size_t>(std::count_if(voices_.begin(), voices_.end(),
+      [](const Voice& voice) { return voice.sound_ != kNoSound; }));
+}
+
+bool AudioMixer::IsPlaying(SoundId sound) const {
+  return std::any_of(voices_.begin(), voices_.end(),
+      [sound](const Voice& voice) { return voice.sound_ == sound; });
+}
+
+float AudioMixer::GetLevel(const Voice& voice, double time) const {
+  if (crossfade_time_ <= 0) {
+    return voice.fade_to_;
+  }
+  const double progress = std::min(
+      1.0, std::max(0.0, (time - voice.fade_start_) / crossfade_time_));
+  return voice.fade_from_
+         + static_cast<float>(progress) * (voice.fade_to_ - voice.fade_from_);
+}
+
+void AudioMixer::Fade(Voice* voice, float level, double time) const {
+  voice->fade_from_ = GetLevel(*voice, time);
+  voice->fade_to_ = level;
+  voice->fade_start_ = time;
+}
+
+size_t AudioMixer::AcquireVoice(std::vector<AudioCommand>* commands) {
+  size_t stolen = voices_.size();
+  for (size_t index = 0; index < voices_.size(); index++) {
+    const Voice& voice = voices_[index];
+    if (voice.sound_ == kNoSound) {
+      return index;
+    }
+    if (!voice.is_music_ && (stolen == voices_.size()
+        || voice.end_time_ < voices_[stolen].end_time_)) {
+      stolen = index;
+    }
+  }
+
+  if (stolen != voices_.size()) {
+    commands->push_back({AudioCommandKind::kStop, stolen, kNoSound, 0,
+                         false});
+    voices_[stolen] = Voice();
+    num_stolen_voices_++;
+  }
+  return stolen;
+}
+
+void AudioMixer::UpdateMusic(double time,
+                             std::vector<AudioCommand>* commands) {
+  bool is_playing = false;
+  for (Voice& voice : voices_) {
+    if (voice.sound_ == kNoSound || !voice.is_music_) {
+      continue;
+    }
+    if (voice.sound_ == music_) {
+      // Fades back in if the music was being faded out.
+      is_playing = true;
+      voice.volume_ = music_volume_;
+      if (voice.fade_to_ < 1) {
+        Fade(&voice, 1, time);
+      }
+    } else if (voice.fade_to_ > 0) {
+      Fade(&voice, 0, time);
+    }
+  }
+  if (is_playing || music_ == kNoSound) {
+    return;
+  }
+
+  // Every voice may be playing music still fading out, in which case the
+  // music starts on a later update once one of them has stopped.
+  const size_t index = AcquireVoice(commands);
+  if (index == voices_.size()) {
+    return;
+  }
+  Voice& voice = voices_[index];
+  voice.sound_ = music_;
+  voice.is_music_ = true;
+  voice.volume_ = music_volume_;
+  voice.gain_ = 0;
+  voice.fade_from_ = 0;
+  voice.fade_to_ = 1;
+  voice.fade_start_ = time;
+  commands->push_back({AudioCommandKind::kStart, index, music_, 0, true});
+}
+
+}  // namespace island
@@ -0,0 +1,196 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/autosaver.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace island {
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+Autosaver::Autosaver(std::string path,
+                     std::chrono::milliseconds flush_interval,
+                     std::chrono::milliseconds compact_interval,
+                     size_t max_journal_records)
+    : path_{std::move(path)},
+      flush_interval_{flush_interval},
+      compact_interval_{compact_interval},
+      max_journal_records_{max_journal_records},
+      last_save_time_{steady_clock::now()},
+      last_flush_time_{steady_clock::now()},
+      generation_{0},
+      num_journal_records_{0},
+      is_save_requested_{false},
+      is_journal_broken_{false},
+      journal_{GetJournalPath(path_)},
+      is_writing_{false},
+      stats_{0, 0, 0, 0, 0, 0, 0, nanoseconds(0), nanoseconds(0),
+             nanoseconds(0), nanoseconds(0)},
+      is_running_{true} {
+  thread_ = std::thread(&Autosaver::SaveLoop, this);
+}
+
+Autosaver::~Autosaver() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  captured_.notify_one();
+  thread_.join();
+}
+
+void Autosaver::Resume(uint64_t generation) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  written_.wait(lock, [this] {
+    return pending_.empty() && !is_writing_;
+  });
+  generation_ = generation;
+  is_journal_broken_ = generation_ != 0 && !journal_.Resume(generation_);
+}
+
+bool Autosaver::Update(Engine* engine) {
+  if (!engine->IsJournaling()) {
+    engine->SetJournaling(true);
+  }
+  const auto time = steady_clock::now();
+  const bool is_changed = num_journal_records_ > 0
+                          || engine->GetNumJournalRecords() > 0;
+  // Nothing is written before the game changes, so starting a new game or
+  // failing to load one leaves the save on disk alone.
+  const bool is_save_due = is_save_requested_
+      || (is_changed
+          && (generation_ == 0 || is_journal_broken_
+              || num_journal_records_ >= max_journal_records_
+              || (compact_interval_.count() > 0
+                  && time - last_save_time_ >= compact_interval_)));
+  if (is_save_due) {
+    Save(engine);
+    return true;
+  }
+
+  if (time - last_flush_time_ < flush_interval_
+      || engine->GetNumJournalRecords() == 0) {
+    return false;
+  }
+  Work work = {false, SaveState(), engine->TakeJournal(), time};
+  num_journal_records_ += work.records_.size();
+  last_flush_time_ = time;
+  Push(std::move(work), time);
+  return true;
+}
+
+void Autosaver::Save(Engine* engine) {
+  const auto start = steady_clock::now();
+  // Generations only need to differ from the last save's, including saves
+  // written by earlier runs, so they start from the time of day.
+  const uint64_t time_generation = static_cast<uint64_t>(
+      system_clock::now().time_since_epoch().count());
+  generation_ = std::max(generation_ + 1, time_generation);
+
+  Work work = {true, engine->CaptureSave(), {}, start};
+  work.state_.journal_generation_ = generation_;
+  // Everything recorded so far is part of the full save.
+  engine->SetJournaling(true);
+  num_journal_records_ = 0;
+  is_save_requested_ = false;
+  is_journal_broken_ = false;
+  last_save_time_ = start;
+  last_flush_time_ = start;
+  Push(std::move(work), start);
+}
+
+void Autosaver::Push(Work work, steady_clock::time_point start) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (work.is_full_save_) {
+      stats_.num_captured_++;
+      stats_.num_replaced_ += pending_.size();
+      pending_.clear();
+    }
+    pending_.push_back(std::move(work));
+    const nanoseconds stall = duration_cast<nanoseconds>(
+        steady_clock::now() - start);
+    stats_.stall_time_ += stall;
+    stats_.max_stall_time_ = std::max(stats_.max_stall_time_, stall);
+  }
+  captured_.notify_one();
+}
+
+void Autosaver::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  written_.wait(lock, [this] {
+    return pending_.empty() && !is_writing_;
+  });
+}
+
+AutosaveStats Autosaver::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void Autosaver::SaveLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    captured_.wait(lock, [this] {
+      return !pending_.empty() || !is_running_;
+    });
+    // Work still waiting when the saver stops is written first.
+    if (pending_.empty()) {
+      return;
+    }
+
+    const Work work = std::move(pending_.front());
+    pending_.pop_front();
+    is_writing_ = true;
+    lock.unlock();
+    const size_t num_bytes = journal_.GetNumBytes();
+    const bool is_written = Write(work);
+    const nanoseconds latency = duration_cast<nanoseconds>(
+        steady_clock::now() - work.capture_time_);
+    lock.lock();
+
+    is_writing_ = false;
+    if (!is_written) {
+      stats_.num_failed_++;
+    } else if (work.is_full_save_) {
+      stats_.num_written_++;
+    } else {
+      stats_.num_batches_++;
+      stats_.num_records_ += work.records_.size();
+      stats_.num_journal_bytes_ += journal_.GetNumBytes() - num_bytes;
+    }
+    if (is_written) {
+      stats_.latency_ += latency;
+      stats_.max_latency_ = std::max(stats_.max_latency_, latency);
+    }
+    written_.notify_all();
+  }
+}
+
+bool Autosaver::Write(const Work& work) {
+  if (!work.is_full_save_) {
+    // A batch only makes sense on top of the full save before it.
+    if (is_journal_broken_ || !journal_.Append(work.records_)) {
+      is_journal_broken_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  // The save is written before its journal is started, so a crash in
+  // between leaves the new save with the old journal, which is ignored as
+  // it belongs to an older generation.
+  if (!WriteFileAtomically(path_, SerializeSave(work.state_))
+      || !journal_.Start(work.state_.journal_generation_)) {
+    is_journal_broken_ = true;
+    return false;
+  }
+  is_journal_broken_ = false;
+  return true;
+}
+
+}  // namespace island
@@ -0,0 +1,33 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/battle_prefetch.h>
+
+#include <algorithm>
+
+namespace island {
+
+const std::string& BattlePrefetch::Update(
+    const std::vector<std::string>& nearby_npcs,
+    const std::string& battle_npc_name) {
+  if (!battle_npc_name.empty()) {
+    target_ = battle_npc_name;
+    fought_ = battle_npc_name;
+    return target_;
+  }
+
+  if (std::find(nearby_npcs.begin(), nearby_npcs.end(), fought_)
+      == nearby_npcs.end()) {
+    fought_.clear();
+  }
+
+  if (!fought_.empty()) {
+    target_ = fought_;
+  } else if (!nearby_npcs.empty()) {
+    target_ = nearby_npcs.front();
+  } else {
+    target_.clear();
+  }
+  return target_;
+}
+
+}  // namespace island
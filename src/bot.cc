@@ -0,0 +1,185 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/bot.h>
+#include <island/map.h>
+
+namespace island {
+
+namespace {
+
+/** The number of actions a bot takes at random while wandering. */
+const size_t kWanderActions = 12;
+
+/** The number of actions a bot may take on top of the way to its goal. */
+const size_t kSpareActions = 24;
+
+/** A bot heals on one battle turn in this many, and attacks otherwise. */
+const uint32_t kHealRate = 4;
+
+/**
+ * Gets the action which moves or turns the player in a direction.
+ *
+ * @param direction the direction
+ * @return the action
+ */
+PlayerAction GetMoveAction(Direction direction) {
+  switch (direction) {
+    case Direction::kUp:
+      return PlayerAction::kMoveUp;
+    case Direction::kDown:
+      return PlayerAction::kMoveDown;
+    case Direction::kLeft:
+      return PlayerAction::kMoveLeft;
+    case Direction::kRight:
+      return PlayerAction::kMoveRight;
+  }
+  return PlayerAction::kMoveUp;
+}
+
+}  // namespace
+
+BotStats& BotStats::operator+=(const BotStats& rhs) {
+  num_actions_ += rhs.num_actions_;
+  num_talks_ += rhs.num_talks_;
+  num_market_visits_ += rhs.num_market_visits_;
+  num_battles_ += rhs.num_battles_;
+  num_given_up_ += rhs.num_given_up_;
+  return *this;
+}
+
+BotRoutes::BotRoutes(const World& world)
+    : targets_(static_cast<size_t>(BotGoal::kBattle) + 1) {
+  // Npcs stand in the way like they do in a game.
+  Map map(world.tiles_);
+  for (const Npc& npc : world.npcs_) {
+    map.SetTile(npc.location_, kNpc);
+  }
+
+  std::vector<Location> places = {kMarketLocation};
+  targets_[static_cast<size_t>(BotGoal::kMarket)].push_back(0);
+  for (const Npc& npc : world.npcs_) {
+    if (npc.location_ == kMarketLocation) {
+      continue;
+    }
+    const BotGoal goal = npc.is_combatable_ ? BotGoal::kBattle
+                                            : BotGoal::kTalk;
+    targets_[static_cast<size_t>(goal)].push_back(places.size());
+    places.push_back(npc.location_);
+  }
+
+  for (const Location& place : places) {
+    fields_.emplace_back(map);
+    fields_.back().SetTarget(place);
+    fields_.back().Rebuild(map);
+  }
+}
+
+Bot::Bot(const BotRoutes* routes, uint32_t seed)
+    : routes_{routes},
+      random_{seed},
+      goal_{BotGoal::kWander},
+      target_{0},
+      num_actions_left_{kWanderActions},
+      last_state_{SessionState::kPlaying},
+      has_tried_buying_{false} {}
+
+bool Bot::GetAction(const ReplicatedState& state, PlayerAction* action) {
+  if (state.state_ != last_state_) {
+    switch (state.state_) {
+      case SessionState::kTalking:
+        stats_.num_talks_++;
+        break;
+      case SessionState::kMarket:
+        stats_.num_market_visits_++;
+        has_tried_buying_ = false;
+        break;
+      case SessionState::kBattle:
+        stats_.num_battles_++;
+        break;
+      default:
+        break;
+    }
+    last_state_ = state.state_;
+  }
+
+  bool is_acting = true;
+  switch (state.state_) {
+    case SessionState::kPlaying:
+      is_acting = GetPlayingAction(state, action);
+      break;
+    case SessionState::kInventory:
+      *action = PlayerAction::kToggleInventory;
+      break;
+    case SessionState::kMarket:
+      // Buy once, and leave if that did not close the market.
+      *action = has_tried_buying_ ? PlayerAction::kDecline
+                                  : PlayerAction::kAccept;
+      has_tried_buying_ = true;
+      break;
+    case SessionState::kTalking:
+      *action = PlayerAction::kInteract;
+      break;
+    case SessionState::kBattle:
+      *action = random_() % kHealRate == 0 ? PlayerAction::kHeal
+                                           : PlayerAction::kAttack;
+      break;
+  }
+  if (is_acting) {
+    stats_.num_actions_++;
+  }
+  return is_acting;
+}
+
+void Bot::PickGoal(const Location& location) {
+  goal_ = static_cast<BotGoal>(random_()
+                               % (static_cast<uint32_t>(BotGoal::kBattle)
+                                  + 1));
+  if (goal_ == BotGoal::kWander || routes_->GetTargets(goal_).empty()) {
+    goal_ = BotGoal::kWander;
+    num_actions_left_ = kWanderActions;
+    return;
+  }
+  const std::vector<size_t>& targets = routes_->GetTargets(goal_);
+  target_ = targets[random_() % targets.size()];
+  const uint16_t distance = routes_->GetField(target_).GetDistance(location);
+  num_actions_left_ = distance == UINT16_MAX ? 0 : distance + kSpareActions;
+}
+
+bool Bot::GetPlayingAction(const ReplicatedState& state,
+                           PlayerAction* action) {
+  if (num_actions_left_ == 0) {
+    if (goal_ != BotGoal::kWander) {
+      stats_.num_given_up_++;
+    }
+    PickGoal(state.player_location_);
+    if (num_actions_left_ == 0) {
+      return false;
+    }
+  }
+  num_actions_left_--;
+
+  if (goal_ == BotGoal::kWander) {
+    *action = GetMoveAction(static_cast<Direction>(random_() % 4));
+    return true;
+  }
+
+  const FlowField& field = routes_->GetField(target_);
+  if (!field.HasDirection(state.player_location_)) {
+    num_actions_left_ = 0;
+    return false;
+  }
+  const Direction direction = field.GetDirection(state.player_location_);
+  if (field.GetDistance(state.player_location_) > 1
+      || state.facing_ != direction) {
+    *action = GetMoveAction(direction);
+    return true;
+  }
+
+  // Next to the goal and facing it, so the goal is reached.
+  goal_ = BotGoal::kWander;
+  num_actions_left_ = 0;
+  *action = PlayerAction::kInteract;
+  return true;
+}
+
+}  // namespace island
@@ -0,0 +1,90 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/camera.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace island {
+
+bool TileRect::Contains(const Location& location) const {
+  if (location.GetRow() < 0 || location.GetCol() < 0) {
+    return false;
+  }
+  size_t row = static_cast<size_t>(location.GetRow());
+  size_t col = static_cast<size_t>(location.GetCol());
+  return row >= first_row_ && row < first_row_ + num_rows_
+         && col >= first_col_ && col < first_col_ + num_cols_;
+}
+
+bool TileRect::operator==(const TileRect& rhs) const {
+  return first_row_ == rhs.first_row_ && first_col_ == rhs.first_col_
+         && num_rows_ == rhs.num_rows_ && num_cols_ == rhs.num_cols_;
+}
+
+bool TileRect::operator!=(const TileRect& rhs) const {
+  return !(*this == rhs);
+}
+
+Camera::Camera(size_t num_rows, size_t num_cols, size_t tile_size)
+    : num_rows_{num_rows},
+      num_cols_{num_cols},
+      tile_size_{tile_size},
+      view_width_{0},
+      view_height_{0},
+      zoom_{1.0},
+      location_{0, 0} {}
+
+void Camera::SetViewSize(size_t width, size_t height) {
+  view_width_ = width;
+  view_height_ = height;
+}
+
+void Camera::SetZoom(double zoom) {
+  if (zoom > 0) {
+    zoom_ = zoom;
+  }
+}
+
+size_t Camera::GetLevel() const {
+  size_t level = 0;
+  for (double scale = 0.5; zoom_ <= scale; scale /= 2.0) {
+    level++;
+  }
+  return level;
+}
+
+void Camera::Follow(const Location& target) {
+  // The row is drawn along the screen's width, the column along its height.
+  const double tile_size = static_cast<double>(tile_size_) * zoom_;
+  int view_rows = static_cast<int>(static_cast<double>(view_width_)
+                                   / tile_size);
+  int view_cols = static_cast<int>(static_cast<double>(view_height_)
+                                   / tile_size);
+  int max_row = std::max(static_cast<int>(num_rows_) - view_rows, 0);
+  int max_col = std::max(static_cast<int>(num_cols_) - view_cols, 0);
+
+  location_.SetRow(std::min(std::max(target.GetRow() - view_rows / 2, 0),
+                            max_row));
+  location_.SetCol(std::min(std::max(target.GetCol() - view_cols / 2, 0),
+                            max_col));
+}
+
+TileRect Camera::GetVisibleTiles() const {
+  size_t first_row = std::min(static_cast<size_t>(location_.GetRow()),
+                              num_rows_);
+  size_t first_col = std::min(static_cast<size_t>(location_.GetCol()),
+                              num_cols_);
+  // Round up, so a tile that is only partly on screen is still drawn.
+  const double tile_size = static_cast<double>(tile_size_) * zoom_;
+  size_t view_rows = static_cast<size_t>(
+      std::ceil(static_cast<double>(view_width_) / tile_size));
+  size_t view_cols = static_cast<size_t>(
+      std::ceil(static_cast<double>(view_height_) / tile_size));
+
+  return {first_row, first_col,
+          std::min(view_rows, num_rows_ - first_row),
+          std::min(view_cols, num_cols_ - first_col)};
+}
+
+}  // namespace island
@@ -0,0 +1,61 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/command_buffer.h>
+
+#include <algorithm>
+#include <tuple>
+
+namespace island {
+
+void CommandBuffer::Clear() {
+  commands_.clear();
+}
+
+void CommandBuffer::AddSprite(uint16_t layer, uint32_t texture,
+                              const CommandRect& rect) {
+  Add({layer, CommandKind::kSprite, texture, 0, 0, rect});
+}
+
+void CommandBuffer::AddText(uint16_t layer, uint32_t texture,
+                            const CommandRect& rect) {
+  Add({layer, CommandKind::kText, texture, 0, 0, rect});
+}
+
+void CommandBuffer::AddRect(uint16_t layer, uint32_t color,
+                            const CommandRect& rect) {
+  Add({layer, CommandKind::kRect, kNoTexture, color, 0, rect});
+}
+
+void CommandBuffer::Append(const CommandBuffer& other) {
+  for (const DrawCommand& command : other.commands_) {
+    Add(command);
+  }
+}
+
+void CommandBuffer::Sort() {
+  // The sequence breaks every tie, so a plain sort is already stable.
+  std::sort(commands_.begin(), commands_.end(),
+            [](const DrawCommand& lhs, const DrawCommand& rhs) {
+    return std::tie(lhs.layer_, lhs.kind_, lhs.texture_, lhs.sequence_)
+           < std::tie(rhs.layer_, rhs.kind_, rhs.texture_, rhs.sequence_);
+  });
+}
+
+size_t CommandBuffer::CountBatches() const {
+  size_t num_batches = 0;
+  for (size_t command = 0; command < commands_.size(); command++) {
+    if (command == 0
+        || commands_[command].kind_ != commands_[command - 1].kind_
+        || commands_[command].texture_ != commands_[command - 1].texture_) {
+      num_batches++;
+    }
+  }
+  return num_batches;
+}
+
+void CommandBuffer::Add(DrawCommand command) {
+  command.sequence_ = static_cast<uint32_t>(commands_.size());
+  commands_.push_back(command);
+}
+
+}  // namespace island
@@ -1,17 +1,17 @@
 // Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
 
-#include <nlohmann/json.hpp>
-
 #include <island/engine.h>
 #include <island/location.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
+#include <iterator>
+#include <memory>
 #include <utility>
 
 namespace island {
 
-using nlohmann::json;
-
 Engine::Engine(size_t width, size_t height, std::vector<Item> items,
     const std::string& player_name, const Location& player_loc,
     const Statistics& player_stats, std::vector<Item> player_inventory,
@@ -20,21 +20,53 @@ Engine::Engine(size_t width, size_t height, std::vector<Item> items,
                       player_inventory, player_money)},
         width_{width},
         height_{height},
-        items_{std::move(items)},
+        items_{std::make_shared<const std::vector<Item>>(std::move(items))},
         direction_{Direction::kRight},
-        is_key_found_{false} {
+        is_key_found_{false},
+        regions_{std::make_shared<const Regions>(map_)},
+        num_tile_changes_{0},
+        is_journaling_{false},
+        is_restored_{false} {
   InitializeNpcs();
+  InitializeDoorLocations();
+}
+
+Engine::Engine(std::shared_ptr<const World> world,
+               const std::string& player_name, const Location& player_loc,
+               const Statistics& player_stats, size_t player_money)
+    :   width_{world->tiles_->num_cols_},
+        height_{world->tiles_->num_rows_},
+        is_key_found_{false},
+        direction_{Direction::kRight},
+        player_ {Player(player_name, player_loc, player_stats,
+                        std::vector<Item>(), player_money)},
+        map_{world->tiles_},
+        regions_{world->regions_},
+        door_locations_{world->door_locations_},
+        num_tile_changes_{0},
+        items_{world->items_},
+        is_journaling_{false},
+        is_restored_{false} {
+  for (const Npc& npc : world->npcs_) {
+    npcs_.Create(npc);
+  }
 }
 
 void Engine::InitializeNpcs() {
-  npcs_.push_back(Npc("Rosalyn", {15, 2}, Statistics(10,10,10,10), false, 0));
-  npcs_.push_back(Npc("John", {20, 1}, Statistics(10,10,10,10), false, 0));
-  npcs_.push_back(Npc("Rod", {16, 48}, Statistics(10,10,10,10), false, 0));
-  npcs_.push_back(Npc("Klutz", {28, 20}, Statistics(10,10,10,10), false, 0));
-  npcs_.push_back(Npc("Azura", {38, 10}, Statistics(10,10,10,10), false, 0));
-  npcs_.push_back(Npc("Boi", {36, 36}, Statistics(10, 10, 10, 10), false, 0));
-  npcs_.push_back(Npc("Sven", {25, 20}, Statistics(7,7,7,7), true, 500));
-  npcs_.push_back(Npc("Elf", {26, 20}, Statistics(11,11,11,11), true, 1000));
+  for (const Npc& npc : GetIslandNpcs()) {
+    npcs_.Create(npc);
+  }
+}
+
+void Engine::InitializeDoorLocations() {
+  for (size_t row = 0; row < map_.GetNumRows(); row++) {
+    for (size_t col = 0; col < map_.GetNumCols(); col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      if (map_.GetTile(location) == kDoor) {
+        door_locations_.push_back(location);
+      }
+    }
+  }
 }
 
 Location Engine::GetLocationDelta(const Direction& direction) const {
@@ -56,80 +88,227 @@ void Engine::ExecuteTimeStep() {
       (player_.location_ + direction_loc) % Location(height_, width_);
   player_.location_.SetRow(new_loc.GetRow());
   player_.location_.SetCol(new_loc.GetCol());
+  JournalRecord record(JournalOp::kMovePlayer);
+  record.location_ = player_.location_;
+  Record(std::move(record));
+}
+
+void Engine::Tick(JobSystem* job_system) {
+  // Pathfinding and npc movement only touch the flow field and the npc
+  // locations, and the distance fields only touch the regions, so the two
+  // chains run side by side.
+  JobId pathfinding = job_system->Submit("pathfinding", [this] {
+    UpdatePathfinding();
+  });
+  job_system->Submit("npc_ai", [this] { MoveNpcs(); }, {pathfinding});
+  job_system->Submit("regions", [this] { UpdateDistanceFields(); });
+  job_system->Wait();
+}
+
+void Engine::Tick() {
+  UpdatePathfinding();
+  MoveNpcs();
+  UpdateDistanceFields();
+}
+
+void Engine::UpdatePathfinding() {
+  if (!flow_field_) {
+    return;
+  }
+  flow_field_->SetTarget(player_.location_);
+  flow_field_->Advance(map_, kFlowFieldBudget);
+}
+
+void Engine::MoveNpcs() {
+  std::vector<Location>& locations = npcs_.GetLocations();
+  const std::vector<uint8_t>& is_roaming = npcs_.GetIsRoaming();
+  for (size_t index = 0; index < locations.size(); index++) {
+    if (is_roaming[index]) {
+      locations[index] = flow_field_->Step(locations[index]);
+    }
+  }
 }
 
-void Engine::Save() {
-  std::ofstream write_file("assets/saved_game.json");
-  json game_engine;
-  json json_items;
-  json json_inventory_items;
-
-  for (const auto& item : items_) {
-    json_items["name"] = item.name_;
-    json_items["description"] = item.description_;
-    json_items["file_path"] = item.file_path_;
-  }
-  for (const auto& inventory_item : player_.inventory_) {
-    json_inventory_items["name"] = inventory_item.name_;
-    json_inventory_items["description"] = inventory_item.description_;
-    json_inventory_items["file_path"] = inventory_item.file_path_;
-  }
-
-  game_engine["width"] = width_;
-  game_engine["height"] = height_;
-  game_engine["is_key_found"] = is_key_found_;
-  game_engine["direction"] = direction_;
-  game_engine["player"]["name"] = player_.name_;
-  game_engine["player"]["location"]["row"] = player_.location_.GetRow();
-  game_engine["player"]["location"]["col"] = player_.location_.GetCol();
-  game_engine["player"]["statistics"]["hp"] = player_.statistics_.hit_points_;
-  game_engine["player"]["statistics"]["atk"] = player_.statistics_.attack_;
-  game_engine["player"]["statistics"]["def"] = player_.statistics_.defense_;
-  game_engine["player"]["statistics"]["spe"] = player_.statistics_.speed_;
-  game_engine["player"]["money"] = player_.money_;
-  game_engine["items"] = json_items;
-  game_engine["inventory_items"] = json_inventory_items;
-
-  write_file << game_engine;
-}
-
-void Engine::Load(const std::string& file_path) {
-  std::ifstream read_file(file_path);
-  json game_engine;
-  read_file >> game_engine;
-
-  std::vector<Item> items;
-  std::vector<Item> inventory_items;
-  json json_items;
-  json json_inventory_items;
-
-  for (const auto& item : json_items) {
-    items.emplace_back(item["name"], item["description"], item["file_path"]);
-  }
-  for (const auto& inventory_item : json_inventory_items) {
-    inventory_items.emplace_back(inventory_item["name"],
-        inventory_item["description"], inventory_item["file_path"]);
-  }
-
-  width_ = game_engine["width"];
-  height_ = game_engine["height"];
-  is_key_found_ = game_engine["is_key_found"];
-  items_ = items;
-  player_.name_ = game_engine["player"]["name"];
-  player_.location_ = {game_engine["player"]["location"]["row"],
-                       game_engine["player"]["location"]["col"]};
-  player_.statistics_.hit_points_ = game_engine["player"]["statistics"]["hp"];
-  player_.statistics_.attack_ = game_engine["player"]["statistics"]["atk"];
-  player_.statistics_.defense_ = game_engine["player"]["statistics"]["def"];
-  player_.statistics_.speed_ = game_engine["player"]["statistics"]["spe"];
-  player_.inventory_ = inventory_items;
-  player_.money_ = game_engine["player"]["money"];
+void Engine::UpdateDistanceFields() {
+  // The fields are usually the world's, so the regions are only copied once
+  // a change to the map has dropped one of them.
+  std::shared_ptr<Regions> regions;
+  CacheDistanceField(kKeyLocation, &regions);
+  for (const auto& door : door_locations_) {
+    CacheDistanceField(door, &regions);
+  }
+  if (regions) {
+    regions_ = std::move(regions);
+  }
+}
 
+void Engine::CacheDistanceField(const Location& source,
+                                std::shared_ptr<Regions>* regions) const {
+  if (!*regions) {
+    if (regions_->HasDistanceField(source)) {
+      return;
+    }
+    *regions = std::make_shared<Regions>(*regions_);
+  }
+  (*regions)->GetDistanceField(source);
+}
+
+EntityHandle Engine::AddNpc(const Npc& npc, bool is_roaming) {
+  if (is_roaming && !flow_field_) {
+    flow_field_.reset(new FlowField(map_));
+  }
+  return npcs_.Create(npc, is_roaming);
+}
+
+SaveState Engine::CaptureSave() const {
+  if (!saved_inventory_) {
+    saved_inventory_ = std::make_shared<const std::vector<Item>>(
+        player_.inventory_);
+  }
+
+  SaveState state;
+  state.width_ = width_;
+  state.height_ = height_;
+  state.is_key_found_ = is_key_found_;
+  state.direction_ = direction_;
+  state.player_name_ = player_.name_;
+  state.player_location_ = player_.location_;
+  state.player_statistics_ = player_.statistics_;
+  state.player_money_ = player_.money_;
+  state.items_ = items_;
+  state.inventory_ = saved_inventory_;
+  state.tile_overrides_ = map_.GetOverrides();
+  return state;
+}
+
+bool Engine::Save(const std::string& file_path) const {
+  return WriteFileAtomically(file_path, SerializeSave(CaptureSave()));
+}
+
+void Engine::Restore(const SaveState& state) {
+  width_ = state.width_;
+  height_ = state.height_;
+  is_key_found_ = state.is_key_found_;
+  direction_ = state.direction_;
+  items_ = state.items_;
+  player_.name_ = state.player_name_;
+  player_.location_ = state.player_location_;
+  player_.statistics_ = state.player_statistics_;
+  player_.inventory_ = *state.inventory_;
+  player_.money_ = state.player_money_;
+  saved_inventory_ = state.inventory_;
+  is_restored_ = true;
+
+  // Going through SetTile keeps the regions, the flow field and the count of
+  // tile changes up to date, tile by tile.
+  for (const TileChange& change : map_.GetOverrides()) {
+    SetTile(change.location_, map_.GetBaseTile(change.location_));
+  }
+  for (const TileChange& change : state.tile_overrides_) {
+    if (IsOnMap(change.location_)) {
+      SetTile(change.location_, change.tile_);
+    }
+  }
+  // Saves from before tiles were saved only imply the key's.
   if (is_key_found_) {
-    map_.SetTile(kKeyLocation, kTree);
+    SetTile(kKeyLocation, kTree);
+  }
+}
+
+void Engine::Apply(const JournalRecord& record) {
+  switch (record.op_) {
+    case JournalOp::kAddInventoryItem:
+      AddInventoryItem(Item(std::string(record.name_),
+                            std::string(record.description_),
+                            std::string(record.file_path_)));
+      break;
+    case JournalOp::kRemoveInventoryItem:
+      RemoveInventoryItem(record.name_);
+      break;
+    case JournalOp::kAddItem:
+      AddItem(Item(std::string(record.name_),
+                   std::string(record.description_),
+                   std::string(record.file_path_)));
+      break;
+    case JournalOp::kRemoveItem:
+      RemoveItem(record.name_);
+      break;
+    case JournalOp::kSetTile:
+      if (IsOnMap(record.location_) && record.value_ <= kNpc) {
+        SetTile(record.location_, static_cast<Tile>(record.value_));
+      }
+      break;
+    case JournalOp::kAddMoney:
+      AddMoney(static_cast<size_t>(record.value_));
+      break;
+    case JournalOp::kRemoveMoney:
+      RemoveMoney(static_cast<size_t>(record.value_));
+      break;
+    case JournalOp::kSetKey:
+      SetKey(record.value_ != 0);
+      break;
+    case JournalOp::kMovePlayer:
+      if (IsOnMap(record.location_)) {
+        player_.location_ = record.location_;
+        Record(record);
+      }
+      break;
+    case JournalOp::kSetDirection:
+      if (record.value_ <= static_cast<uint64_t>(Direction::kRight)) {
+        SetDirection(static_cast<Direction>(record.value_));
+      }
+      break;
   }
 }
 
+bool Engine::IsOnMap(const Location& location) const {
+  return location.GetRow() >= 0 && location.GetCol() >= 0
+      && static_cast<size_t>(location.GetRow()) < map_.GetNumRows()
+      && static_cast<size_t>(location.GetCol()) < map_.GetNumCols();
+}
+
+void Engine::SetJournaling(bool is_journaling) {
+  is_journaling_ = is_journaling;
+  journal_.clear();
+}
+
+std::vector<JournalRecord> Engine::TakeJournal() {
+  std::vector<JournalRecord> journal;
+  journal.swap(journal_);
+  return journal;
+}
+
+bool Engine::Load(const std::string& file_path, uint64_t* generation) {
+  std::ifstream read_file(file_path, std::ios::binary);
+  if (!read_file) {
+    return false;
+  }
+  const std::string text((std::istreambuf_iterator<char>(read_file)),
+                         std::istreambuf_iterator<char>());
+  SaveState state;
+  if (!ParseSave(text, &state)) {
+    return false;
+  }
+  Restore(state);
+
+  // A journal left over from an older save was already part of this one.
+  uint64_t journal_generation;
+  std::vector<JournalRecord> records;
+  if (state.journal_generation_ != 0
+      && ReadSaveJournal(GetJournalPath(file_path), &journal_generation,
+                         &records)
+      && journal_generation == state.journal_generation_) {
+    for (const JournalRecord& record : records) {
+      Apply(record);
+    }
+  }
+  journal_.clear();
+  if (generation != nullptr) {
+    *generation = state.journal_generation_;
+  }
+  return true;
+}
+
 bool Engine::IsValidDirection(const Direction &direction) const {
   Location direction_loc = GetLocationDelta(direction);
   Location new_loc =
@@ -140,12 +319,11 @@ bool Engine::IsValidDirection(const Direction &direction) const {
 
 
 Npc Engine::GetNpcAtLocation(const Location &location) const {
-  for (const auto& npc : npcs_) {
-    if (npc.location_.GetRow() == location.GetRow() &&
-        npc.location_.GetCol() == location.GetCol()) {
-      return npc;
-    }
+  size_t index = npcs_.FindAtLocation(location);
+  if (index == npcs_.GetSize()) {
+    return Npc("", location, {0, 0, 0, 0}, false, 0);
   }
+  return npcs_.GetNpc(index);
 }
 
 Location Engine::GetFacingLocation(const Direction& direction) const {
@@ -153,38 +331,150 @@ Location Engine::GetFacingLocation(const Direction& direction) const {
   return (player_.location_ + direction_loc) % Location(height_, width_);
 }
 
+bool Engine::CanPlayerReach(const Location& location) const {
+  return regions_->CanReach(player_.location_, location);
+}
+
+uint16_t Engine::GetPlayerDistance(const Location& location) {
+  std::shared_ptr<Regions> regions;
+  CacheDistanceField(location, &regions);
+  if (regions) {
+    regions_ = std::move(regions);
+  }
+  return regions_->GetCachedDistance(location, player_.location_);
+}
+
+std::vector<Npc> Engine::GetReachableNpcs() const {
+  std::vector<Npc> reachable_npcs;
+  const std::vector<Location>& locations = npcs_.GetLocations();
+  for (size_t index = 0; index < locations.size(); index++) {
+    if (CanPlayerReach(locations[index])) {
+      reachable_npcs.push_back(npcs_.GetNpc(index));
+    }
+  }
+  return reachable_npcs;
+}
+
+std::vector<std::string> Engine::GetCombatableNpcsNear(size_t num_tiles)
+    const {
+  std::vector<std::pair<size_t, std::string>> nearby;
+  const std::vector<Location>& locations = npcs_.GetLocations();
+  for (size_t index = 0; index < locations.size(); index++) {
+    if (!npcs_.GetIsCombatable()[index]) {
+      continue;
+    }
+    const size_t distance = static_cast<size_t>(std::max(
+        std::abs(locations[index].GetRow() - player_.location_.GetRow()),
+        std::abs(locations[index].GetCol() - player_.location_.GetCol())));
+    if (distance <= num_tiles) {
+      nearby.emplace_back(distance, npcs_.GetNames()[index]);
+    }
+  }
+  std::sort(nearby.begin(), nearby.end());
+
+  std::vector<std::string> names;
+  for (const auto& npc : nearby) {
+    names.push_back(npc.second);
+  }
+  return names;
+}
+
 Tile Engine::GetTileType(const Location& location) const {
   return map_.GetTile(location);
 }
 
+void Engine::SetDirection(const Direction& direction) {
+  if (direction_ == direction) {
+    return;
+  }
+  direction_ = direction;
+  JournalRecord record(JournalOp::kSetDirection);
+  record.value_ = static_cast<uint64_t>(direction);
+  Record(std::move(record));
+}
+
+void Engine::AddMoney(size_t money_to_add) {
+  player_.money_ += money_to_add;
+  JournalRecord record(JournalOp::kAddMoney);
+  record.value_ = money_to_add;
+  Record(std::move(record));
+}
+
+void Engine::RemoveMoney(size_t money_to_remove) {
+  player_.money_ -= money_to_remove;
+  JournalRecord record(JournalOp::kRemoveMoney);
+  record.value_ = money_to_remove;
+  Record(std::move(record));
+}
+
+void Engine::SetKey(bool is_key_found) {
+  is_key_found_ = is_key_found;
+  JournalRecord record(JournalOp::kSetKey);
+  record.value_ = is_key_found ? 1 : 0;
+  Record(std::move(record));
+}
+
 void Engine::AddInventoryItem(const Item& item) {
   player_.inventory_.push_back(item);
+  saved_inventory_.reset();
+  JournalRecord record(JournalOp::kAddInventoryItem);
+  record.name_ = item.name_;
+  record.description_ = item.description_;
+  record.file_path_ = item.file_path_;
+  Record(std::move(record));
 }
 
 void Engine::RemoveInventoryItem(const std::string& name) {
   for (size_t index = 0; index < player_.inventory_.size(); index++) {
     if (player_.inventory_[index].name_ == name) {
       player_.inventory_.erase(player_.inventory_.begin() + index);
+      saved_inventory_.reset();
+      JournalRecord record(JournalOp::kRemoveInventoryItem);
+      record.name_ = name;
+      Record(std::move(record));
       break;
     }
   }
 }
 
 void Engine::AddItem(const Item& item) {
-  items_.push_back(item);
+  std::shared_ptr<std::vector<Item>> items =
+      std::make_shared<std::vector<Item>>(*items_);
+  items->push_back(item);
+  items_ = std::move(items);
+  JournalRecord record(JournalOp::kAddItem);
+  record.name_ = item.name_;
+  record.description_ = item.description_;
+  record.file_path_ = item.file_path_;
+  Record(std::move(record));
+}
+
+void Engine::StockItems(const std::vector<Item>& items) {
+  if (is_restored_) {
+    return;
+  }
+  for (const Item& item : items) {
+    AddItem(item);
+  }
 }
 
 void Engine::RemoveItem(const std::string& item_name) {
-  for (size_t index = 0; index < items_.size(); index++) {
-    if (items_[index].name_ == item_name) {
-      items_.erase(items_.begin() + index);
+  for (size_t index = 0; index < items_->size(); index++) {
+    if ((*items_)[index].name_ == item_name) {
+      std::shared_ptr<std::vector<Item>> items =
+          std::make_shared<std::vector<Item>>(*items_);
+      items->erase(items->begin() + index);
+      items_ = std::move(items);
+      JournalRecord record(JournalOp::kRemoveItem);
+      record.name_ = item_name;
+      Record(std::move(record));
       return;
     }
   }
 }
 
 Item Engine::GetItem(const std::string& item_name) const {
-  for (auto& item : items_) {
+  for (auto& item : *items_) {
     if (item.name_ == item_name) {
       return item;
     }
@@ -192,11 +482,58 @@ Item Engine::GetItem(const std::string& item_name) const {
 }
 
 Item Engine::GetItemFromIndex(size_t index) const {
-  return items_[index];
+  return (*items_)[index];
 }
 
 void Engine::SetTile(const Location& location, const Tile& tile) {
+  if (map_.GetTile(location) == tile) {
+    return;
+  }
   map_.SetTile(location, tile);
+  num_tile_changes_++;
+  std::shared_ptr<Regions> regions = std::make_shared<Regions>(*regions_);
+  regions->Update(map_, location);
+  regions_ = std::move(regions);
+  if (flow_field_) {
+    flow_field_->Invalidate();
+  }
+  JournalRecord record(JournalOp::kSetTile);
+  record.location_ = location;
+  record.value_ = static_cast<uint64_t>(tile);
+  Record(std::move(record));
+}
+
+size_t Engine::GetNumBytes() const {
+  size_t num_bytes = sizeof(Engine) + map_.GetNumOverrideBytes()
+                     + door_locations_.capacity() * sizeof(Location)
+                     + player_.inventory_.capacity() * sizeof(Item)
+                     + journal_.capacity() * sizeof(JournalRecord)
+                     + npcs_.GetSize() * (sizeof(Npc) + sizeof(uint64_t));
+  if (flow_field_) {
+    num_bytes += sizeof(FlowField) + flow_field_->GetNumBytes();
+  }
+  // The items and the regions are only this game's own once it has changed
+  // them.
+  if (items_.use_count() == 1) {
+    num_bytes += items_->capacity() * sizeof(Item);
+  }
+  if (regions_.use_count() == 1) {
+    num_bytes += sizeof(Regions) + regions_->GetNumBytes();
+  }
+  return num_bytes;
+}
+
+void Engine::Record(JournalRecord record) {
+  if (!is_journaling_) {
+    return;
+  }
+  const bool is_move = record.op_ == JournalOp::kMovePlayer
+                       || record.op_ == JournalOp::kSetDirection;
+  if (is_move && !journal_.empty() && journal_.back().op_ == record.op_) {
+    journal_.back() = std::move(record);
+    return;
+  }
+  journal_.push_back(std::move(record));
 }
 
 }  // namespace island
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/entity_store.h>
+
+#include <utility>
+
+namespace island {
+
+EntityHandle EntityStore::Create(const Npc& npc, bool is_roaming) {
+  uint32_t slot_index;
+  if (!free_slots_.empty()) {
+    slot_index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot_index = static_cast<uint32_t>(slots_.size());
+    slots_.push_back({0, 0});
+  }
+
+  slots_[slot_index].dense_index_ = static_cast<uint32_t>(GetSize());
+  dense_to_slot_.push_back(slot_index);
+  names_.push_back(npc.name_);
+  locations_.push_back(npc.location_);
+  statistics_.push_back(npc.statistics_);
+  is_combatable_.push_back(npc.is_combatable_ ? 1 : 0);
+  money_.push_back(npc.money_);
+  is_roaming_.push_back(is_roaming ? 1 : 0);
+
+  return {slot_index, slots_[slot_index].generation_};
+}
+
+bool EntityStore::Destroy(const EntityHandle& handle) {
+  if (!IsAlive(handle)) {
+    return false;
+  }
+
+  // Moves the last entity into the destroyed entity's place in every column.
+  size_t removed = slots_[handle.index_].dense_index_;
+  size_t last = GetSize() - 1;
+  if (removed != last) {
+    names_[removed] = std::move(names_[last]);
+    locations_[removed] = locations_[last];
+    statistics_[removed] = statistics_[last];
+    is_combatable_[removed] = is_combatable_[last];
+    money_[removed] = money_[last];
+    is_roaming_[removed] = is_roaming_[last];
+    dense_to_slot_[removed] = dense_to_slot_[last];
+    slots_[dense_to_slot_[removed]].dense_index_ =
+        static_cast<uint32_t>(removed);
+  }
+
+  names_.pop_back();
+  locations_.pop_back();
+  statistics_.pop_back();
+  is_combatable_.pop_back();
+  money_.pop_back();
+  is_roaming_.pop_back();
+  dense_to_slot_.pop_back();
+
+  slots_[handle.index_].generation_++;
+  free_slots_.push_back(handle.index_);
+  return true;
+}
+
+bool EntityStore::IsAlive(const EntityHandle& handle) const {
+  return handle.index_ < slots_.size()
+      && slots_[handle.index_].generation_ == handle.generation_
+      && slots_[handle.index_].dense_index_ < GetSize()
+      && dense_to_slot_[slots_[handle.index_].dense_index_] == handle.index_;
+}
+
+size_t EntityStore::GetDenseIndex(const EntityHandle& handle) const {
+  return slots_[handle.index_].dense_index_;
+}
+
+EntityHandle EntityStore::GetHandle(size_t dense_index) const {
+  uint32_t slot_index = dense_to_slot_[dense_index];
+  return {slot_index, slots_[slot_index].generation_};
+}
+
+Npc EntityStore::GetNpc(size_t dense_index) const {
+  return Npc(names_[dense_index], locations_[dense_index],
+             statistics_[dense_index], is_combatable_[dense_index] != 0,
+             money_[dense_index]);
+}
+
+std::vector<Npc> EntityStore::GetNpcs() const {
+  std::vector<Npc> npcs;
+  npcs.reserve(GetSize());
+  for (size_t index = 0; index < GetSize(); index++) {
+    npcs.push_back(GetNpc(index));
+  }
+  return npcs;
+}
+
+size_t EntityStore::FindAtLocation(const Location& location) const {
+  for (size_t index = 0; index < locations_.size(); index++) {
+    if (locations_[index] == location) {
+      return index;
+    }
+  }
+  return GetSize();
+}
+
+}  // namespace island
@@ -0,0 +1,156 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/flow_field.h>
+
+#include <utility>
+
+namespace island {
+
+const uint8_t FlowField::kNoDirection;
+
+FlowField::FlowField(const Map& map)
+    : num_rows_{map.GetNumRows()},
+      num_cols_{map.GetNumCols()},
+      target_{0, 0},
+      pending_target_{0, 0},
+      latest_target_{0, 0},
+      has_target_{false},
+      is_building_{false},
+      directions_(num_rows_ * num_cols_, kNoDirection),
+      distances_(num_rows_ * num_cols_, UINT16_MAX),
+      frontier_head_{0} {}
+
+void FlowField::SetTarget(const Location& target) {
+  if (has_target_ && target == latest_target_) {
+    return;
+  }
+
+  latest_target_ = target;
+  has_target_ = true;
+  if (!is_building_) {
+    StartBuild();
+  }
+}
+
+void FlowField::Invalidate() {
+  if (has_target_) {
+    StartBuild();
+  }
+}
+
+bool FlowField::Advance(const Map& map, size_t budget) {
+  const Direction directions[] = {Direction::kUp, Direction::kDown,
+                                  Direction::kLeft, Direction::kRight};
+  const Direction opposites[] = {Direction::kDown, Direction::kUp,
+                                 Direction::kRight, Direction::kLeft};
+
+  for (size_t visited = 0; is_building_ && visited < budget; visited++) {
+    if (frontier_head_ == frontier_.size()) {
+      std::swap(directions_, back_directions_);
+      std::swap(distances_, back_distances_);
+      target_ = pending_target_;
+      is_building_ = false;
+
+      // The target moved while this field was being built.
+      if (latest_target_ != target_) {
+        StartBuild();
+      }
+      continue;
+    }
+
+    Location current = frontier_[frontier_head_++];
+    uint16_t distance = back_distances_[ToIndex(current)];
+    for (size_t dir = 0; dir < 4; dir++) {
+      Location neighbor = current + GetDelta(directions[dir]);
+      if (!IsOnMap(neighbor) || !map.IsAccessibleTile(neighbor)) {
+        continue;
+      }
+
+      size_t neighbor_index = ToIndex(neighbor);
+      if (back_distances_[neighbor_index] == UINT16_MAX) {
+        back_distances_[neighbor_index] = static_cast<uint16_t>(distance + 1);
+        back_directions_[neighbor_index] =
+            static_cast<uint8_t>(opposites[dir]);
+        frontier_.push_back(neighbor);
+      }
+    }
+  }
+
+  return !is_building_;
+}
+
+void FlowField::Rebuild(const Map& map) {
+  Invalidate();
+  while (!Advance(map, SIZE_MAX)) {}
+}
+
+bool FlowField::HasDirection(const Location& location) const {
+  return IsOnMap(location) && directions_[ToIndex(location)] != kNoDirection;
+}
+
+Direction FlowField::GetDirection(const Location& location) const {
+  return static_cast<Direction>(directions_[ToIndex(location)]);
+}
+
+Location FlowField::Step(const Location& location) const {
+  if (!HasDirection(location) || distances_[ToIndex(location)] <= 1) {
+    return location;
+  }
+  return location + GetDelta(GetDirection(location));
+}
+
+void FlowField::StepAll(std::vector<Location>* locations) const {
+  for (auto& location : *locations) {
+    location = Step(location);
+  }
+}
+
+uint16_t FlowField::GetDistance(const Location& location) const {
+  if (!IsOnMap(location)) {
+    return UINT16_MAX;
+  }
+  return distances_[ToIndex(location)];
+}
+
+size_t FlowField::GetNumBytes() const {
+  return directions_.capacity() + back_directions_.capacity()
+         + (distances_.capacity() + back_distances_.capacity())
+           * sizeof(uint16_t)
+         + frontier_.capacity() * sizeof(Location);
+}
+
+bool FlowField::IsOnMap(const Location& location) const {
+  return location.GetRow() >= 0 && location.GetCol() >= 0
+      && static_cast<size_t>(location.GetRow()) < num_rows_
+      && static_cast<size_t>(location.GetCol()) < num_cols_;
+}
+
+Location FlowField::GetDelta(Direction direction) {
+  switch (direction) {
+    case Direction::kUp:
+      return {0, -1};
+    case Direction::kDown:
+      return {0, +1};
+    case Direction::kLeft:
+      return {-1, 0};
+    case Direction::kRight:
+      return {+1, 0};
+  }
+  return {0, 0};
+}
+
+void FlowField::StartBuild() {
+  pending_target_ = latest_target_;
+  is_building_ = true;
+  back_directions_.assign(num_rows_ * num_cols_, kNoDirection);
+  back_distances_.assign(num_rows_ * num_cols_, UINT16_MAX);
+  frontier_.clear();
+  frontier_head_ = 0;
+
+  if (IsOnMap(pending_target_)) {
+    back_distances_[ToIndex(pending_target_)] = 0;
+    frontier_.push_back(pending_target_);
+  }
+}
+
+}  // namespace island
@@ -0,0 +1,100 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/frame_encoder.h>
+
+#include <utility>
+
+namespace island {
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+FrameEncoder::FrameEncoder(size_t num_slots,
+                           std::function<void(const CapturedFrame&)> encode)
+    : encode_{std::move(encode)},
+      slots_(num_slots),
+      num_acquired_{0},
+      num_submitted_{0},
+      num_dropped_{0},
+      num_encoded_{0},
+      encode_time_{0},
+      is_running_{true} {
+  for (CapturedFrame& slot : slots_) {
+    free_slots_.push_back(&slot);
+  }
+  thread_ = std::thread(&FrameEncoder::EncodeLoop, this);
+}
+
+FrameEncoder::~FrameEncoder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  submitted_.notify_one();
+  thread_.join();
+}
+
+CapturedFrame* FrameEncoder::Acquire() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t index = num_acquired_++;
+  if (free_slots_.empty()) {
+    num_dropped_++;
+    return nullptr;
+  }
+
+  CapturedFrame* frame = free_slots_.back();
+  free_slots_.pop_back();
+  frame->index_ = index;
+  return frame;
+}
+
+void FrameEncoder::Submit(CapturedFrame* frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(frame);
+    num_submitted_++;
+  }
+  submitted_.notify_one();
+}
+
+void FrameEncoder::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  encoded_.wait(lock, [this] {
+    return num_encoded_ == num_submitted_;
+  });
+}
+
+CaptureStats FrameEncoder::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {num_submitted_, num_dropped_, num_encoded_, encode_time_};
+}
+
+void FrameEncoder::EncodeLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    submitted_.wait(lock, [this] {
+      return !pending_.empty() || !is_running_;
+    });
+    // Frames still waiting when the encoder stops are written first.
+    if (pending_.empty()) {
+      return;
+    }
+
+    CapturedFrame* frame = pending_.front();
+    pending_.pop_front();
+    lock.unlock();
+    const auto start = steady_clock::now();
+    encode_(*frame);
+    const nanoseconds time = duration_cast<nanoseconds>(
+        steady_clock::now() - start);
+    lock.lock();
+
+    free_slots_.push_back(frame);
+    num_encoded_++;
+    encode_time_ += time;
+    encoded_.notify_all();
+  }
+}
+
+}  // namespace island
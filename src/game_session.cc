@@ -0,0 +1,318 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/game_session.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/**
+ * Determines whether the game has something to say about a tile, which
+ * the player then reads until they interact again.
+ *
+ * @param tile the tile
+ * @return true if the tile has a text
+ */
+bool HasText(Tile tile) {
+  switch (tile) {
+    case kCold:
+    case kFarm:
+    case kWater:
+    case kPuddle:
+    case kTree:
+    case kNotice:
+    case kMailBox:
+    case kDoor:
+    case kExtreme:
+    case kKey:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Gets the direction opposite to another, which an npc turns to face the
+ * player who is talking to them.
+ *
+ * @param direction the direction
+ * @return the opposite direction
+ */
+Direction GetOpposite(Direction direction) {
+  switch (direction) {
+    case Direction::kUp:
+      return Direction::kDown;
+    case Direction::kDown:
+      return Direction::kUp;
+    case Direction::kLeft:
+      return Direction::kRight;
+    case Direction::kRight:
+      return Direction::kLeft;
+  }
+  return direction;
+}
+
+}  // namespace
+
+GameSession::GameSession(std::shared_ptr<const World> world,
+                         const std::string& player_name)
+    : engine_{world, player_name, kStartLocation,
+              {10, 10, 10, 10}, kStartMoney},
+      state_{SessionState::kPlaying},
+      facing_{Direction::kDown},
+      is_moving_{false},
+      should_start_battle_{false},
+      battle_npc_{Npc("", {0, 0}, {0, 0, 0, 0}, false, 0)},
+      npc_facings_{world->npc_facings_},
+      player_hp_{0},
+      npc_hp_{0},
+      num_npc_turns_{0},
+      has_run_{false} {}
+
+void GameSession::HandleAction(PlayerAction action) {
+  if (state_ == SessionState::kBattle) {
+    BattleTurn(action);
+    return;
+  }
+
+  switch (action) {
+    case PlayerAction::kMoveUp:
+      Move(Direction::kUp);
+      break;
+    case PlayerAction::kMoveDown:
+      Move(Direction::kDown);
+      break;
+    case PlayerAction::kMoveLeft:
+      Move(Direction::kLeft);
+      break;
+    case PlayerAction::kMoveRight:
+      Move(Direction::kRight);
+      break;
+
+    case PlayerAction::kInteract:
+      Interact();
+      break;
+
+    case PlayerAction::kToggleInventory:
+      if (state_ == SessionState::kInventory) {
+        state_ = SessionState::kPlaying;
+      } else if (state_ == SessionState::kPlaying) {
+        state_ = SessionState::kInventory;
+      }
+      break;
+
+    case PlayerAction::kAccept:
+      if (state_ == SessionState::kMarket) {
+        BuyItem();
+      }
+      break;
+
+    case PlayerAction::kDecline:
+      if (state_ == SessionState::kMarket) {
+        state_ = SessionState::kPlaying;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void GameSession::Step() {
+  if (is_moving_) {
+    engine_.ExecuteTimeStep();
+    is_moving_ = false;
+  }
+  engine_.Tick();
+}
+
+void GameSession::Step(JobSystem* job_system) {
+  if (is_moving_) {
+    engine_.ExecuteTimeStep();
+    is_moving_ = false;
+  }
+  engine_.Tick(job_system);
+}
+
+bool GameSession::GetItemForSale(Item* item) const {
+  if (engine_.GetNumItems() == 0
+      || engine_.GetItemFromIndex(0).name_ == "key") {
+    return false;
+  }
+  *item = engine_.GetItemFromIndex(0);
+  return true;
+}
+
+size_t GameSession::GetNumBytes() const {
+  return sizeof(GameSession) - sizeof(Engine) + engine_.GetNumBytes()
+         + npc_facings_.capacity() * sizeof(Direction);
+}
+
+void GameSession::Move(Direction direction) {
+  if (state_ != SessionState::kPlaying) {
+    return;
+  }
+  facing_ = direction;
+  if (engine_.IsValidDirection(direction)) {
+    engine_.SetDirection(direction);
+    is_moving_ = true;
+  }
+}
+
+void GameSession::Interact() {
+  if (state_ == SessionState::kTalking) {
+    state_ = SessionState::kPlaying;
+    if (should_start_battle_) {
+      should_start_battle_ = false;
+      has_run_ = false;
+      state_ = SessionState::kBattle;
+      // The faster side moves first.
+      const Statistics& stats = engine_.GetPlayer().statistics_;
+      if (static_cast<double>(stats.speed_) * GetMultiplier("shoe")
+          < static_cast<double>(battle_npc_.statistics_.speed_)) {
+        NpcTurn();
+        UpdateBattle();
+      }
+    }
+    return;
+  }
+  if (state_ == SessionState::kMarket) {
+    state_ = SessionState::kPlaying;
+    return;
+  }
+  if (state_ != SessionState::kPlaying) {
+    return;
+  }
+
+  const Location facing_location = engine_.GetFacingLocation(facing_);
+  const Tile facing_tile = engine_.GetTileType(facing_location);
+  if (facing_location == kMarketLocation) {
+    TurnNpc(facing_location);
+    state_ = SessionState::kMarket;
+    return;
+  }
+  if (facing_tile == kNpc) {
+    TalkToNpc(facing_location);
+    return;
+  }
+  if (!HasText(facing_tile)) {
+    return;
+  }
+
+  state_ = SessionState::kTalking;
+  if (facing_tile == kKey) {
+    engine_.SetKey(true);
+    engine_.AddInventoryItem(engine_.GetItem("key"));
+    engine_.RemoveItem("key");
+    engine_.SetTile(facing_location, kTree);
+  } else if (facing_tile == kPuddle) {
+    engine_.AddMoney(kPuddleMoney);
+  }
+}
+
+void GameSession::TurnNpc(const Location& location) {
+  const size_t index = engine_.GetNpcStore().FindAtLocation(location);
+  if (index < npc_facings_.size()) {
+    npc_facings_[index] = GetOpposite(facing_);
+  }
+}
+
+void GameSession::TalkToNpc(const Location& location) {
+  const Npc npc = engine_.GetNpcAtLocation(location);
+  state_ = SessionState::kTalking;
+  TurnNpc(location);
+
+  // Klutz pays for his key once.
+  const std::vector<Item>& inventory = engine_.GetPlayer().inventory_;
+  const bool has_key = std::any_of(inventory.begin(), inventory.end(),
+                                   [](const Item& item) {
+    return item.name_ == "key";
+  });
+  if (npc.name_ == "Klutz" && engine_.GetKey() && has_key) {
+    engine_.AddMoney(kKeyMoney);
+    engine_.RemoveInventoryItem("key");
+  }
+
+  if (npc.is_combatable_) {
+    should_start_battle_ = true;
+    battle_npc_ = npc;
+    const Statistics& stats = engine_.GetPlayer().statistics_;
+    player_hp_ = static_cast<double>(stats.hit_points_)
+                 * GetMultiplier("heart");
+    npc_hp_ = static_cast<double>(npc.statistics_.hit_points_);
+    num_npc_turns_ = 0;
+  }
+}
+
+void GameSession::BuyItem() {
+  Item item("", "", "");
+  if (engine_.GetPlayer().money_ < kItemPrice || !GetItemForSale(&item)) {
+    return;
+  }
+  engine_.AddInventoryItem(item);
+  engine_.RemoveItem(item.name_);
+  engine_.RemoveMoney(kItemPrice);
+  state_ = SessionState::kPlaying;
+}
+
+void GameSession::BattleTurn(PlayerAction action) {
+  const Statistics& stats = engine_.GetPlayer().statistics_;
+  switch (action) {
+    case PlayerAction::kAttack:
+      npc_hp_ -= static_cast<double>(stats.attack_) * GetMultiplier("sword")
+                 * kAttackConstant
+                 / static_cast<double>(battle_npc_.statistics_.defense_);
+      break;
+    case PlayerAction::kHeal:
+      player_hp_ = std::min(
+          player_hp_ + static_cast<double>(stats.hit_points_) / kHealConstant,
+          static_cast<double>(stats.hit_points_));
+      break;
+    case PlayerAction::kRun:
+      has_run_ = true;
+      break;
+    default:
+      return;
+  }
+  UpdateBattle();
+  if (state_ == SessionState::kBattle) {
+    NpcTurn();
+    UpdateBattle();
+  }
+}
+
+void GameSession::NpcTurn() {
+  num_npc_turns_++;
+  player_hp_ -= static_cast<double>(battle_npc_.statistics_.attack_)
+                * kAttackConstant
+                / (static_cast<double>(engine_.GetPlayer().statistics_.defense_)
+                   * GetMultiplier("shield"));
+}
+
+void GameSession::UpdateBattle() {
+  if (has_run_) {
+    state_ = SessionState::kPlaying;
+  } else if (player_hp_ < 0) {
+    if (engine_.GetPlayer().money_ > battle_npc_.money_) {
+      engine_.RemoveMoney(battle_npc_.money_);
+    }
+    state_ = SessionState::kPlaying;
+  } else if (npc_hp_ < 0) {
+    engine_.AddMoney(battle_npc_.money_);
+    state_ = SessionState::kPlaying;
+  }
+}
+
+double GameSession::GetMultiplier(const std::string& item_name) const {
+  for (const Item& item : engine_.GetPlayer().inventory_) {
+    if (item.name_ == item_name) {
+      return kStatMultiplier;
+    }
+  }
+  return 1;
+}
+
+}  // namespace island
@@ -0,0 +1,185 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/job_system.h>
+
+#include <utility>
+
+namespace island {
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+JobSystem::JobSystem(size_t num_workers)
+    : num_unfinished_{0},
+      num_ready_{0},
+      next_queue_{0},
+      is_stopping_{false} {
+  for (size_t queue = 0; queue < num_workers + 1; queue++) {
+    queues_.emplace_back(new WorkQueue());
+  }
+  for (size_t worker = 0; worker < num_workers; worker++) {
+    workers_.emplace_back(&JobSystem::WorkerLoop, this, worker);
+  }
+}
+
+JobSystem::~JobSystem() {
+  Wait();
+  is_stopping_ = true;
+  WakeAll();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+JobId JobSystem::Submit(const std::string& name, std::function<void()> task,
+                        const std::vector<JobId>& dependencies) {
+  bool is_ready;
+  JobId id;
+  {
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+    std::unique_ptr<Job> job(new Job());
+    job->name_ = name;
+    job->task_ = std::move(task);
+    job->num_pending_ = 0;
+    job->is_finished_ = false;
+
+    for (JobId dependency : dependencies) {
+      Job* prerequisite = jobs_[dependency].get();
+      if (!prerequisite->is_finished_) {
+        prerequisite->dependents_.push_back(job.get());
+        job->num_pending_++;
+      }
+    }
+
+    num_unfinished_++;
+    is_ready = job->num_pending_ == 0;
+    if (is_ready) {
+      PushReady(job.get());
+    }
+    id = jobs_.size();
+    jobs_.push_back(std::move(job));
+  }
+
+  if (is_ready) {
+    WakeAll();
+  }
+  return id;
+}
+
+void JobSystem::Wait() {
+  const size_t waiter = queues_.size() - 1;
+  while (num_unfinished_ > 0) {
+    Job* job = TakeJob(waiter);
+    if (job != nullptr) {
+      Run(job, waiter);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this] {
+      return num_ready_ > 0 || num_unfinished_ == 0;
+    });
+  }
+
+  std::lock_guard<std::mutex> lock(graph_mutex_);
+  timings_.clear();
+  for (const auto& job : jobs_) {
+    timings_.push_back(job->timing_);
+  }
+  jobs_.clear();
+}
+
+void JobSystem::WorkerLoop(size_t worker) {
+  while (!is_stopping_) {
+    Job* job = TakeJob(worker);
+    if (job != nullptr) {
+      Run(job, worker);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this] {
+      return num_ready_ > 0 || is_stopping_;
+    });
+  }
+}
+
+JobSystem::Job* JobSystem::TakeJob(size_t worker) {
+  {
+    WorkQueue& own = *queues_[worker];
+    std::lock_guard<std::mutex> lock(own.mutex_);
+    if (!own.jobs_.empty()) {
+      Job* job;
+      // Deterministic mode keeps submission order, workers prefer the job
+      // they released most recently since its data is likely still cached.
+      if (IsDeterministic()) {
+        job = own.jobs_.front();
+        own.jobs_.pop_front();
+      } else {
+        job = own.jobs_.back();
+        own.jobs_.pop_back();
+      }
+      num_ready_--;
+      return job;
+    }
+  }
+
+  for (size_t offset = 1; offset < queues_.size(); offset++) {
+    WorkQueue& victim = *queues_[(worker + offset) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (!victim.jobs_.empty()) {
+      Job* job = victim.jobs_.front();
+      victim.jobs_.pop_front();
+      num_ready_--;
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::PushReady(Job* job) {
+  size_t queue = 0;
+  if (!IsDeterministic()) {
+    queue = next_queue_;
+    next_queue_ = (next_queue_ + 1) % workers_.size();
+  }
+
+  std::lock_guard<std::mutex> lock(queues_[queue]->mutex_);
+  queues_[queue]->jobs_.push_back(job);
+  num_ready_++;
+}
+
+void JobSystem::WakeAll() {
+  // Taking the lock makes sure no thread is between checking its wait
+  // condition and going to sleep, so the notification can't be lost.
+  std::lock_guard<std::mutex> lock(wake_mutex_);
+  wake_.notify_all();
+}
+
+void JobSystem::Run(Job* job, size_t worker) {
+  auto start = steady_clock::now();
+  job->task_();
+  job->timing_.name_ = job->name_;
+  job->timing_.duration_ =
+      duration_cast<nanoseconds>(steady_clock::now() - start);
+  job->timing_.worker_ = worker;
+
+  bool has_released = false;
+  {
+    std::lock_guard<std::mutex> lock(graph_mutex_);
+    job->is_finished_ = true;
+    for (Job* dependent : job->dependents_) {
+      if (--dependent->num_pending_ == 0) {
+        PushReady(dependent);
+        has_released = true;
+      }
+    }
+  }
+
+  if (--num_unfinished_ == 0 || has_released) {
+    WakeAll();
+  }
+}
+
+}  // namespace island
@@ -0,0 +1,100 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/key_actions.h>
+
+namespace island {
+
+bool GetKeyAction(uint32_t key_code, PlayerAction* action) {
+  switch (key_code) {
+    case kKeyUp:
+    case kKeyW:
+      *action = PlayerAction::kMoveUp;
+      return true;
+
+    case kKeyDown:
+    case kKeyS:
+      *action = PlayerAction::kMoveDown;
+      return true;
+
+    case kKeyLeft:
+    case kKeyA:
+      *action = PlayerAction::kMoveLeft;
+      return true;
+
+    case kKeyRight:
+    case kKeyD:
+      *action = PlayerAction::kMoveRight;
+      return true;
+
+    case kKeyZ:
+      *action = PlayerAction::kInteract;
+      return true;
+
+    case kKeyX:
+      *action = PlayerAction::kToggleInventory;
+      return true;
+
+    case kKeyY:
+      *action = PlayerAction::kAccept;
+      return true;
+
+    case kKeyN:
+      *action = PlayerAction::kDecline;
+      return true;
+
+    case kKeySpace:
+      *action = PlayerAction::kAttack;
+      return true;
+
+    case kKeyH:
+      *action = PlayerAction::kHeal;
+      return true;
+
+    case kKeyR:
+      *action = PlayerAction::kRun;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+KeyCode GetActionKey(PlayerAction action) {
+  switch (action) {
+    case PlayerAction::kMoveUp:
+      return kKeyUp;
+
+    case PlayerAction::kMoveDown:
+      return kKeyDown;
+
+    case PlayerAction::kMoveLeft:
+      return kKeyLeft;
+
+    case PlayerAction::kMoveRight:
+      return kKeyRight;
+
+    case PlayerAction::kInteract:
+      return kKeyZ;
+
+    case PlayerAction::kToggleInventory:
+      return kKeyX;
+
+    case PlayerAction::kAccept:
+      return kKeyY;
+
+    case PlayerAction::kDecline:
+      return kKeyN;
+
+    case PlayerAction::kAttack:
+      return kKeySpace;
+
+    case PlayerAction::kHeal:
+      return kKeyH;
+
+    case PlayerAction::kRun:
+      return kKeyR;
+  }
+  return kKeyUnknown;
+}
+
+}  // namespace island
@@ -23,4 +23,12 @@ Location Location::operator%(const Location& rhs) const {
   return {mod(row_, rhs.row_), mod(col_, rhs.col_)};
 }
 
+bool Location::operator==(const Location& rhs) const {
+  return row_ == rhs.row_ && col_ == rhs.col_;
+}
+
+bool Location::operator!=(const Location& rhs) const {
+  return !(*this == rhs);
+}
+
 }  // namespace island
@@ -3,55 +3,132 @@
 #include <island/map.h>
 
 #include <fstream>
+#include <memory>
+#include <utility>
 
 namespace island {
 
-Map::Map() {
-  std::ifstream map_file("assets/map_tileset.txt");
-  char tile;
-  InitializeMapTiles();
-  for (size_t row = 0; row < kMapSize; row++) {
-    raw_map_.emplace_back();
-    for (size_t col = 0; col < kMapSize; col++) {
-      map_file >> tile;
-      raw_map_[row].push_back(letter_tiles_.at(tile));
-    }
+namespace {
+
+/**
+ * Gets the tile a letter in the tileset file stands for.
+ *
+ * @param letter the letter
+ * @return the tile, or kInvalid if the letter is not a tile
+ */
+Tile GetLetterTile(char letter) {
+  switch (letter) {
+    case 'g': return kGrass;
+    case 'r': return kRoad;
+    case 's': return kSand;
+    case 'c': return kCold;
+    case 'f': return kFarm;
+    case 'w': return kWater;
+    case 'p': return kPuddle;
+    case 't': return kTree;
+    case 'n': return kNotice;
+    case 'm': return kMailBox;
+    case 'b': return kBarrier;
+    case 'h': return kHouse;
+    case 'l': return kDoor;
+    case 'e': return kExtreme;
+    case 'k': return kKey;
+    case 'q': return kNpc;
+    default: return kInvalid;
   }
 }
 
-void Map::InitializeMapTiles() {
-  letter_tiles_.insert(std::pair<char, Tile>('i', kInvalid));
-  letter_tiles_.insert(std::pair<char, Tile>('g', kGrass));
-  letter_tiles_.insert(std::pair<char, Tile>('r', kRoad));
-  letter_tiles_.insert(std::pair<char, Tile>('s', kSand));
-  letter_tiles_.insert(std::pair<char, Tile>('c', kCold));
-  letter_tiles_.insert(std::pair<char, Tile>('f', kFarm));
-  letter_tiles_.insert(std::pair<char, Tile>('w', kWater));
-  letter_tiles_.insert(std::pair<char, Tile>('p', kPuddle));
-  letter_tiles_.insert(std::pair<char, Tile>('t', kTree));
-  letter_tiles_.insert(std::pair<char, Tile>('n', kNotice));
-  letter_tiles_.insert(std::pair<char, Tile>('m', kMailBox));
-  letter_tiles_.insert(std::pair<char, Tile>('b', kBarrier));
-  letter_tiles_.insert(std::pair<char, Tile>('h', kHouse));
-  letter_tiles_.insert(std::pair<char, Tile>('l', kDoor));
-  letter_tiles_.insert(std::pair<char, Tile>('e', kExtreme));
-  letter_tiles_.insert(std::pair<char, Tile>('k', kKey));
-  letter_tiles_.insert(std::pair<char, Tile>('q', kNpc));
+}  // namespace
+
+Map::Map()
+    : Map([] {
+        // Loaded once, however many maps are made from it.
+        static const std::shared_ptr<const MapTiles> tiles =
+            LoadTiles("assets/map_tileset.txt");
+        return tiles;
+      }()) {}
+
+Map::Map(const std::vector<std::vector<Tile>>& raw_map)
+    : Map([&raw_map] {
+        std::shared_ptr<MapTiles> tiles = std::make_shared<MapTiles>();
+        tiles->num_rows_ = raw_map.size();
+        tiles->num_cols_ = raw_map.empty() ? 0 : raw_map[0].size();
+        for (const std::vector<Tile>& row : raw_map) {
+          tiles->tiles_.insert(tiles->tiles_.end(), row.begin(), row.end());
+        }
+        return std::shared_ptr<const MapTiles>(std::move(tiles));
+      }()) {}
+
+Map::Map(std::shared_ptr<const MapTiles> base)
+    : base_{std::move(base)},
+      num_cols_{base_->num_cols_} {}
+
+std::shared_ptr<const MapTiles> Map::LoadTiles(const std::string& file_path) {
+  std::shared_ptr<MapTiles> tiles = std::make_shared<MapTiles>();
+  tiles->num_rows_ = kMapSize;
+  tiles->num_cols_ = kMapSize;
+  tiles->tiles_.reserve(kMapSize * kMapSize);
+
+  std::ifstream map_file(file_path);
+  char letter = '\0';
+  for (size_t tile = 0; tile < kMapSize * kMapSize; tile++) {
+    tiles->tiles_.push_back(map_file >> letter ? GetLetterTile(letter)
+                                               : kInvalid);
+  }
+  return tiles;
 }
 
 bool Map::IsAccessibleTile(const Location& location) const {
-  return raw_map_[location.GetRow()][location.GetCol()] == kGrass
-  || raw_map_[location.GetRow()][location.GetCol()] == kRoad
-  || raw_map_[location.GetRow()][location.GetCol()] == kSand
-  || raw_map_[location.GetRow()][location.GetCol()] == kPuddle;
+  const Tile tile = GetTile(location);
+  return tile == kGrass || tile == kRoad || tile == kSand || tile == kPuddle;
+}
+
+void Map::SetTile(const Location& location, const Tile& tile) {
+  const size_t index = static_cast<size_t>(location.GetRow()) * num_cols_
+                       + static_cast<size_t>(location.GetCol());
+  if (override_bits_.empty()) {
+    override_bits_.resize((base_->tiles_.size() + 63) / 64, 0);
+  }
+  if (tile == base_->tiles_[index]) {
+    override_bits_[index / 64] &= ~(uint64_t(1) << (index % 64));
+    overrides_.erase(index);
+  } else {
+    override_bits_[index / 64] |= uint64_t(1) << (index % 64);
+    overrides_[index] = tile;
+  }
 }
 
-Tile Map::GetTile(const Location& location) const {
-  return raw_map_[location.GetRow()][location.GetCol()];
+void Map::ResetTiles() {
+  std::vector<uint64_t>().swap(override_bits_);
+  std::unordered_map<size_t, Tile>().swap(overrides_);
 }
 
-void Map::SetTile(const Location& location, const Tile& tile) {
-  raw_map_[location.GetRow()][location.GetCol()] = tile;
+std::vector<TileChange> Map::GetOverrides() const {
+  std::vector<TileChange> changes;
+  for (size_t word = 0; word < override_bits_.size(); word++) {
+    if (override_bits_[word] == 0) {
+      continue;
+    }
+    for (size_t bit = 0; bit < 64; bit++) {
+      if (override_bits_[word] >> bit & 1) {
+        const size_t index = word * 64 + bit;
+        changes.push_back({Location(static_cast<int>(index / num_cols_),
+                                    static_cast<int>(index % num_cols_)),
+                           overrides_.at(index)});
+      }
+    }
+  }
+  return changes;
+}
+
+size_t Map::GetNumOverrideBytes() const {
+  if (override_bits_.empty()) {
+    return 0;
+  }
+  // Each override costs at least its key, its tile and a bucket pointer.
+  return override_bits_.capacity() * sizeof(uint64_t)
+         + overrides_.size() * (sizeof(size_t) + sizeof(Tile) + sizeof(void*))
+         + overrides_.bucket_count() * sizeof(void*);
 }
 
 }  // namespace island
\ No newline at end of file
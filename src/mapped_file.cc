@@ -0,0 +1,73 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/mapped_file.h>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace island {
+
+MappedFile::MappedFile()
+    : data_{nullptr},
+      size_{0} {}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+#if defined(_WIN32)
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  contents_.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  if (contents_.empty()) {
+    return false;
+  }
+  data_ = contents_.data();
+  size_ = contents_.size();
+#else
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat info;
+  void* mapping = MAP_FAILED;
+  if (fstat(file, &info) == 0 && info.st_size > 0) {
+    mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                   MAP_PRIVATE, file, 0);
+  }
+  // The mapping stays valid after the file is closed.
+  close(file);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(info.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::Close() {
+#if !defined(_WIN32)
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+#endif
+  contents_.clear();
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace island
@@ -0,0 +1,212 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/pcm_cache.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/** The size of the header, in bytes. */
+const size_t kHeaderSize = 16;
+
+/** The size of one directory entry, in bytes. */
+const size_t kEntrySize = 32;
+
+/** The alignment of every sound's samples, in bytes. */
+const size_t kAlignment = 64;
+
+/**
+ * Appends a little endian word to a buffer.
+ *
+ * @param value the word to append
+ * @param num_bytes the size of the word, in bytes
+ * @param buffer the buffer to append to
+ */
+void AppendWord(uint64_t value, size_t num_bytes,
+                std::vector<uint8_t>* buffer) {
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    buffer->push_back(static_cast<uint8_t>(value >> (8 * byte)));
+  }
+}
+
+/**
+ * Reads a little endian word.
+ *
+ * @param data the first byte of the word
+ * @param num_bytes the size of the word, in bytes
+ * @return the word
+ */
+uint64_t ReadWord(const uint8_t* data, size_t num_bytes) {
+  uint64_t value = 0;
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    value |= uint64_t(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * Rounds an offset up to the cache's alignment.
+ *
+ * @param offset the offset to round
+ * @return the smallest aligned offset which is not less than offset
+ */
+size_t Align(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+void PcmCacheWriter::Add(uint64_t source_hash, size_t sample_rate,
+                         size_t num_channels, std::vector<float> samples) {
+  Sound sound = {source_hash, sample_rate, num_channels, std::move(samples)};
+  for (Sound& added : sounds_) {
+    if (added.source_hash_ == source_hash) {
+      added = std::move(sound);
+      return;
+    }
+  }
+  sounds_.push_back(std::move(sound));
+}
+
+bool PcmCacheWriter::Write(const std::string& path) const {
+  // The directory is sorted by hash so the reader can binary search it.
+  std::vector<const Sound*> sorted;
+  for (const Sound& sound : sounds_) {
+    sorted.push_back(&sound);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Sound* lhs, const Sound* rhs) {
+    return lhs->source_hash_ < rhs->source_hash_;
+  });
+
+  std::vector<uint8_t> header;
+  AppendWord(kPcmCacheMagic, 4, &header);
+  AppendWord(kPcmCacheVersion, 4, &header);
+  AppendWord(sorted.size(), 4, &header);
+  AppendWord(0, 4, &header);
+
+  const size_t first_data_offset = Align(kHeaderSize
+                                         + kEntrySize * sorted.size());
+  size_t data_offset = first_data_offset;
+  for (const Sound* sound : sorted) {
+    AppendWord(sound->source_hash_, 8, &header);
+    AppendWord(data_offset, 8, &header);
+    AppendWord(sound->samples_.size() / sound->num_channels_, 4, &header);
+    AppendWord(sound->sample_rate_, 4, &header);
+    AppendWord(sound->num_channels_, 4, &header);
+    AppendWord(0, 4, &header);
+    data_offset = Align(data_offset + sound->samples_.size() * sizeof(float));
+  }
+  header.resize(first_data_offset, 0);
+
+  // The samples are written as they are in memory, which is little endian
+  // on every platform the game runs on.
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(header.data()),
+               static_cast<std::streamsize>(header.size()));
+    size_t offset = first_data_offset;
+    const char padding[kAlignment] = {};
+    for (const Sound* sound : sorted) {
+      const size_t size = sound->samples_.size() * sizeof(float);
+      file.write(reinterpret_cast<const char*>(sound->samples_.data()),
+                 static_cast<std::streamsize>(size));
+      offset += size;
+      file.write(padding, static_cast<std::streamsize>(Align(offset)
+                                                       - offset));
+      offset = Align(offset);
+    }
+    if (!file) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+#ifdef _WIN32
+  // Renaming does not replace an existing file on Windows.
+  std::remove(path.c_str());
+#endif
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+PcmCache::PcmCache()
+    : num_sounds_{0} {}
+
+bool PcmCache::Open(const std::string& path) {
+  Close();
+  if (!file_.Open(path)) {
+    return false;
+  }
+
+  const uint8_t* data = file_.GetData();
+  const size_t size = file_.GetSize();
+  if (size < kHeaderSize || ReadWord(data, 4) != kPcmCacheMagic
+      || ReadWord(data + 4, 4) != kPcmCacheVersion) {
+    Close();
+    return false;
+  }
+  num_sounds_ = ReadWord(data + 8, 4);
+  if (kHeaderSize + kEntrySize * num_sounds_ > size) {
+    Close();
+    return false;
+  }
+
+  // Check every entry once, so Find can trust the directory.
+  for (size_t sound = 0; sound < num_sounds_; sound++) {
+    const uint8_t* entry = data + kHeaderSize + kEntrySize * sound;
+    const uint64_t offset = ReadWord(entry + 8, 8);
+    const uint64_t num_samples = ReadWord(entry + 16, 4)
+                                 * ReadWord(entry + 24, 4);
+    const bool is_valid = offset % kAlignment == 0 && offset <= size
+                          && num_samples <= (size - offset) / sizeof(float)
+                          && ReadWord(entry + 24, 4) > 0
+                          && (sound == 0
+                              || ReadWord(entry - kEntrySize, 8)
+                                 < ReadWord(entry, 8));
+    if (!is_valid) {
+      Close();
+      return false;
+    }
+  }
+  return true;
+}
+
+void PcmCache::Close() {
+  file_.Close();
+  num_sounds_ = 0;
+}
+
+bool PcmCache::Find(uint64_t source_hash, size_t sample_rate,
+                    PcmView* sound) const {
+  const uint8_t* data = file_.GetData();
+  size_t low = 0;
+  size_t high = num_sounds_;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const uint8_t* entry = data + kHeaderSize + kEntrySize * middle;
+    const uint64_t hash = ReadWord(entry, 8);
+    if (hash < source_hash) {
+      low = middle + 1;
+    } else if (hash > source_hash) {
+      high = middle;
+    } else {
+      if (ReadWord(entry + 20, 4) != sample_rate) {
+        return false;
+      }
+      sound->num_frames_ = ReadWord(entry + 16, 4);
+      sound->sample_rate_ = sample_rate;
+      sound->num_channels_ = ReadWord(entry + 24, 4);
+      sound->samples_ = reinterpret_cast<const float*>(
+          data + ReadWord(entry + 8, 8));
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace island
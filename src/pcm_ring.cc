@@ -0,0 +1,69 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/pcm_ring.h>
+
+#include <algorithm>
+
+namespace island {
+
+PcmRing::PcmRing(size_t num_frames, size_t num_channels)
+    : samples_(num_frames * num_channels),
+      num_frames_{num_frames},
+      num_channels_{num_channels},
+      read_count_{0},
+      write_count_{0},
+      num_underruns_{0},
+      num_missed_frames_{0} {}
+
+size_t PcmRing::Write(const float* samples, size_t num_frames) {
+  const size_t write_count = write_count_.load(std::memory_order_relaxed);
+  const size_t num_written = std::min(num_frames, GetNumFramesFree());
+
+  // The frames may wrap around the end of the ring, so copy in two parts.
+  const size_t start = write_count % num_frames_;
+  const size_t first_part = std::min(num_written, num_frames_ - start);
+  std::copy(samples, samples + first_part * num_channels_,
+            samples_.begin() + static_cast<std::ptrdiff_t>(
+                start * num_channels_));
+  std::copy(samples + first_part * num_channels_,
+            samples + num_written * num_channels_, samples_.begin());
+
+  write_count_.store(write_count + num_written, std::memory_order_release);
+  return num_written;
+}
+
+size_t PcmRing::Read(float* samples, size_t num_frames) {
+  const size_t read_count = read_count_.load(std::memory_order_relaxed);
+  const size_t num_read = std::min(num_frames, GetNumFramesQueued());
+
+  const size_t start = read_count % num_frames_;
+  const size_t first_part = std::min(num_read, num_frames_ - start);
+  const auto begin = samples_.begin()
+                     + static_cast<std::ptrdiff_t>(start * num_channels_);
+  std::copy(begin, begin + static_cast<std::ptrdiff_t>(
+                first_part * num_channels_), samples);
+  std::copy(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(
+                (num_read - first_part) * num_channels_),
+            samples + first_part * num_channels_);
+  read_count_.store(read_count + num_read, std::memory_order_release);
+
+  if (num_read < num_frames) {
+    std::fill(samples + num_read * num_channels_,
+              samples + num_frames * num_channels_, 0.0f);
+    num_underruns_.fetch_add(1, std::memory_order_relaxed);
+    num_missed_frames_.fetch_add(num_frames - num_read,
+                                 std::memory_order_relaxed);
+  }
+  return num_read;
+}
+
+size_t PcmRing::GetNumFramesQueued() const {
+  return write_count_.load(std::memory_order_acquire)
+         - read_count_.load(std::memory_order_acquire);
+}
+
+size_t PcmRing::GetNumFramesFree() const {
+  return num_frames_ - GetNumFramesQueued();
+}
+
+}  // namespace island
@@ -0,0 +1,309 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/regions.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace island {
+
+Regions::Regions(const Map& map) : num_rows_{0}, num_cols_{0} {
+  Label(map);
+}
+
+void Regions::Label(const Map& map) {
+  num_rows_ = map.GetNumRows();
+  num_cols_ = map.GetNumCols();
+  labels_.assign(num_rows_ * num_cols_, kNoRegion);
+  region_sizes_.assign(1, 0);
+  free_regions_.clear();
+  distance_fields_.clear();
+
+  for (size_t row = 0; row < num_rows_; row++) {
+    for (size_t col = 0; col < num_cols_; col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      if (labels_[ToIndex(location)] == kNoRegion
+          && map.IsAccessibleTile(location)) {
+        FloodFill(map, location, AllocateRegion());
+      }
+    }
+  }
+}
+
+void Regions::Update(const Map& map, const Location& location) {
+  size_t index = ToIndex(location);
+  bool was_accessible = labels_[index] != kNoRegion;
+  bool is_accessible = map.IsAccessibleTile(location);
+  std::vector<uint16_t> changed_regions;
+
+  if (was_accessible == is_accessible) {
+    return;
+  }
+
+  if (was_accessible) {
+    // The region may have been split in two, so every neighbor still in the
+    // old region starts a new one. Neighbors which turn out to be connected
+    // are absorbed by the first fill that reaches them.
+    uint16_t old_region = labels_[index];
+    changed_regions.push_back(old_region);
+    labels_[index] = kNoRegion;
+    region_sizes_[old_region]--;
+
+    for (const auto& neighbor : GetNeighbors(location)) {
+      if (labels_[ToIndex(neighbor)] == old_region) {
+        FloodFill(map, neighbor, AllocateRegion());
+      }
+    }
+  } else {
+    // The new tile may join several regions together.
+    for (const auto& neighbor : GetNeighbors(location)) {
+      uint16_t region = labels_[ToIndex(neighbor)];
+      if (region != kNoRegion
+          && std::find(changed_regions.begin(), changed_regions.end(),
+                       region) == changed_regions.end()) {
+        changed_regions.push_back(region);
+      }
+    }
+    FloodFill(map, location, AllocateRegion());
+  }
+
+  for (uint16_t region : changed_regions) {
+    if (region_sizes_[region] == 0) {
+      ReleaseRegion(region);
+    }
+  }
+  InvalidateFields(changed_regions, location);
+}
+
+uint16_t Regions::GetRegion(const Location& location) const {
+  if (!IsOnMap(location)) {
+    return kNoRegion;
+  }
+  return labels_[ToIndex(location)];
+}
+
+bool Regions::IsSameRegion(const Location& first,
+                           const Location& second) const {
+  uint16_t region = GetRegion(first);
+  return region != kNoRegion && region == GetRegion(second);
+}
+
+bool Regions::CanReach(const Location& from, const Location& target) const {
+  uint16_t region = GetRegion(from);
+  if (region == kNoRegion) {
+    return false;
+  }
+  if (GetRegion(target) == region) {
+    return true;
+  }
+
+  for (const auto& neighbor : GetNeighbors(target)) {
+    if (GetRegion(neighbor) == region) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::vector<uint16_t>& Regions::GetDistanceField(
+    const Location& source) {
+  size_t source_index = ToIndex(source);
+  auto cached = distance_fields_.find(source_index);
+  if (cached != distance_fields_.end()) {
+    return cached->second.distances_;
+  }
+
+  DistanceField field;
+  field.distances_.assign(labels_.size(), kUnreachable);
+  std::vector<Location> frontier;
+
+  // Points of interest such as doors and npcs can't be stood on, so the
+  // search starts from every accessible tile next to them instead.
+  std::vector<Location> seeds;
+  if (labels_[source_index] != kNoRegion) {
+    seeds.push_back(source);
+  } else {
+    seeds = GetNeighbors(source);
+  }
+
+  for (const auto& seed : seeds) {
+    uint16_t region = labels_[ToIndex(seed)];
+    if (region == kNoRegion) {
+      continue;
+    }
+    field.distances_[ToIndex(seed)] = 0;
+    frontier.push_back(seed);
+    if (std::find(field.regions_.begin(), field.regions_.end(), region)
+        == field.regions_.end()) {
+      field.regions_.push_back(region);
+    }
+  }
+
+  for (size_t next = 0; next < frontier.size(); next++) {
+    Location current = frontier[next];
+    uint16_t distance = field.distances_[ToIndex(current)];
+    for (const auto& neighbor : GetNeighbors(current)) {
+      size_t neighbor_index = ToIndex(neighbor);
+      if (labels_[neighbor_index] != kNoRegion
+          && field.distances_[neighbor_index] == kUnreachable) {
+        field.distances_[neighbor_index] =
+            static_cast<uint16_t>(distance + 1);
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+
+  return distance_fields_.emplace(source_index, std::move(field))
+      .first->second.distances_;
+}
+
+uint16_t Regions::GetDistance(const Location& source,
+                              const Location& location) {
+  if (!IsOnMap(location)) {
+    return kUnreachable;
+  }
+  return GetDistanceField(source)[ToIndex(location)];
+}
+
+bool Regions::HasDistanceField(const Location& source) const {
+  return IsOnMap(source) && distance_fields_.count(ToIndex(source)) != 0;
+}
+
+uint16_t Regions::GetCachedDistance(const Location& source,
+                                    const Location& location) const {
+  if (!IsOnMap(source) || !IsOnMap(location)) {
+    return kUnreachable;
+  }
+  auto cached = distance_fields_.find(ToIndex(source));
+  if (cached == distance_fields_.end()) {
+    return kUnreachable;
+  }
+  return cached->second.distances_[ToIndex(location)];
+}
+
+Location Regions::FindNearestAccessible(const Location& location) const {
+  if (!IsOnMap(location)) {
+    return location;
+  }
+
+  std::vector<bool> is_visited(labels_.size(), false);
+  std::vector<Location> frontier = {location};
+  is_visited[ToIndex(location)] = true;
+
+  for (size_t next = 0; next < frontier.size(); next++) {
+    Location current = frontier[next];
+    if (labels_[ToIndex(current)] != kNoRegion) {
+      return current;
+    }
+    for (const auto& neighbor : GetNeighbors(current)) {
+      if (!is_visited[ToIndex(neighbor)]) {
+        is_visited[ToIndex(neighbor)] = true;
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+
+  return location;
+}
+
+size_t Regions::GetNumRegions() const {
+  return region_sizes_.size() - 1 - free_regions_.size();
+}
+
+size_t Regions::GetNumBytes() const {
+  size_t num_bytes = labels_.capacity() * sizeof(uint16_t)
+                     + region_sizes_.capacity() * sizeof(size_t)
+                     + free_regions_.capacity() * sizeof(uint16_t)
+                     + distance_fields_.bucket_count() * sizeof(void*);
+  for (const auto& field : distance_fields_) {
+    num_bytes += sizeof(field) + sizeof(void*)
+                 + field.second.distances_.capacity() * sizeof(uint16_t)
+                 + field.second.regions_.capacity() * sizeof(uint16_t);
+  }
+  return num_bytes;
+}
+
+bool Regions::IsOnMap(const Location& location) const {
+  return location.GetRow() >= 0 && location.GetCol() >= 0
+      && static_cast<size_t>(location.GetRow()) < num_rows_
+      && static_cast<size_t>(location.GetCol()) < num_cols_;
+}
+
+std::vector<Location> Regions::GetNeighbors(const Location& location) const {
+  std::vector<Location> neighbors;
+  const Location deltas[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+  for (const auto& delta : deltas) {
+    Location neighbor = location + delta;
+    if (IsOnMap(neighbor)) {
+      neighbors.push_back(neighbor);
+    }
+  }
+  return neighbors;
+}
+
+uint16_t Regions::AllocateRegion() {
+  if (!free_regions_.empty()) {
+    uint16_t region = free_regions_.back();
+    free_regions_.pop_back();
+    return region;
+  }
+  region_sizes_.push_back(0);
+  return static_cast<uint16_t>(region_sizes_.size() - 1);
+}
+
+void Regions::ReleaseRegion(uint16_t region) {
+  free_regions_.push_back(region);
+}
+
+void Regions::FloodFill(const Map& map, const Location& start,
+                        uint16_t region) {
+  std::vector<Location> frontier = {start};
+  Relabel(ToIndex(start), region);
+
+  for (size_t next = 0; next < frontier.size(); next++) {
+    for (const auto& neighbor : GetNeighbors(frontier[next])) {
+      size_t neighbor_index = ToIndex(neighbor);
+      if (labels_[neighbor_index] != region
+          && map.IsAccessibleTile(neighbor)) {
+        Relabel(neighbor_index, region);
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+}
+
+void Regions::Relabel(size_t index, uint16_t region) {
+  if (labels_[index] != kNoRegion) {
+    region_sizes_[labels_[index]]--;
+  }
+  labels_[index] = region;
+  region_sizes_[region]++;
+}
+
+void Regions::InvalidateFields(const std::vector<uint16_t>& regions,
+                               const Location& location) {
+  for (auto field = distance_fields_.begin();
+       field != distance_fields_.end();) {
+    size_t source = field->first;
+    int source_row = static_cast<int>(source / num_cols_);
+    int source_col = static_cast<int>(source % num_cols_);
+    bool is_near_source =
+        std::abs(source_row - location.GetRow())
+        + std::abs(source_col - location.GetCol()) <= 1;
+    bool is_touched = std::any_of(
+        field->second.regions_.begin(), field->second.regions_.end(),
+        [&regions](uint16_t region) {
+          return std::find(regions.begin(), regions.end(), region)
+              != regions.end();
+        });
+
+    if (is_near_source || is_touched) {
+      field = distance_fields_.erase(field);
+    } else {
+      ++field;
+    }
+  }
+}
+
+}  // namespace island
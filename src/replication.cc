@@ -0,0 +1,750 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/replication.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/** The number of bits a direction takes. */
+const size_t kDirectionBits = 2;
+
+/** The number of bits a session state takes. */
+const size_t kStateBits = 3;
+
+/** The number of bits a tile takes. */
+const size_t kTileBits = 5;
+
+/** The groups of fields a frame may hold, one bit each. */
+enum FieldGroup {
+  kPlayerLocationGroup,
+  kFacingGroup,
+  kStateGroup,
+  kMoneyGroup,
+  kKeyGroup,
+  kInventoryGroup,
+  kNpcLocationsGroup,
+  kNpcFacingsGroup,
+  kTilesGroup,
+  kNumFieldGroups
+};
+
+/** The one step moves, in the order their 2 bit codes are given. */
+const int kStepRows[] = {-1, 1, 0, 0};
+const int kStepCols[] = {0, 0, -1, 1};
+
+/**
+ * Gets the number of bits needed for a number of values.
+ *
+ * @param num_values the number of values
+ * @return the number of bits to write the largest value
+ */
+size_t GetNumBits(size_t num_values) {
+  size_t num_bits = 0;
+  while ((size_t(1) << num_bits) < num_values) {
+    num_bits++;
+  }
+  return num_bits;
+}
+
+/** The sizes of a world's fields in a frame. */
+struct Layout {
+  /**
+   * Constructor which measures a world.
+   *
+   * @param world the world
+   */
+  explicit Layout(const World& world)
+      : num_rows_{world.tiles_->num_rows_},
+        num_cols_{world.tiles_->num_cols_},
+        row_bits_{GetNumBits(num_rows_)},
+        col_bits_{GetNumBits(num_cols_)},
+        num_items_{world.items_->size()},
+        item_bits_{GetNumBits(num_items_)} {}
+
+  /** The number of rows of the map. */
+  size_t num_rows_;
+
+  /** The number of columns of the map. */
+  size_t num_cols_;
+
+  /** The number of bits a row takes. */
+  size_t row_bits_;
+
+  /** The number of bits a column takes. */
+  size_t col_bits_;
+
+  /** The number of items in the world. */
+  size_t num_items_;
+
+  /** The number of bits an item's index takes. */
+  size_t item_bits_;
+};
+
+/** Appends values to a frame bit by bit. */
+class BitWriter {
+ public:
+  /**
+   * Constructor for a writer appending to an empty frame.
+   *
+   * @param bytes the frame
+   */
+  explicit BitWriter(std::vector<uint8_t>* bytes)
+      : bytes_{bytes},
+        num_bits_{0} {
+    bytes_->clear();
+  }
+
+  /**
+   * Appends the lowest bits of a value, lowest first.
+   *
+   * @param value the value
+   * @param num_bits the number of bits
+   */
+  void Write(uint64_t value, size_t num_bits) {
+    for (size_t bit = 0; bit < num_bits; bit++) {
+      if (num_bits_ % 8 == 0) {
+        bytes_->push_back(0);
+      }
+      bytes_->back() |= static_cast<uint8_t>((value >> bit & 1)
+                                             << (num_bits_ % 8));
+      num_bits_++;
+    }
+  }
+
+  /**
+   * Appends a value in as many 7 bit groups as it needs, each followed by
+   * a bit set if another group follows.
+   *
+   * @param value the value
+   */
+  void WriteVarint(uint64_t value) {
+    do {
+      Write(value & 0x7f, 7);
+      value >>= 7;
+      Write(value != 0 ? 1 : 0, 1);
+    } while (value != 0);
+  }
+
+ private:
+  /** The frame. */
+  std::vector<uint8_t>* bytes_;
+
+  /** The number of bits written. */
+  size_t num_bits_;
+};
+
+/** Reads values from a frame bit by bit, failing past its end. */
+class BitReader {
+ public:
+  /**
+   * Constructor for a reader at the start of a frame.
+   *
+   * @param data the first byte of the frame
+   * @param size the size of the frame, in bytes
+   */
+  BitReader(const uint8_t* data, size_t size)
+      : data_{data},
+        num_bits_{size * 8},
+        position_{0} {}
+
+  /**
+   * Reads a value written by BitWriter::Write.
+   *
+   * @param num_bits the number of bits
+   * @param value where to store the value
+   * @return false if the frame ends first
+   */
+  bool Read(size_t num_bits, uint64_t* value) {
+    if (num_bits > num_bits_ - position_) {
+      return false;
+    }
+    *value = 0;
+    for (size_t bit = 0; bit < num_bits; bit++, position_++) {
+      *value |= uint64_t(data_[position_ / 8] >> (position_ % 8) & 1) << bit;
+    }
+    return true;
+  }
+
+  /**
+   * Reads a value written by BitWriter::WriteVarint.
+   *
+   * @param value where to store the value
+   * @return false if the frame ends first or the value is too long
+   */
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+      uint64_t group;
+      uint64_t has_more;
+      if (!Read(7, &group) || !Read(1, &has_more)) {
+        return false;
+      }
+      *value |= group << shift;
+      if (!has_more) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  /** The frame. */
+  const uint8_t* data_;
+
+  /** The size of the frame, in bits. */
+  size_t num_bits_;
+
+  /** The number of bits read. */
+  size_t position_;
+};
+
+/**
+ * Gets the index of a location in the map's tiles.
+ *
+ * @param layout the sizes of the world
+ * @param location the location
+ * @return the index
+ */
+size_t GetIndex(const Layout& layout, const Location& location) {
+  return static_cast<size_t>(location.GetRow()) * layout.num_cols_
+         + static_cast<size_t>(location.GetCol());
+}
+
+/**
+ * Writes a location in full.
+ *
+ * @param layout the sizes of the world
+ * @param location the location
+ * @param writer the frame
+ */
+void WriteLocation(const Layout& layout, const Location& location,
+                   BitWriter* writer) {
+  writer->Write(static_cast<uint64_t>(location.GetRow()), layout.row_bits_);
+  writer->Write(static_cast<uint64_t>(location.GetCol()), layout.col_bits_);
+}
+
+/**
+ * Reads a location written in full, failing if it is off the map.
+ *
+ * @param layout the sizes of the world
+ * @param reader the frame
+ * @param location where to store the location
+ * @return false if the frame is damaged
+ */
+bool ReadLocation(const Layout& layout, BitReader* reader,
+                  Location* location) {
+  uint64_t row;
+  uint64_t col;
+  if (!reader->Read(layout.row_bits_, &row)
+      || !reader->Read(layout.col_bits_, &col)
+      || row >= layout.num_rows_ || col >= layout.num_cols_) {
+    return false;
+  }
+  *location = Location(static_cast<int>(row), static_cast<int>(col));
+  return true;
+}
+
+/**
+ * Writes where a character is, as a step from where they were when that
+ * is all they did, and in full otherwise.
+ *
+ * @param layout the sizes of the world
+ * @param base where the character was
+ * @param location where the character is
+ * @param writer the frame
+ */
+void WriteMove(const Layout& layout, const Location& base,
+               const Location& location, BitWriter* writer) {
+  for (uint64_t step = 0; step < 4; step++) {
+    if (location.GetRow() - base.GetRow() == kStepRows[step]
+        && location.GetCol() - base.GetCol() == kStepCols[step]) {
+      writer->Write(1, 1);
+      writer->Write(step, 2);
+      return;
+    }
+  }
+  writer->Write(0, 1);
+  WriteLocation(layout, location, writer);
+}
+
+/**
+ * Reads where a character is, written by WriteMove.
+ *
+ * @param layout the sizes of the world
+ * @param base where the character was
+ * @param reader the frame
+ * @param location where to store where the character is
+ * @return false if the frame is damaged
+ */
+bool ReadMove(const Layout& layout, const Location& base, BitReader* reader,
+              Location* location) {
+  uint64_t is_step;
+  if (!reader->Read(1, &is_step)) {
+    return false;
+  }
+  if (!is_step) {
+    return ReadLocation(layout, reader, location);
+  }
+  uint64_t step;
+  if (!reader->Read(2, &step)) {
+    return false;
+  }
+  const int row = base.GetRow() + kStepRows[step];
+  const int col = base.GetCol() + kStepCols[step];
+  if (row < 0 || col < 0 || static_cast<size_t>(row) >= layout.num_rows_
+      || static_cast<size_t>(col) >= layout.num_cols_) {
+    return false;
+  }
+  *location = Location(row, col);
+  return true;
+}
+
+/**
+ * Writes the tiles which changed between two states, in the order of
+ * their index, each with a bit set if it was overridden rather than reset.
+ *
+ * @param layout the sizes of the world
+ * @param base the tiles overridden in the earlier state
+ * @param overrides the tiles overridden in the later state
+ * @param writer the frame
+ */
+void WriteTiles(const Layout& layout, const std::vector<TileChange>& base,
+                const std::vector<TileChange>& overrides, BitWriter* writer) {
+  std::vector<std::pair<TileChange, bool>> changes;
+  auto old_tile = base.begin();
+  auto new_tile = overrides.begin();
+  while (old_tile != base.end() || new_tile != overrides.end()) {
+    const bool is_old_first = new_tile == overrides.end()
+        || (old_tile != base.end() && GetIndex(layout, old_tile->location_)
+                                      < GetIndex(layout, new_tile->location_));
+    if (is_old_first) {
+      changes.emplace_back(*old_tile++, false);
+    } else if (old_tile == base.end()
+               || GetIndex(layout, new_tile->location_)
+                  < GetIndex(layout, old_tile->location_)) {
+      changes.emplace_back(*new_tile++, true);
+    } else {
+      if (old_tile->tile_ != new_tile->tile_) {
+        changes.emplace_back(*new_tile, true);
+      }
+      ++old_tile;
+      ++new_tile;
+    }
+  }
+
+  writer->WriteVarint(changes.size());
+  for (const auto& change : changes) {
+    writer->Write(change.second ? 1 : 0, 1);
+    WriteLocation(layout, change.first.location_, writer);
+    if (change.second) {
+      writer->Write(static_cast<uint64_t>(change.first.tile_), kTileBits);
+    }
+  }
+}
+
+/**
+ * Reads the tiles written by WriteTiles and applies them.
+ *
+ * @param layout the sizes of the world
+ * @param base the tiles overridden in the earlier state
+ * @param reader the frame
+ * @param overrides where to store the tiles overridden in the later state
+ * @return false if the frame is damaged
+ */
+bool ReadTiles(const Layout& layout, const std::vector<TileChange>& base,
+               BitReader* reader, std::vector<TileChange>* overrides) {
+  uint64_t num_changes;
+  if (!reader->ReadVarint(&num_changes)
+      || num_changes > layout.num_rows_ * layout.num_cols_) {
+    return false;
+  }
+  overrides->clear();
+  auto old_tile = base.begin();
+  size_t next_index = 0;
+  for (uint64_t change = 0; change < num_changes; change++) {
+    uint64_t is_set;
+    Location location(0, 0);
+    if (!reader->Read(1, &is_set) || !ReadLocation(layout, reader, &location)
+        || GetIndex(layout, location) < next_index) {
+      return false;
+    }
+    const size_t index = GetIndex(layout, location);
+    next_index = index + 1;
+    while (old_tile != base.end()
+           && GetIndex(layout, old_tile->location_) < index) {
+      overrides->push_back(*old_tile++);
+    }
+    if (old_tile != base.end()
+        && GetIndex(layout, old_tile->location_) == index) {
+      ++old_tile;
+    }
+    if (is_set) {
+      uint64_t tile;
+      if (!reader->Read(kTileBits, &tile) || tile > kNpc) {
+        return false;
+      }
+      overrides->push_back({location, static_cast<Tile>(tile)});
+    }
+  }
+  overrides->insert(overrides->end(), old_tile, base.end());
+  return true;
+}
+
+/**
+ * Writes the difference between two states.
+ *
+ * @param layout the sizes of the world
+ * @param base the earlier state
+ * @param state the later state
+ * @param writer the frame
+ */
+void WriteDelta(const Layout& layout, const ReplicatedState& base,
+                const ReplicatedState& state, BitWriter* writer) {
+  bool is_changed[kNumFieldGroups];
+  is_changed[kPlayerLocationGroup] =
+      !(state.player_location_ == base.player_location_);
+  is_changed[kFacingGroup] = state.facing_ != base.facing_;
+  is_changed[kStateGroup] = state.state_ != base.state_;
+  is_changed[kMoneyGroup] = state.money_ != base.money_;
+  is_changed[kKeyGroup] = state.is_key_found_ != base.is_key_found_;
+  is_changed[kInventoryGroup] = state.inventory_ != base.inventory_;
+  is_changed[kNpcLocationsGroup] =
+      !std::equal(state.npc_locations_.begin(), state.npc_locations_.end(),
+                  base.npc_locations_.begin(), base.npc_locations_.end());
+  is_changed[kNpcFacingsGroup] = state.npc_facings_ != base.npc_facings_;
+  is_changed[kTilesGroup] = state.tile_overrides_.size()
+                            != base.tile_overrides_.size()
+      || !std::equal(state.tile_overrides_.begin(),
+                     state.tile_overrides_.end(),
+                     base.tile_overrides_.begin(),
+                     [](const TileChange& lhs, const TileChange& rhs) {
+        return lhs.location_ == rhs.location_ && lhs.tile_ == rhs.tile_;
+      });
+  for (bool is_group_changed : is_changed) {
+    writer->Write(is_group_changed ? 1 : 0, 1);
+  }
+
+  if (is_changed[kPlayerLocationGroup]) {
+    WriteMove(layout, base.player_location_, state.player_location_, writer);
+  }
+  if (is_changed[kFacingGroup]) {
+    writer->Write(static_cast<uint64_t>(state.facing_), kDirectionBits);
+  }
+  if (is_changed[kStateGroup]) {
+    writer->Write(static_cast<uint64_t>(state.state_), kStateBits);
+  }
+  if (is_changed[kMoneyGroup]) {
+    // The change is zigzag encoded, so small losses stay small too.
+    const int64_t change = static_cast<int64_t>(state.money_ - base.money_);
+    writer->WriteVarint(static_cast<uint64_t>(change) << 1
+                        ^ static_cast<uint64_t>(change >> 63));
+  }
+  if (is_changed[kKeyGroup]) {
+    writer->Write(state.is_key_found_ ? 1 : 0, 1);
+  }
+  if (is_changed[kInventoryGroup]) {
+    writer->WriteVarint(state.inventory_.size());
+    for (uint8_t item : state.inventory_) {
+      writer->Write(item, layout.item_bits_);
+    }
+  }
+  if (is_changed[kNpcLocationsGroup]) {
+    writer->WriteVarint(state.npc_locations_.size());
+    for (size_t npc = 0; npc < state.npc_locations_.size(); npc++) {
+      const bool is_known = npc < base.npc_locations_.size();
+      if (is_known && state.npc_locations_[npc] == base.npc_locations_[npc]) {
+        writer->Write(0, 1);
+        continue;
+      }
+      writer->Write(1, 1);
+      WriteMove(layout, is_known ? base.npc_locations_[npc] : Location(0, 0),
+                state.npc_locations_[npc], writer);
+    }
+  }
+  if (is_changed[kNpcFacingsGroup]) {
+    writer->WriteVarint(state.npc_facings_.size());
+    for (size_t npc = 0; npc < state.npc_facings_.size(); npc++) {
+      const bool is_known = npc < base.npc_facings_.size();
+      if (is_known && state.npc_facings_[npc] == base.npc_facings_[npc]) {
+        writer->Write(0, 1);
+        continue;
+      }
+      writer->Write(1, 1);
+      writer->Write(static_cast<uint64_t>(state.npc_facings_[npc]),
+                    kDirectionBits);
+    }
+  }
+  if (is_changed[kTilesGroup]) {
+    WriteTiles(layout, base.tile_overrides_, state.tile_overrides_, writer);
+  }
+}
+
+/**
+ * Reads the difference written by WriteDelta and applies it.
+ *
+ * @param layout the sizes of the world
+ * @param base the earlier state
+ * @param reader the frame
+ * @param state where to store the later state
+ * @return false if the frame is damaged
+ */
+bool ReadDelta(const Layout& layout, const ReplicatedState& base,
+               BitReader* reader, ReplicatedState* state) {
+  uint64_t is_changed[kNumFieldGroups];
+  for (uint64_t& is_group_changed : is_changed) {
+    if (!reader->Read(1, &is_group_changed)) {
+      return false;
+    }
+  }
+  *state = base;
+  uint64_t value;
+
+  if (is_changed[kPlayerLocationGroup]
+      && !ReadMove(layout, base.player_location_, reader,
+                   &state->player_location_)) {
+    return false;
+  }
+  if (is_changed[kFacingGroup]) {
+    if (!reader->Read(kDirectionBits, &value)) {
+      return false;
+    }
+    state->facing_ = static_cast<Direction>(value);
+  }
+  if (is_changed[kStateGroup]) {
+    if (!reader->Read(kStateBits, &value)
+        || value > static_cast<uint64_t>(SessionState::kBattle)) {
+      return false;
+    }
+    state->state_ = static_cast<SessionState>(value);
+  }
+  if (is_changed[kMoneyGroup]) {
+    if (!reader->ReadVarint(&value)) {
+      return false;
+    }
+    const uint64_t change = value >> 1 ^ (~(value & 1) + 1);
+    state->money_ = base.money_ + change;
+  }
+  if (is_changed[kKeyGroup]) {
+    if (!reader->Read(1, &value)) {
+      return false;
+    }
+    state->is_key_found_ = value != 0;
+  }
+  if (is_changed[kInventoryGroup]) {
+    uint64_t num_items;
+    if (!reader->ReadVarint(&num_items) || num_items > UINT16_MAX) {
+      return false;
+    }
+    state->inventory_.clear();
+    for (uint64_t item = 0; item < num_items; item++) {
+      if (!reader->Read(layout.item_bits_, &value)
+          || value >= layout.num_items_) {
+        return false;
+      }
+      state->inventory_.push_back(static_cast<uint8_t>(value));
+    }
+  }
+  if (is_changed[kNpcLocationsGroup]) {
+    uint64_t num_npcs;
+    if (!reader->ReadVarint(&num_npcs) || num_npcs > UINT16_MAX) {
+      return false;
+    }
+    state->npc_locations_.resize(static_cast<size_t>(num_npcs), {0, 0});
+    for (size_t npc = 0; npc < state->npc_locations_.size(); npc++) {
+      const bool is_known = npc < base.npc_locations_.size();
+      if (!reader->Read(1, &value)) {
+        return false;
+      }
+      if (value && !ReadMove(layout, is_known ? base.npc_locations_[npc]
+                                              : Location(0, 0),
+                             reader, &state->npc_locations_[npc])) {
+        return false;
+      }
+      if (!value && !is_known) {
+        return false;
+      }
+    }
+  }
+  if (is_changed[kNpcFacingsGroup]) {
+    uint64_t num_npcs;
+    if (!reader->ReadVarint(&num_npcs) || num_npcs > UINT16_MAX) {
+      return false;
+    }
+    state->npc_facings_.resize(static_cast<size_t>(num_npcs),
+                               Direction::kDown);
+    for (size_t npc = 0; npc < state->npc_facings_.size(); npc++) {
+      const bool is_known = npc < base.npc_facings_.size();
+      if (!reader->Read(1, &value) || (!value && !is_known)) {
+        return false;
+      }
+      if (value) {
+        if (!reader->Read(kDirectionBits, &value)) {
+          return false;
+        }
+        state->npc_facings_[npc] = static_cast<Direction>(value);
+      }
+    }
+  }
+  return !is_changed[kTilesGroup]
+         || ReadTiles(layout, base.tile_overrides_, reader,
+                      &state->tile_overrides_);
+}
+
+/**
+ * Determines whether one sequence number comes after another, allowing
+ * for them wrapping around.
+ *
+ * @param sequence the sequence number
+ * @param other the other sequence number
+ * @return true if the sequence number is the later one
+ */
+bool IsAfter(uint16_t sequence, uint16_t other) {
+  return static_cast<int16_t>(static_cast<uint16_t>(sequence - other)) > 0;
+}
+
+}  // namespace
+
+bool ReplicatedState::operator==(const ReplicatedState& rhs) const {
+  return player_location_ == rhs.player_location_ && facing_ == rhs.facing_
+         && state_ == rhs.state_ && money_ == rhs.money_
+         && is_key_found_ == rhs.is_key_found_ && inventory_ == rhs.inventory_
+         && std::equal(npc_locations_.begin(), npc_locations_.end(),
+                       rhs.npc_locations_.begin(), rhs.npc_locations_.end())
+         && npc_facings_ == rhs.npc_facings_
+         && tile_overrides_.size() == rhs.tile_overrides_.size()
+         && std::equal(tile_overrides_.begin(), tile_overrides_.end(),
+                       rhs.tile_overrides_.begin(),
+                       [](const TileChange& lhs, const TileChange& rhs) {
+           return lhs.location_ == rhs.location_ && lhs.tile_ == rhs.tile_;
+         });
+}
+
+ReplicatedState GetInitialState(const World& world) {
+  ReplicatedState state;
+  state.player_location_ = kStartLocation;
+  state.money_ = kStartMoney;
+  for (const Npc& npc : world.npcs_) {
+    state.npc_locations_.push_back(npc.location_);
+  }
+  state.npc_facings_ = world.npc_facings_;
+  return state;
+}
+
+ReplicatedState CaptureReplicatedState(const World& world,
+                                       const GameSession& session) {
+  const Engine& engine = session.GetEngine();
+  const Player& player = engine.GetPlayer();
+  ReplicatedState state;
+  state.player_location_ = player.location_;
+  state.facing_ = session.GetFacing();
+  state.state_ = session.GetState();
+  state.money_ = player.money_;
+  state.is_key_found_ = engine.GetKey();
+  for (const Item& item : player.inventory_) {
+    for (size_t index = 0; index < world.items_->size(); index++) {
+      if ((*world.items_)[index].name_ == item.name_) {
+        state.inventory_.push_back(static_cast<uint8_t>(index));
+        break;
+      }
+    }
+  }
+  state.npc_locations_ = engine.GetNpcStore().GetLocations();
+  state.npc_facings_ = session.GetNpcFacings();
+  state.tile_overrides_ = engine.GetTileOverrides();
+  return state;
+}
+
+ReplicationEncoder::ReplicationEncoder(std::shared_ptr<const World> world)
+    : world_{std::move(world)},
+      initial_state_{GetInitialState(*world_)},
+      snapshots_(kNumReplicationSnapshots),
+      next_sequence_{1},
+      acknowledged_sequence_{0},
+      is_acknowledged_{false} {}
+
+void ReplicationEncoder::Encode(const ReplicatedState& state,
+                                std::vector<uint8_t>* frame) {
+  const uint16_t sequence = next_sequence_++;
+  const ReplicatedState* base = &initial_state_;
+  uint16_t age = 0;
+  if (is_acknowledged_) {
+    const uint16_t distance =
+        static_cast<uint16_t>(sequence - acknowledged_sequence_);
+    const Snapshot& snapshot =
+        snapshots_[acknowledged_sequence_ % kNumReplicationSnapshots];
+    if (distance < kNumReplicationSnapshots && snapshot.is_sent_
+        && snapshot.sequence_ == acknowledged_sequence_) {
+      base = &snapshot.state_;
+      age = distance;
+    }
+  }
+
+  BitWriter writer(frame);
+  writer.Write(sequence, 16);
+  writer.Write(age, 8);
+  WriteDelta(Layout(*world_), *base, state, &writer);
+
+  Snapshot& snapshot = snapshots_[sequence % kNumReplicationSnapshots];
+  snapshot.sequence_ = sequence;
+  snapshot.is_sent_ = true;
+  snapshot.state_ = state;
+}
+
+void ReplicationEncoder::Acknowledge(uint16_t sequence) {
+  if (IsAfter(sequence, GetSequence())
+      || (is_acknowledged_ && !IsAfter(sequence, acknowledged_sequence_))) {
+    return;
+  }
+  acknowledged_sequence_ = sequence;
+  is_acknowledged_ = true;
+}
+
+ReplicationDecoder::ReplicationDecoder(std::shared_ptr<const World> world)
+    : world_{std::move(world)},
+      initial_state_{GetInitialState(*world_)},
+      snapshots_(kNumReplicationSnapshots),
+      sequence_{0},
+      is_decoded_{false} {}
+
+bool ReplicationDecoder::Decode(const uint8_t* data, size_t size,
+                                ReplicatedState* state) {
+  BitReader reader(data, size);
+  uint64_t sequence;
+  uint64_t age;
+  if (!reader.Read(16, &sequence) || !reader.Read(8, &age)
+      || age >= kNumReplicationSnapshots
+      || (is_decoded_
+          && !IsAfter(static_cast<uint16_t>(sequence), sequence_))) {
+    return false;
+  }
+
+  const ReplicatedState* base = &initial_state_;
+  if (age != 0) {
+    const uint16_t base_sequence = static_cast<uint16_t>(sequence - age);
+    const Snapshot& snapshot =
+        snapshots_[base_sequence % kNumReplicationSnapshots];
+    if (!snapshot.is_decoded_ || snapshot.sequence_ != base_sequence) {
+      return false;
+    }
+    base = &snapshot.state_;
+  }
+
+  ReplicatedState decoded;
+  if (!ReadDelta(Layout(*world_), *base, &reader, &decoded)) {
+    return false;
+  }
+  Snapshot& snapshot = snapshots_[sequence % kNumReplicationSnapshots];
+  snapshot.sequence_ = static_cast<uint16_t>(sequence);
+  snapshot.is_decoded_ = true;
+  snapshot.state_ = decoded;
+  sequence_ = static_cast<uint16_t>(sequence);
+  is_decoded_ = true;
+  *state = std::move(decoded);
+  return true;
+}
+
+}  // namespace island
@@ -0,0 +1,300 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/resource_pack.h>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/** The size of the header, in bytes. */
+const size_t kHeaderSize = 16;
+
+/** The size of one directory entry, in bytes. */
+const size_t kEntrySize = 32;
+
+/** The FNV-1a offset basis for 64 bit hashes. */
+const uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+
+/** The FNV-1a prime for 64 bit hashes. */
+const uint64_t kFnvPrime = 1099511628211ull;
+
+/**
+ * Appends a little endian word to a buffer.
+ *
+ * @param value the word to append
+ * @param num_bytes the size of the word, in bytes
+ * @param buffer the buffer to append to
+ */
+void AppendWord(uint64_t value, size_t num_bytes,
+                std::vector<uint8_t>* buffer) {
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    buffer->push_back(static_cast<uint8_t>(value >> (8 * byte)));
+  }
+}
+
+/**
+ * Reads a little endian word.
+ *
+ * @param data the first byte of the word
+ * @param num_bytes the size of the word, in bytes
+ * @return the word
+ */
+uint64_t ReadWord(const uint8_t* data, size_t num_bytes) {
+  uint64_t value = 0;
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    value |= uint64_t(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * Rounds an offset up to the pack's alignment.
+ *
+ * @param offset the offset to round
+ * @return the smallest aligned offset which is not less than offset
+ */
+size_t Align(size_t offset) {
+  return (offset + kResourcePackAlignment - 1) / kResourcePackAlignment
+         * kResourcePackAlignment;
+}
+
+}  // namespace
+
+AssetId GetAssetId(const std::string& name) {
+  return HashBytes(reinterpret_cast<const uint8_t*>(name.data()),
+                   name.size());
+}
+
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+  uint64_t hash = kFnvOffsetBasis;
+  for (size_t byte = 0; byte < size; byte++) {
+    hash ^= data[byte];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+void PremultiplyAlpha(std::vector<uint8_t>* pixels) {
+  for (size_t pixel = 0; pixel + 3 < pixels->size(); pixel += 4) {
+    const unsigned alpha = (*pixels)[pixel + 3];
+    for (size_t channel = pixel; channel < pixel + 3; channel++) {
+      // Rounds to the nearest value, so opaque pixels are left unchanged.
+      (*pixels)[channel] = static_cast<uint8_t>(
+          ((*pixels)[channel] * alpha + 127) / 255);
+    }
+  }
+}
+
+void ResourcePackWriter::Add(const std::string& name,
+                             std::vector<uint8_t> bytes) {
+  Add({name, GetAssetId(name), ResourceType::kRaw, std::move(bytes)});
+}
+
+void ResourcePackWriter::AddTexture(const std::string& name, size_t width,
+                                    size_t height,
+                                    std::vector<uint8_t> pixels) {
+  PremultiplyAlpha(&pixels);
+  std::vector<uint8_t> bytes;
+  bytes.reserve(kTextureHeaderSize + pixels.size());
+  AppendWord(width, 4, &bytes);
+  AppendWord(height, 4, &bytes);
+  bytes.resize(kTextureHeaderSize, 0);
+  bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+  Add({name, GetAssetId(name), ResourceType::kTexture, std::move(bytes)});
+}
+
+void ResourcePackWriter::Add(Resource resource) {
+  for (Resource& added : resources_) {
+    if (added.name_ == resource.name_) {
+      added = std::move(resource);
+      return;
+    }
+  }
+  resources_.push_back(std::move(resource));
+}
+
+bool ResourcePackWriter::Write(const std::string& path) const {
+  // The directory is sorted by id so the reader can binary search it.
+  std::vector<const Resource*> sorted;
+  for (const Resource& resource : resources_) {
+    sorted.push_back(&resource);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Resource* lhs, const Resource* rhs) {
+    return lhs->id_ < rhs->id_;
+  });
+  for (size_t resource = 1; resource < sorted.size(); resource++) {
+    if (sorted[resource]->id_ == sorted[resource - 1]->id_) {
+      return false;
+    }
+  }
+
+  std::vector<uint8_t> header;
+  AppendWord(kResourcePackMagic, 4, &header);
+  AppendWord(kResourcePackVersion, 4, &header);
+  AppendWord(sorted.size(), 4, &header);
+  AppendWord(0, 4, &header);
+
+  std::string names;
+  for (const Resource* resource : sorted) {
+    names += resource->name_;
+  }
+  size_t name_offset = 0;
+  size_t data_offset = Align(kHeaderSize + kEntrySize * sorted.size()
+                             + names.size());
+  const size_t first_data_offset = data_offset;
+  for (const Resource* resource : sorted) {
+    AppendWord(resource->id_, 8, &header);
+    AppendWord(data_offset, 8, &header);
+    AppendWord(resource->bytes_.size(), 8, &header);
+    AppendWord(name_offset, 4, &header);
+    AppendWord(resource->name_.size(), 2, &header);
+    AppendWord(static_cast<uint16_t>(resource->type_), 2, &header);
+    name_offset += resource->name_.size();
+    data_offset = Align(data_offset + resource->bytes_.size());
+  }
+  header.insert(header.end(), names.begin(), names.end());
+  header.resize(first_data_offset, 0);
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(header.data()),
+             static_cast<std::streamsize>(header.size()));
+  size_t offset = first_data_offset;
+  const char padding[kResourcePackAlignment] = {};
+  for (const Resource* resource : sorted) {
+    file.write(reinterpret_cast<const char*>(resource->bytes_.data()),
+               static_cast<std::streamsize>(resource->bytes_.size()));
+    offset += resource->bytes_.size();
+    file.write(padding, static_cast<std::streamsize>(Align(offset) - offset));
+    offset = Align(offset);
+  }
+  return static_cast<bool>(file);
+}
+
+ResourcePack::ResourcePack()
+    : num_resources_{0} {}
+
+bool ResourcePack::Open(const std::string& path) {
+  Close();
+  if (!file_.Open(path)) {
+    return false;
+  }
+
+  const uint8_t* data = file_.GetData();
+  const size_t size = file_.GetSize();
+  if (size < kHeaderSize || ReadWord(data, 4) != kResourcePackMagic
+      || ReadWord(data + 4, 4) != kResourcePackVersion) {
+    Close();
+    return false;
+  }
+  num_resources_ = ReadWord(data + 8, 4);
+
+  // Check every entry once, so Find can trust the directory.
+  const size_t names_offset = kHeaderSize + kEntrySize * num_resources_;
+  if (names_offset > size) {
+    Close();
+    return false;
+  }
+  for (size_t resource = 0; resource < num_resources_; resource++) {
+    const uint8_t* entry = data + kHeaderSize + kEntrySize * resource;
+    const uint64_t data_offset = ReadWord(entry + 8, 8);
+    const uint64_t data_size = ReadWord(entry + 16, 8);
+    const uint64_t name_end = names_offset + ReadWord(entry + 24, 4)
+                              + ReadWord(entry + 28, 2);
+    bool is_valid = name_end <= size && data_offset <= size
+                    && data_size <= size - data_offset
+                    && (resource == 0
+                        || ReadWord(entry - kEntrySize, 8)
+                           < ReadWord(entry, 8));
+    if (is_valid && ReadWord(entry + 30, 2)
+                    == static_cast<uint16_t>(ResourceType::kTexture)) {
+      is_valid = data_size >= kTextureHeaderSize
+                 && data_size - kTextureHeaderSize
+                    == ReadWord(data + data_offset, 4)
+                       * ReadWord(data + data_offset + 4, 4) * 4;
+    }
+    if (!is_valid) {
+      Close();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ResourcePack::Find(AssetId id, ResourceSpan* resource) const {
+  const size_t entry = FindEntry(id);
+  if (entry == 0) {
+    return false;
+  }
+  *resource = GetResource(entry);
+  return true;
+}
+
+bool ResourcePack::Find(const std::string& name,
+                        ResourceSpan* resource) const {
+  const size_t entry = FindEntry(GetAssetId(name));
+  if (entry == 0) {
+    return false;
+  }
+  const uint8_t* data = file_.GetData();
+  const size_t names_offset = kHeaderSize + kEntrySize * num_resources_;
+  const char* entry_name = reinterpret_cast<const char*>(
+      data + names_offset + ReadWord(data + entry + 24, 4));
+  if (name.compare(0, std::string::npos, entry_name,
+                   ReadWord(data + entry + 28, 2)) != 0) {
+    return false;
+  }
+  *resource = GetResource(entry);
+  return true;
+}
+
+bool ResourcePack::FindTexture(const std::string& name,
+                               TextureView* image) const {
+  ResourceSpan resource;
+  if (!Find(name, &resource) || resource.type_ != ResourceType::kTexture) {
+    return false;
+  }
+  image->width_ = ReadWord(resource.data_, 4);
+  image->height_ = ReadWord(resource.data_ + 4, 4);
+  image->pixels_ = resource.data_ + kTextureHeaderSize;
+  return true;
+}
+
+size_t ResourcePack::FindEntry(AssetId id) const {
+  const uint8_t* data = file_.GetData();
+  size_t first = 0;
+  size_t last = num_resources_;
+  while (first < last) {
+    const size_t middle = first + (last - first) / 2;
+    const size_t entry = kHeaderSize + kEntrySize * middle;
+    const AssetId entry_id = ReadWord(data + entry, 8);
+    if (id < entry_id) {
+      last = middle;
+    } else if (id > entry_id) {
+      first = middle + 1;
+    } else {
+      return entry;
+    }
+  }
+  return 0;
+}
+
+ResourceSpan ResourcePack::GetResource(size_t entry) const {
+  const uint8_t* data = file_.GetData() + entry;
+  ResourceSpan resource;
+  resource.data_ = file_.GetData() + ReadWord(data + 8, 8);
+  resource.size_ = ReadWord(data + 16, 8);
+  resource.type_ = static_cast<ResourceType>(ReadWord(data + 30, 2));
+  return resource;
+}
+
+void ResourcePack::Close() {
+  file_.Close();
+  num_resources_ = 0;
+}
+
+}  // namespace island
@@ -0,0 +1,409 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/resource_pack.h>
+#include <island/save_journal.h>
+#include <island/save_state.h>
+
+#include <iterator>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/** The size of the header, in bytes. */
+const size_t kHeaderSize = 16;
+
+/** The size of the start of each batch, in bytes. */
+const size_t kBatchHeaderSize = 16;
+
+/**
+ * Appends a little endian word to a buffer.
+ *
+ * @param value the word to append
+ * @param num_bytes the size of the word, in bytes
+ * @param buffer the buffer to append to
+ */
+void AppendWord(uint64_t value, size_t num_bytes,
+                std::vector<uint8_t>* buffer) {
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    buffer->push_back(static_cast<uint8_t>(value >> (8 * byte)));
+  }
+}
+
+/**
+ * Reads a little endian word.
+ *
+ * @param data the first byte of the word
+ * @param num_bytes the size of the word, in bytes
+ * @return the word
+ */
+uint64_t ReadWord(const uint8_t* data, size_t num_bytes) {
+  uint64_t value = 0;
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    value |= uint64_t(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * Appends a number using seven bits of each byte, the high bit set on
+ * every byte but the last, so small numbers take a single byte.
+ *
+ * @param value the number to append
+ * @param buffer the buffer to append to
+ */
+void AppendVarint(uint64_t value, std::vector<uint8_t>* buffer) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * Appends a length prefixed string.
+ *
+ * @param text the string to append
+ * @param buffer the buffer to append to
+ */
+void AppendString(const std::string& text, std::vector<uint8_t>* buffer) {
+  AppendVarint(text.size(), buffer);
+  buffer->insert(buffer->end(), text.begin(), text.end());
+}
+
+/**
+ * Appends a location, each coordinate zigzag encoded so a negative one
+ * still takes few bytes.
+ *
+ * @param location the location to append
+ * @param buffer the buffer to append to
+ */
+void AppendLocation(const Location& location, std::vector<uint8_t>* buffer) {
+  for (int coordinate : {location.GetRow(), location.GetCol()}) {
+    const int64_t value = coordinate;
+    AppendVarint(static_cast<uint64_t>((value << 1) ^ (value >> 63)), buffer);
+  }
+}
+
+/** Reads the fields of records from a batch, checking every length. */
+class RecordReader {
+ public:
+  /**
+   * Constructor for a reader at the start of a batch's records.
+   *
+   * @param data the first byte of the records
+   * @param size the size of the records, in bytes
+   */
+  RecordReader(const uint8_t* data, size_t size)
+      : data_{data}, end_{data + size}, is_valid_{true} {}
+
+  /**
+   * Reads a variable length number.
+   *
+   * @return the number, or 0 if the records end first
+   */
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+      if (data_ == end_) {
+        is_valid_ = false;
+        return 0;
+      }
+      const uint8_t byte = *data_++;
+      value |= uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    is_valid_ = false;
+    return 0;
+  }
+
+  /**
+   * Reads a length prefixed string.
+   *
+   * @return the string, or an empty one if the records end first
+   */
+  std::string ReadString() {
+    const uint64_t size = ReadVarint();
+    if (!is_valid_ || size > static_cast<uint64_t>(end_ - data_)) {
+      is_valid_ = false;
+      return "";
+    }
+    std::string text(reinterpret_cast<const char*>(data_),
+                     static_cast<size_t>(size));
+    data_ += size;
+    return text;
+  }
+
+  /**
+   * Reads a zigzag encoded location.
+   *
+   * @return the location
+   */
+  Location ReadLocation() {
+    int coordinates[2];
+    for (int& coordinate : coordinates) {
+      const uint64_t value = ReadVarint();
+      coordinate = static_cast<int>(static_cast<int64_t>(value >> 1)
+                                    ^ -static_cast<int64_t>(value & 1));
+    }
+    return {coordinates[0], coordinates[1]};
+  }
+
+  /**
+   * Determines whether every field so far was whole.
+   *
+   * @return true if nothing ran past the end of the records
+   */
+  inline bool IsValid() const {
+    return is_valid_;
+  }
+
+  /**
+   * Determines whether every record has been read.
+   *
+   * @return true if the reader is at the end of the records
+   */
+  inline bool IsDone() const {
+    return data_ == end_;
+  }
+
+ private:
+  /** The next byte to read. */
+  const uint8_t* data_;
+
+  /** One past the last byte of the records. */
+  const uint8_t* end_;
+
+  /** Determines whether every field so far was whole. */
+  bool is_valid_;
+};
+
+/**
+ * Appends one record.
+ *
+ * @param record the record to append
+ * @param buffer the buffer to append to
+ */
+void AppendRecord(const JournalRecord& record, std::vector<uint8_t>* buffer) {
+  buffer->push_back(static_cast<uint8_t>(record.op_));
+  switch (record.op_) {
+    case JournalOp::kAddInventoryItem:
+    case JournalOp::kAddItem:
+      AppendString(record.name_, buffer);
+      AppendString(record.description_, buffer);
+      AppendString(record.file_path_, buffer);
+      break;
+    case JournalOp::kRemoveInventoryItem:
+    case JournalOp::kRemoveItem:
+      AppendString(record.name_, buffer);
+      break;
+    case JournalOp::kSetTile:
+      AppendLocation(record.location_, buffer);
+      AppendVarint(record.value_, buffer);
+      break;
+    case JournalOp::kMovePlayer:
+      AppendLocation(record.location_, buffer);
+      break;
+    case JournalOp::kAddMoney:
+    case JournalOp::kRemoveMoney:
+    case JournalOp::kSetKey:
+    case JournalOp::kSetDirection:
+      AppendVarint(record.value_, buffer);
+      break;
+  }
+}
+
+/**
+ * Reads one record.
+ *
+ * @param reader the reader, at the start of the record
+ * @param record where to store the record
+ * @return true if the record is whole and of a known kind
+ */
+bool ReadRecord(RecordReader* reader, JournalRecord* record) {
+  const uint64_t op = reader->ReadVarint();
+  if (op > static_cast<uint64_t>(JournalOp::kSetDirection)) {
+    return false;
+  }
+  record->op_ = static_cast<JournalOp>(op);
+  switch (record->op_) {
+    case JournalOp::kAddInventoryItem:
+    case JournalOp::kAddItem:
+      record->name_ = reader->ReadString();
+      record->description_ = reader->ReadString();
+      record->file_path_ = reader->ReadString();
+      break;
+    case JournalOp::kRemoveInventoryItem:
+    case JournalOp::kRemoveItem:
+      record->name_ = reader->ReadString();
+      break;
+    case JournalOp::kSetTile:
+      record->location_ = reader->ReadLocation();
+      record->value_ = reader->ReadVarint();
+      break;
+    case JournalOp::kMovePlayer:
+      record->location_ = reader->ReadLocation();
+      break;
+    case JournalOp::kAddMoney:
+    case JournalOp::kRemoveMoney:
+    case JournalOp::kSetKey:
+    case JournalOp::kSetDirection:
+      record->value_ = reader->ReadVarint();
+      break;
+  }
+  return reader->IsValid();
+}
+
+/**
+ * Reads a whole file.
+ *
+ * @param path the path of the file
+ * @return its bytes, or none if it could not be read
+ */
+std::vector<uint8_t> ReadBytes(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+}
+
+/**
+ * Determines whether a journal starts with the header SaveJournal writes.
+ *
+ * @param bytes the journal
+ * @return true if the header is valid, false otherwise
+ */
+bool IsValidHeader(const std::vector<uint8_t>& bytes) {
+  return bytes.size() >= kHeaderSize
+         && ReadWord(bytes.data(), 4) == kSaveJournalMagic
+         && ReadWord(bytes.data() + 4, 4) == kSaveJournalVersion;
+}
+
+/**
+ * Reads every whole batch of a journal with a valid header, stopping at the
+ * first batch which was cut short or is damaged.
+ *
+ * @param bytes the journal
+ * @param records where to store the changes, oldest first
+ * @return the number of bytes up to the end of the last whole batch
+ */
+size_t ReadBatches(const std::vector<uint8_t>& bytes,
+                   std::vector<JournalRecord>* records) {
+  // A batch is only replayed whole, so a crash while appending loses the
+  // last batch instead of applying half of it.
+  size_t offset = kHeaderSize;
+  while (bytes.size() - offset >= kBatchHeaderSize) {
+    const uint8_t* batch = bytes.data() + offset;
+    const size_t size = ReadWord(batch, 4);
+    const size_t num_records = ReadWord(batch + 4, 4);
+    const uint8_t* payload = batch + kBatchHeaderSize;
+    if (size > bytes.size() - offset - kBatchHeaderSize || num_records > size
+        || HashBytes(payload, size) != ReadWord(batch + 8, 8)) {
+      break;
+    }
+
+    std::vector<JournalRecord> batch_records(num_records);
+    RecordReader reader(payload, size);
+    bool is_valid = true;
+    for (JournalRecord& record : batch_records) {
+      if (!ReadRecord(&reader, &record)) {
+        is_valid = false;
+        break;
+      }
+    }
+    if (!is_valid || !reader.IsDone()) {
+      break;
+    }
+    for (JournalRecord& record : batch_records) {
+      records->push_back(std::move(record));
+    }
+    offset += kBatchHeaderSize + size;
+  }
+  return offset;
+}
+
+}  // namespace
+
+std::string GetJournalPath(const std::string& save_path) {
+  return save_path + ".journal";
+}
+
+SaveJournal::SaveJournal(std::string path)
+    : path_{std::move(path)},
+      num_bytes_{0} {}
+
+bool SaveJournal::Start(uint64_t generation) {
+  file_.close();
+  std::vector<uint8_t> header;
+  AppendWord(kSaveJournalMagic, 4, &header);
+  AppendWord(kSaveJournalVersion, 4, &header);
+  AppendWord(generation, 8, &header);
+  if (!WriteFileAtomically(path_, std::string(header.begin(),
+                                              header.end()))) {
+    return false;
+  }
+
+  file_.clear();
+  file_.open(path_, std::ios::binary | std::ios::app);
+  num_bytes_ = header.size();
+  return static_cast<bool>(file_);
+}
+
+bool SaveJournal::Resume(uint64_t generation) {
+  const std::vector<uint8_t> bytes = ReadBytes(path_);
+  if (!IsValidHeader(bytes) || ReadWord(bytes.data() + 8, 8) != generation) {
+    return Start(generation);
+  }
+
+  // Batches appended after a cut short one would never be read, so the
+  // journal is cut back to its last whole batch first.
+  std::vector<JournalRecord> records;
+  const size_t num_bytes = ReadBatches(bytes, &records);
+  file_.close();
+  if (num_bytes < bytes.size()
+      && !WriteFileAtomically(path_, std::string(bytes.begin(),
+                                                 bytes.begin() + num_bytes))) {
+    return false;
+  }
+
+  file_.clear();
+  file_.open(path_, std::ios::binary | std::ios::app);
+  num_bytes_ = num_bytes;
+  return static_cast<bool>(file_);
+}
+
+bool SaveJournal::Append(const std::vector<JournalRecord>& records) {
+  if (!file_.is_open()) {
+    return false;
+  }
+  std::vector<uint8_t> payload;
+  for (const JournalRecord& record : records) {
+    AppendRecord(record, &payload);
+  }
+
+  std::vector<uint8_t> batch;
+  AppendWord(payload.size(), 4, &batch);
+  AppendWord(records.size(), 4, &batch);
+  AppendWord(HashBytes(payload.data(), payload.size()), 8, &batch);
+  batch.insert(batch.end(), payload.begin(), payload.end());
+  file_.write(reinterpret_cast<const char*>(batch.data()),
+              static_cast<std::streamsize>(batch.size()));
+  file_.flush();
+  num_bytes_ += batch.size();
+  return static_cast<bool>(file_);
+}
+
+bool ReadSaveJournal(const std::string& path, uint64_t* generation,
+                     std::vector<JournalRecord>* records) {
+  const std::vector<uint8_t> bytes = ReadBytes(path);
+  if (!IsValidHeader(bytes)) {
+    return false;
+  }
+  *generation = ReadWord(bytes.data() + 8, 8);
+  ReadBatches(bytes, records);
+  return true;
+}
+
+}  // namespace island
@@ -0,0 +1,288 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/resource_pack.h>
+#include <island/save_slots.h>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace island {
+
+namespace {
+
+/** The size of every slot's header, in bytes. */
+const size_t kSlotHeaderSize = 128;
+
+/** The size of the index's own header, in bytes. */
+const size_t kIndexHeaderSize = 16;
+
+/** The size of the player's name in a slot's header, in bytes. */
+const size_t kNameSize = kMaxSlotNameLength + 1;
+
+/** The flag of a slot's header set when the key has been found. */
+const uint32_t kKeyFoundFlag = 1;
+
+/** The name of the index file in the slots' directory. */
+const char kIndexFileName[] = "slots.index";
+
+/**
+ * Appends a little endian word to a buffer.
+ *
+ * @param value the word to append
+ * @param num_bytes the size of the word, in bytes
+ * @param buffer the buffer to append to
+ */
+void AppendWord(uint64_t value, size_t num_bytes,
+                std::vector<uint8_t>* buffer) {
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    buffer->push_back(static_cast<uint8_t>(value >> (8 * byte)));
+  }
+}
+
+/**
+ * Reads a little endian word.
+ *
+ * @param data the first byte of the word
+ * @param num_bytes the size of the word, in bytes
+ * @return the word
+ */
+uint64_t ReadWord(const uint8_t* data, size_t num_bytes) {
+  uint64_t value = 0;
+  for (size_t byte = 0; byte < num_bytes; byte++) {
+    value |= uint64_t(data[byte]) << (8 * byte);
+  }
+  return value;
+}
+
+/**
+ * Appends the fixed layout of a slot's header.
+ *
+ * @param header the header
+ * @param buffer the buffer to append to
+ */
+void AppendHeader(const SaveSlotHeader& header, std::vector<uint8_t>* buffer) {
+  const size_t start = buffer->size();
+  AppendWord(kSaveSlotMagic, 4, buffer);
+  AppendWord(kSaveSlotVersion, 4, buffer);
+  AppendWord(header.slot_, 4, buffer);
+  AppendWord(header.is_key_found_ ? kKeyFoundFlag : 0, 4, buffer);
+  buffer->insert(buffer->end(), header.player_name_.begin(),
+                 header.player_name_.end());
+  buffer->resize(start + 16 + kNameSize, 0);
+  AppendWord(header.player_money_, 8, buffer);
+  AppendWord(header.playtime_seconds_, 8, buffer);
+  AppendWord(header.timestamp_, 8, buffer);
+  AppendWord(header.thumbnail_offset_, 8, buffer);
+  AppendWord(header.thumbnail_size_, 8, buffer);
+  AppendWord(header.body_offset_, 8, buffer);
+  AppendWord(header.body_size_, 8, buffer);
+  AppendWord(header.body_hash_, 8, buffer);
+  buffer->resize(start + kSlotHeaderSize, 0);
+}
+
+/**
+ * Reads the fixed layout of a slot's header.
+ *
+ * @param data the first byte of the header, with kSlotHeaderSize bytes
+ * @param header where to store the header
+ * @return true if the header has the right magic number and version
+ */
+bool ParseHeader(const uint8_t* data, SaveSlotHeader* header) {
+  if (ReadWord(data, 4) != kSaveSlotMagic
+      || ReadWord(data + 4, 4) != kSaveSlotVersion) {
+    return false;
+  }
+  header->slot_ = ReadWord(data + 8, 4);
+  header->is_key_found_ = (ReadWord(data + 12, 4) & kKeyFoundFlag) != 0;
+  const char* name = reinterpret_cast<const char*>(data + 16);
+  header->player_name_.assign(name, std::find(name, name + kNameSize, '\0'));
+  const uint8_t* words = data + 16 + kNameSize;
+  header->player_money_ = ReadWord(words, 8);
+  header->playtime_seconds_ = ReadWord(words + 8, 8);
+  header->timestamp_ = ReadWord(words + 16, 8);
+  header->thumbnail_offset_ = ReadWord(words + 24, 8);
+  header->thumbnail_size_ = ReadWord(words + 32, 8);
+  header->body_offset_ = ReadWord(words + 40, 8);
+  header->body_size_ = ReadWord(words + 48, 8);
+  header->body_hash_ = ReadWord(words + 56, 8);
+  return header->slot_ < kNumSaveSlots;
+}
+
+/**
+ * Reads part of a file.
+ *
+ * @param file the file
+ * @param offset where the part starts
+ * @param size the size of the part, in bytes
+ * @param bytes where to store the part
+ * @return true if the whole part was read, false if the file is shorter
+ */
+bool ReadRange(std::ifstream* file, uint64_t offset, uint64_t size,
+               std::vector<uint8_t>* bytes) {
+  file->seekg(0, std::ios::end);
+  const std::streamoff file_size = file->tellg();
+  if (!*file || offset > static_cast<uint64_t>(file_size)
+      || size > static_cast<uint64_t>(file_size) - offset) {
+    return false;
+  }
+  bytes->resize(static_cast<size_t>(size));
+  file->seekg(static_cast<std::streamoff>(offset));
+  file->read(reinterpret_cast<char*>(bytes->data()),
+             static_cast<std::streamsize>(size));
+  return static_cast<bool>(*file);
+}
+
+}  // namespace
+
+SaveSlots::SaveSlots(std::string directory)
+    : directory_{std::move(directory)} {}
+
+bool SaveSlots::Open() {
+  slots_.clear();
+  std::ifstream index(directory_ + "/" + kIndexFileName, std::ios::binary);
+  std::vector<uint8_t> bytes(kIndexHeaderSize);
+  index.read(reinterpret_cast<char*>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  const size_t num_slots = static_cast<size_t>(ReadWord(bytes.data() + 8, 4));
+  bool is_valid = index && ReadWord(bytes.data(), 4) == kSaveSlotIndexMagic
+                  && ReadWord(bytes.data() + 4, 4) == kSaveSlotVersion
+                  && num_slots <= kNumSaveSlots;
+  if (is_valid) {
+    bytes.resize(num_slots * kSlotHeaderSize);
+    index.read(reinterpret_cast<char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    is_valid = static_cast<bool>(index);
+  }
+  for (size_t slot = 0; is_valid && slot < num_slots; slot++) {
+    SaveSlotHeader header;
+    is_valid = ParseHeader(bytes.data() + slot * kSlotHeaderSize, &header)
+               && (slots_.empty() || slots_.back().slot_ < header.slot_);
+    slots_.push_back(std::move(header));
+  }
+  if (is_valid) {
+    return true;
+  }
+
+  // Every slot's file starts with its header, so the index can be rebuilt
+  // by reading the first bytes of each.
+  slots_.clear();
+  for (size_t slot = 0; slot < kNumSaveSlots; slot++) {
+    SaveSlotHeader header;
+    if (ReadHeader(slot, &header)) {
+      slots_.push_back(std::move(header));
+    }
+  }
+  WriteIndex();
+  return false;
+}
+
+bool SaveSlots::Write(size_t slot, const SaveState& state,
+                      uint64_t playtime_seconds, uint64_t timestamp,
+                      const std::vector<uint8_t>& thumbnail) {
+  if (slot >= kNumSaveSlots) {
+    return false;
+  }
+  SaveState body_state = state;
+  // A slot is a save of its own, which no autosave journal follows.
+  body_state.journal_generation_ = 0;
+  const std::string body = SerializeSave(body_state);
+
+  SaveSlotHeader header;
+  header.slot_ = slot;
+  header.player_name_ = state.player_name_.substr(0, kMaxSlotNameLength);
+  header.player_money_ = state.player_money_;
+  header.playtime_seconds_ = playtime_seconds;
+  header.is_key_found_ = state.is_key_found_;
+  header.timestamp_ = timestamp;
+  header.body_offset_ = kSlotHeaderSize;
+  header.body_size_ = body.size();
+  header.body_hash_ = HashBytes(reinterpret_cast<const uint8_t*>(body.data()),
+                                body.size());
+  if (!thumbnail.empty()) {
+    header.thumbnail_offset_ = kSlotHeaderSize + body.size();
+    header.thumbnail_size_ = thumbnail.size();
+  }
+
+  std::vector<uint8_t> bytes;
+  AppendHeader(header, &bytes);
+  std::string contents(bytes.begin(), bytes.end());
+  contents += body;
+  contents.append(thumbnail.begin(), thumbnail.end());
+  if (!WriteFileAtomically(GetSlotPath(slot), contents)) {
+    return false;
+  }
+
+  auto position = std::lower_bound(slots_.begin(), slots_.end(), slot,
+                                   [](const SaveSlotHeader& lhs, size_t rhs) {
+    return lhs.slot_ < rhs;
+  });
+  if (position != slots_.end() && position->slot_ == slot) {
+    *position = std::move(header);
+  } else {
+    slots_.insert(position, std::move(header));
+  }
+  return WriteIndex();
+}
+
+bool SaveSlots::Load(size_t slot, SaveState* state,
+                     SaveSlotHeader* header) const {
+  std::ifstream file(GetSlotPath(slot), std::ios::binary);
+  std::vector<uint8_t> bytes;
+  SaveSlotHeader slot_header;
+  if (!ReadRange(&file, 0, kSlotHeaderSize, &bytes)
+      || !ParseHeader(bytes.data(), &slot_header) || slot_header.slot_ != slot
+      || !ReadRange(&file, slot_header.body_offset_, slot_header.body_size_,
+                    &bytes)
+      || HashBytes(bytes.data(), bytes.size()) != slot_header.body_hash_
+      || !ParseSave(std::string(bytes.begin(), bytes.end()), state)) {
+    return false;
+  }
+  if (header) {
+    *header = std::move(slot_header);
+  }
+  return true;
+}
+
+bool SaveSlots::LoadThumbnail(size_t slot,
+                              std::vector<uint8_t>* thumbnail) const {
+  std::ifstream file(GetSlotPath(slot), std::ios::binary);
+  std::vector<uint8_t> bytes;
+  SaveSlotHeader header;
+  if (!ReadRange(&file, 0, kSlotHeaderSize, &bytes)
+      || !ParseHeader(bytes.data(), &header)) {
+    return false;
+  }
+  if (header.thumbnail_size_ == 0) {
+    thumbnail->clear();
+    return true;
+  }
+  return ReadRange(&file, header.thumbnail_offset_, header.thumbnail_size_,
+                   thumbnail);
+}
+
+std::string SaveSlots::GetSlotPath(size_t slot) const {
+  return directory_ + "/slot_" + std::to_string(slot) + ".save";
+}
+
+bool SaveSlots::ReadHeader(size_t slot, SaveSlotHeader* header) const {
+  std::ifstream file(GetSlotPath(slot), std::ios::binary);
+  std::vector<uint8_t> bytes;
+  return ReadRange(&file, 0, kSlotHeaderSize, &bytes)
+         && ParseHeader(bytes.data(), header) && header->slot_ == slot;
+}
+
+bool SaveSlots::WriteIndex() const {
+  std::vector<uint8_t> bytes;
+  AppendWord(kSaveSlotIndexMagic, 4, &bytes);
+  AppendWord(kSaveSlotVersion, 4, &bytes);
+  AppendWord(slots_.size(), 4, &bytes);
+  AppendWord(0, 4, &bytes);
+  for (const SaveSlotHeader& header : slots_) {
+    AppendHeader(header, &bytes);
+  }
+  return WriteFileAtomically(directory_ + "/" + kIndexFileName,
+                             std::string(bytes.begin(), bytes.end()));
+}
+
+}  // namespace island
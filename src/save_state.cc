@@ -0,0 +1,245 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <nlohmann/json.hpp>
+
+#include <island/save_state.h>
+
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace island {
+
+using nlohmann::json;
+
+namespace {
+
+/**
+ * Converts a list of items to JSON.
+ *
+ * @param items the items, or nullptr for none
+ * @return a JSON array with one object per item
+ */
+json ItemsToJson(const std::shared_ptr<const std::vector<Item>>& items) {
+  json json_items = json::array();
+  if (!items) {
+    return json_items;
+  }
+  for (const Item& item : *items) {
+    json_items.push_back({{"name", item.name_},
+                          {"description", item.description_},
+                          {"file_path", item.file_path_}});
+  }
+  return json_items;
+}
+
+/**
+ * Reads one item from JSON.
+ *
+ * @param item the JSON object of the item
+ * @param items where to add the item
+ * @return true if the item has a name, a description and a file path
+ */
+bool ItemFromJson(const json& item, std::vector<Item>* items) {
+  if (!item.is_object() || !item.contains("name")
+      || !item["name"].is_string() || !item.contains("description")
+      || !item["description"].is_string() || !item.contains("file_path")
+      || !item["file_path"].is_string()) {
+    return false;
+  }
+  items->emplace_back(item["name"].get<std::string>(),
+                      item["description"].get<std::string>(),
+                      item["file_path"].get<std::string>());
+  return true;
+}
+
+/**
+ * Reads a list of items from JSON. Save files written before items were
+ * saved as arrays hold a single item object instead.
+ *
+ * @param json_items the JSON array of items, or a single item
+ * @param items where to store the items
+ * @return true if every item has a name, a description and a file path
+ */
+bool ItemsFromJson(const json& json_items, std::vector<Item>* items) {
+  if (json_items.is_object()) {
+    return ItemFromJson(json_items, items);
+  }
+  if (!json_items.is_array()) {
+    return json_items.is_null();
+  }
+  for (const json& item : json_items) {
+    if (!ItemFromJson(item, items)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Determines whether a JSON object has an unsigned number in a field.
+ *
+ * @param object the object
+ * @param key the name of the field
+ * @return true if the field is a number no less than zero
+ */
+bool HasNumber(const json& object, const char* key) {
+  return object.is_object() && object.contains(key)
+         && object[key].is_number_unsigned();
+}
+
+/**
+ * Determines whether a JSON object has an integer in a field.
+ *
+ * @param object the object
+ * @param key the name of the field
+ * @return true if the field is a whole number
+ */
+bool HasInteger(const json& object, const char* key) {
+  return object.is_object() && object.contains(key)
+         && object[key].is_number_integer();
+}
+
+/**
+ * Reads the tiles which differ from the island's own from JSON.
+ *
+ * @param json_tiles the JSON array of tiles, each one its row, column and
+ * tile
+ * @param height the number of rows of the saved map
+ * @param width the number of columns of the saved map
+ * @param tiles where to store the tiles
+ * @return true if every tile is valid and on the map
+ */
+bool TilesFromJson(const json& json_tiles, size_t height, size_t width,
+                   std::vector<TileChange>* tiles) {
+  if (!json_tiles.is_array()) {
+    return false;
+  }
+  for (const json& tile : json_tiles) {
+    if (!tile.is_array() || tile.size() != 3 || !tile[0].is_number_integer()
+        || !tile[1].is_number_integer() || !tile[2].is_number_unsigned()
+        || tile[2].get<int>() > kNpc || tile[0].get<int>() < 0
+        || tile[1].get<int>() < 0
+        || tile[0].get<size_t>() >= height || tile[1].get<size_t>() >= width) {
+      return false;
+    }
+    tiles->push_back({Location(tile[0].get<int>(), tile[1].get<int>()),
+                      static_cast<Tile>(tile[2].get<int>())});
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string SerializeSave(const SaveState& state) {
+  json game_engine;
+  game_engine["width"] = state.width_;
+  game_engine["height"] = state.height_;
+  game_engine["is_key_found"] = state.is_key_found_;
+  game_engine["direction"] = static_cast<int>(state.direction_);
+  game_engine["player"]["name"] = state.player_name_;
+  game_engine["player"]["location"]["row"] = state.player_location_.GetRow();
+  game_engine["player"]["location"]["col"] = state.player_location_.GetCol();
+  game_engine["player"]["statistics"]["hp"] =
+      state.player_statistics_.hit_points_;
+  game_engine["player"]["statistics"]["atk"] =
+      state.player_statistics_.attack_;
+  game_engine["player"]["statistics"]["def"] =
+      state.player_statistics_.defense_;
+  game_engine["player"]["statistics"]["spe"] = state.player_statistics_.speed_;
+  game_engine["player"]["money"] = state.player_money_;
+  game_engine["items"] = ItemsToJson(state.items_);
+  game_engine["inventory_items"] = ItemsToJson(state.inventory_);
+  game_engine["journal_generation"] = state.journal_generation_;
+  // Only the tiles changed while playing are saved; the rest are the
+  // island's own.
+  game_engine["tiles"] = json::array();
+  for (const TileChange& change : state.tile_overrides_) {
+    game_engine["tiles"].push_back({change.location_.GetRow(),
+                                    change.location_.GetCol(),
+                                    static_cast<int>(change.tile_)});
+  }
+  return game_engine.dump();
+}
+
+bool ParseSave(const std::string& text, SaveState* state) {
+  const json game_engine = json::parse(text, nullptr, false);
+  if (game_engine.is_discarded() || !HasNumber(game_engine, "width")
+      || !HasNumber(game_engine, "height")
+      || !game_engine.contains("is_key_found")
+      || !game_engine["is_key_found"].is_boolean()
+      || !game_engine.contains("player")) {
+    return false;
+  }
+  const json& player = game_engine["player"];
+  if (!player.contains("name") || !player["name"].is_string()
+      || !player.contains("location") || !player.contains("statistics")
+      || !HasInteger(player["location"], "row")
+      || !HasInteger(player["location"], "col")
+      || !HasNumber(player["statistics"], "hp")
+      || !HasNumber(player["statistics"], "atk")
+      || !HasNumber(player["statistics"], "def")
+      || !HasNumber(player["statistics"], "spe")
+      || !HasNumber(player, "money")) {
+    return false;
+  }
+
+  std::vector<Item> items;
+  std::vector<Item> inventory;
+  std::vector<TileChange> tiles;
+  if ((game_engine.contains("items")
+       && !ItemsFromJson(game_engine["items"], &items))
+      || (game_engine.contains("inventory_items")
+          && !ItemsFromJson(game_engine["inventory_items"], &inventory))
+      || (game_engine.contains("tiles")
+          && !TilesFromJson(game_engine["tiles"], game_engine["height"],
+                            game_engine["width"], &tiles))) {
+    return false;
+  }
+
+  state->width_ = game_engine["width"];
+  state->height_ = game_engine["height"];
+  state->is_key_found_ = game_engine["is_key_found"];
+  if (HasNumber(game_engine, "direction")
+      && game_engine["direction"] <= static_cast<int>(Direction::kRight)) {
+    state->direction_ = static_cast<Direction>(
+        game_engine["direction"].get<int>());
+  }
+  state->player_name_ = player["name"];
+  state->player_location_ = {player["location"]["row"].get<int>(),
+                             player["location"]["col"].get<int>()};
+  state->player_statistics_.hit_points_ = player["statistics"]["hp"];
+  state->player_statistics_.attack_ = player["statistics"]["atk"];
+  state->player_statistics_.defense_ = player["statistics"]["def"];
+  state->player_statistics_.speed_ = player["statistics"]["spe"];
+  state->player_money_ = player["money"];
+  state->items_ = std::make_shared<const std::vector<Item>>(std::move(items));
+  state->inventory_ = std::make_shared<const std::vector<Item>>(
+      std::move(inventory));
+  state->tile_overrides_ = std::move(tiles);
+  state->journal_generation_ = HasNumber(game_engine, "journal_generation")
+      ? game_engine["journal_generation"].get<uint64_t>() : 0;
+  return true;
+}
+
+bool WriteFileAtomically(const std::string& path,
+                         const std::string& contents) {
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary);
+    file.write(contents.data(),
+               static_cast<std::streamsize>(contents.size()));
+    file.flush();
+    if (!file) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+#ifdef _WIN32
+  // Renaming does not replace an existing file on Windows.
+  std::remove(path.c_str());
+#endif
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace island
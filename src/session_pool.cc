@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/session_pool.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace island {
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+SessionPool::SessionPool(std::shared_ptr<const World> world,
+                         size_t num_workers, size_t sessions_per_job)
+    : world_{std::move(world)},
+      sessions_per_job_{std::max<size_t>(sessions_per_job, 1)},
+      job_system_{num_workers},
+      next_id_{1},
+      num_ticks_{0},
+      tick_time_{0} {}
+
+SessionId SessionPool::Create(const std::string& player_name) {
+  // Ids are not reused, so an old id never reaches a new player's game.
+  const SessionId id = next_id_++;
+  indices_[id] = entries_.size();
+  entries_.emplace_back(new Entry(id, world_, player_name));
+  return id;
+}
+
+bool SessionPool::Remove(SessionId id) {
+  auto index = indices_.find(id);
+  if (index == indices_.end()) {
+    return false;
+  }
+  // The last session moves into the gap, keeping the sessions packed.
+  std::swap(entries_[index->second], entries_.back());
+  indices_[entries_[index->second]->id_] = index->second;
+  entries_.pop_back();
+  indices_.erase(id);
+  return true;
+}
+
+bool SessionPool::PushAction(SessionId id, PlayerAction action) {
+  auto index = indices_.find(id);
+  if (index == indices_.end()) {
+    return false;
+  }
+  entries_[index->second]->actions_.push_back(action);
+  return true;
+}
+
+void SessionPool::Tick() {
+  const auto start = steady_clock::now();
+  for (size_t first = 0; first < entries_.size();
+       first += sessions_per_job_) {
+    const size_t last = std::min(first + sessions_per_job_, entries_.size());
+    job_system_.Submit("sessions", [this, first, last] {
+      for (size_t index = first; index < last; index++) {
+        Entry& entry = *entries_[index];
+        const auto session_start = steady_clock::now();
+        for (PlayerAction action : entry.actions_) {
+          entry.session_.HandleAction(action);
+        }
+        entry.actions_.clear();
+        entry.session_.Step();
+        entry.latency_ = duration_cast<nanoseconds>(
+            steady_clock::now() - session_start);
+      }
+    });
+  }
+  job_system_.Wait();
+  num_ticks_++;
+  tick_time_ = duration_cast<nanoseconds>(steady_clock::now() - start);
+}
+
+const GameSession* SessionPool::Find(SessionId id) const {
+  auto index = indices_.find(id);
+  if (index == indices_.end()) {
+    return nullptr;
+  }
+  return &entries_[index->second]->session_;
+}
+
+SessionStats SessionPool::GetStats() const {
+  SessionStats stats = {entries_.size(), 0, 0, num_ticks_, tick_time_,
+                        nanoseconds(0), nanoseconds(0), nanoseconds(0)};
+  std::vector<nanoseconds> latencies;
+  latencies.reserve(entries_.size());
+  for (const std::unique_ptr<Entry>& entry : entries_) {
+    const size_t num_bytes = sizeof(Entry)
+        + entry->actions_.capacity() * sizeof(PlayerAction)
+        + entry->session_.GetNumBytes() - sizeof(GameSession);
+    stats.num_bytes_ += num_bytes;
+    stats.max_session_bytes_ = std::max(stats.max_session_bytes_, num_bytes);
+    latencies.push_back(entry->latency_);
+  }
+  if (latencies.empty()) {
+    return stats;
+  }
+
+  auto median = latencies.begin() + latencies.size() / 2;
+  std::nth_element(latencies.begin(), median, latencies.end());
+  stats.median_latency_ = *median;
+  auto p99 = latencies.begin() + latencies.size() * 99 / 100;
+  std::nth_element(latencies.begin(), p99, latencies.end());
+  stats.p99_latency_ = *p99;
+  stats.max_latency_ = *std::max_element(latencies.begin(), latencies.end());
+  return stats;
+}
+
+}  // namespace island
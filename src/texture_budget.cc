@@ -0,0 +1,115 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/texture_budget.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace island {
+
+namespace {
+
+/** The number of bytes in a kilobyte. */
+const size_t kBytesPerKilobyte = 1024;
+
+}  // namespace
+
+std::string GetCategoryName(TextureCategory category) {
+  switch (category) {
+    case TextureCategory::kMap:
+      return "map";
+    case TextureCategory::kSprites:
+      return "sprites";
+    case TextureCategory::kBattle:
+      return "battle";
+    case TextureCategory::kUi:
+      return "ui";
+    case TextureCategory::kText:
+      return "text";
+  }
+  return "";
+}
+
+TextureBudget::TextureBudget(size_t budget)
+    : budget_{budget},
+      num_bytes_{0},
+      peak_bytes_{0},
+      num_evictions_{0},
+      frame_{0},
+      category_bytes_() {}
+
+void TextureBudget::BeginFrame() {
+  frame_++;
+}
+
+std::vector<std::string> TextureBudget::Add(const std::string& name,
+                                            TextureCategory category,
+                                            size_t num_bytes,
+                                            bool is_pinned) {
+  Remove(name);
+  entries_.push_front({name, category, num_bytes, is_pinned, frame_});
+  index_[name] = entries_.begin();
+  num_bytes_ += num_bytes;
+  category_bytes_[static_cast<size_t>(category)] += num_bytes;
+  peak_bytes_ = std::max(peak_bytes_, num_bytes_);
+  return Evict();
+}
+
+void TextureBudget::Touch(const std::string& name) {
+  auto entry = index_.find(name);
+  if (entry == index_.end()) {
+    return;
+  }
+  entry->second->last_frame_ = frame_;
+  entries_.splice(entries_.begin(), entries_, entry->second);
+}
+
+void TextureBudget::Remove(const std::string& name) {
+  auto entry = index_.find(name);
+  if (entry != index_.end()) {
+    Erase(entry->second);
+  }
+}
+
+std::vector<std::string> TextureBudget::SetBudget(size_t budget) {
+  budget_ = budget;
+  return Evict();
+}
+
+std::string TextureBudget::GetReport() const {
+  std::ostringstream report;
+  report << "texture memory: " << num_bytes_ / kBytesPerKilobyte << " of "
+         << budget_ / kBytesPerKilobyte << " KB in " << index_.size()
+         << " textures, peak " << peak_bytes_ / kBytesPerKilobyte << " KB, "
+         << num_evictions_ << " evicted";
+  for (size_t category = 0; category < kNumTextureCategories; category++) {
+    report << "\n  "
+           << GetCategoryName(static_cast<TextureCategory>(category)) << ": "
+           << category_bytes_[category] / kBytesPerKilobyte << " KB";
+  }
+  return report.str();
+}
+
+std::vector<std::string> TextureBudget::Evict() {
+  std::vector<std::string> evicted;
+  auto entry = entries_.end();
+  while (num_bytes_ > budget_ && entry != entries_.begin()) {
+    --entry;
+    if (entry->is_pinned_ || entry->last_frame_ == frame_) {
+      continue;
+    }
+    evicted.push_back(entry->name_);
+    num_evictions_++;
+    Erase(entry++);
+  }
+  return evicted;
+}
+
+void TextureBudget::Erase(std::list<Entry>::iterator entry) {
+  num_bytes_ -= entry->num_bytes_;
+  category_bytes_[static_cast<size_t>(entry->category_)] -= entry->num_bytes_;
+  index_.erase(entry->name_);
+  entries_.erase(entry);
+}
+
+}  // namespace island
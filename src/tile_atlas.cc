@@ -0,0 +1,116 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/tile_atlas.h>
+
+#include <cstring>
+#include <unordered_map>
+
+namespace island {
+
+TileAtlas::TileAtlas(const std::vector<uint8_t>& pixels, size_t width,
+                     size_t height, size_t tile_size)
+    : num_rows_{width / tile_size},
+      num_cols_{height / tile_size},
+      tile_size_{tile_size},
+      cells_per_line_{1},
+      num_cells_{0} {
+  // Lay the cells out in a square that would fit every tile being distinct,
+  // and only add lines to the image as cells are used.
+  size_t num_tiles = num_rows_ * num_cols_;
+  while (cells_per_line_ * cells_per_line_ < num_tiles) {
+    cells_per_line_++;
+  }
+  cells_.assign(num_tiles, 0);
+
+  std::unordered_multimap<uint64_t, uint32_t> cells_by_hash;
+  for (size_t row = 0; row < num_rows_; row++) {
+    for (size_t col = 0; col < num_cols_; col++) {
+      size_t x = row * tile_size_;
+      size_t y = col * tile_size_;
+      uint64_t hash = HashTile(pixels, width, x, y);
+
+      bool is_found = false;
+      auto range = cells_by_hash.equal_range(hash);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (IsSameTile(pixels, width, x, y, it->second)) {
+          cells_[row * num_cols_ + col] = it->second;
+          is_found = true;
+          break;
+        }
+      }
+
+      if (!is_found) {
+        uint32_t cell = static_cast<uint32_t>(num_cells_++);
+        CopyTile(pixels, width, x, y, cell);
+        cells_by_hash.emplace(hash, cell);
+        cells_[row * num_cols_ + col] = cell;
+      }
+    }
+  }
+}
+
+uint32_t TileAtlas::GetCell(const Location& location) const {
+  return cells_[static_cast<size_t>(location.GetRow()) * num_cols_ +
+                static_cast<size_t>(location.GetCol())];
+}
+
+void TileAtlas::SetCell(const Location& location, uint32_t cell) {
+  cells_[static_cast<size_t>(location.GetRow()) * num_cols_ +
+         static_cast<size_t>(location.GetCol())] = cell;
+}
+
+Location TileAtlas::GetCellOrigin(uint32_t cell) const {
+  return {static_cast<int>(cell % cells_per_line_ * tile_size_),
+          static_cast<int>(cell / cells_per_line_ * tile_size_)};
+}
+
+uint64_t TileAtlas::HashTile(const std::vector<uint8_t>& pixels, size_t width,
+                             size_t x, size_t y) const {
+  // FNV-1a over the tile's rows.
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t line = y; line < y + tile_size_; line++) {
+    const uint8_t* begin = &pixels[(line * width + x) * kBytesPerPixel];
+    for (size_t byte = 0; byte < tile_size_ * kBytesPerPixel; byte++) {
+      hash = (hash ^ begin[byte]) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+bool TileAtlas::IsSameTile(const std::vector<uint8_t>& pixels, size_t width,
+                           size_t x, size_t y, uint32_t cell) const {
+  Location origin = GetCellOrigin(cell);
+  size_t line_bytes = tile_size_ * kBytesPerPixel;
+  for (size_t line = 0; line < tile_size_; line++) {
+    const uint8_t* tile = &pixels[((y + line) * width + x) * kBytesPerPixel];
+    const uint8_t* atlas = &pixels_[
+        ((static_cast<size_t>(origin.GetCol()) + line) * GetWidth()
+         + static_cast<size_t>(origin.GetRow())) * kBytesPerPixel];
+    if (std::memcmp(tile, atlas, line_bytes) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TileAtlas::CopyTile(const std::vector<uint8_t>& pixels, size_t width,
+                         size_t x, size_t y, uint32_t cell) {
+  size_t line_bytes = tile_size_ * kBytesPerPixel;
+  size_t num_lines = cell / cells_per_line_ + 1;
+  size_t size = num_lines * tile_size_ * GetWidth() * kBytesPerPixel;
+  if (pixels_.size() < size) {
+    pixels_.resize(size, 0);
+  }
+
+  Location origin = GetCellOrigin(cell);
+  for (size_t line = 0; line < tile_size_; line++) {
+    std::memcpy(&pixels_[((static_cast<size_t>(origin.GetCol()) + line)
+                          * GetWidth()
+                          + static_cast<size_t>(origin.GetRow()))
+                         * kBytesPerPixel],
+                &pixels[((y + line) * width + x) * kBytesPerPixel],
+                line_bytes);
+  }
+}
+
+}  // namespace island
@@ -0,0 +1,143 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/tile_pyramid.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace island {
+
+const size_t TilePyramid::kBandHeight;
+
+TilePyramid::TilePyramid(const TileAtlas& atlas) {
+  Level level;
+  level.width_ = atlas.GetNumRows() * atlas.GetTileSize();
+  level.height_ = atlas.GetNumCols() * atlas.GetTileSize();
+  level.pixels_.assign(level.width_ * level.height_ * kBytesPerPixel, 0);
+  levels_.push_back(level);
+
+  // Every level rounds up, so the odd pixel at an edge is not lost.
+  while (levels_.back().width_ > 1 || levels_.back().height_ > 1) {
+    Level next;
+    next.width_ = (levels_.back().width_ + 1) / 2;
+    next.height_ = (levels_.back().height_ + 1) / 2;
+    next.pixels_.assign(next.width_ * next.height_ * kBytesPerPixel, 0);
+    levels_.push_back(next);
+  }
+
+  for (size_t row = 0; row < atlas.GetNumRows(); row++) {
+    for (size_t col = 0; col < atlas.GetNumCols(); col++) {
+      CopyTile(atlas, {static_cast<int>(row), static_cast<int>(col)});
+    }
+  }
+}
+
+void TilePyramid::Build(JobSystem* job_system) {
+  if (job_system == nullptr) {
+    for (size_t level = 1; level < levels_.size(); level++) {
+      Downsample(level, 0, 0, levels_[level].width_, levels_[level].height_);
+    }
+    return;
+  }
+
+  // The bands of a level only read the level before, so each level waits
+  // for every band of the previous one.
+  std::vector<JobId> previous_bands;
+  for (size_t level = 1; level < levels_.size(); level++) {
+    std::vector<JobId> bands;
+    const size_t width = levels_[level].width_;
+    const size_t height = levels_[level].height_;
+    for (size_t first_y = 0; first_y < height; first_y += kBandHeight) {
+      size_t last_y = std::min(first_y + kBandHeight, height);
+      bands.push_back(job_system->Submit(
+          "pyramid_level_" + std::to_string(level),
+          [this, level, first_y, last_y, width] {
+            Downsample(level, 0, first_y, width, last_y);
+          },
+          previous_bands));
+    }
+    previous_bands = bands;
+  }
+  job_system->Wait();
+}
+
+void TilePyramid::UpdateTile(const TileAtlas& atlas,
+                             const Location& location) {
+  CopyTile(atlas, location);
+
+  size_t first_x = static_cast<size_t>(location.GetRow())
+                   * atlas.GetTileSize();
+  size_t first_y = static_cast<size_t>(location.GetCol())
+                   * atlas.GetTileSize();
+  size_t last_x = first_x + atlas.GetTileSize();
+  size_t last_y = first_y + atlas.GetTileSize();
+  for (size_t level = 1; level < levels_.size(); level++) {
+    first_x /= 2;
+    first_y /= 2;
+    last_x = (last_x + 1) / 2;
+    last_y = (last_y + 1) / 2;
+    Downsample(level, first_x, first_y, last_x, last_y);
+  }
+}
+
+size_t TilePyramid::GetLevelForZoom(double zoom) const {
+  size_t level = 0;
+  double scale = 1.0;
+  while (level + 1 < levels_.size() && zoom <= scale / 2.0) {
+    scale /= 2.0;
+    level++;
+  }
+  return level;
+}
+
+void TilePyramid::CopyTile(const TileAtlas& atlas, const Location& location) {
+  const size_t tile_size = atlas.GetTileSize();
+  const size_t line_bytes = tile_size * kBytesPerPixel;
+  Location origin = atlas.GetCellOrigin(atlas.GetCell(location));
+  size_t x = static_cast<size_t>(location.GetRow()) * tile_size;
+  size_t y = static_cast<size_t>(location.GetCol()) * tile_size;
+  Level& base = levels_.front();
+
+  for (size_t line = 0; line < tile_size; line++) {
+    std::memcpy(&base.pixels_[((y + line) * base.width_ + x)
+                              * kBytesPerPixel],
+                &atlas.GetPixels()[((static_cast<size_t>(origin.GetCol())
+                                     + line) * atlas.GetWidth()
+                                    + static_cast<size_t>(origin.GetRow()))
+                                   * kBytesPerPixel],
+                line_bytes);
+  }
+}
+
+void TilePyramid::Downsample(size_t level, size_t first_x, size_t first_y,
+                             size_t last_x, size_t last_y) {
+  const Level& source = levels_[level - 1];
+  Level& target = levels_[level];
+  last_x = std::min(last_x, target.width_);
+  last_y = std::min(last_y, target.height_);
+
+  for (size_t y = first_y; y < last_y; y++) {
+    // Odd sized levels reuse their last line or column at the edge.
+    size_t top = std::min(2 * y, source.height_ - 1);
+    size_t bottom = std::min(2 * y + 1, source.height_ - 1);
+    for (size_t x = first_x; x < last_x; x++) {
+      size_t left = std::min(2 * x, source.width_ - 1);
+      size_t right = std::min(2 * x + 1, source.width_ - 1);
+      const uint8_t* samples[] = {
+          &source.pixels_[(top * source.width_ + left) * kBytesPerPixel],
+          &source.pixels_[(top * source.width_ + right) * kBytesPerPixel],
+          &source.pixels_[(bottom * source.width_ + left) * kBytesPerPixel],
+          &source.pixels_[(bottom * source.width_ + right) * kBytesPerPixel]};
+
+      uint8_t* out = &target.pixels_[(y * target.width_ + x) * kBytesPerPixel];
+      for (size_t channel = 0; channel < kBytesPerPixel; channel++) {
+        unsigned sum = samples[0][channel] + samples[1][channel]
+                       + samples[2][channel] + samples[3][channel];
+        out[channel] = static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+}  // namespace island
@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <island/world.h>
+
+#include <utility>
+
+namespace island {
+
+World::World(std::shared_ptr<const MapTiles> tiles, std::vector<Npc> npcs,
+             std::vector<Direction> npc_facings, std::vector<Item> items)
+    : tiles_{std::move(tiles)},
+      npcs_{std::move(npcs)},
+      npc_facings_{std::move(npc_facings)},
+      items_{std::make_shared<const std::vector<Item>>(std::move(items))} {
+  const Map map(tiles_);
+  for (size_t row = 0; row < map.GetNumRows(); row++) {
+    for (size_t col = 0; col < map.GetNumCols(); col++) {
+      Location location(static_cast<int>(row), static_cast<int>(col));
+      if (map.GetTile(location) == kDoor) {
+        door_locations_.push_back(location);
+      }
+    }
+  }
+
+  // Every game asks for these fields, so they are only computed once.
+  std::shared_ptr<Regions> regions = std::make_shared<Regions>(map);
+  regions->GetDistanceField(kIslandKeyLocation);
+  for (const auto& door : door_locations_) {
+    regions->GetDistanceField(door);
+  }
+  regions_ = std::move(regions);
+}
+
+std::vector<Npc> GetIslandNpcs() {
+  return {
+      Npc("Rosalyn", {15, 2}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("John", {20, 1}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("Rod", {16, 48}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("Klutz", {28, 20}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("Azura", {38, 10}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("Boi", {36, 36}, Statistics(10, 10, 10, 10), false, 0),
+      Npc("Sven", {25, 20}, Statistics(7, 7, 7, 7), true, 500),
+      Npc("Elf", {26, 20}, Statistics(11, 11, 11, 11), true, 1000)};
+}
+
+std::vector<Direction> GetIslandNpcFacings() {
+  return {Direction::kUp, Direction::kDown, Direction::kUp, Direction::kRight,
+          Direction::kLeft, Direction::kUp, Direction::kUp, Direction::kUp};
+}
+
+std::vector<Item> GetIslandItems() {
+  std::vector<Item> items;
+  items.emplace_back("shoe",
+                     "Footwear that helps you outspeed others in battle.",
+                     "assets/shoe.png");
+  items.emplace_back("sword",
+                     "A legendary sword, it is said that it "
+                     "grants the user amazing attack power.",
+                     "assets/sword.png");
+  items.emplace_back("shield",
+                     "Armour that increases your defensive prowess,"
+                     " helping you take hits better in battle.",
+                     "assets/shield.png");
+  items.emplace_back("heart",
+                     "An extra heart, it will help strengthen "
+                     "your life force in battle.",
+                     "assets/heart.png");
+  items.emplace_back("key",
+                     "Looks like a key to someone's house",
+                     "assets/key.png");
+  return items;
+}
+
+std::shared_ptr<const World> LoadIslandWorld(const std::string& tileset_path) {
+  return std::make_shared<const World>(Map::LoadTiles(tileset_path),
+                                       GetIslandNpcs(), GetIslandNpcFacings(),
+                                       GetIslandItems());
+}
+
+}  // namespace island
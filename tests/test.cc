@@ -2,11 +2,48 @@
 
 #define CATCH_CONFIG_MAIN
 
+#include <island/audio_mixer.h>
+#include <island/autosaver.h>
+#include <island/battle_prefetch.h>
+#include <island/bot.h>
+#include <island/camera.h>
+#include <island/command_buffer.h>
 #include <island/engine.h>
+#include <island/entity_store.h>
+#include <island/flow_field.h>
+#include <island/frame_encoder.h>
+#include <island/game_session.h>
+#include <island/job_system.h>
+#include <island/key_actions.h>
 #include <island/location.h>
+#include <island/map.h>
+#include <island/regions.h>
+#include <island/pcm_cache.h>
+#include <island/pcm_ring.h>
+#include <island/replication.h>
+#include <island/resource_pack.h>
+#include <island/save_journal.h>
+#include <island/save_slots.h>
+#include <island/save_state.h>
+#include <island/session_pool.h>
+#include <island/spsc_queue.h>
+#include <island/texture_budget.h>
+#include <island/tile_atlas.h>
+#include <island/tile_pyramid.h>
+#include <island/triple_buffer.h>
+#include <island/world.h>
 
 #include <catch2/catch.hpp>
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
 TEST_CASE("Location addition overload test", "[location]") {
   island::Location first_location(10, 20);
   island::Location second_location(5, 10);
@@ -23,4 +60,1141 @@ TEST_CASE("Location mod overload test", "[location]") {
 
   REQUIRE(location.GetRow() == 2);
   REQUIRE(location.GetCol() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Regions label separated areas", "[regions]") {
+  island::Map map({{island::kGrass, island::kWater, island::kGrass},
+                   {island::kGrass, island::kWater, island::kGrass},
+                   {island::kGrass, island::kWater, island::kGrass}});
+  island::Regions regions(map);
+
+  REQUIRE(regions.GetNumRegions() == 2);
+  REQUIRE(regions.IsSameRegion({0, 0}, {2, 0}));
+  REQUIRE_FALSE(regions.IsSameRegion({0, 0}, {0, 2}));
+  REQUIRE(regions.GetRegion({1, 1}) == island::kNoRegion);
+  REQUIRE(regions.CanReach({0, 0}, {1, 1}));
+}
+
+TEST_CASE("Regions merge and split on tile changes", "[regions]") {
+  island::Map map({{island::kGrass, island::kWater, island::kGrass},
+                   {island::kGrass, island::kWater, island::kGrass},
+                   {island::kGrass, island::kWater, island::kGrass}});
+  island::Regions regions(map);
+
+  map.SetTile({1, 1}, island::kRoad);
+  regions.Update(map, {1, 1});
+  REQUIRE(regions.GetNumRegions() == 1);
+  REQUIRE(regions.IsSameRegion({0, 0}, {2, 2}));
+
+  map.SetTile({1, 1}, island::kTree);
+  regions.Update(map, {1, 1});
+  REQUIRE(regions.GetNumRegions() == 2);
+  REQUIRE_FALSE(regions.IsSameRegion({0, 0}, {2, 2}));
+}
+
+TEST_CASE("Regions distance fields are cached and invalidated",
+          "[regions]") {
+  island::Map map({{island::kGrass, island::kGrass, island::kGrass},
+                   {island::kWater, island::kWater, island::kGrass},
+                   {island::kGrass, island::kGrass, island::kGrass}});
+  island::Regions regions(map);
+
+  REQUIRE(regions.GetDistance({1, 0}, {2, 2}) == 2);
+  REQUIRE(regions.GetDistance({1, 0}, {0, 2}) == 2);
+  REQUIRE(regions.GetNumDistanceFields() == 1);
+
+  map.SetTile({1, 2}, island::kWater);
+  regions.Update(map, {1, 2});
+  REQUIRE(regions.GetNumDistanceFields() == 0);
+  REQUIRE(regions.GetDistance({0, 0}, {2, 2}) == island::kUnreachable);
+  REQUIRE(regions.FindNearestAccessible({1, 1}).GetRow() != 1);
+}
+
+TEST_CASE("Flow field leads characters around obstacles", "[flow_field]") {
+  island::Map map({{island::kGrass, island::kGrass, island::kGrass},
+                   {island::kWater, island::kWater, island::kGrass},
+                   {island::kGrass, island::kGrass, island::kGrass}});
+  island::FlowField field(map);
+  field.SetTarget({2, 0});
+  field.Rebuild(map);
+
+  REQUIRE(field.GetDistance({0, 0}) == 6);
+  std::vector<island::Location> chasers = {{0, 0}, {2, 2}};
+  field.StepAll(&chasers);
+  REQUIRE(chasers[0] == island::Location(0, 1));
+  REQUIRE(chasers[1] == island::Location(2, 1));
+
+  field.StepAll(&chasers);
+  REQUIRE(chasers[1] == island::Location(2, 1));
+}
+
+TEST_CASE("Flow field keeps the old field while building", "[flow_field]") {
+  island::Map map({{island::kGrass, island::kGrass, island::kGrass}});
+  island::FlowField field(map);
+  field.SetTarget({0, 0});
+  field.Rebuild(map);
+
+  field.SetTarget({0, 2});
+  REQUIRE_FALSE(field.Advance(map, 1));
+  REQUIRE(field.GetTarget() == island::Location(0, 0));
+  REQUIRE(field.Advance(map, 10));
+  REQUIRE(field.GetTarget() == island::Location(0, 2));
+  REQUIRE(field.GetDistance({0, 0}) == 2);
+}
+
+TEST_CASE("Entity store keeps columns packed on destroy", "[entity_store]") {
+  island::EntityStore store;
+  island::EntityHandle sven = store.Create(
+      island::Npc("Sven", {25, 20}, {7, 7, 7, 7}, true, 500));
+  island::EntityHandle elf = store.Create(
+      island::Npc("Elf", {26, 20}, {11, 11, 11, 11}, true, 1000));
+
+  REQUIRE(store.Destroy(sven));
+  REQUIRE(store.GetSize() == 1);
+  REQUIRE(store.IsAlive(elf));
+  REQUIRE(store.GetNames()[store.GetDenseIndex(elf)] == "Elf");
+  REQUIRE(store.GetMoney()[store.GetDenseIndex(elf)] == 1000);
+  REQUIRE(store.FindAtLocation({26, 20}) == 0);
+}
+
+TEST_CASE("Entity store handles go stale after reuse", "[entity_store]") {
+  island::EntityStore store;
+  island::EntityHandle first = store.Create(
+      island::Npc("Rod", {16, 48}, {10, 10, 10, 10}, false, 0));
+  store.Destroy(first);
+  island::EntityHandle second = store.Create(
+      island::Npc("Boi", {36, 36}, {10, 10, 10, 10}, false, 0));
+
+  REQUIRE(second.index_ == first.index_);
+  REQUIRE_FALSE(store.IsAlive(first));
+  REQUIRE_FALSE(store.Destroy(first));
+  REQUIRE(store.GetNpc(store.GetDenseIndex(second)).name_ == "Boi");
+}
+
+TEST_CASE("Deterministic job system respects dependencies", "[job_system]") {
+  island::JobSystem job_system(0);
+  std::vector<std::string> order;
+  island::JobId first = job_system.Submit("first", [&order] {
+    order.emplace_back("first");
+  });
+  job_system.Submit("second", [&order] {
+    order.emplace_back("second");
+  }, {first});
+  job_system.Submit("third", [&order] {
+    order.emplace_back("third");
+  });
+  job_system.Wait();
+
+  REQUIRE(job_system.IsDeterministic());
+  REQUIRE(order == std::vector<std::string>({"first", "third", "second"}));
+  REQUIRE(job_system.GetTimings().size() == 3);
+  REQUIRE(job_system.GetTimings()[1].name_ == "second");
+}
+
+TEST_CASE("Job system runs every job on its workers", "[job_system]") {
+  island::JobSystem job_system(4);
+  std::atomic<size_t> sum(0);
+  std::vector<island::JobId> parts;
+  for (size_t part = 1; part <= 100; part++) {
+    parts.push_back(job_system.Submit("part", [&sum, part] {
+      sum += part;
+    }));
+  }
+  size_t total = 0;
+  job_system.Submit("total", [&sum, &total] {
+    total = sum;
+  }, parts);
+  job_system.Wait();
+
+  REQUIRE(total == 5050);
+  REQUIRE(job_system.GetTimings().size() == 101);
+}
+
+TEST_CASE("Triple buffer hands over the newest value", "[triple_buffer]") {
+  island::TripleBuffer<int> buffer;
+  REQUIRE_FALSE(buffer.Update());
+
+  buffer.GetBack() = 1;
+  buffer.Publish();
+  buffer.GetBack() = 2;
+  buffer.Publish();
+
+  REQUIRE(buffer.Update());
+  REQUIRE(buffer.GetFront() == 2);
+  REQUIRE_FALSE(buffer.Update());
+  REQUIRE(buffer.GetFront() == 2);
+}
+
+TEST_CASE("Spsc queue keeps order and refuses when full", "[spsc_queue]") {
+  island::SpscQueue<int, 2> queue;
+  REQUIRE(queue.Push(1));
+  REQUIRE(queue.Push(2));
+  REQUIRE_FALSE(queue.Push(3));
+
+  int value = 0;
+  REQUIRE(queue.Pop(&value));
+  REQUIRE(value == 1);
+  REQUIRE(queue.Pop(&value));
+  REQUIRE(value == 2);
+  REQUIRE_FALSE(queue.Pop(&value));
+}
+
+TEST_CASE("Camera follows the player and stays on the map", "[camera]") {
+  island::Camera camera(50, 50, 40);
+  camera.SetViewSize(800, 800);
+
+  camera.Follow({25, 30});
+  REQUIRE(camera.GetLocation() == island::Location(15, 20));
+  island::TileRect visible = camera.GetVisibleTiles();
+  REQUIRE(visible.num_rows_ == 20);
+  REQUIRE(visible.num_cols_ == 20);
+  REQUIRE(visible.Contains({34, 39}));
+  REQUIRE_FALSE(visible.Contains({35, 20}));
+
+  camera.Follow({49, 0});
+  REQUIRE(camera.GetLocation() == island::Location(30, 0));
+
+  camera.SetViewSize(810, 800);
+  REQUIRE(camera.GetVisibleTiles().num_rows_ == 20);
+}
+
+TEST_CASE("Tile atlas stores repeated tiles once", "[tile_atlas]") {
+  // A 3x2 tile map of 2x2 pixel tiles, where only the middle row differs.
+  const size_t width = 6;
+  const size_t height = 4;
+  std::vector<uint8_t> pixels(width * height * island::kBytesPerPixel, 7);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 2; x < 4; x++) {
+      pixels[(y * width + x) * island::kBytesPerPixel] = 200;
+    }
+  }
+  pixels[(3 * width + 3) * island::kBytesPerPixel + 1] = 9;
+
+  island::TileAtlas atlas(pixels, width, height, 2);
+  REQUIRE(atlas.GetNumRows() == 3);
+  REQUIRE(atlas.GetNumCols() == 2);
+  REQUIRE(atlas.GetNumCells() == 3);
+  REQUIRE(atlas.GetCell({0, 0}) == atlas.GetCell({2, 1}));
+  REQUIRE(atlas.GetCell({1, 0}) != atlas.GetCell({1, 1}));
+
+  island::Location origin = atlas.GetCellOrigin(atlas.GetCell({1, 1}));
+  size_t index = ((static_cast<size_t>(origin.GetCol()) + 1) * atlas.GetWidth()
+                  + static_cast<size_t>(origin.GetRow()) + 1)
+                 * island::kBytesPerPixel;
+  REQUIRE(atlas.GetPixels()[index] == 200);
+  REQUIRE(atlas.GetPixels()[index + 1] == 9);
+}
+
+TEST_CASE("Tile pyramid levels halve down to one pixel", "[tile_pyramid]") {
+  // A 3x3 tile map of 2x2 pixel tiles, with every tile a different shade.
+  const size_t size = 6;
+  std::vector<uint8_t> pixels(size * size * island::kBytesPerPixel);
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      pixels[(y * size + x) * island::kBytesPerPixel] =
+          static_cast<uint8_t>((x / 2 + y / 2 * 3) * 20);
+    }
+  }
+  island::TileAtlas atlas(pixels, size, size, 2);
+
+  island::TilePyramid serial(atlas);
+  serial.Build(nullptr);
+  island::TilePyramid parallel(atlas);
+  island::JobSystem job_system(2);
+  parallel.Build(&job_system);
+
+  REQUIRE(serial.GetNumLevels() == 4);
+  REQUIRE(serial.GetLevel(1).width_ == 3);
+  REQUIRE(serial.GetLevel(2).width_ == 2);
+  REQUIRE(serial.GetLevel(3).width_ == 1);
+  REQUIRE(serial.GetLevel(1).pixels_[0] == 0);
+  REQUIRE(serial.GetLevel(1).pixels_[island::kBytesPerPixel] == 20);
+  for (size_t level = 0; level < serial.GetNumLevels(); level++) {
+    REQUIRE(serial.GetLevel(level).pixels_ ==
+            parallel.GetLevel(level).pixels_);
+  }
+
+  REQUIRE(serial.GetLevelForZoom(1.0) == 0);
+  REQUIRE(serial.GetLevelForZoom(0.5) == 1);
+  REQUIRE(serial.GetLevelForZoom(0.3) == 1);
+  REQUIRE(serial.GetLevelForZoom(0.01) == 3);
+}
+
+TEST_CASE("Tile pyramid updates only the changed tile", "[tile_pyramid]") {
+  const size_t size = 8;
+  std::vector<uint8_t> pixels(size * size * island::kBytesPerPixel, 0);
+  for (size_t y = 0; y < 2; y++) {
+    for (size_t x = 0; x < 2; x++) {
+      pixels[(y * size + x) * island::kBytesPerPixel] = 240;
+    }
+  }
+  island::TileAtlas atlas(pixels, size, size, 2);
+  island::TilePyramid pyramid(atlas);
+  pyramid.Build(nullptr);
+
+  atlas.SetCell({3, 2}, atlas.GetCell({0, 0}));
+  pyramid.UpdateTile(atlas, {3, 2});
+
+  island::TilePyramid rebuilt(atlas);
+  rebuilt.Build(nullptr);
+  for (size_t level = 0; level < pyramid.GetNumLevels(); level++) {
+    REQUIRE(pyramid.GetLevel(level).pixels_ ==
+            rebuilt.GetLevel(level).pixels_);
+  }
+}
+
+TEST_CASE("Camera zoom picks the matching level of detail", "[camera]") {
+  island::Camera camera(50, 50, 40);
+  camera.SetViewSize(800, 800);
+  REQUIRE(camera.GetLevel() == 0);
+
+  camera.SetZoom(0.25);
+  REQUIRE(camera.GetLevel() == 2);
+  REQUIRE(camera.GetVisibleTiles().num_rows_ == 50);
+  camera.Follow({25, 25});
+  REQUIRE(camera.GetLocation() == island::Location(0, 0));
+
+  camera.SetZoom(0.7);
+  REQUIRE(camera.GetLevel() == 0);
+}
+
+TEST_CASE("Frame encoder drops frames instead of waiting", "[frame_encoder]") {
+  std::promise<void> release;
+  std::shared_future<void> is_released = release.get_future().share();
+  std::vector<size_t> written;
+  {
+    island::FrameEncoder encoder(2, [&](const island::CapturedFrame& frame) {
+      is_released.wait();
+      written.push_back(frame.index_);
+    });
+
+    // The first frame blocks the encoder, the second waits in the other
+    // slot, and the third has nowhere to go.
+    for (size_t frame = 0; frame < 3; frame++) {
+      island::CapturedFrame* slot = encoder.Acquire();
+      if (frame < 2) {
+        REQUIRE(slot != nullptr);
+        encoder.Submit(slot);
+      } else {
+        REQUIRE(slot == nullptr);
+      }
+    }
+    REQUIRE(encoder.GetStats().num_dropped_ == 1);
+
+    release.set_value();
+    encoder.Flush();
+    REQUIRE(encoder.GetStats().num_encoded_ == 2);
+
+    island::CapturedFrame* slot = encoder.Acquire();
+    REQUIRE(slot != nullptr);
+    REQUIRE(slot->index_ == 3);
+    encoder.Submit(slot);
+  }
+  REQUIRE(written == std::vector<size_t>({0, 1, 3}));
+}
+
+TEST_CASE("Resource pack finds assets by id without copying",
+          "[resource_pack]") {
+  const std::string path = "resource_pack_test.pack";
+  const std::string text = "Welcome to the island!";
+  island::ResourcePackWriter writer;
+  writer.AddTexture("assets/b.png", 1, 1, {200, 100, 50, 255});
+  writer.AddTexture("assets/a.png", 2, 1,
+                    {255, 255, 255, 0, 200, 100, 50, 128});
+  writer.Add("assets/text/notice.txt", {1, 2, 3});
+  writer.Add("assets/text/notice.txt",
+             std::vector<uint8_t>(text.begin(), text.end()));
+  writer.Add("assets/text_sound.wav", std::vector<uint8_t>(100, 7));
+  REQUIRE(writer.GetNumResources() == 4);
+  REQUIRE(writer.Write(path));
+
+  island::ResourcePack pack;
+  REQUIRE(pack.Open(path));
+  REQUIRE(pack.GetNumResources() == 4);
+
+  island::ResourceSpan resource;
+  REQUIRE(pack.Find(island::GetAssetId("assets/text/notice.txt"),
+                    &resource));
+  REQUIRE(resource.type_ == island::ResourceType::kRaw);
+  REQUIRE(std::string(reinterpret_cast<const char*>(resource.data_),
+                      resource.size_) == text);
+  REQUIRE(reinterpret_cast<uintptr_t>(resource.data_)
+          % island::kResourcePackAlignment == 0);
+  REQUIRE(pack.Find("assets/text_sound.wav", &resource));
+  REQUIRE(resource.size_ == 100);
+  REQUIRE_FALSE(pack.Find("assets/missing.txt", &resource));
+  REQUIRE_FALSE(pack.Find(island::GetAssetId("assets/missing.txt"),
+                          &resource));
+
+  island::TextureView image;
+  REQUIRE(pack.FindTexture("assets/a.png", &image));
+  REQUIRE(image.width_ == 2);
+  REQUIRE(image.height_ == 1);
+  // Transparent pixels turn black, opaque pixels keep their color.
+  REQUIRE(std::vector<uint8_t>(image.pixels_, image.pixels_ + 8)
+          == std::vector<uint8_t>({0, 0, 0, 0, 100, 50, 25, 128}));
+  REQUIRE(pack.FindTexture("assets/b.png", &image));
+  REQUIRE(image.pixels_[0] == 200);
+  REQUIRE_FALSE(pack.FindTexture("assets/text_sound.wav", &image));
+
+  std::remove(path.c_str());
+  REQUIRE_FALSE(pack.Open(path));
+  REQUIRE(pack.GetNumResources() == 0);
+}
+
+TEST_CASE("Battle prefetch drops an npc's assets once the player leaves",
+          "[battle_prefetch]") {
+  island::BattlePrefetch prefetch;
+  REQUIRE(prefetch.Update({}, "").empty());
+  REQUIRE(prefetch.Update({"Sven", "Elf"}, "") == "Sven");
+  REQUIRE(prefetch.Update({"Sven", "Elf"}, "Elf") == "Elf");
+
+  // Elf can be fought again on the spot, so he stays loaded even with Sven
+  // as near, until the player walks away from him.
+  REQUIRE(prefetch.Update({"Sven", "Elf"}, "") == "Elf");
+  REQUIRE(prefetch.Update({"Sven"}, "") == "Sven");
+  REQUIRE(prefetch.Update({"Sven", "Elf"}, "") == "Sven");
+  REQUIRE(prefetch.Update({}, "").empty());
+  REQUIRE(prefetch.GetTarget().empty());
+}
+
+TEST_CASE("Texture budget evicts the least recently used textures",
+          "[texture_budget]") {
+  island::TextureBudget budget(1000);
+  REQUIRE(budget.Add("map", island::TextureCategory::kMap, 400, true)
+          .empty());
+  REQUIRE(budget.Add("battle", island::TextureCategory::kBattle, 300)
+          .empty());
+  budget.BeginFrame();
+  REQUIRE(budget.Add("sprite", island::TextureCategory::kSprites, 200)
+          .empty());
+  REQUIRE(budget.GetNumBytes() == 900);
+  REQUIRE(budget.GetNumBytes(island::TextureCategory::kBattle) == 300);
+
+  // The battle art is the coldest texture which is not pinned.
+  budget.BeginFrame();
+  budget.Touch("sprite");
+  REQUIRE(budget.Add("text", island::TextureCategory::kText, 200)
+          == std::vector<std::string>({"battle"}));
+  REQUIRE(budget.GetNumBytes() == 800);
+  REQUIRE(budget.GetNumBytes(island::TextureCategory::kBattle) == 0);
+  REQUIRE(budget.GetPeakBytes() == 1100);
+  REQUIRE(budget.GetNumEvictions() == 1);
+
+  // Textures used this frame stay, even over budget.
+  REQUIRE(budget.Add("ui", island::TextureCategory::kUi, 500).empty());
+  REQUIRE(budget.GetNumBytes() == 1300);
+  budget.BeginFrame();
+  budget.Touch("ui");
+  REQUIRE(budget.SetBudget(900)
+          == std::vector<std::string>({"sprite", "text"}));
+  REQUIRE(budget.GetNumTextures() == 2);
+
+  budget.Remove("ui");
+  REQUIRE(budget.GetNumBytes() == 400);
+  REQUIRE(budget.GetReport().find("map: 0 KB") != std::string::npos);
+}
+
+TEST_CASE("Command buffer groups commands by layer and texture",
+          "[command_buffer]") {
+  const island::CommandRect rect = {0, 0, 40, 40};
+  island::CommandBuffer buffer;
+  buffer.AddSprite(1, 7, rect);
+  buffer.AddSprite(1, 3, rect);
+  buffer.AddText(2, 9, rect);
+  buffer.AddSprite(1, 7, {40, 0, 80, 40});
+  buffer.AddRect(0, 0xFF0000FF, rect);
+
+  // Another thread's commands come after this buffer's.
+  island::CommandBuffer other;
+  other.AddSprite(1, 3, {80, 0, 120, 40});
+  buffer.Append(other);
+  REQUIRE(buffer.GetCommands().size() == 6);
+  REQUIRE(buffer.CountBatches() == 6);
+
+  buffer.Sort();
+  const std::vector<island::DrawCommand>& commands = buffer.GetCommands();
+  REQUIRE(commands[0].kind_ == island::CommandKind::kRect);
+  REQUIRE(commands[0].color_ == 0xFF0000FF);
+  REQUIRE(commands[1].texture_ == 3);
+  REQUIRE(commands[2].texture_ == 3);
+  REQUIRE(commands[2].rect_.x1_ == Approx(80));
+  REQUIRE(commands[3].texture_ == 7);
+  REQUIRE(commands[3].rect_.x1_ == Approx(0));
+  REQUIRE(commands[4].rect_.x1_ == Approx(40));
+  REQUIRE(commands[5].kind_ == island::CommandKind::kText);
+  REQUIRE(buffer.CountBatches() == 4);
+
+  buffer.Clear();
+  REQUIRE(buffer.GetCommands().empty());
+}
+
+TEST_CASE("Audio mixer crossfades music and limits sound effects",
+          "[audio_mixer]") {
+  using island::AudioCommandKind;
+  island::AudioMixer mixer(3, 1.0, 0.1);
+  mixer.SetMusic(1, 1.0f);
+  std::vector<island::AudioCommand> commands = mixer.Update(0);
+  REQUIRE(commands.size() == 1);
+  REQUIRE(commands[0].kind_ == AudioCommandKind::kStart);
+  REQUIRE(commands[0].is_looping_);
+  REQUIRE(commands[0].gain_ == Approx(0));
+
+  commands = mixer.Update(0.5);
+  REQUIRE(commands.size() == 1);
+  REQUIRE(commands[0].gain_ == Approx(0.5));
+  REQUIRE(mixer.Update(1.0).size() == 1);
+
+  // Asking for the same music again changes nothing.
+  mixer.SetMusic(1, 1.0f);
+  REQUIRE(mixer.Update(2.0).empty());
+
+  mixer.SetMusic(2, 0.5f);
+  commands = mixer.Update(2.0);
+  REQUIRE(commands.size() == 1);
+  REQUIRE(commands[0].sound_ == 2);
+  REQUIRE(commands[0].voice_ == 1);
+  REQUIRE(mixer.GetNumVoicesInUse() == 2);
+  commands = mixer.Update(3.0);
+  REQUIRE(commands.size() == 2);
+  REQUIRE(commands[0].kind_ == AudioCommandKind::kStop);
+  REQUIRE(commands[0].voice_ == 0);
+  REQUIRE(commands[1].gain_ == Approx(0.5));
+  REQUIRE(mixer.GetNumVoicesInUse() == 1);
+  REQUIRE_FALSE(mixer.IsPlaying(1));
+
+  // One character per update only starts the sound every interval.
+  mixer.PlaySfx(7, 1.0f, 0.05);
+  mixer.PlaySfx(7, 1.0f, 0.05);
+  REQUIRE(mixer.Update(3.0).size() == 1);
+  mixer.PlaySfx(7, 1.0f, 0.05);
+  REQUIRE(mixer.Update(3.05).empty());
+  mixer.PlaySfx(7, 1.0f, 0.05);
+  REQUIRE(mixer.Update(3.1).size() == 1);
+  REQUIRE(mixer.GetNumSkippedSfx() == 2);
+
+  mixer.SetMuted(true);
+  commands = mixer.Update(3.12);
+  REQUIRE(commands.size() == 2);
+  REQUIRE(commands[0].gain_ == Approx(0));
+  REQUIRE(commands[1].gain_ == Approx(0));
+  REQUIRE(mixer.IsMuted());
+}
+
+TEST_CASE("Pcm ring wraps around and plays silence when it runs out",
+          "[pcm_ring]") {
+  island::PcmRing ring(4, 2);
+  const std::vector<float> frames = {1, -1, 2, -2, 3, -3};
+  REQUIRE(ring.Write(frames.data(), 3) == 3);
+  REQUIRE(ring.Write(frames.data(), 3) == 1);
+  REQUIRE(ring.GetNumFramesFree() == 0);
+
+  std::vector<float> read(6);
+  REQUIRE(ring.Read(read.data(), 3) == 3);
+  REQUIRE(read == std::vector<float>({1, -1, 2, -2, 3, -3}));
+  REQUIRE(ring.GetNumUnderruns() == 0);
+
+  // The second write wraps around the end of the ring.
+  REQUIRE(ring.Write(frames.data() + 2, 2) == 2);
+  REQUIRE(ring.GetNumFramesQueued() == 3);
+  REQUIRE(ring.Read(read.data(), 3) == 3);
+  REQUIRE(read == std::vector<float>({1, -1, 2, -2, 3, -3}));
+
+  REQUIRE(ring.Write(frames.data(), 1) == 1);
+  REQUIRE(ring.Read(read.data(), 3) == 1);
+  REQUIRE(read == std::vector<float>({1, -1, 0, 0, 0, 0}));
+  REQUIRE(ring.GetNumUnderruns() == 1);
+  REQUIRE(ring.GetNumMissedFrames() == 2);
+}
+
+TEST_CASE("Pcm cache maps decoded sounds by the hash of their file",
+          "[pcm_cache]") {
+  const std::string path = "pcm_cache_test.pcmcache";
+  const std::vector<uint8_t> wav = {'R', 'I', 'F', 'F', 1, 2, 3};
+  const uint64_t hash = island::HashBytes(wav.data(), wav.size());
+  island::PcmCacheWriter writer;
+  writer.Add(hash, 44100, 2, {0.5f, 0.25f, -0.5f, -0.25f});
+  writer.Add(7, 44100, 1, {1.0f});
+  writer.Add(7, 48000, 1, {1.0f, 0.0f});
+  REQUIRE(writer.GetNumSounds() == 2);
+  REQUIRE(writer.Write(path));
+
+  island::PcmCache cache;
+  REQUIRE(cache.Open(path));
+  REQUIRE(cache.GetNumSounds() == 2);
+
+  island::PcmView sound;
+  REQUIRE(cache.Find(hash, 44100, &sound));
+  REQUIRE(sound.num_frames_ == 2);
+  REQUIRE(sound.num_channels_ == 2);
+  REQUIRE(reinterpret_cast<uintptr_t>(sound.samples_) % 64 == 0);
+  REQUIRE(std::vector<float>(sound.samples_, sound.samples_ + 4)
+          == std::vector<float>({0.5f, 0.25f, -0.5f, -0.25f}));
+  REQUIRE(cache.Find(7, 48000, &sound));
+  REQUIRE(sound.num_frames_ == 2);
+
+  // A sound decoded at another rate, or an edited file, misses the cache.
+  REQUIRE_FALSE(cache.Find(hash, 48000, &sound));
+  REQUIRE_FALSE(cache.Find(hash + 1, 44100, &sound));
+
+  std::remove(path.c_str());
+  REQUIRE_FALSE(cache.Open(path));
+  REQUIRE(cache.GetNumSounds() == 0);
+}
+
+TEST_CASE("Save state is written atomically and read back",
+          "[save_state]") {
+  const std::string path = "save_state_test.json";
+  island::SaveState state;
+  state.width_ = 50;
+  state.height_ = 50;
+  state.is_key_found_ = true;
+  state.direction_ = island::Direction::kLeft;
+  state.player_name_ = "Kanav";
+  state.player_location_ = {7, 3};
+  state.player_statistics_ = {10, 11, 12, 13};
+  state.player_money_ = 1200;
+  state.items_ = std::make_shared<const std::vector<island::Item>>(
+      std::vector<island::Item>{island::Item("sword", "Sharp", "sword.png"),
+                                island::Item("heart", "Red", "heart.png")});
+  state.inventory_ = std::make_shared<const std::vector<island::Item>>();
+  REQUIRE(island::WriteFileAtomically(path, island::SerializeSave(state)));
+
+  std::ifstream file(path);
+  const std::string text((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  island::SaveState loaded;
+  REQUIRE(island::ParseSave(text, &loaded));
+  REQUIRE(loaded.is_key_found_);
+  REQUIRE(loaded.direction_ == island::Direction::kLeft);
+  REQUIRE(loaded.player_name_ == "Kanav");
+  REQUIRE(loaded.player_location_ == island::Location(7, 3));
+  REQUIRE(loaded.player_statistics_.defense_ == 12);
+  REQUIRE(loaded.player_money_ == 1200);
+  REQUIRE(loaded.items_->size() == 2);
+  REQUIRE(loaded.items_->at(1).file_path_ == "heart.png");
+  REQUIRE(loaded.inventory_->empty());
+
+  // A half written file is never read back.
+  REQUIRE_FALSE(island::ParseSave(text.substr(0, text.size() / 2), &loaded));
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Save journal replays whole batches and drops a torn one",
+          "[save_journal]") {
+  const std::string path = island::GetJournalPath("save_journal_test.json");
+  island::SaveJournal journal(path);
+  REQUIRE_FALSE(journal.Append({}));
+  REQUIRE(journal.Start(42));
+
+  island::JournalRecord item(island::JournalOp::kAddInventoryItem);
+  item.name_ = "sword";
+  item.description_ = "Sharp";
+  item.file_path_ = "sword.png";
+  island::JournalRecord tile(island::JournalOp::kSetTile);
+  tile.location_ = {31, 45};
+  tile.value_ = island::kTree;
+  island::JournalRecord money(island::JournalOp::kRemoveMoney);
+  money.value_ = 5000;
+  REQUIRE(journal.Append({item, tile}));
+  REQUIRE(journal.Append({money}));
+  const size_t num_bytes = journal.GetNumBytes();
+
+  // Three changes take a fraction of the space of a whole JSON save.
+  REQUIRE(num_bytes < 100);
+  REQUIRE(journal.Append({money, money}));
+  std::ifstream file(path, std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+  file.close();
+  {
+    std::ofstream torn(path, std::ios::binary | std::ios::trunc);
+    torn.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+  }
+
+  uint64_t generation = 0;
+  std::vector<island::JournalRecord> records;
+  REQUIRE(island::ReadSaveJournal(path, &generation, &records));
+  REQUIRE(generation == 42);
+  REQUIRE(records.size() == 3);
+  REQUIRE(records[0].op_ == island::JournalOp::kAddInventoryItem);
+  REQUIRE(records[0].file_path_ == "sword.png");
+  REQUIRE(records[1].location_ == island::Location(31, 45));
+  REQUIRE(records[1].value_ == island::kTree);
+  REQUIRE(records[2].value_ == 5000);
+
+  // Resuming cuts the torn batch off, so batches after it are read.
+  island::SaveJournal resumed(path);
+  REQUIRE(resumed.Resume(42));
+  REQUIRE(resumed.GetNumBytes() == num_bytes);
+  REQUIRE(resumed.Append({tile}));
+  records.clear();
+  REQUIRE(island::ReadSaveJournal(path, &generation, &records));
+  REQUIRE(records.size() == 4);
+  REQUIRE(records[3].op_ == island::JournalOp::kSetTile);
+
+  REQUIRE(journal.Start(43));
+  records.clear();
+  REQUIRE(island::ReadSaveJournal(path, &generation, &records));
+  REQUIRE(generation == 43);
+  REQUIRE(records.empty());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Autosaver only writes once the game changes and resumes a save",
+          "[autosaver]") {
+  const std::string path = "autosaver_test.json";
+  const std::string journal_path = island::GetJournalPath(path);
+  std::remove(path.c_str());
+  std::remove(journal_path.c_str());
+  const std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  island::Engine engine(world, "Meow", island::kStartLocation,
+                        {10, 10, 10, 10}, 100);
+  {
+    island::Autosaver saver(path, std::chrono::milliseconds(0),
+                            std::chrono::milliseconds(0), 100);
+    REQUIRE_FALSE(saver.Update(&engine));
+    saver.Flush();
+    REQUIRE_FALSE(std::ifstream(path).good());
+
+    engine.AddMoney(20);
+    REQUIRE(saver.Update(&engine));
+    engine.AddMoney(30);
+    REQUIRE(saver.Update(&engine));
+    saver.Flush();
+    REQUIRE(saver.GetStats().num_written_ == 1);
+    REQUIRE(saver.GetStats().num_batches_ == 1);
+  }
+
+  island::Engine loaded(world, "Meow", island::kStartLocation,
+                        {10, 10, 10, 10}, 0);
+  uint64_t generation = 0;
+  REQUIRE(loaded.Load(path, &generation));
+  REQUIRE(generation != 0);
+  REQUIRE(loaded.GetPlayer().money_ == 150);
+  {
+    // Carrying on from the loaded save only appends to its journal.
+    island::Autosaver saver(path, std::chrono::milliseconds(0),
+                            std::chrono::milliseconds(0), 100);
+    saver.Resume(generation);
+    REQUIRE_FALSE(saver.Update(&loaded));
+    loaded.AddMoney(5);
+    REQUIRE(saver.Update(&loaded));
+    saver.Flush();
+    REQUIRE(saver.GetStats().num_captured_ == 0);
+    REQUIRE(saver.GetStats().num_batches_ == 1);
+  }
+
+  island::Engine reloaded(world, "Meow", island::kStartLocation,
+                          {10, 10, 10, 10}, 0);
+  uint64_t reloaded_generation = 0;
+  REQUIRE(reloaded.Load(path, &reloaded_generation));
+  REQUIRE(reloaded_generation == generation);
+  REQUIRE(reloaded.GetPlayer().money_ == 155);
+  std::remove(path.c_str());
+  std::remove(journal_path.c_str());
+}
+
+TEST_CASE("Only a new game is stocked with the island's items", "[engine]") {
+  island::Engine loaded(island::kMapSize, island::kMapSize, {}, "Meow",
+                        island::kStartLocation, {10, 10, 10, 10}, {}, 0);
+  REQUIRE(loaded.Load("assets/saved_game.json"));
+  loaded.StockItems(island::GetIslandItems());
+  REQUIRE(loaded.GetNumItems() == 1);
+  REQUIRE(loaded.GetItemFromIndex(0).name_ == "heart");
+
+  island::SaveState state = loaded.CaptureSave();
+  island::Engine slot(island::kMapSize, island::kMapSize, {}, "Meow",
+                      island::kStartLocation, {10, 10, 10, 10}, {}, 0);
+  slot.Restore(state);
+  slot.StockItems(island::GetIslandItems());
+  REQUIRE(slot.GetNumItems() == 1);
+
+  // A save which fails to load leaves a new game to stock.
+  island::Engine fresh(island::kMapSize, island::kMapSize, {}, "Meow",
+                       island::kStartLocation, {10, 10, 10, 10}, {}, 0);
+  REQUIRE_FALSE(fresh.Load("missing_save.json"));
+  fresh.StockItems(island::GetIslandItems());
+  REQUIRE(fresh.GetNumItems() == island::GetIslandItems().size());
+  REQUIRE(fresh.GetItemFromIndex(0).name_ == "shoe");
+}
+
+TEST_CASE("Save slots are listed from their headers alone", "[save_slots]") {
+  island::SaveState state;
+  state.player_name_ = "A player whose name is far too long for a slot";
+  state.player_money_ = 8800;
+  state.is_key_found_ = true;
+  state.items_ = std::make_shared<const std::vector<island::Item>>();
+  state.inventory_ = std::make_shared<const std::vector<island::Item>>(
+      std::vector<island::Item>{island::Item("key", "A key", "key.png")});
+
+  island::SaveSlots slots(".");
+  REQUIRE(slots.Write(3, state, 600, 1588000000, {1, 2, 3, 4}));
+  state.player_name_ = "Meow";
+  state.is_key_found_ = false;
+  REQUIRE(slots.Write(1, state, 60, 1588000100, {}));
+  REQUIRE(slots.Write(1, state, 90, 1588000200, {}));
+
+  island::SaveSlots listed(".");
+  REQUIRE(listed.Open());
+  REQUIRE(listed.GetSlots().size() == 2);
+  REQUIRE(listed.GetSlots()[0].slot_ == 1);
+  REQUIRE(listed.GetSlots()[0].playtime_seconds_ == 90);
+  REQUIRE(listed.GetSlots()[1].player_name_.size()
+          == island::kMaxSlotNameLength);
+  REQUIRE(listed.GetSlots()[1].is_key_found_);
+  REQUIRE(listed.GetSlots()[1].timestamp_ == 1588000000);
+
+  island::SaveState loaded;
+  island::SaveSlotHeader header;
+  REQUIRE(listed.Load(3, &loaded, &header));
+  REQUIRE(loaded.player_money_ == 8800);
+  REQUIRE(loaded.inventory_->at(0).name_ == "key");
+  REQUIRE(header.thumbnail_size_ == 4);
+  std::vector<uint8_t> thumbnail;
+  REQUIRE(listed.LoadThumbnail(3, &thumbnail));
+  REQUIRE(thumbnail == std::vector<uint8_t>({1, 2, 3, 4}));
+  REQUIRE_FALSE(listed.Load(2, &loaded, nullptr));
+
+  // Without the index, the slots are found again from their own headers.
+  std::remove("./slots.index");
+  island::SaveSlots rebuilt(".");
+  REQUIRE_FALSE(rebuilt.Open());
+  REQUIRE(rebuilt.GetSlots().size() == 2);
+  REQUIRE(island::SaveSlots(".").Open());
+
+  std::remove(slots.GetSlotPath(1).c_str());
+  std::remove(slots.GetSlotPath(3).c_str());
+  std::remove("./slots.index");
+}
+
+TEST_CASE("Maps share their base tiles and only keep their own overrides",
+          "[map]") {
+  const island::Map base({{island::kGrass, island::kGrass, island::kWater},
+                          {island::kRoad, island::kTree, island::kGrass}});
+  island::Map first(base.GetBase());
+  island::Map second(base.GetBase());
+  REQUIRE(first.GetBase() == second.GetBase());
+  REQUIRE(first.GetNumOverrideBytes() == 0);
+
+  first.SetTile({1, 1}, island::kGrass);
+  first.SetTile({0, 2}, island::kSand);
+  REQUIRE(first.GetTile({1, 1}) == island::kGrass);
+  REQUIRE(first.IsAccessibleTile({1, 1}));
+  REQUIRE(first.GetBaseTile({1, 1}) == island::kTree);
+  REQUIRE(second.GetTile({1, 1}) == island::kTree);
+  REQUIRE_FALSE(second.IsAccessibleTile({1, 1}));
+
+  const std::vector<island::TileChange> overrides = first.GetOverrides();
+  REQUIRE(overrides.size() == 2);
+  REQUIRE(overrides[0].location_ == island::Location(0, 2));
+  REQUIRE(overrides[0].tile_ == island::kSand);
+  REQUIRE(overrides[1].location_ == island::Location(1, 1));
+
+  // Setting a tile back to the base tile drops its override.
+  first.SetTile({0, 2}, island::kWater);
+  REQUIRE(first.GetOverrides().size() == 1);
+  first.ResetTiles();
+  REQUIRE(first.GetOverrides().empty());
+  REQUIRE(first.GetTile({1, 1}) == island::kTree);
+
+  island::SaveState state;
+  state.width_ = 3;
+  state.height_ = 2;
+  state.items_ = std::make_shared<const std::vector<island::Item>>();
+  state.inventory_ = std::make_shared<const std::vector<island::Item>>();
+  state.tile_overrides_ = overrides;
+  island::SaveState loaded;
+  REQUIRE(island::ParseSave(island::SerializeSave(state), &loaded));
+  REQUIRE(loaded.tile_overrides_.size() == 2);
+  REQUIRE(loaded.tile_overrides_[1].location_ == island::Location(1, 1));
+  REQUIRE(loaded.tile_overrides_[1].tile_ == island::kGrass);
+
+  // Tiles off the map are rejected, whether saved or journaled.
+  state.tile_overrides_.push_back({{2, 0}, island::kSand});
+  REQUIRE_FALSE(island::ParseSave(island::SerializeSave(state), &loaded));
+  state.tile_overrides_.back() = {{999, -3}, island::kSand};
+  REQUIRE_FALSE(island::ParseSave(island::SerializeSave(state), &loaded));
+  island::Engine engine(island::LoadIslandWorld("assets/map_tileset.txt"),
+                        "Player", island::kStartLocation, {10, 10, 10, 10},
+                        island::kStartMoney);
+  island::JournalRecord tile(island::JournalOp::kSetTile);
+  tile.location_ = {999, -3};
+  tile.value_ = island::kSand;
+  engine.Apply(tile);
+  island::JournalRecord move(island::JournalOp::kMovePlayer);
+  move.location_ = {-1, 50};
+  engine.Apply(move);
+  island::JournalRecord turn(island::JournalOp::kSetDirection);
+  turn.value_ = 7;
+  engine.Apply(turn);
+  REQUIRE(engine.GetNumTileChanges() == 0);
+  REQUIRE(engine.GetTileOverrides().empty());
+  REQUIRE(engine.GetPlayer().location_ == island::kStartLocation);
+  REQUIRE(engine.CaptureSave().direction_ == island::Direction::kRight);
+
+  // Changes are counted, while only the tiles still changed are kept.
+  const island::Location corner(0, 0);
+  const island::Tile base_tile = engine.GetBaseTileType(corner);
+  engine.SetTile(corner, base_tile == island::kSand ? island::kGrass
+                                                    : island::kSand);
+  engine.SetTile(corner, base_tile);
+  REQUIRE(engine.GetNumTileChanges() == 2);
+  REQUIRE(engine.GetTileOverrides().empty());
+}
+
+TEST_CASE("Session pools run independent games on one shared world",
+          "[session_pool]") {
+  std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  island::SessionPool pool(world, 2, 2);
+  const island::SessionId first = pool.Create("First");
+  const island::SessionId second = pool.Create("Second");
+  const island::SessionId third = pool.Create("Third");
+  REQUIRE(pool.GetNumSessions() == 3);
+
+  // Find a way out of the start which is clear, and only move one player.
+  const island::Engine& engine = pool.Find(first)->GetEngine();
+  const island::PlayerAction moves[] = {
+      island::PlayerAction::kMoveUp, island::PlayerAction::kMoveDown,
+      island::PlayerAction::kMoveLeft, island::PlayerAction::kMoveRight};
+  const island::Direction directions[] = {
+      island::Direction::kUp, island::Direction::kDown,
+      island::Direction::kLeft, island::Direction::kRight};
+  size_t move = 0;
+  while (move < 3 && !engine.IsValidDirection(directions[move])) {
+    move++;
+  }
+  const bool can_move = engine.IsValidDirection(directions[move]);
+  REQUIRE(pool.PushAction(first, moves[move]));
+  pool.Tick();
+  REQUIRE((engine.GetPlayer().location_ == island::kStartLocation)
+          != can_move);
+  REQUIRE(pool.Find(second)->GetEngine().GetPlayer().location_
+          == island::kStartLocation);
+  REQUIRE(pool.Find(first)->GetFacing() == directions[move]);
+
+  REQUIRE(pool.Remove(second));
+  REQUIRE_FALSE(pool.Remove(second));
+  REQUIRE_FALSE(pool.PushAction(second, island::PlayerAction::kInteract));
+  REQUIRE(pool.Find(second) == nullptr);
+  REQUIRE(pool.Find(third) != nullptr);
+  REQUIRE(pool.Find(third)->GetEngine().GetNumItems()
+          == world->items_->size());
+
+  const island::SessionStats stats = pool.GetStats();
+  REQUIRE(stats.num_sessions_ == 2);
+  REQUIRE(stats.num_ticks_ == 1);
+  REQUIRE(stats.num_bytes_ > 0);
+  REQUIRE(stats.max_session_bytes_ * 2 >= stats.num_bytes_);
+
+  // Every game shares the world's map, items and npcs as they start out.
+  island::Engine own(world, "Own", island::kStartLocation, {10, 10, 10, 10},
+                     island::kStartMoney);
+  REQUIRE(own.GetNpcs().size() == world->npcs_.size());
+  REQUIRE(own.GetTileType(island::kMarketLocation)
+          == world->tiles_->tiles_[36 * world->tiles_->num_cols_ + 36]);
+  const size_t shared_bytes = own.GetNumBytes();
+  own.RemoveItem("shoe");
+  REQUIRE(own.GetNumItems() + 1 == world->items_->size());
+  REQUIRE(own.GetNumBytes() > shared_bytes);
+
+  // The world's distance fields are shared, and there is no flow field to
+  // build until an npc roams.
+  const size_t item_bytes = own.GetNumBytes();
+  own.Tick();
+  REQUIRE(own.GetNumBytes() == item_bytes);
+  REQUIRE(&own.GetRegions() == world->regions_.get());
+  own.AddNpc(world->npcs_.front(), true);
+  own.Tick();
+  REQUIRE(own.GetNumBytes() > item_bytes);
+  REQUIRE(&own.GetRegions() == world->regions_.get());
+
+  // The regions are copied once the map changes, leaving the world's alone.
+  const size_t num_fields = world->regions_->GetNumDistanceFields();
+  own.SetTile(own.kKeyLocation, island::kTree);
+  REQUIRE(&own.GetRegions() != world->regions_.get());
+  own.Tick();
+  REQUIRE(own.GetRegions().GetNumDistanceFields() == num_fields);
+  REQUIRE(world->regions_->GetNumDistanceFields() == num_fields);
+}
+
+TEST_CASE("Game sessions play the market, the key and Klutz's reward",
+          "[game_session]") {
+  std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  island::GameSession session(world, "Player");
+  island::Engine& engine = session.GetEngine();
+  island::JournalRecord move(island::JournalOp::kMovePlayer);
+
+  // Boi turns to the player at the market, which only sells what they can
+  // afford, in order.
+  move.location_ = island::kMarketLocation + island::Location(1, 0);
+  engine.Apply(move);
+  session.HandleAction(island::PlayerAction::kMoveLeft);
+  session.HandleAction(island::PlayerAction::kInteract);
+  REQUIRE(session.GetState() == island::SessionState::kMarket);
+  const size_t boi =
+      engine.GetNpcStore().FindAtLocation(island::kMarketLocation);
+  REQUIRE(session.GetNpcFacings()[boi] == island::Direction::kRight);
+  session.HandleAction(island::PlayerAction::kAccept);
+  REQUIRE(session.GetState() == island::SessionState::kMarket);
+  REQUIRE(engine.GetPlayer().inventory_.empty());
+
+  engine.AddMoney(4 * island::kItemPrice);
+  const std::string names[] = {"shoe", "sword", "shield", "heart"};
+  island::Item item("", "", "");
+  for (const std::string& name : names) {
+    REQUIRE(session.GetItemForSale(&item));
+    REQUIRE(item.name_ == name);
+    session.HandleAction(island::PlayerAction::kAccept);
+    REQUIRE(session.GetState() == island::SessionState::kPlaying);
+    REQUIRE(engine.GetPlayer().inventory_.back().name_ == name);
+    session.HandleAction(island::PlayerAction::kInteract);
+  }
+  // The key is never sold.
+  REQUIRE_FALSE(session.GetItemForSale(&item));
+  engine.AddMoney(island::kItemPrice);
+  session.HandleAction(island::PlayerAction::kAccept);
+  REQUIRE(engine.GetPlayer().inventory_.size() == 4);
+  session.HandleAction(island::PlayerAction::kDecline);
+
+  move.location_ = engine.kKeyLocation + island::Location(1, 0);
+  engine.Apply(move);
+  session.HandleAction(island::PlayerAction::kInteract);
+  REQUIRE(session.GetState() == island::SessionState::kTalking);
+  REQUIRE(engine.GetKey());
+  REQUIRE(engine.GetPlayer().inventory_.back().name_ == "key");
+  REQUIRE(engine.GetTileType(engine.kKeyLocation) == island::kTree);
+  session.HandleAction(island::PlayerAction::kInteract);
+
+  // Klutz pays for his key once.
+  const size_t money = engine.GetPlayer().money_;
+  move.location_ = island::Location(29, 20);
+  engine.Apply(move);
+  for (size_t talk = 0; talk < 2; talk++) {
+    session.HandleAction(island::PlayerAction::kInteract);
+    REQUIRE(session.GetState() == island::SessionState::kTalking);
+    session.HandleAction(island::PlayerAction::kInteract);
+  }
+  REQUIRE(engine.GetPlayer().money_ == money + island::kKeyMoney);
+  REQUIRE(engine.GetPlayer().inventory_.size() == 4);
+
+  // Sven's dialogue leads into a battle, which starts as it ends.
+  move.location_ = island::Location(24, 20);
+  engine.Apply(move);
+  session.HandleAction(island::PlayerAction::kMoveRight);
+  session.HandleAction(island::PlayerAction::kInteract);
+  REQUIRE(session.IsBattleStarting());
+  session.HandleAction(island::PlayerAction::kInteract);
+  REQUIRE(session.GetState() == island::SessionState::kBattle);
+  REQUIRE_FALSE(session.IsBattleStarting());
+}
+
+TEST_CASE("Replication frames are deltas against the acknowledged frame",
+          "[replication]") {
+  std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  island::GameSession session(world, "Player");
+  island::ReplicationEncoder encoder(world);
+  island::ReplicationDecoder decoder(world);
+  island::ReplicatedState state;
+  std::vector<uint8_t> frame;
+
+  // Nothing has happened yet, so the first frame is barely more than its
+  // header.
+  encoder.Encode(island::CaptureReplicatedState(*world, session), &frame);
+  REQUIRE(frame.size() <= 8);
+  REQUIRE(decoder.Decode(frame.data(), frame.size(), &state));
+  REQUIRE(state == island::CaptureReplicatedState(*world, session));
+  encoder.Acknowledge(decoder.GetSequence());
+
+  // A frame which never arrives is not needed to decode the next ones.
+  island::Engine& engine = session.GetEngine();
+  engine.AddMoney(250);
+  engine.SetTile(island::kMarketLocation, island::kKey);
+  encoder.Encode(island::CaptureReplicatedState(*world, session), &frame);
+  engine.AddInventoryItem((*world->items_)[2]);
+  engine.SetKey(true);
+  engine.SetTile({0, 0}, island::kWater);
+  engine.RemoveMoney(300);
+  engine.Tick();
+  encoder.Encode(island::CaptureReplicatedState(*world, session), &frame);
+  REQUIRE(decoder.Decode(frame.data(), frame.size(), &state));
+  REQUIRE(state == island::CaptureReplicatedState(*world, session));
+  REQUIRE(state.inventory_.back() == 2);
+  REQUIRE(state.tile_overrides_.size() == 2);
+  REQUIRE(state.money_ == island::kStartMoney - 50);
+
+  // Frames arriving late are ignored, and damaged frames rejected.
+  const std::vector<uint8_t> late = frame;
+  encoder.Acknowledge(decoder.GetSequence());
+  encoder.Encode(island::CaptureReplicatedState(*world, session), &frame);
+  REQUIRE(frame.size() == 5);
+  REQUIRE(decoder.Decode(frame.data(), frame.size(), &state));
+  REQUIRE_FALSE(decoder.Decode(late.data(), late.size(), &state));
+  engine.SetTile({1, 1}, island::kSand);
+  encoder.Encode(island::CaptureReplicatedState(*world, session), &frame);
+  REQUIRE_FALSE(decoder.Decode(frame.data(), frame.size() - 1, &state));
+  REQUIRE(decoder.Decode(frame.data(), frame.size(), &state));
+  REQUIRE(state.tile_overrides_.size() == 3);
+}
+
+TEST_CASE("Bots walk to the market and npcs and change their game's state",
+          "[bot]") {
+  std::shared_ptr<const island::World> world =
+      island::LoadIslandWorld("assets/map_tileset.txt");
+  const island::BotRoutes routes(*world);
+  island::GameSession session(world, "Bot");
+  island::Bot bot(&routes, 7);
+
+  // A bot's actions drive its game with nothing but the replicated state.
+  bool has_moved = false;
+  bool has_visited = false;
+  island::PlayerAction action;
+  for (size_t tick = 0; tick < 2000 && !has_visited; tick++) {
+    const island::ReplicatedState state =
+        island::CaptureReplicatedState(*world, session);
+    has_moved = has_moved || state.player_location_ != island::kStartLocation;
+    if (bot.GetAction(state, &action)) {
+      session.HandleAction(action);
+    }
+    session.Step();
+    has_visited = session.GetState() == island::SessionState::kTalking
+                  || session.GetState() == island::SessionState::kMarket
+                  || session.GetState() == island::SessionState::kBattle;
+  }
+  REQUIRE(has_moved);
+  REQUIRE(has_visited);
+
+  // The bot counts the visit once it sees it, and answers it.
+  REQUIRE(bot.GetAction(island::CaptureReplicatedState(*world, session),
+                        &action));
+  const island::BotStats& stats = bot.GetStats();
+  REQUIRE(stats.num_actions_ > 0);
+  REQUIRE(stats.num_talks_ + stats.num_market_visits_ + stats.num_battles_
+          == 1);
+}
+
+TEST_CASE("Keys map to actions and back the same way on either side",
+          "[key_actions]") {
+  island::PlayerAction action;
+  REQUIRE(island::GetKeyAction(island::kKeyW, &action));
+  REQUIRE(action == island::PlayerAction::kMoveUp);
+  REQUIRE(island::GetKeyAction(island::kKeyLeft, &action));
+  REQUIRE(action == island::PlayerAction::kMoveLeft);
+  REQUIRE_FALSE(island::GetKeyAction(island::kKeyUnknown, &action));
+
+  const island::PlayerAction actions[] = {
+      island::PlayerAction::kMoveUp, island::PlayerAction::kMoveDown,
+      island::PlayerAction::kMoveLeft, island::PlayerAction::kMoveRight,
+      island::PlayerAction::kInteract, island::PlayerAction::kToggleInventory,
+      island::PlayerAction::kAccept, island::PlayerAction::kDecline,
+      island::PlayerAction::kAttack, island::PlayerAction::kHeal,
+      island::PlayerAction::kRun};
+  for (island::PlayerAction sent : actions) {
+    REQUIRE(island::GetKeyAction(island::GetActionKey(sent), &action));
+    REQUIRE(action == sent);
+  }
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Kanav Bhatnagar. All rights reserved.
+
+#include <cinder/Filesystem.h>
+#include <gflags/gflags.h>
+
+#include <island/resource_pack.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "texture_cache.h"
+
+using islandapp::TextureCache;
+using std::string;
+
+DEFINE_string(assets_dir, "assets",
+              "The directory whose files are packed, named by their path "
+              "relative to its parent");
+DEFINE_string(output, "assets/resources.pack", "The resource pack to write");
+
+/**
+ * Determines whether a file under the assets directory belongs in the pack.
+ * Packs, the sound effect cache, the save file and its journal, and the save
+ * slots are written by the game, so they are left out.
+ *
+ * @param path the path of the file
+ * @return true if the file is packed, false otherwise
+ */
+bool IsResource(const cinder::fs::path& path) {
+  return path.extension() != ".pack" && path.extension() != ".pcmcache"
+         && path.extension() != ".journal" && path.extension() != ".tmp"
+         && path.extension() != ".save" && path.extension() != ".index"
+         && path.filename() != "saved_game.json";
+}
+
+/**
+ * Packs every file under the assets directory into a single resource pack
+ * the game maps into memory. PNG images are decoded and premultiplied ahead
+ * of time, and every other file is packed as it is.
+ */
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage("Pack the game's assets into a resource pack.");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const cinder::fs::path assets_dir(FLAGS_assets_dir);
+  const string prefix = assets_dir.filename().string() + "/";
+  std::vector<string> names;
+  for (cinder::fs::recursive_directory_iterator entry(assets_dir), end;
+       entry != end; ++entry) {
+    if (cinder::fs::is_regular_file(entry->path())
+        && IsResource(entry->path())) {
+      // Name each file the way the game refers to it, with forward slashes.
+      names.push_back(prefix + cinder::fs::relative(entry->path(), assets_dir)
+                                   .generic_string());
+    }
+  }
+  std::sort(names.begin(), names.end());
+
+  island::ResourcePackWriter writer;
+  size_t num_textures = 0;
+  size_t num_texture_bytes = 0;
+  size_t num_raw_bytes = 0;
+  for (const string& name : names) {
+    const cinder::fs::path path =
+        assets_dir / cinder::fs::path(name.substr(prefix.size()));
+    if (path.extension() == ".png") {
+      size_t width;
+      size_t height;
+      std::vector<uint8_t> pixels = TextureCache::DecodeRgba(path.string(),
+                                                             &width, &height);
+      num_textures++;
+      num_texture_bytes += pixels.size();
+      writer.AddTexture(name, width, height, std::move(pixels));
+    } else {
+      std::ifstream file(path.string(), std::ios::binary);
+      std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+      num_raw_bytes += bytes.size();
+      writer.Add(name, std::move(bytes));
+    }
+  }
+
+  if (!writer.Write(FLAGS_output)) {
+    std::cerr << "Could not write " << FLAGS_output
+              << ", or two asset names hash to the same id" << std::endl;
+    return 1;
+  }
+  std::cout << "Packed " << writer.GetNumResources() << " resources into "
+            << FLAGS_output << ": " << num_textures << " images ("
+            << num_texture_bytes / 1024 << " KB of pixels) and "
+            << writer.GetNumResources() - num_textures << " files ("
+            << num_raw_bytes / 1024 << " KB)" << std::endl;
+  return 0;
+}